@@ -37,6 +37,7 @@
 #include "hashwindow.h"
 #include <math.h>
 #include <stdint.h>
+#include <pthread.h>
 
 /*
 ** Globals
@@ -805,8 +806,111 @@ VALUE AnalyzePosition(POSITION thePosition, VALUE theValue)
 	return(theValue);
 }
 
+/* Analysis is collated after solving, in one pass over the DB, instead of
+   counting each value as a solver stores it. The cells are read a block at
+   a time into a histogram by remoteness and value; with gSolverWorkers > 1,
+   and a DB that can be read from several threads, each thread scans its own
+   slice into its own histogram and they are added up at the end. */
+
+#define ANALYSIS_SCAN_BLOCK 4096
+#define ANALYSIS_SCAN_MIN_SLICE (1 << 20)     // smaller slices aren't worth a thread
+
+typedef struct analysis_scan {
+	POSITION start, end;
+	POSITION counts[REMOTENESS_MAX+1][4];   // by remoteness, then value
+} ANALYSIS_SCAN;
+
+void* AnalysisScanSlice(void* arg) {
+	ANALYSIS_SCAN* scan = (ANALYSIS_SCAN*) arg;
+	VALUE values[ANALYSIS_SCAN_BLOCK];
+	REMOTENESS remotenesses[ANALYSIS_SCAN_BLOCK];
+	POSITION pos;
+	int i, length;
+
+	for (pos = scan->start; pos < scan->end; pos += length) {
+		length = (scan->end - pos < ANALYSIS_SCAN_BLOCK) ? (int) (scan->end - pos) : ANALYSIS_SCAN_BLOCK;
+		GetRawDataRange(pos, length, values, remotenesses);
+		for (i = 0; i < length; i++)
+			scan->counts[(remotenesses[i] < REMOTENESS_MAX) ? remotenesses[i] : REMOTENESS_MAX][values[i] & 3]++;
+	}
+	return NULL;
+}
+
+/* Adds the positions in [start, end) to the analysis counters. Tiers are
+   scanned one at a time as they are solved, everything else at once. */
+void AnalysisScanRange(POSITION start, POSITION end) {
+	int workers = 1, started, w, r;
+	ANALYSIS_SCAN* scans;
+	pthread_t* threads;
+	POSITION slice, wins, loses, ties;
+
+	if (end <= start)
+		return;
+	if (gSolverWorkers > 1 && GetRawDataRangeIsThreadSafe()) {
+		workers = (int) ((end - start) / ANALYSIS_SCAN_MIN_SLICE);
+		workers = (workers > gSolverWorkers) ? gSolverWorkers : (workers < 1) ? 1 : workers;
+	}
+	scans = (ANALYSIS_SCAN*) SafeMalloc(workers * sizeof(ANALYSIS_SCAN));
+	threads = (pthread_t*) SafeMalloc(workers * sizeof(pthread_t));
+	memset(scans, 0, workers * sizeof(ANALYSIS_SCAN));
+	slice = (end - start + workers - 1) / workers;
+	for (w = 0; w < workers; w++) {
+		scans[w].start = start + w * slice;
+		scans[w].end = (w == workers - 1) ? end : scans[w].start + slice;
+	}
+
+	// this thread takes the first slice, and any a thread couldn't be started for
+	for (started = 1; started < workers; started++)
+		if (pthread_create(&threads[started], NULL, AnalysisScanSlice, &scans[started]) != 0)
+			break;
+	AnalysisScanSlice(&scans[0]);
+	for (w = started; w < workers; w++)
+		AnalysisScanSlice(&scans[w]);
+	for (w = 1; w < started; w++)
+		pthread_join(threads[w], NULL);
+
+	// same rules AnalyzePosition counts by; a tie of REMOTENESS_MAX is a draw
+	for (r = 0; r <= REMOTENESS_MAX; r++) {
+		wins = loses = ties = 0;
+		for (w = 0; w < workers; w++) {
+			wins += scans[w].counts[r][win];
+			loses += scans[w].counts[r][lose];
+			ties += scans[w].counts[r][tie];
+		}
+		totalPositions += wins + loses + ties;
+		reachablePositions += wins + loses + ties;
+		winCount += wins;
+		loseCount += loses;
+		gAnalysis.DetailedPositionSummary[r][0] += wins;
+		gAnalysis.DetailedPositionSummary[r][1] += loses;
+		if (r < REMOTENESS_MAX) {
+			tieCount += ties;
+			gAnalysis.DetailedPositionSummary[r][2] += ties;
+		} else ties = 0;
+		if ((wins || loses || ties) && r > theLargestRemoteness)
+			theLargestRemoteness = r;
+		if (r == 0) {
+			primitiveWins += wins;
+			primitiveLoses += loses;
+			primitiveTies += ties;
+		}
+	}
+	SafeFree(scans);
+	SafeFree(threads);
+}
+
 void AnalysisCollation()
 {
+	/* Tier-Gamesman scans each tier as it solves it (see SolveTier) */
+	if (!(kSupportsTierGamesman && gTierGamesman)) {
+		theLargestRemoteness = 0;
+		winCount = loseCount = tieCount = unknownCount = 0;
+		primitiveWins = primitiveLoses = primitiveTies = 0;
+		reachablePositions = totalPositions = 0;
+		memset(gAnalysis.DetailedPositionSummary, 0, sizeof(gAnalysis.DetailedPositionSummary));
+		AnalysisScanRange(0, gNumberOfPositions);
+	}
+
 	hashEfficiency = (int)((((float)reachablePositions ) / (float)gNumberOfPositions) * 100.0);
 	averageFanout = (float)((float)gAnalysis.TotalMoves/(float)(reachablePositions - primitiveWins - primitiveLoses - primitiveTies));
 
@@ -30,6 +30,7 @@ void    PrintDetailedOpenSummary();
 
 void    analyze                         ();
 VALUE   AnalyzePosition(POSITION thePosition, VALUE value);
+void    AnalysisScanRange(POSITION start, POSITION end);
 void    AnalysisCollation();
 float   DetermineProbability    (POSITION position, VALUE value);
 void    writeVarStat                    (STRING statName, STRING text, FILE* out);
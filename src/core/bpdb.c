@@ -49,6 +49,7 @@
 #include "bpdb_bitlib.h"
 #include "bpdb_schemes.h"
 #include "bpdb_misc.h"
+#include <pthread.h>
 
 
 //typedef enum
@@ -128,6 +129,35 @@ BOOLEAN bpdb_have_printed = FALSE;
 
 UINT32 bpdb_buffer_length = 10000;
 
+//
+// with gBitPerfectDBConcurrent, a caller brackets the part where
+// several threads write with bpdb_concurrent_begin/end. In there
+// slot reads and writes take no lock; a write that needs its slot
+// grown would move the arrays out from under the other threads,
+// so it is queued here instead, and bpdb_concurrent_end grows the
+// slots and applies it once the threads are done
+//
+
+BOOLEAN bpdb_concurrent = FALSE;
+
+typedef struct bpdb_deferred_write {
+	UINT64 position;
+	UINT8 index;
+	UINT64 value;
+} BPDB_DEFERRED_WRITE;
+
+BPDB_DEFERRED_WRITE *bpdb_deferred = NULL;
+UINT64 bpdb_deferred_count = 0;
+UINT64 bpdb_deferred_max = 0;
+pthread_mutex_t bpdb_deferred_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//
+// arrays are allocated in whole 64-bit words so that the
+// word containing the last slot can always be swapped
+//
+
+#define BPDB_ARRAY_ALLOC(length) (((length) + sizeof(UINT64) - 1) & ~(sizeof(UINT64) - 1))
+
 
 
 /*++
@@ -277,6 +307,8 @@ bpdb_init(
 	new_db->put_mex = bpdb_set_mex;
 	new_db->get_winby = bpdb_get_winby;
 	new_db->put_winby = bpdb_set_winby;
+	new_db->get_bulk_data = bpdb_get_bulk_data;
+	new_db->put_bulk_data = bpdb_put_bulk_data;
 	new_db->save_database = bpdb_save_database;
 	new_db->load_database = bpdb_load_database;
 	new_db->allocate = bpdb_allocate;
@@ -285,6 +317,10 @@ bpdb_init(
 	new_db->set_slice_slot = bpdb_set_slice_slot;
 	new_db->set_slice_slot_max = bpdb_set_slice_slot_max;
 	new_db->free_db = bpdb_free;
+	if(gBitPerfectDBConcurrent) {
+		new_db->begin_concurrent = bpdb_concurrent_begin;
+		new_db->end_concurrent = bpdb_concurrent_end;
+	}
 
 	// create a new singly-linked list of schemes
 	bpdb_schemes = slist_new();
@@ -365,7 +401,7 @@ bpdb_allocate( )
 	bpdb_nowrite_array_length = (size_t)ceil(((double)bpdb_slices/(double)BITSINBYTE) * (size_t)(bpdb_nowrite_slice->bits));
 
 	// allocate room for data that will be written out to file
-	bpdb_write_array = (BYTE *) calloc( bpdb_write_array_length, sizeof(BYTE) );
+	bpdb_write_array = (BYTE *) calloc( BPDB_ARRAY_ALLOC(bpdb_write_array_length), sizeof(BYTE) );
 	if(NULL == bpdb_write_array) {
 		status = STATUS_NOT_ENOUGH_MEMORY;
 		BPDB_TRACE("bpdb_allocate()", "Could not allocate bpdb_write_array in memory", status);
@@ -373,7 +409,7 @@ bpdb_allocate( )
 	}
 
 	// allocate room for transient data that will only be stored in memory
-	bpdb_nowrite_array = (BYTE *) calloc( bpdb_nowrite_array_length, sizeof(BYTE));
+	bpdb_nowrite_array = (BYTE *) calloc( BPDB_ARRAY_ALLOC(bpdb_nowrite_array_length), sizeof(BYTE));
 	if(NULL == bpdb_write_array) {
 		status = STATUS_NOT_ENOUGH_MEMORY;
 		BPDB_TRACE("bpdb_allocate()", "Could not allocate bpdb_nowrite_array in memory", status);
@@ -508,6 +544,10 @@ bpdb_free( )
 	// free database to be written
 	SAFE_FREE( bpdb_write_array );
 
+	// free the queue of deferred concurrent writes
+	SAFE_FREE( bpdb_deferred );
+	bpdb_deferred_count = bpdb_deferred_max = 0;
+
 	// free each scheme
 	cur = bpdb_schemes;
 	while( NULL != cur ) {
@@ -622,6 +662,81 @@ bpdb_get_winby(
 	return (WINBY) functionsMapping->get_slice_slot( (UINT64)pos, BPDB_WINBYSLOT );
 }
 
+/*++
+
+   Routine Description:
+
+    bpdb_get_bulk_data reads the slots asked for (the arrays that are
+    not NULL) of several positions, going straight to the slice slot
+    functions instead of one DB_Table call per position and field.
+
+   --*/
+
+void
+bpdb_get_bulk_data(
+        POSITION *positions,
+        int length,
+        VALUE *values,
+        REMOTENESS *remotenesses,
+        MEX *mexes,
+        WINBY *winbys
+        )
+{
+	UINT64 (*getSlot)(UINT64, UINT8) = functionsMapping->get_slice_slot;
+	REMOTENESS drawRemoteness = 0;
+	int i;
+
+	if(NULL != remotenesses) {
+		drawRemoteness = bpdb_write_slice->maxvalue[BPDB_REMSLOT/2]+1;
+	}
+
+	for(i = 0; i < length; i++) {
+		if(NULL != values) {
+			values[i] = (VALUE) getSlot( (UINT64)positions[i], BPDB_VALUESLOT );
+		}
+		if(NULL != remotenesses) {
+			remotenesses[i] = (REMOTENESS) getSlot( (UINT64)positions[i], BPDB_REMSLOT );
+			if(drawRemoteness == remotenesses[i]) {
+				remotenesses[i] = REMOTENESS_MAX;
+			}
+		}
+		if(NULL != mexes) {
+			mexes[i] = (MEX) getSlot( (UINT64)positions[i], BPDB_MEXSLOT );
+		}
+		if(NULL != winbys) {
+			winbys[i] = (WINBY) getSlot( (UINT64)positions[i], BPDB_WINBYSLOT );
+		}
+	}
+}
+
+void
+bpdb_put_bulk_data(
+        POSITION *positions,
+        int length,
+        VALUE *values,
+        REMOTENESS *remotenesses,
+        MEX *mexes,
+        WINBY *winbys
+        )
+{
+	int i;
+
+	for(i = 0; i < length; i++) {
+		if(NULL != remotenesses) {
+			bpdb_set_slice_slot( (UINT64)positions[i], BPDB_REMSLOT, (REMOTENESS) remotenesses[i] );
+		}
+		if(NULL != mexes) {
+			bpdb_set_slice_slot( (UINT64)positions[i], BPDB_MEXSLOT, (UINT64) mexes[i] );
+		}
+		if(NULL != winbys) {
+			bpdb_set_slice_slot( (UINT64)positions[i], BPDB_WINBYSLOT, (UINT64) winbys[i] );
+		}
+		if(NULL != values) {
+			bpdb_set_slice_slot( (UINT64)positions[i], BPDB_VALUESLOT, (UINT64) values[i] );
+		}
+	}
+}
+
 /*++
 
    Routine Description:
@@ -665,6 +780,10 @@ bpdb_set_slice_slot(
 	SLICE bpdb_slice = NULL;
 	BOOLEAN write = TRUE;
 
+	if(bpdb_concurrent) {
+		return bpdb_set_slice_slot_concurrent( position, index, value );
+	}
+
 	if(index % 2) {
 		bpdb_array = bpdb_nowrite_array;
 		bpdb_slice = bpdb_nowrite_slice;
@@ -720,6 +839,249 @@ bpdb_set_slice_slot(
 }
 
 
+/*++
+
+   Routine Description:
+
+    bpdb_set_slice_slot_concurrent is the version of
+    bpdb_set_slice_slot used when several threads write to
+    the database at once. It takes no lock.
+
+    Flow:
+    1. maxseen is raised with a compare-and-swap so that no
+        larger value is lost to a racing writer
+    2. If the slot has to be enlarged, the write is queued
+        for bpdb_concurrent_end and is not visible until that
+        runs; a slot must not be written again before then
+    3. Otherwise the slot is written with
+        bpdb_insert_bits_atomic, so writes to neighbouring
+        slots sharing a word are kept
+
+   Arguments:
+
+    position - the slice to be modified
+    index - the slot to be modified
+    value - the new value of the slot
+
+   Return value:
+
+    The value that was (or will be) stored in the slot.
+
+   --*/
+
+UINT64
+bpdb_set_slice_slot_concurrent(
+        UINT64 position,
+        UINT8 index,
+        UINT64 value
+        )
+{
+	UINT64 byteOffset = 0;
+	UINT8 bitOffset = 0;
+	UINT64 seen = 0;
+	UINT8 slot = index;
+	SLICE bpdb_slice = NULL;
+	BOOLEAN write = TRUE;
+
+	if(index % 2) {
+		bpdb_slice = bpdb_nowrite_slice;
+		write = FALSE;
+	} else {
+		bpdb_slice = bpdb_write_slice;
+	}
+	index /= 2;
+
+	seen = bpdb_slice->maxseen[index];
+	while(value > seen && !__sync_bool_compare_and_swap( &bpdb_slice->maxseen[index], seen, value )) {
+		seen = bpdb_slice->maxseen[index];
+	}
+
+	if(value > bpdb_slice->maxvalue[index] && bpdb_slice->adjust[index]) {
+		pthread_mutex_lock( &bpdb_deferred_lock );
+		if(bpdb_deferred_count == bpdb_deferred_max) {
+			bpdb_deferred_max = (0 == bpdb_deferred_max) ? 1024 : 2 * bpdb_deferred_max;
+			bpdb_deferred = (BPDB_DEFERRED_WRITE *) realloc( bpdb_deferred, bpdb_deferred_max * sizeof(BPDB_DEFERRED_WRITE) );
+			if(NULL == bpdb_deferred) {
+				BPDB_TRACE("bpdb_set_slice_slot_concurrent()", "Could not grow the deferred write queue", STATUS_NOT_ENOUGH_MEMORY);
+				exit(1);
+			}
+		}
+		bpdb_deferred[bpdb_deferred_count].position = position;
+		bpdb_deferred[bpdb_deferred_count].index = slot;
+		bpdb_deferred[bpdb_deferred_count].value = value;
+		bpdb_deferred_count++;
+		pthread_mutex_unlock( &bpdb_deferred_lock );
+		return value;
+	}
+
+	if(value > bpdb_slice->maxvalue[index]) {
+		if(__sync_bool_compare_and_swap( &bpdb_slice->overflowed[index], FALSE, TRUE )) {
+			if(!bpdb_have_printed) {
+				bpdb_have_printed = TRUE;
+				printf("\n");
+			}
+			printf("Warning: Slot %s with bit size %u had to be rounded from %llu to its maxvalue %llu.\n",
+			       bpdb_slice->name[index],
+			       bpdb_slice->size[index],
+			       value,
+			       bpdb_slice->maxvalue[index]
+			       );
+		}
+		value = bpdb_slice->maxvalue[index];
+	}
+
+	byteOffset = (bpdb_slice->bits * position)/BITSINBYTE;
+	bitOffset = ((UINT8)(bpdb_slice->bits % BITSINBYTE) * (UINT8)(position % BITSINBYTE)) % BITSINBYTE;
+	bitOffset += bpdb_slice->offset[index];
+
+	byteOffset += bitOffset / BITSINBYTE;
+	bitOffset %= BITSINBYTE;
+
+	bpdb_insert_bits_atomic( write ? bpdb_write_array : bpdb_nowrite_array, byteOffset, bitOffset, value, bpdb_slice->size[index] );
+
+	return value;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bpdb_concurrent_begin and bpdb_concurrent_end bracket
+    the part where several threads use the database. Neither
+    may be called while another thread is using it.
+
+    bpdb_concurrent_end grows the slots that writes made
+    since bpdb_concurrent_begin did not fit in, and applies
+    those writes in the order they were made.
+
+   Arguments:
+
+    None
+
+   Return value:
+
+    None
+
+   --*/
+
+void
+bpdb_concurrent_begin( )
+{
+	bpdb_concurrent = TRUE;
+}
+
+void
+bpdb_concurrent_end( )
+{
+	UINT64 i = 0;
+	UINT64 byteOffset = 0;
+	UINT8 bitOffset = 0;
+	UINT8 index = 0;
+	UINT64 value = 0;
+	SLICE bpdb_slice = NULL;
+	BOOLEAN write = TRUE;
+
+	bpdb_concurrent = FALSE;
+
+	for(i = 0; i < bpdb_deferred_count; i++) {
+		index = bpdb_deferred[i].index;
+		value = bpdb_deferred[i].value;
+		if(index % 2) {
+			bpdb_slice = bpdb_nowrite_slice;
+			write = FALSE;
+		} else {
+			bpdb_slice = bpdb_write_slice;
+			write = TRUE;
+		}
+		index /= 2;
+
+		if(value > bpdb_slice->maxvalue[index]) {
+			bpdb_grow_slice( write ? bpdb_write_array : bpdb_nowrite_array, bpdb_slice, index, value );
+		}
+		// only if growing failed
+		if(value > bpdb_slice->maxvalue[index]) {
+			value = bpdb_slice->maxvalue[index];
+		}
+
+		byteOffset = (bpdb_slice->bits * bpdb_deferred[i].position)/BITSINBYTE;
+		bitOffset = ((UINT8)(bpdb_slice->bits % BITSINBYTE) * (UINT8)(bpdb_deferred[i].position % BITSINBYTE)) % BITSINBYTE;
+		bitOffset += bpdb_slice->offset[index];
+
+		byteOffset += bitOffset / BITSINBYTE;
+		bitOffset %= BITSINBYTE;
+
+		bitlib_insert_bits( (write ? bpdb_write_array : bpdb_nowrite_array) + byteOffset, bitOffset, value, bpdb_slice->size[index] );
+	}
+
+	bpdb_deferred_count = 0;
+}
+
+
+/*++
+
+   Routine Description:
+
+    bpdb_insert_bits_atomic writes a slot the same way
+    bitlib_insert_bits does, but as a compare-and-swap on each
+    aligned 64-bit word the slot touches. A slot can straddle
+    two words; each word is swapped on its own, which is safe
+    since only the bits of this slot change in either word.
+
+   Arguments:
+
+    bpdb_array - the array holding the slot; must be word
+        aligned and allocated with BPDB_ARRAY_ALLOC.
+    byteOffset - byte of the array the slot starts in.
+    bitOffset - offset from the most significant bit of that
+        byte where the slot starts.
+    value - contains the bits to write.
+    bitsToOutput - size of the slot in bits.
+
+   Return value:
+
+    None.
+
+   --*/
+
+void
+bpdb_insert_bits_atomic(
+        BYTE *bpdb_array,
+        UINT64 byteOffset,
+        UINT8 bitOffset,
+        UINT64 value,
+        UINT8 bitsToOutput
+        )
+{
+	UINT64 *word = NULL;
+	UINT64 oldWord = 0;
+	UINT64 newWord = 0;
+	UINT32 wordByte = 0;
+	UINT32 bitsInWord = 0;
+	UINT8 bits = 0;
+
+	while(bitsToOutput > 0) {
+		wordByte = byteOffset % sizeof(UINT64);
+		word = (UINT64 *)(bpdb_array + byteOffset - wordByte);
+		bitsInWord = (sizeof(UINT64) - wordByte) * BITSINBYTE - bitOffset;
+		bits = MIN(bitsToOutput, bitsInWord);
+
+		// the most significant bits of value are written first,
+		// and bitlib_insert_bits only uses the low bits it is given
+		do {
+			oldWord = *(volatile UINT64 *)word;
+			newWord = oldWord;
+			bitlib_insert_bits( (BYTE *)&newWord + wordByte, bitOffset, value >> (bitsToOutput - bits), bits );
+		} while(!__sync_bool_compare_and_swap( word, oldWord, newWord ));
+
+		bitsToOutput -= bits;
+		bitOffset += bits % BITSINBYTE;
+		byteOffset += bits / BITSINBYTE + bitOffset / BITSINBYTE;
+		bitOffset %= BITSINBYTE;
+	}
+}
+
+
 /*++
 
    Routine Description:
@@ -781,6 +1143,11 @@ bpdb_set_slice_slot_max(
 	byteOffset += bitOffset / BITSINBYTE;
 	bitOffset %= BITSINBYTE;
 
+	if(bpdb_concurrent) {
+		bpdb_insert_bits_atomic( bpdb_array, byteOffset, bitOffset, bpdb_slice->maxvalue[index]+1, bpdb_slice->size[index] );
+		return bpdb_slice->maxvalue[index]+1;
+	}
+
 	bitlib_insert_bits( bpdb_array + byteOffset, bitOffset, bpdb_slice->maxvalue[index]+1, bpdb_slice->size[index] );
 
 	return bpdb_slice->maxvalue[index]+1;
@@ -885,7 +1252,7 @@ bpdb_grow_slice(
 	}
 
 	// allocate new space needed for the larger database
-	bpdb_new_array = (BYTE *) realloc( bpdb_array, (size_t)ceil(((double)bpdb_slices/(double)BITSINBYTE) * (size_t)(newSliceSize) ) * sizeof(BYTE));
+	bpdb_new_array = (BYTE *) realloc( bpdb_array, BPDB_ARRAY_ALLOC((size_t)ceil(((double)bpdb_slices/(double)BITSINBYTE) * (size_t)(newSliceSize) )) * sizeof(BYTE));
 	if(NULL == bpdb_new_array) {
 		status = STATUS_NOT_ENOUGH_MEMORY;
 		BPDB_TRACE("bpdb_grow_slice()", "Could not allocate new database", status);
@@ -1202,7 +1569,7 @@ bpdb_shrink_slice(
 
 
 	// allocate new space needed for the larger database
-	bpdb_new_array = (BYTE *) realloc( bpdb_array, (size_t)ceil(((double)bpdb_slices/(double)BITSINBYTE) * (size_t)(newSliceSize) ) * sizeof(BYTE));
+	bpdb_new_array = (BYTE *) realloc( bpdb_array, BPDB_ARRAY_ALLOC((size_t)ceil(((double)bpdb_slices/(double)BITSINBYTE) * (size_t)(newSliceSize) )) * sizeof(BYTE));
 	if(NULL == bpdb_new_array) {
 		status = STATUS_NOT_ENOUGH_MEMORY;
 		BPDB_TRACE("bpdb_shrink_slice()", "Could not allocate new database", status);
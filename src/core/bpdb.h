@@ -131,6 +131,27 @@ bpdb_set_winby(
         POSITION pos,
         WINBY winBy);
 
+// bulk get/set
+void
+bpdb_get_bulk_data(
+        POSITION *positions,
+        int length,
+        VALUE *values,
+        REMOTENESS *remotenesses,
+        MEX *mexes,
+        WINBY *winbys
+        );
+
+void
+bpdb_put_bulk_data(
+        POSITION *positions,
+        int length,
+        VALUE *values,
+        REMOTENESS *remotenesses,
+        MEX *mexes,
+        WINBY *winbys
+        );
+
 //
 // functions for internal use
 //
@@ -154,6 +175,28 @@ bpdb_set_slice_slot_max(
         UINT8 index
         );
 
+UINT64
+bpdb_set_slice_slot_concurrent(
+        UINT64 position,
+        UINT8 index,
+        UINT64 value
+        );
+
+void
+bpdb_concurrent_begin( );
+
+void
+bpdb_concurrent_end( );
+
+void
+bpdb_insert_bits_atomic(
+        BYTE *bpdb_array,
+        UINT64 byteOffset,
+        UINT8 bitOffset,
+        UINT64 value,
+        UINT8 bitsToOutput
+        );
+
 GMSTATUS
 bpdb_add_slot(
         UINT8 size,
@@ -0,0 +1,150 @@
+/************************************************************************
+**
+** NAME:	bpdbtest.c
+**
+** DESCRIPTION:	Stores into bpdb from several threads at once with
+**		--bpdbconcurrent, with slots that have to grow while the
+**		threads run, and checks every slot against what was stored.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "gamesman.h"
+#include "bpdb.h"
+
+#define TEST_POSITIONS          (1 << 18)
+#define TEST_THREADS            4
+#define TEST_ROUNDS             6
+
+/* Only bpdb and globals are linked in; these stand in for the rest. */
+POSITION gNumberOfPositions = TEST_POSITIONS;
+STRING kDBName = "bpdbtest";
+int getOption(void) {
+	return 0;
+}
+void showDBLoadingStatus(STATICMESSAGE msg) {
+}
+
+DB_Table table;
+int currentRound = 0;
+int mismatches = 0;
+
+/* What round r stores in position p. A few positions per round need
+   more bits than the slots have so far (winby starts at 5 bits and
+   remoteness at 8), so the slots grow while the threads are storing. */
+VALUE expectedValue(POSITION p, int r)
+{
+	return (VALUE) ((p + r) % 4);
+}
+
+MEX expectedMex(POSITION p, int r)
+{
+	return (MEX) ((p * 7 + r) % 32);
+}
+
+WINBY expectedWinBy(POSITION p, int r)
+{
+	return (p % 4099 == 0) ? (WINBY) (100 * r + 7) : (WINBY) ((p * 5 + r) % 32);
+}
+
+REMOTENESS expectedRemoteness(POSITION p, int r)
+{
+	return (p % 65537 == 1) ? (REMOTENESS) (300 + 50 * r) : (REMOTENESS) ((p + 3 * r) % 200);
+}
+
+/* Thread t stores the positions equal to t mod TEST_THREADS, so
+   neighbouring positions, which share words, are stored by
+   different threads. */
+void* storeWorker(void* arg)
+{
+	POSITION p, t = (POSITION) (size_t) arg;
+
+	for (p = t; p < TEST_POSITIONS; p += TEST_THREADS) {
+		table.put_mex(p, expectedMex(p, currentRound));
+		table.put_winby(p, expectedWinBy(p, currentRound));
+		table.put_remoteness(p, expectedRemoteness(p, currentRound));
+		table.put_value(p, expectedValue(p, currentRound));
+	}
+	return NULL;
+}
+
+void checkRound(int r)
+{
+	POSITION p;
+
+	for (p = 0; p < TEST_POSITIONS; p++) {
+		if (table.get_value(p) != expectedValue(p, r)
+		    || table.get_mex(p) != expectedMex(p, r)
+		    || table.get_winby(p) != expectedWinBy(p, r)
+		    || table.get_remoteness(p) != expectedRemoteness(p, r)) {
+			if (mismatches++ < 10)
+				printf("round %d, position " POSITION_FORMAT ": read %d %d %d %d, stored %d %d %d %d\n",
+				       r, p, table.get_value(p), table.get_mex(p), table.get_winby(p), table.get_remoteness(p),
+				       expectedValue(p, r), expectedMex(p, r), expectedWinBy(p, r), expectedRemoteness(p, r));
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t threads[TEST_THREADS];
+	size_t t;
+
+	gBitPerfectDBSolver = FALSE;
+	gBitPerfectDBConcurrent = TRUE;
+	memset(&table, 0, sizeof(DB_Table));
+	bpdb_init(&table);
+	if (table.begin_concurrent == NULL || table.end_concurrent == NULL) {
+		printf("bpdb did not set the concurrent store hooks\n");
+		return 1;
+	}
+
+	printf("Storing %d positions from %d threads, %d times...\n", TEST_POSITIONS, TEST_THREADS, TEST_ROUNDS);
+	for (currentRound = 0; currentRound < TEST_ROUNDS; currentRound++) {
+		table.begin_concurrent();
+		for (t = 0; t < TEST_THREADS; t++)
+			if (pthread_create(&threads[t], NULL, storeWorker, (void*) t) != 0) {
+				printf("Could not start a thread\n");
+				return 1;
+			}
+		for (t = 0; t < TEST_THREADS; t++)
+			pthread_join(threads[t], NULL);
+		table.end_concurrent();
+		checkRound(currentRound);
+	}
+
+	// outside begin/end the serial path grows the slots itself
+	for (t = 0; t < TEST_THREADS; t++)
+		storeWorker((void*) t);
+	checkRound(currentRound);
+
+	bpdb_free();
+	printf("%d mismatches\n", mismatches);
+	return mismatches != 0;
+}
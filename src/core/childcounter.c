@@ -0,0 +1,387 @@
+/************************************************************************
+**
+** NAME:	childcounter.c
+**
+** DESCRIPTION:	Packed child counters for the loopy solvers. A counter
+**		is 4 bits when the game's fanout allows it and 8 bits
+**		otherwise; the few positions with more children than
+**		that keep their count in a small open-addressing table
+**		instead of forcing every counter to be wide. Pages of
+**		counters are allocated on first use, and decrements and
+**		claims are atomic so the parallel frontier walk can
+**		share one counter array.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include "gamesman.h"
+
+#define CHILDCOUNTER_PAGE_SIZE  ((POSITION)1 << CHILDCOUNTER_PAGE_BITS)
+#define CHILDCOUNTER_PAGE_MASK  (CHILDCOUNTER_PAGE_SIZE - 1)
+
+#define ChildCounterMax(counter) ((1u << (counter)->bits) - 1)
+#define ChildCounterPageBytes(counter) (CHILDCOUNTER_PAGE_SIZE * (counter)->bits / 8)
+
+void ChildCounterInit(CHILDCOUNTER *counter, POSITION numPositions, int bits)
+{
+	counter->numPositions = numPositions;
+	counter->bits = (bits == 4) ? 4 : 8;
+	counter->numPages = (numPositions + CHILDCOUNTER_PAGE_MASK) >> CHILDCOUNTER_PAGE_BITS;
+	counter->pages = (unsigned char **) SafeMalloc((counter->numPages > 0 ? counter->numPages : 1) * sizeof(unsigned char *));
+	memset(counter->pages, 0, counter->numPages * sizeof(unsigned char *));
+	counter->overflow = NULL;
+	counter->overflowSize = counter->overflowUsed = 0;
+	pthread_mutex_init(&counter->overflowLock, NULL);
+}
+
+void ChildCounterFree(CHILDCOUNTER *counter)
+{
+	POSITION i;
+
+	if (counter->pages != NULL) {
+		for (i = 0; i < counter->numPages; i++)
+			if (counter->pages[i] != NULL) SafeFree(counter->pages[i]);
+		SafeFree(counter->pages);
+		pthread_mutex_destroy(&counter->overflowLock);
+	}
+	if (counter->overflow != NULL) SafeFree(counter->overflow);
+	counter->pages = NULL;
+	counter->overflow = NULL;
+	counter->numPositions = counter->numPages = 0;
+	counter->overflowSize = counter->overflowUsed = 0;
+}
+
+// 4 bits pay off unless more than 1% of the positions would spill into the
+// side-table, which costs far more per entry than the half byte saved.
+int ChildCounterBitsFor(int *fanouts, int numFanouts)
+{
+	int i, wide = 0;
+
+	if (numFanouts == 0) return 8;
+	for (i = 0; i < numFanouts; i++)
+		if (fanouts[i] >= 15) wide++;
+	return (wide * 100 <= numFanouts) ? 4 : 8;
+}
+
+/*
+** The counter of pos lives in (*cell >> *shift) & ChildCounterMax.
+** Returns NULL if its page isn't there and create is FALSE.
+*/
+static unsigned char *ChildCounterCell(CHILDCOUNTER *counter, POSITION pos, int *shift, BOOLEAN create)
+{
+	POSITION page = pos >> CHILDCOUNTER_PAGE_BITS, offset = pos & CHILDCOUNTER_PAGE_MASK;
+
+	if (counter->pages[page] == NULL) {
+		if (!create) return NULL;
+		counter->pages[page] = (unsigned char *) SafeMalloc(ChildCounterPageBytes(counter));
+		memset(counter->pages[page], 0, ChildCounterPageBytes(counter));
+	}
+	if (counter->bits == 4) {
+		*shift = (offset & 1) << 2;
+		return counter->pages[page] + (offset >> 1);
+	}
+	*shift = 0;
+	return counter->pages[page] + offset;
+}
+
+// Stores v into the cell without disturbing the other counter in its byte
+static void ChildCounterStore(CHILDCOUNTER *counter, unsigned char *cell, int shift, unsigned int v)
+{
+	unsigned char old, mask = (unsigned char) (ChildCounterMax(counter) << shift);
+
+	do old = *(volatile unsigned char *) cell;
+	while (!__sync_bool_compare_and_swap(cell, old, (unsigned char) ((old & ~mask) | (v << shift))));
+}
+
+#define ChildCounterHome(counter, pos) ((((pos) * 0x9E3779B97F4A7C15ULL) >> 32) & ((counter)->overflowSize - 1))
+
+/*
+** The side-table slot of pos, or NULL if it has none.
+** Call with overflowLock held.
+*/
+static CHILDCOUNTER_OVERFLOW *ChildCounterFind(CHILDCOUNTER *counter, POSITION pos)
+{
+	POSITION i;
+
+	if (counter->overflowSize == 0) return NULL;
+	for (i = ChildCounterHome(counter, pos);
+	     counter->overflow[i].position != INVALID_POSITION;
+	     i = (i + 1) & (counter->overflowSize - 1))
+		if (counter->overflow[i].position == pos)
+			return &counter->overflow[i];
+	return NULL;
+}
+
+/*
+** The side-table slot of pos, which is claimed for it if it has none.
+** Call with overflowLock held.
+*/
+static CHILDCOUNTER_OVERFLOW *ChildCounterSlot(CHILDCOUNTER *counter, POSITION pos)
+{
+	CHILDCOUNTER_OVERFLOW *old, *slot;
+	POSITION i, oldSize;
+
+	if ((slot = ChildCounterFind(counter, pos)) != NULL)
+		return slot;
+	if ((counter->overflowUsed + 1) * 2 > counter->overflowSize) {
+		old = counter->overflow;
+		oldSize = counter->overflowSize;
+		counter->overflowSize = (oldSize == 0) ? 1024 : oldSize * 2;
+		counter->overflow = (CHILDCOUNTER_OVERFLOW *) SafeMalloc(counter->overflowSize * sizeof(CHILDCOUNTER_OVERFLOW));
+		for (i = 0; i < counter->overflowSize; i++)
+			counter->overflow[i].position = INVALID_POSITION;
+		counter->overflowUsed = 0;
+		for (i = 0; i < oldSize; i++)
+			if (old[i].position != INVALID_POSITION)
+				*ChildCounterSlot(counter, old[i].position) = old[i];
+		if (old != NULL) SafeFree(old);
+	}
+	for (i = ChildCounterHome(counter, pos);
+	     counter->overflow[i].position != INVALID_POSITION;
+	     i = (i + 1) & (counter->overflowSize - 1))
+		;
+	counter->overflow[i].position = pos;
+	counter->overflow[i].count = 0;
+	counter->overflowUsed++;
+	return &counter->overflow[i];
+}
+
+/*
+** Frees the side-table slot of pos, if it has one, once its counter is back
+** in its cell. The entries after it in the probe run are shifted back over
+** the hole so later lookups don't stop short. Call with overflowLock held.
+*/
+static void ChildCounterRemove(CHILDCOUNTER *counter, POSITION pos)
+{
+	CHILDCOUNTER_OVERFLOW *slot;
+	POSITION i, j, mask = counter->overflowSize - 1;
+
+	if ((slot = ChildCounterFind(counter, pos)) == NULL)
+		return;
+	i = slot - counter->overflow;
+	for (j = (i + 1) & mask; counter->overflow[j].position != INVALID_POSITION; j = (j + 1) & mask) {
+		// the entry at j may fill the hole if the hole lies between its home and j
+		if (((j - ChildCounterHome(counter, counter->overflow[j].position)) & mask) >= ((j - i) & mask)) {
+			counter->overflow[i] = counter->overflow[j];
+			i = j;
+		}
+	}
+	counter->overflow[i].position = INVALID_POSITION;
+	counter->overflowUsed--;
+}
+
+unsigned int ChildCounterGet(CHILDCOUNTER *counter, POSITION pos)
+{
+	unsigned char *cell;
+	unsigned int v, max = ChildCounterMax(counter);
+	int shift;
+
+	if ((cell = ChildCounterCell(counter, pos, &shift, FALSE)) == NULL)
+		return 0;
+	v = (*(volatile unsigned char *) cell >> shift) & max;
+	if (v == max) {
+		pthread_mutex_lock(&counter->overflowLock);
+		// a decrement may have moved it back into the cell meanwhile
+		v = (*(volatile unsigned char *) cell >> shift) & max;
+		if (v == max)
+			v = ChildCounterFind(counter, pos)->count;
+		pthread_mutex_unlock(&counter->overflowLock);
+	}
+	return v;
+}
+
+void ChildCounterSet(CHILDCOUNTER *counter, POSITION pos, unsigned int count)
+{
+	unsigned char *cell;
+	unsigned int max = ChildCounterMax(counter);
+	int shift;
+
+	cell = ChildCounterCell(counter, pos, &shift, TRUE);
+	if (count >= max) {
+		pthread_mutex_lock(&counter->overflowLock);
+		ChildCounterSlot(counter, pos)->count = count;
+		pthread_mutex_unlock(&counter->overflowLock);
+		count = max;
+	} else if (((*(volatile unsigned char *) cell >> shift) & max) == max) {
+		// the cell goes first so that nobody looks for the freed slot
+		pthread_mutex_lock(&counter->overflowLock);
+		ChildCounterStore(counter, cell, shift, count);
+		ChildCounterRemove(counter, pos);
+		pthread_mutex_unlock(&counter->overflowLock);
+		return;
+	}
+	ChildCounterStore(counter, cell, shift, count);
+}
+
+// Counters don't go below zero
+void ChildCounterAdd(CHILDCOUNTER *counter, POSITION pos, int amount)
+{
+	long long count = (long long) ChildCounterGet(counter, pos) + amount;
+
+	ChildCounterSet(counter, pos, count > 0 ? (unsigned int) count : 0);
+}
+
+/*
+** Decrements a nonzero counter and returns its new value; a zero counter is
+** left alone. Counters in the side-table move back into their cell, and
+** their slot is freed, as soon as they fit, so the lock is only taken near
+** the top of the range.
+*/
+unsigned int ChildCounterDecrement(CHILDCOUNTER *counter, POSITION pos)
+{
+	unsigned char *cell, old;
+	unsigned int v, max = ChildCounterMax(counter);
+	CHILDCOUNTER_OVERFLOW *slot;
+	int shift;
+
+	if ((cell = ChildCounterCell(counter, pos, &shift, FALSE)) == NULL)
+		return 0;
+	for (;;) {
+		old = *(volatile unsigned char *) cell;
+		v = (old >> shift) & max;
+		if (v == 0) return 0;
+		if (v != max) {
+			if (__sync_bool_compare_and_swap(cell, old, (unsigned char) (old - (1u << shift))))
+				return v - 1;
+			continue;
+		}
+		pthread_mutex_lock(&counter->overflowLock);
+		// another thread may have moved it back into the cell meanwhile
+		if (((*(volatile unsigned char *) cell >> shift) & max) == max) {
+			slot = ChildCounterFind(counter, pos);
+			v = --slot->count;
+			if (v < max) {
+				ChildCounterStore(counter, cell, shift, v);
+				ChildCounterRemove(counter, pos);
+			}
+			pthread_mutex_unlock(&counter->overflowLock);
+			return v;
+		}
+		pthread_mutex_unlock(&counter->overflowLock);
+	}
+}
+
+/*
+** Zeroes the counter. Returns TRUE if it wasn't zero already, so that only
+** one of several threads reaching the same parent gets to solve it.
+*/
+BOOLEAN ChildCounterClaim(CHILDCOUNTER *counter, POSITION pos)
+{
+	unsigned char *cell, old, mask;
+	unsigned int max = ChildCounterMax(counter);
+	int shift;
+
+	if ((cell = ChildCounterCell(counter, pos, &shift, FALSE)) == NULL)
+		return FALSE;
+	mask = (unsigned char) (max << shift);
+	for (;;) {
+		old = *(volatile unsigned char *) cell;
+		if ((old & mask) == 0) return FALSE;
+		if ((old & mask) != mask) {
+			if (__sync_bool_compare_and_swap(cell, old, (unsigned char) (old & ~mask)))
+				return TRUE;
+			continue;
+		}
+		pthread_mutex_lock(&counter->overflowLock);
+		if ((*(volatile unsigned char *) cell & mask) == mask) {
+			ChildCounterStore(counter, cell, shift, 0);
+			ChildCounterRemove(counter, pos);
+			pthread_mutex_unlock(&counter->overflowLock);
+			return TRUE;
+		}
+		pthread_mutex_unlock(&counter->overflowLock);
+	}
+}
+
+/*
+** Saves the counters as the width, the used pages (each preceded by its
+** index) and the side-table entries. ChildCounterRead replaces whatever
+** the counter held with them.
+*/
+BOOLEAN ChildCounterWrite(CHILDCOUNTER *counter, FILE *fp)
+{
+	POSITION i, used = 0;
+	int bits = counter->bits;
+
+	for (i = 0; i < counter->numPages; i++)
+		if (counter->pages[i] != NULL) used++;
+	if (fwrite(&bits, sizeof(int), 1, fp) != 1
+	    || fwrite(&counter->numPositions, sizeof(POSITION), 1, fp) != 1
+	    || fwrite(&used, sizeof(POSITION), 1, fp) != 1)
+		return FALSE;
+	for (i = 0; i < counter->numPages; i++)
+		if (counter->pages[i] != NULL
+		    && (fwrite(&i, sizeof(POSITION), 1, fp) != 1
+		        || fwrite(counter->pages[i], 1, ChildCounterPageBytes(counter), fp) != ChildCounterPageBytes(counter)))
+			return FALSE;
+	if (fwrite(&counter->overflowUsed, sizeof(POSITION), 1, fp) != 1)
+		return FALSE;
+	for (i = 0; i < counter->overflowSize; i++)
+		if (counter->overflow[i].position != INVALID_POSITION
+		    && fwrite(&counter->overflow[i], sizeof(CHILDCOUNTER_OVERFLOW), 1, fp) != 1)
+			return FALSE;
+	return TRUE;
+}
+
+BOOLEAN ChildCounterRead(CHILDCOUNTER *counter, FILE *fp)
+{
+	POSITION i, numPositions, used, page;
+	CHILDCOUNTER_OVERFLOW entry;
+	int bits;
+
+	if (fread(&bits, sizeof(int), 1, fp) != 1
+	    || fread(&numPositions, sizeof(POSITION), 1, fp) != 1
+	    || fread(&used, sizeof(POSITION), 1, fp) != 1)
+		return FALSE;
+	ChildCounterFree(counter);
+	ChildCounterInit(counter, numPositions, bits);
+	for (i = 0; i < used; i++) {
+		if (fread(&page, sizeof(POSITION), 1, fp) != 1 || page >= counter->numPages)
+			return FALSE;
+		counter->pages[page] = (unsigned char *) SafeMalloc(ChildCounterPageBytes(counter));
+		if (fread(counter->pages[page], 1, ChildCounterPageBytes(counter), fp) != ChildCounterPageBytes(counter))
+			return FALSE;
+	}
+	if (fread(&used, sizeof(POSITION), 1, fp) != 1)
+		return FALSE;
+	for (i = 0; i < used; i++) {
+		if (fread(&entry, sizeof(CHILDCOUNTER_OVERFLOW), 1, fp) != 1)
+			return FALSE;
+		ChildCounterSlot(counter, entry.position)->count = entry.count;
+	}
+	return TRUE;
+}
+
+// Memory held by the counters, for the solvers' progress output
+POSITION ChildCounterBytes(CHILDCOUNTER *counter)
+{
+	POSITION i, bytes = counter->numPages * sizeof(unsigned char *);
+
+	for (i = 0; i < counter->numPages; i++)
+		if (counter->pages[i] != NULL) bytes += ChildCounterPageBytes(counter);
+	return bytes + counter->overflowSize * sizeof(CHILDCOUNTER_OVERFLOW);
+}
+
+// End ChildCounter
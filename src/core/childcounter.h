@@ -0,0 +1,52 @@
+#ifndef GMCORE_CHILDCOUNTER_H
+#define GMCORE_CHILDCOUNTER_H
+
+#include <pthread.h>
+
+/* Packed child counters for the loopy solvers. Each position gets a 4 or 8
+   bit counter; a counter at its largest value means the real count is in
+   the overflow side-table. Counters are kept in pages that are only
+   allocated once one of their positions is counted, so unreached stretches
+   of the hash cost nothing. A page is all or nothing, though: illegal or
+   non-canonical positions that share a page with counted ones still take
+   up their (zero) cell. */
+
+#define CHILDCOUNTER_PAGE_BITS  16
+#define CHILDCOUNTER_SAMPLE     1024    /* fanouts looked at to pick the width */
+
+typedef struct child_counter_overflow
+{
+	POSITION position;      /* INVALID_POSITION while the slot is free */
+	unsigned int count;
+}
+CHILDCOUNTER_OVERFLOW;
+
+typedef struct child_counter
+{
+	POSITION numPositions;
+	int bits;                       /* 4 or 8 */
+	unsigned char **pages;          /* NULL until the page is used */
+	POSITION numPages;
+	CHILDCOUNTER_OVERFLOW *overflow; /* open addressing, slots freed once a count fits again */
+	POSITION overflowSize, overflowUsed;
+	pthread_mutex_t overflowLock;
+}
+CHILDCOUNTER;
+
+void            ChildCounterInit                (CHILDCOUNTER *counter, POSITION numPositions, int bits);
+void            ChildCounterFree                (CHILDCOUNTER *counter);
+int             ChildCounterBitsFor             (int *fanouts, int numFanouts);
+
+unsigned int    ChildCounterGet                 (CHILDCOUNTER *counter, POSITION pos);
+void            ChildCounterSet                 (CHILDCOUNTER *counter, POSITION pos, unsigned int count);
+void            ChildCounterAdd                 (CHILDCOUNTER *counter, POSITION pos, int amount);
+
+/* Safe to call from several threads at once (but not alongside Set/Add) */
+unsigned int    ChildCounterDecrement           (CHILDCOUNTER *counter, POSITION pos);
+BOOLEAN         ChildCounterClaim               (CHILDCOUNTER *counter, POSITION pos);
+
+BOOLEAN         ChildCounterWrite               (CHILDCOUNTER *counter, FILE *fp);
+BOOLEAN         ChildCounterRead                (CHILDCOUNTER *counter, FILE *fp);
+POSITION        ChildCounterBytes               (CHILDCOUNTER *counter);
+
+#endif /* GMCORE_CHILDCOUNTER_H */
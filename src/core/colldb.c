@@ -29,18 +29,55 @@
 **
 **************************************************************************/
 
+#include <zlib.h>
+#include <netinet/in.h>
 #include "gamesman.h"
 #include "colldb.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-/* this defines the maximum number of bits that can be in the hash field
- * of a position.
- * (thus limiting the maximum length of the hash array to be (2^HASH_FIELD_MAX)*40 bits)
- * the maximum size of the db should be
- * (2^HASH_FIELD_MAX)*32 + (2^HASH_FIELD_MAX + 8)*40
- * the first term needs to be continuous space, the second one consists of sparse 40-bit spaces
- *  ----------- hand tuning with big games possible -------------
+/* Only the positions that are reached are stored, in an open-addressed hash
+ * table, so the size of the database follows the reachable set rather than
+ * the size of the hash.
+ *
+ * Each position is first scrambled by a reversible mix over the bits the
+ * hash needs. The top bits of the mixed value pick the home group of
+ * COLLDB_GROUP slots and only the rest of the bits (the remainder) are
+ * stored in the slot:
+ *
+ *  |  quotient  |          remainder          |
+ *  | home group |   kept in the slot, 32 bits when they fit   |
+ *
+ * A slot's control byte is 0 when it is empty, otherwise one more than how
+ * many groups past its home group it was put, so the quotient, and with it
+ * the position, can be got back when the table is resized or saved. A probe
+ * compares the control bytes of a whole group at once and only looks at the
+ * remainders of the slots that could hold the position.
+ *
+ * When the table gets full a table of twice the size is made and the old one
+ * is moved into it a few groups at a time, on each position added, so no
+ * single access pays for the whole move.
  */
-#define HASH_FIELD_MAX 16
+
+#define COLLDB_GROUP            16      /* slots in a group, one SSE2 compare */
+#define COLLDB_MIN_GROUP_BITS   6
+#define COLLDB_MAX_DISPLACEMENT 253     /* control bytes 1..254 */
+#define COLLDB_MOVED            0xff    /* slot of the old table already moved */
+#define COLLDB_MIGRATE_STEP     4       /* old groups moved per position added */
+#define COLLDB_MIX              0x9e3779b97f4a7c15ULL
+#define COLLDB_FILEVER          1
+#define COLLDB_NO_SLOT          ((POSITION) -1)
+
+typedef struct colldb_table {
+	unsigned char *ctrl;
+	unsigned int *rem32;            /* one of these two is used */
+	POSITION *rem64;
+	unsigned short *cells;
+	POSITION numGroups;
+	int groupBits, remBits;
+	POSITION count;
+} COLLDB_TABLE;
 
 void            colldb_free ();
 
@@ -61,95 +98,55 @@ void            colldb_unmark_visited   (POSITION pos);
 MEX             colldb_get_mex          (POSITION pos);
 void            colldb_set_mex          (POSITION pos, MEX mex);
 
+/* Bulk */
+void            colldb_get_bulk_data    (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void            colldb_put_bulk_data    (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
 
-/* the concept here is to divide the POSITION into two fields */
-
-/* 00000000000000000000000000000000
- * | key  |      hash index       |
- * The key is stored in the chain hanging off the bucket
- * the hash index determines which bucket the POSITION goes in.
- * the database always try to minimize the hash index for maximum capacity
- * due to memory restrictions the hash index may reach its theoretical
- * maximum around 2^20 (because the array needs continuous space)
- * so this db may not make do with all 64 bits of the POSITION
- * but it is better than the array db, since it has more tolerance
- * for fragmentation
- */
-
-/* Collision Specific */
-typedef struct colldb_node {
-
-	VALUE myValue;
-	char myPos;
-	struct colldb_node *next;
+/* Save/Load */
+BOOLEAN         colldb_save_database    ();
+BOOLEAN         colldb_load_database    ();
 
-} colldb_value_node;
+/* Table */
+void            colldb_table_init       (COLLDB_TABLE *table, int groupBits);
+void            colldb_table_free       (COLLDB_TABLE *table);
+POSITION        colldb_table_find       (COLLDB_TABLE *table, POSITION mixed);
+POSITION        colldb_table_insert     (COLLDB_TABLE *table, POSITION mixed, unsigned short cell);
+void            colldb_grow             ();
+void            colldb_migrate          (POSITION groups);
+unsigned short* colldb_find_cell        (POSITION pos);
+unsigned short* colldb_add_cell         (POSITION pos);
 
-colldb_value_node *colldb_find_pos(POSITION position);
-colldb_value_node *colldb_make_node(POSITION pos, VALUE val, colldb_value_node *next);
-colldb_value_node *colldb_add_node(POSITION position);
+COLLDB_TABLE colldb_table;              /* where new positions go */
+COLLDB_TABLE colldb_old_table;          /* being moved into colldb_table */
+BOOLEAN colldb_migrating = FALSE;
+POSITION colldb_migrate_next;           /* first old group not yet moved */
 
-colldb_value_node** colldb_hash_table;
+int colldb_mix_bits, colldb_mix_shift;
+POSITION colldb_mix_mask, colldb_unmix;
 
-POSITION colldb_num_allocated;
-unsigned int hash_field_len;
-POSITION hash_mask;
+char colldb_filename[80];
 
-unsigned int hitcount;
-unsigned int accesscount;
-unsigned int remotecount;
-unsigned int visitcount;
 /*
 ** Code
 */
 
-/* this guarantees that in the case of a tight hash,
- * and all POSITIONs are valid,
- * each bucket contains as many POSITIONs as possible
- * (all 2^8 keys allowed are utilized)
- */
-unsigned int calc_field_len(POSITION total)
-{
-	unsigned int shamt = 0;
-
-	while (total > ((1<<8)-1)) {
-		total = total >> 1;
-		shamt++;
-	}
-
-	if (shamt > HASH_FIELD_MAX) {
-		/* the hash index field exceeds a predefined value */
-		printf("this is probably too big to be handled by the collision database. I give up.\n");
-		ExitStageRight();
-		exit(0);
-	}
-
-	return shamt;
-}
-
-
 void colldb_init(DB_Table *new_db)
 {
-	hitcount = 0;
-	hash_field_len = calc_field_len(gNumberOfPositions);
-	hash_mask = (1 << hash_field_len) - 1;
-/*
- *   POSITION temp = hash_mask;
- *
- *    printf("hash_mask = ");
-
- *    while(temp > 1) {
- *      printf("%d", (int)(temp & 1));
- *      temp = temp >> 1;
- *    }
+	POSITION inverse = COLLDB_MIX;
+	int i;
 
- *    printf("\n");
- */
-	//setup internal memory table
-	colldb_hash_table = (colldb_value_node **) SafeMalloc ((1 << hash_field_len) * sizeof(colldb_value_node*));
-	//printf("initalizing collision database. %d rows allocated.\n",colldb_HASHSIZE);
+	/* mix over at least 32 bits so small games still spread over the table */
+	colldb_mix_bits = 32;
+	while (colldb_mix_bits < 64 && (gNumberOfPositions - 1) >> colldb_mix_bits != 0)
+		colldb_mix_bits++;
+	colldb_mix_mask = (colldb_mix_bits == 64) ? ~0ULL : (1ULL << colldb_mix_bits) - 1;
+	colldb_mix_shift = (colldb_mix_bits + 1) / 2;
+	for (i = 0; i < 6; i++) // Newton's iteration for the inverse of COLLDB_MIX mod 2^64
+		inverse *= 2 - COLLDB_MIX * inverse;
+	colldb_unmix = inverse;
 
-	memset(colldb_hash_table, 0x0000, (1 << hash_field_len) * sizeof(colldb_value_node*));
+	colldb_table_init(&colldb_table, COLLDB_MIN_GROUP_BITS);
+	colldb_migrating = FALSE;
 
 	//set function pointers
 	new_db->get_value = colldb_get_value;
@@ -161,6 +158,10 @@ void colldb_init(DB_Table *new_db)
 	new_db->unmark_visited = colldb_unmark_visited;
 	new_db->get_mex = colldb_get_mex;
 	new_db->put_mex = colldb_set_mex;
+	new_db->get_bulk_data = colldb_get_bulk_data;
+	new_db->put_bulk_data = colldb_put_bulk_data;
+	new_db->save_database = colldb_save_database;
+	new_db->load_database = colldb_load_database;
 
 	new_db->free_db = colldb_free;
 
@@ -168,191 +169,429 @@ void colldb_init(DB_Table *new_db)
 }
 
 void colldb_free(){
+	colldb_table_free(&colldb_table);
+	if (colldb_migrating)
+		colldb_table_free(&colldb_old_table);
+	colldb_migrating = FALSE;
+}
+
+/* The mix is a xor-shift and a multiply by an odd number, both of which
+   can be undone within colldb_mix_bits bits. */
+static inline POSITION colldb_mix(POSITION pos)
+{
+	pos ^= pos >> colldb_mix_shift;
+	return (pos * COLLDB_MIX) & colldb_mix_mask;
+}
 
+static inline POSITION colldb_unmix_pos(POSITION mixed)
+{
+	mixed = (mixed * colldb_unmix) & colldb_mix_mask;
+	return mixed ^ (mixed >> colldb_mix_shift);
+}
+
+/* bit i of the result is set if byte i of the group equals b */
+static inline unsigned int colldb_match(const unsigned char *group, unsigned char b)
+{
+#ifdef __SSE2__
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) group), _mm_set1_epi8((char) b)));
+#else
+	unsigned int i, mask = 0;
+
+	for (i = 0; i < COLLDB_GROUP; i++)
+		if (group[i] == b)
+			mask |= 1U << i;
+	return mask;
+#endif
+}
+
+static inline POSITION colldb_get_rem(COLLDB_TABLE *table, POSITION slot)
+{
+	return table->rem32 ? table->rem32[slot] : table->rem64[slot];
+}
+
+void colldb_table_init(COLLDB_TABLE *table, int groupBits)
+{
+	POSITION slots;
+
+	if (groupBits >= colldb_mix_bits) {
+		printf("this is probably too big to be handled by the collision database. I give up.\n");
+		ExitStageRight();
+		exit(0);
+	}
+	table->groupBits = groupBits;
+	table->remBits = colldb_mix_bits - groupBits;
+	table->numGroups = 1ULL << groupBits;
+	table->count = 0;
+	slots = table->numGroups * COLLDB_GROUP;
+	table->ctrl = (unsigned char *) SafeMalloc(slots);
+	memset(table->ctrl, 0, slots);
+	table->cells = (unsigned short *) SafeMalloc(slots * sizeof(unsigned short));
+	if (table->remBits <= 32) {
+		table->rem32 = (unsigned int *) SafeMalloc(slots * sizeof(unsigned int));
+		table->rem64 = NULL;
+	} else {
+		table->rem64 = (POSITION *) SafeMalloc(slots * sizeof(POSITION));
+		table->rem32 = NULL;
+	}
+}
+
+void colldb_table_free(COLLDB_TABLE *table)
+{
+	if (table->ctrl == NULL)
+		return;
+	SafeFree(table->ctrl);
+	SafeFree(table->cells);
+	if (table->rem32) SafeFree(table->rem32);
+	if (table->rem64) SafeFree(table->rem64);
+	table->ctrl = NULL;
+	table->rem32 = NULL;
+	table->rem64 = NULL;
+}
+
+/* Returns the slot holding the mixed position, or COLLDB_NO_SLOT. */
+POSITION colldb_table_find(COLLDB_TABLE *table, POSITION mixed)
+{
+	POSITION group = mixed >> table->remBits;
+	POSITION rem = mixed & ((1ULL << table->remBits) - 1);
+	POSITION groupMask = table->numGroups - 1, base;
+	unsigned int d, match;
 	int i;
-	colldb_value_node *next, *cur;
-
-	if(colldb_hash_table) {
-		for(i=0; i<(1 << hash_field_len); i++) {
-			cur = colldb_hash_table[i];
-			while(cur != NULL) {
-				next = cur->next;
-				SafeFree(cur);
-				cur = next;
-			}
+
+	for (d = 0; d <= COLLDB_MAX_DISPLACEMENT; d++, group = (group + 1) & groupMask) {
+		base = group * COLLDB_GROUP;
+		match = colldb_match(table->ctrl + base, (unsigned char) (d + 1));
+		while (match != 0) {
+			i = __builtin_ctz(match);
+			if (colldb_get_rem(table, base + i) == rem)
+				return base + i;
+			match &= match - 1;
 		}
-		SafeFree(colldb_hash_table);
+		if (colldb_match(table->ctrl + base, 0) != 0)
+			break;
 	}
+	return COLLDB_NO_SLOT;
 }
 
-colldb_value_node *colldb_find_pos(POSITION position){
-
-	POSITION i;
-	char key;
-	colldb_value_node *cur;
-
-	key = (char) (position >> hash_field_len);
-	i = position & hash_mask;
-	cur = colldb_hash_table[i];
-
-	while(cur != NULL) {
-		if(cur->myPos == key) {
-			/*
-			 * hitcount++;
-			 * if(hitcount%1000 == 0){
-			 *	printf("hit: %d, access: %d, visit: %d, remote: %d\n",hitcount,accesscount,visitcount,remotecount);
-			 *}
-			 */
-			return cur;
+/* Puts a mixed position known not to be in the table into the first free
+   slot on its probe. Returns COLLDB_NO_SLOT if that is too far from home. */
+POSITION colldb_table_insert(COLLDB_TABLE *table, POSITION mixed, unsigned short cell)
+{
+	POSITION group = mixed >> table->remBits;
+	POSITION rem = mixed & ((1ULL << table->remBits) - 1);
+	POSITION groupMask = table->numGroups - 1, slot;
+	unsigned int d, empty;
+
+	for (d = 0; d <= COLLDB_MAX_DISPLACEMENT; d++, group = (group + 1) & groupMask) {
+		empty = colldb_match(table->ctrl + group * COLLDB_GROUP, 0);
+		if (empty != 0) {
+			slot = group * COLLDB_GROUP + __builtin_ctz(empty);
+			table->ctrl[slot] = (unsigned char) (d + 1);
+			if (table->rem32) table->rem32[slot] = (unsigned int) rem;
+			else table->rem64[slot] = rem;
+			table->cells[slot] = cell;
+			table->count++;
+			return slot;
 		}
-		cur = cur->next;
 	}
+	return COLLDB_NO_SLOT;
+}
 
-	return NULL;
+/* Moves the next groups of the old table over. Moved slots are marked
+   rather than emptied, so probes for positions further on still get past
+   them. */
+void colldb_migrate(POSITION groups)
+{
+	COLLDB_TABLE *old = &colldb_old_table;
+	POSITION end = colldb_migrate_next + groups, slot, home, mixed;
+	unsigned char ctrl;
+
+	if (end > old->numGroups)
+		end = old->numGroups;
+	for (slot = colldb_migrate_next * COLLDB_GROUP; slot < end * COLLDB_GROUP; slot++) {
+		ctrl = old->ctrl[slot];
+		if (ctrl == 0 || ctrl == COLLDB_MOVED)
+			continue;
+		home = (slot / COLLDB_GROUP - (ctrl - 1)) & (old->numGroups - 1);
+		mixed = (home << old->remBits) | colldb_get_rem(old, slot);
+		if (colldb_table_insert(&colldb_table, mixed, old->cells[slot]) == COLLDB_NO_SLOT) {
+			printf("collision database: no room to move a position while resizing. I give up.\n");
+			ExitStageRight();
+			exit(0);
+		}
+		old->ctrl[slot] = COLLDB_MOVED;
+	}
+	colldb_migrate_next = end;
+	if (end == old->numGroups) {
+		colldb_table_free(old);
+		colldb_migrating = FALSE;
+	}
 }
 
-colldb_value_node* colldb_make_node(POSITION pos, VALUE val, colldb_value_node *next){
-
-	colldb_value_node *ptr = (colldb_value_node *) SafeMalloc (sizeof(colldb_value_node));
-
-	ptr->myPos = (char) (pos >> hash_field_len);
-	ptr->myValue = val;
-	ptr->next = next;
-	colldb_num_allocated++;
-	/*
-	 * if(colldb_num_allocated % 100 == 0){
-	 *	printf("number allocated: "POSITION_FORMAT"\n",colldb_num_allocated);
-	 *	fflush(NULL);
-	 *    }
-	 */
-	return ptr;
+void colldb_grow()
+{
+	if (colldb_migrating)
+		colldb_migrate(colldb_old_table.numGroups);
+	colldb_old_table = colldb_table;
+	colldb_table_init(&colldb_table, colldb_old_table.groupBits + 1);
+	colldb_migrating = TRUE;
+	colldb_migrate_next = 0;
 }
 
-colldb_value_node *colldb_add_node(POSITION position)
+unsigned short* colldb_find_cell(POSITION pos)
 {
-	POSITION i = position & hash_mask;
+	POSITION mixed = colldb_mix(pos), slot;
 
-	colldb_hash_table[i] = colldb_make_node(position, undecided, colldb_hash_table[i]);
+	if ((slot = colldb_table_find(&colldb_table, mixed)) != COLLDB_NO_SLOT)
+		return &colldb_table.cells[slot];
+	if (colldb_migrating && (slot = colldb_table_find(&colldb_old_table, mixed)) != COLLDB_NO_SLOT)
+		return &colldb_old_table.cells[slot];
+	return NULL;
+}
 
-	return colldb_hash_table[i];
+/* The cell of pos, which is added (as 0) if it isn't there yet. */
+unsigned short* colldb_add_cell(POSITION pos)
+{
+	unsigned short *cell;
+	POSITION mixed, slot;
+
+	if ((cell = colldb_find_cell(pos)) != NULL)
+		return cell;
+	if (colldb_migrating)
+		colldb_migrate(COLLDB_MIGRATE_STEP);
+	if (colldb_table.count + 1 > colldb_table.numGroups * COLLDB_GROUP / 8 * 7)
+		colldb_grow();
+	mixed = colldb_mix(pos);
+	while ((slot = colldb_table_insert(&colldb_table, mixed, 0)) == COLLDB_NO_SLOT)
+		colldb_grow();
+	return &colldb_table.cells[slot];
 }
 
 VALUE colldb_set_value(POSITION pos, VALUE val)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
-
-	if(ptr == NULL)
-		ptr = colldb_add_node(pos);
+	unsigned short *cell = colldb_add_cell(pos);
 
-	ptr->myValue = (ptr->myValue & ~VALUE_MASK) | (val & VALUE_MASK);
+	*cell = (*cell & ~VALUE_MASK) | (val & VALUE_MASK);
 
-	return (ptr->myValue & VALUE_MASK);
+	return (*cell & VALUE_MASK);
 }
 
 VALUE colldb_get_value(POSITION pos)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	unsigned short *cell = colldb_find_cell(pos);
 
-	if(ptr == NULL)
+	if(cell == NULL)
 		return undecided;
 
-	return (ptr->myValue & VALUE_MASK);
-
+	return (*cell & VALUE_MASK);
 }
 
 REMOTENESS colldb_get_remoteness(POSITION pos)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	unsigned short *cell = colldb_find_cell(pos);
 
-	if(ptr == NULL) {
-		//printf("HAHAHAHAHAHAHAHAHAHAHAHAHAHAHAHAHAH!!!!!\n\n\n\n\n");
+	if(cell == NULL)
 		return 0;
-	}
-
-	return (ptr->myValue & REMOTENESS_MASK) >> REMOTENESS_SHIFT;
 
+	return (*cell & REMOTENESS_MASK) >> REMOTENESS_SHIFT;
 }
 
 void colldb_set_remoteness (POSITION pos, REMOTENESS val)
 {
-	colldb_value_node *ptr;
+	unsigned short *cell = colldb_add_cell(pos);
 
-/*
-   if(remoteness > REMOTENESS_MAX) {
-    printf("Remoteness request (%d) for " POSITION_FORMAT  " larger than Max Remoteness (%d)\n",remoteness,position,REMOTENESS_MAX);
-    ExitStageRight();
-    exit(0);
-   }
- */
-	//printf("pos: %llu, remoteness: %d\n", pos, val);
+	*cell = (*cell & ~REMOTENESS_MASK) | (val << REMOTENESS_SHIFT);
+}
+
+BOOLEAN colldb_check_visited(POSITION pos)
+{
+	unsigned short *cell = colldb_find_cell(pos);
 
-	ptr = colldb_find_pos(pos);
+	if(cell == NULL)
+		return FALSE;
+
+	return ((*cell & VISITED_MASK) == VISITED_MASK);
+}
 
-	if(ptr == NULL)
-		ptr = colldb_add_node(pos);
+void colldb_mark_visited (POSITION pos)
+{
+	unsigned short *cell = colldb_add_cell(pos);
 
-	ptr->myValue = (ptr->myValue & ~REMOTENESS_MASK) | (val << REMOTENESS_SHIFT);
+	*cell = *cell | VISITED_MASK;
 }
 
-BOOLEAN colldb_check_visited(POSITION pos)
+void colldb_unmark_visited (POSITION pos)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	unsigned short *cell = colldb_find_cell(pos);
 
-	if(ptr == NULL)
-		return FALSE;
+	if(cell == NULL)
+		return;
 
-	//printf("check pos: %llu, %d\n", pos, ptr->myValue & VISITED_MASK);
+	*cell = *cell & ~VISITED_MASK;
+}
 
-	return ((ptr->myValue & VISITED_MASK) == VISITED_MASK);
+void colldb_set_mex(POSITION pos, MEX mex)
+{
+	unsigned short *cell = colldb_add_cell(pos);
+
+	*cell = (*cell & (~MEX_MASK)) | (mex << MEX_SHIFT);
 }
 
-void colldb_mark_visited (POSITION pos)
+MEX colldb_get_mex(POSITION pos)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	unsigned short *cell = colldb_find_cell(pos);
 
-	if(ptr == NULL)
-		ptr = colldb_add_node(pos);
+	if (cell == NULL)
+		return 0;
 
-	//printf("mark pos: %llu\n", pos);
+	return (MEX)((*cell & MEX_MASK) >> MEX_SHIFT);
+}
 
-	ptr->myValue = ptr->myValue | VISITED_MASK;
+/* One probe per position for all of the fields asked for. The home groups
+   are prefetched first. A missing position reads as 0. */
+void colldb_get_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i;
+	unsigned short *cell;
+
+	for (i = 0; i < length; i++)
+		__builtin_prefetch(colldb_table.ctrl + (colldb_mix(positions[i]) >> colldb_table.remBits) * COLLDB_GROUP);
+	for (i = 0; i < length; i++) {
+		cell = colldb_find_cell(positions[i]);
+		db_unpack_cell((cell == NULL) ? 0 : *cell, i, values, remotenesses, mexes);
+		if (winbys != NULL) winbys[i] = 0;
+	}
 }
 
-void colldb_unmark_visited (POSITION pos)
+void colldb_put_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	int i;
+	unsigned short *cell;
 
-	if(ptr == NULL) {
-		//printf("this should never happen!!! unmark_visited\n");
-		return;
+	for (i = 0; i < length; i++) {
+		cell = colldb_add_cell(positions[i]);
+		*cell = db_pack_cell(*cell, i, values, remotenesses, mexes);
 	}
+}
 
-	//printf("unmark pos: %llu\n", pos);
+/* Positions go into the file big-endian, so it can be read on any machine. */
+static BOOLEAN colldb_write_position(gzFile filep, POSITION pos)
+{
+	unsigned int words[2];
 
-	ptr->myValue = ptr->myValue & ~VISITED_MASK;
+	words[0] = htonl((unsigned int) (pos >> 32));
+	words[1] = htonl((unsigned int) pos);
+	return gzwrite(filep, words, sizeof(words)) == sizeof(words);
 }
 
-void colldb_set_mex(POSITION pos, MEX mex)
+static BOOLEAN colldb_read_position(gzFile filep, POSITION *pos)
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	unsigned int words[2];
 
-	if (ptr == NULL) {
-		//printf("this should never happen, but I will do it anyway. set_mex\n");
-		ptr = colldb_add_node(pos);
+	if (gzread(filep, words, sizeof(words)) != sizeof(words))
+		return FALSE;
+	*pos = ((POSITION) ntohl(words[0]) << 32) | ntohl(words[1]);
+	return TRUE;
+}
+
+/* The file holds the version, the number of positions of the game, how many
+   positions were stored, and then each of them with its cell. Cells that
+   are 0 read the same as missing ones and are left out. */
+BOOLEAN colldb_save_database()
+{
+	COLLDB_TABLE *table = &colldb_table;
+	POSITION slot, count = 0, mixed, home;
+	unsigned short ver, cell;
+	unsigned char ctrl;
+	BOOLEAN good;
+	gzFile filep;
+
+	if (table->ctrl == NULL)
+		return FALSE;
+	if (colldb_migrating)
+		colldb_migrate(colldb_old_table.numGroups);
+	for (slot = 0; slot < table->numGroups * COLLDB_GROUP; slot++)
+		if (table->ctrl[slot] != 0 && table->cells[slot] != 0)
+			count++;
+
+	mkdir("data", 0755);
+	sprintf(colldb_filename, "./data/m%s_%d_colldb.dat.gz", kDBName, getOption());
+	if ((filep = gzopen(colldb_filename, "wb")) == NULL) {
+		if (kDebugDetermineValue) {
+			printf("Unable to create compressed data file\n");
+		}
+		return FALSE;
+	}
+	ver = htons(COLLDB_FILEVER);
+	good = gzwrite(filep, &ver, sizeof(ver)) == sizeof(ver) &&
+	       colldb_write_position(filep, gNumberOfPositions) &&
+	       colldb_write_position(filep, count);
+	for (slot = 0; good && slot < table->numGroups * COLLDB_GROUP; slot++) {
+		ctrl = table->ctrl[slot];
+		if (ctrl == 0 || table->cells[slot] == 0)
+			continue;
+		home = (slot / COLLDB_GROUP - (ctrl - 1)) & (table->numGroups - 1);
+		mixed = (home << table->remBits) | colldb_get_rem(table, slot);
+		cell = htons(table->cells[slot]);
+		good = colldb_write_position(filep, colldb_unmix_pos(mixed)) &&
+		       gzwrite(filep, &cell, sizeof(cell)) == sizeof(cell);
 	}
+	good = (gzclose(filep) == Z_OK) && good;
 
-	ptr->myValue = (ptr->myValue & (~MEX_MASK)) | (mex << MEX_SHIFT);
+	if (good) {
+		if (kDebugDetermineValue && !gJustSolving) {
+			printf("File Successfully compressed\n");
+		}
+		return TRUE;
+	}
+	if (kDebugDetermineValue) {
+		fprintf(stderr, "\nError writing %s\n", colldb_filename);
+	}
+	remove(colldb_filename);
+	return FALSE;
 }
 
-MEX colldb_get_mex(POSITION pos)
+BOOLEAN colldb_load_database()
 {
-	colldb_value_node *ptr = colldb_find_pos(pos);
+	POSITION numPos, count, i, pos;
+	unsigned short ver, cell;
+	BOOLEAN good;
+	gzFile filep;
 
-	if (ptr == NULL) {
-		//printf("you are trying to access a cell that is not in the db already.\n");
-		return 0;
+	sprintf(colldb_filename, "./data/m%s_%d_colldb.dat.gz", kDBName, getOption());
+	if ((filep = gzopen(colldb_filename, "rb")) == NULL)
+		return FALSE;
+	good = gzread(filep, &ver, sizeof(ver)) == sizeof(ver) && ntohs(ver) == COLLDB_FILEVER &&
+	       colldb_read_position(filep, &numPos) && numPos == gNumberOfPositions &&
+	       colldb_read_position(filep, &count);
+	if (good) {
+		// start at about the size the table had, rather than growing up to it
+		colldb_table_free(&colldb_table);
+		if (colldb_migrating)
+			colldb_table_free(&colldb_old_table);
+		colldb_migrating = FALSE;
+		i = COLLDB_MIN_GROUP_BITS;
+		while (i + 1 < (POSITION) colldb_mix_bits && (1ULL << i) * COLLDB_GROUP / 8 * 7 < count)
+			i++;
+		colldb_table_init(&colldb_table, (int) i);
 	}
+	for (i = 0; good && i < count; i++) {
+		good = colldb_read_position(filep, &pos) && pos < gNumberOfPositions &&
+		       gzread(filep, &cell, sizeof(cell)) == sizeof(cell);
+		if (good)
+			*colldb_add_cell(pos) = ntohs(cell);
+	}
+	gzclose(filep);
 
-	return (MEX)((ptr->myValue & MEX_MASK) >> MEX_SHIFT);
-
+	if (good) {
+		if (kDebugDetermineValue) {
+			printf("File Successfully Decompressed\n");
+		}
+		return TRUE;
+	}
+	colldb_free();
+	colldb_table_init(&colldb_table, COLLDB_MIN_GROUP_BITS);
+	if (kDebugDetermineValue) {
+		printf("\n\nError in file decompression: %s is not a collision database of this game\n", colldb_filename);
+	}
+	return FALSE;
 }
@@ -187,40 +187,62 @@ STRING kSolveVersion = "2006.01.01";
 
 STRING kCommandSyntaxHelp =
         "\nSyntax:\n"
-        "%s  {--nodb | --newdb | --filedb | --numoptions | --curroption |\n"
+        "%s  {--nodb | --newdb | --filedb | --filedbmem <MB> |\n"
+        "\t--filedbreadahead <n> | --numoptions | --curroption |\n"
         "\t--option <n> | --nobpdb | --2bit | --colldb | --univdb | --gps |\n"
-        "\t--bottomup | --alpha-beta | --lowmem | --slicessolver | --schemes |\n"
-        "\t--allschemes | --adjust | --noadjust | --solve [<n> | <all>] |\n"
+        "\t--bottomup | --alpha-beta | --lowmem | --valueonly | --slicessolver |\n"
+        "\t--schemes | --allschemes | --adjust | --noadjust | --solve [<n> | <all>] |\n"
         "\t--analyze [ <linkname> ] | --open | --visualize |\n"
         "\t--DoMove <args> <move> | --Primitive <args> | --PrintPosition <args> |\n"
-        "\t--GenerateMoves <args>} | --lightplayer | --netDb | --hashCounting |\n"
+        "\t--GenerateMoves <args>} | --lightplayer | --netDb [<url>] |\n"
+        "\t--netcache <n> | --hashCounting |\n"
         "\t--help}\n\n"
         "--export <filename>\t\t\tSolves the game (if needed) then exports to filename.\n"
         "--interact\t\t\tSolves the game (if needed) then enters server interaction mode.\n"
         "--nodb\t\t\tStarts game without loading or saving to the database.\n"
         "--newdb\t\t\tStarts game and clobbers the old database.\n"
         "--filedb\t\tStarts game with file-based database.\n"
+        "--filedbmem <MB>\tKeeps at most <MB> megabytes of the file-based database in memory (default 0, no limit).\n"
+        "--filedbreadahead <n>\tReads <n> pages ahead of a sequential sweep of the file-based database and writes\n"
+        "\t\t\tevicted pages in the background (default 8, 0 for neither).\n"
         "--numoptions\t\tPrints the number of options.\n"
         "--curroption\t\tPrints the current option.\n"
         "--option <n>\t\tStarts game with the n option configuration.\n"
         "--nobpdb\t\tStarts game without using Bit Perfect Database.\n"
         "--2bit\t\t\tStarts game with two-bit solving enabled.\n"
-        "--colldb\t\tStarts game with Collision based Database. Currently Experimental. \n"
+        "--colldb\t\tStarts game with a database holding only the positions reached, for games whose hash\n\t\t\tis much bigger than their set of reachable positions.\n"
 #ifdef HAVE_GMP
         "--univdb\t\tStarts game with 2-Universal hash-based resizable database. \n"
 #endif
         "--gps\t\t\tStarts game with global position solver enabled.\n"
         "--bottomup\n"
         "--alpha-beta\t\tStarts game with weak alpha-beta solver. \n"
+        "--abtable <MB>\t\tGives the alpha-beta solver a <MB> megabyte transposition table (default 64).\n"
         "--lowmem\t\tStarts game with low memory overhead solver enabled.\n"
+        "--valueonly\t\tSolves only for win, lose or tie (no remoteness) into a two-bit database,\n"
+        "\t\t\twhich is saved so it can be mmap'd when playing. Tier games keep their tier\n"
+        "\t\t\tsolver and database, and store no remoteness for their non-loopy tiers.\n"
         "--slicessolver\t\tWith bpdb turned on, the variable slice aware solver will be used (faster).\n"
         "--schemes\t\tWith bpdb turned on variable gaps compression will be used for saved dbs.\n"
         "--allschemes\n"
         "--adjust\t\tWith bpdb turned on, slice sizes will be grow and shrink to best-fit data.\n"
         "--noadjust\n"
+        "--bpdbconcurrent\tWith bpdb turned on, slots are written atomically so several threads can solve into it\n"
+        "\t\t\t(used by --bottomup with --workers).\n"
         "--notiers\t\tStarts game with Tier-Gamesman Mode OFF by default.\n"
         "--notiermenu\t\tThis option disables the Tier-Gamesman solver menu, and auto-solves all tiers.\n"
         "--notierprint\t\tThis option disables the printing from the Tier-Gamesman solver menu.\n"
+        "--workers <n>\t\tSolves each tier with <n> parallel workers (Tier-Gamesman only),\n"
+        "\t\t\tor runs the alpha-beta search with <n> workers sharing one table,\n"
+        "\t\t\tor each stage of --bottomup with <n> threads (needs --bpdbconcurrent).\n"
+        "--tierjobs <n>\t\tWithout the tier menu, solves up to <n> tiers or tier slices at once in separate processes.\n"
+        "--frontiermem <MB>\tKeeps at most <MB> megabytes of solver frontier in memory, spilling the rest to disk.\n"
+        "--checkpoint <s>\tSaves the state of the tier being solved every <s> seconds (Tier-Gamesman only);\n"
+        "\t\t\ta killed solve started again picks up from the last save.\n"
+        "--tiercache <MB>\tKeeps up to <MB> megabytes of loaded tier databases when playing (default 256).\n"
+        "--movetable\t\tAfter solving, saves a summary of the best moves of every position next to the\n"
+        "\t\t\tdatabase, so the computer and --interact look up fewer children. A saved\n"
+        "\t\t\ttable is used whenever it is there.\n"
         "--solve [<n> | <all>]\tSolves game with the n option configuration.\n"
         "\t\t\tTo solve all option configurations of game, use <all>.\n"
         "\t\t\tIf <n> and <all> are ommited, it will solve the default\n"
@@ -237,8 +259,11 @@ STRING kCommandSyntaxHelp =
         "--PrintPosition <pos>\tPrints the ASCII representation of the position.\n"
         "--GenerateMoves <pos>\tGenerates all possible moves from position.\n"
         "--lightplayer\t\tHints the database to minimize memory usage.\n"
-        "--netDb\t\t\tStarts game with the network database.\n"
+        "--netDb [<url>]\t\tStarts game with the network database, served from url (host:port/path).\n"
+        "--netcache <n>\t\tNumber of cells the network database keeps cached (default 65536, 0 for none).\n"
         "--hashCounting\t\tStarts the generic-hash counting tool instead of the game.\n"
+        "--canonbench\t\tTimes canonicalizing positions from random playouts, one at a time and in a batch.\n"
+        "--hashbench\t\tTimes the table-driven generic hash against the original one for this game.\n"
         "--hashtable_buckets\t(advanced) Sets the total number of buckets in any hashtables used.\n"
         "--withPen <file>\tStarts game with Anoto Pen support, reading data from <file> (with GUI only)\n"
         "--penDebug\t\tEnables Anoto Pen log messages / data saving to 'bin/pen/' (with GUI only)\n\n";
@@ -77,11 +77,18 @@ void            db_put_winby            (POSITION pos, WINBY winBy);
 BOOLEAN         db_save_database        ();
 BOOLEAN         db_load_database        ();
 void            db_get_bulk             (POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
+void            db_get_bulk_data        (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void            db_put_bulk_data        (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+POSITION*       db_bulk_scratch         (int length);
 
 /*internal variables*/
 
 DB_Table *db_functions;
 
+/* canonical positions for the bulk calls */
+POSITION *db_bulkPositions = NULL;
+int db_bulkSize = 0;
+
 /*
 ** function code
 */
@@ -111,6 +118,11 @@ void db_create() {
 	db_functions->load_database = db_load_database;
 	db_functions->free_db = db_free;
 	db_functions->get_bulk = db_get_bulk;
+	db_functions->get_bulk_data = db_get_bulk_data;
+	db_functions->put_bulk_data = db_put_bulk_data;
+	db_functions->get_range_data = NULL;
+	db_functions->begin_concurrent = NULL;
+	db_functions->end_concurrent = NULL;
 }
 
 void db_destroy() {
@@ -242,11 +254,37 @@ BOOLEAN db_load_database(){
 }
 
 void db_get_bulk (POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length) {
+	GetPositionDataBulk(positions, length, ValueArray, remotenessArray, NULL, NULL);
+}
+
+/* for DBs without bulk access of their own: one call per position and field */
+void db_get_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys) {
+	int i;
+	for (i = 0; i < length; i++) {
+		if (values != NULL) values[i] = db_functions->get_value(positions[i]);
+		if (remotenesses != NULL) remotenesses[i] = db_functions->get_remoteness(positions[i]);
+		if (mexes != NULL) mexes[i] = db_functions->get_mex(positions[i]);
+		if (winbys != NULL) winbys[i] = db_functions->get_winby(positions[i]);
+	}
+}
+
+void db_put_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys) {
 	int i;
 	for (i = 0; i < length; i++) {
-		ValueArray[i] = GetValueOfPosition(positions[i]);
-		remotenessArray[i] = Remoteness(positions[i]);
+		if (remotenesses != NULL) db_functions->put_remoteness(positions[i], remotenesses[i]);
+		if (mexes != NULL) db_functions->put_mex(positions[i], mexes[i]);
+		if (winbys != NULL) db_functions->put_winby(positions[i], winbys[i]);
+		if (values != NULL) db_functions->put_value(positions[i], values[i]);
+	}
+}
+
+POSITION* db_bulk_scratch(int length) {
+	if (length > db_bulkSize) {
+		if (db_bulkPositions != NULL) SafeFree(db_bulkPositions);
+		db_bulkSize = (length > 64) ? length : 64;
+		db_bulkPositions = (POSITION*) SafeMalloc(db_bulkSize * sizeof(POSITION));
 	}
+	return db_bulkPositions;
 }
 
 void CreateDatabases()
@@ -290,8 +328,6 @@ SetSlot(
 {
 	if(gSymmetries)
 		position = gCanonicalPosition(position);
-	if(index == gValueSlot)
-		AnalyzePosition(position, value);
 	return db_functions->set_slice_slot(position, index, value);
 }
 
@@ -328,11 +364,20 @@ VALUE StoreValueOfPosition(POSITION position, VALUE value)
 
 	if(gSymmetries)
 		position = gCanonicalPosition(position);
-	AnalyzePosition(position,value);
 	return db_functions->put_value(position,value);
 }
 
 
+/* Stores both value and remoteness of a position that is already canonical,
+   without the status meter. The parallel solvers use this; it is safe to
+   call from several threads as long as no two of them store the same
+   position. */
+void StoreValueAndRemotenessOfCanonical(POSITION position, VALUE value, REMOTENESS remoteness)
+{
+	db_functions->put_bulk_data(&position, 1, &value, &remoteness, NULL, NULL);
+}
+
+
 VALUE GetValueOfPosition(POSITION position)
 {
 	if(((gMenuMode != Analysis) || gMenuMode == Evaluated) && gSymmetries)
@@ -442,3 +487,85 @@ BOOLEAN LoadDatabase() {
 void GetValueAndRemotenessOfPositionBulk(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length) {
 	db_functions->get_bulk(positions, ValueArray, remotenessArray, length);
 }
+
+/* The bulk versions of GetValueOfPosition, Remoteness, MexLoad and WinByLoad
+   (for the arrays that aren't NULL), with one call into the DB. */
+void GetPositionDataBulk(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys) {
+	POSITION* canonical;
+	int i;
+
+	if (length <= 0)
+		return;
+	if (!gSymmetries) {
+		db_functions->get_bulk_data(positions, length, values, remotenesses, mexes, winbys);
+	} else {
+		canonical = db_bulk_scratch(length);
+		CanonicalPositionBulk(positions, canonical, length);
+		if (gMenuMode != Analysis) {
+			db_functions->get_bulk_data(canonical, length, values, remotenesses, mexes, winbys);
+		} else { // like GetValueOfPosition, values and remotenesses aren't canonicalized in analysis
+			db_functions->get_bulk_data(positions, length, values, remotenesses, NULL, NULL);
+			db_functions->get_bulk_data(canonical, length, NULL, NULL, mexes, winbys);
+		}
+	}
+	if (winbys != NULL)
+		for (i = 0; i < length; i++)
+			if (winbys[i] > ((1 << (MEX_BITS-1))-1))
+				winbys[i] |= ~MEX_MAX;
+}
+
+/* The bulk version of SetRemoteness, MexStore, WinByStore and then
+   StoreValueOfPosition (for the arrays that aren't NULL). */
+void StorePositionDataBulk(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys) {
+	int i;
+
+	if (length <= 0)
+		return;
+	if (gSymmetries) {
+		POSITION* canonical = db_bulk_scratch(length);
+		CanonicalPositionBulk(positions, canonical, length);
+		positions = canonical;
+	}
+	if (values != NULL)
+		for (i = 0; i < length; i++)
+			showStatus(Update);
+	db_functions->put_bulk_data(positions, length, values, remotenesses, mexes, winbys);
+}
+
+/* The value and remoteness in the cells of positions start to
+   start+length-1, without canonicalizing; for scans over the whole DB. */
+BOOLEAN GetRawDataRangeIsThreadSafe() {
+	return db_functions->get_range_data != NULL;
+}
+
+void GetRawDataRange(POSITION start, int length, VALUE* values, REMOTENESS* remotenesses) {
+	POSITION* positions;
+	int i;
+
+	if (db_functions->get_range_data != NULL) {
+		db_functions->get_range_data(start, length, values, remotenesses);
+		return;
+	}
+	positions = db_bulk_scratch(length);
+	for (i = 0; i < length; i++)
+		positions[i] = start + i;
+	db_functions->get_bulk_data(positions, length, values, remotenesses, NULL, NULL);
+}
+
+/* Between BeginConcurrentStores and EndConcurrentStores several threads
+   may use GetPositionDataBulk and StoreValueAndRemotenessOfCanonical on
+   canonical positions, as long as no two store the same one. Stores may
+   only be seen by reads once EndConcurrentStores has returned. */
+BOOLEAN ConcurrentStoresSupported() {
+	return db_functions->begin_concurrent != NULL && !gSymmetries;
+}
+
+void BeginConcurrentStores() {
+	if (db_functions->begin_concurrent != NULL)
+		db_functions->begin_concurrent();
+}
+
+void EndConcurrentStores() {
+	if (db_functions->end_concurrent != NULL)
+		db_functions->end_concurrent();
+}
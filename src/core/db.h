@@ -84,8 +84,39 @@ typedef struct DB {
 
 	void (*get_bulk)(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
 
+	/* the fields of length positions at once. Any of the arrays may be NULL,
+	   and that field is then skipped. put_bulk_data stores the value last. */
+	void (*get_bulk_data)(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+	void (*put_bulk_data)(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+
+	/* reads the cells of positions start to start+length-1 as they are.
+	   Only DBs that can do this from several threads at once set it. */
+	void (*get_range_data)(POSITION start, int length, VALUE* values, REMOTENESS* remotenesses);
+
+	/* bracket the part where several threads read and store distinct
+	   positions at once. Only DBs that allow this set them. */
+	void (*begin_concurrent)();
+	void (*end_concurrent)();
+
 } DB_Table;
 
+/* For DBs whose cells use the masks above: unpacks/packs the fields of
+   entry i of the bulk arrays that aren't NULL. */
+static inline void db_unpack_cell(int cell, int i, VALUE* values, REMOTENESS* remotenesses, MEX* mexes)
+{
+	if (values != NULL) values[i] = (VALUE)(cell & VALUE_MASK);
+	if (remotenesses != NULL) remotenesses[i] = (REMOTENESS)((cell & REMOTENESS_MASK) >> REMOTENESS_SHIFT);
+	if (mexes != NULL) mexes[i] = (MEX)((cell & MEX_MASK) >> MEX_SHIFT);
+}
+
+static inline int db_pack_cell(int cell, int i, VALUE* values, REMOTENESS* remotenesses, MEX* mexes)
+{
+	if (remotenesses != NULL) cell = (cell & ~REMOTENESS_MASK) | (remotenesses[i] << REMOTENESS_SHIFT);
+	if (mexes != NULL) cell = (cell & ~MEX_MASK) | ((mexes[i] & MEX_MAX) << MEX_SHIFT);
+	if (values != NULL) cell = (cell & ~VALUE_MASK) | (values[i] & VALUE_MASK);
+	return cell;
+}
+
 typedef struct db_list_struct {
 	DB_Table *db;
 	struct db_list_struct *next_db;
@@ -138,6 +169,7 @@ Allocate( );
 /* Value */
 VALUE           GetValueOfPosition      (POSITION pos);
 VALUE           StoreValueOfPosition    (POSITION pos, VALUE val);
+void            StoreValueAndRemotenessOfCanonical (POSITION pos, VALUE val, REMOTENESS rem);
 
 /* Remoteness */
 REMOTENESS      Remoteness              (POSITION pos);
@@ -163,5 +195,12 @@ BOOLEAN         LoadDatabase            ();
 
 //bulk
 void GetValueAndRemotenessOfPositionBulk(POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
+void GetPositionDataBulk(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void StorePositionDataBulk(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+BOOLEAN GetRawDataRangeIsThreadSafe();
+void GetRawDataRange(POSITION start, int length, VALUE* values, REMOTENESS* remotenesses);
+BOOLEAN ConcurrentStoresSupported();
+void BeginConcurrentStores();
+void EndConcurrentStores();
 
 #endif /* GMCORE_DB_H */
@@ -37,6 +37,8 @@
 
 typedef short cellValue;
 
+#define FILEDB_PAGE_RECORDS 4196
+
 BOOLEAN start;
 POSITION mypos;
 cellValue myvalue;
@@ -95,8 +97,13 @@ void filedb_init(DB_Table *new_db)
 	gamesdb_pageid max_pages = 0;
 
 	if (gZeroMemPlayer) max_pages = 1;
+	else if (gFileDBMemoryMB > 0) {
+		max_pages = ((gamesdb_pageid)gFileDBMemoryMB << 20) / (sizeof(cellValue) * FILEDB_PAGE_RECORDS);
+		if (max_pages == 0) max_pages = 1;
+	}
 
-	mydb = gamesdb_create(sizeof(cellValue), 4196, max_pages, 10, dirname);
+	mydb = gamesdb_create(sizeof(cellValue), FILEDB_PAGE_RECORDS, max_pages, 10, dirname);
+	gamesdb_io_start(mydb, GAMESDB_IO_THREADS, gFileDBReadahead);
 
 	start = FALSE;
 	mypos = 0;
@@ -224,6 +231,8 @@ MEX filedb_get_mex(POSITION pos)
 BOOLEAN filedb_save_database()
 {
 	gamesdb_buf_flush_all(mydb);
+	if (gPrintDatabaseInfo)
+		gamesdb_print_stats(mydb);
 	return TRUE;
 }
 
@@ -43,6 +43,7 @@ static gamesdb_frameid gamesdb_translate(gamesdb* db, gamesdb_pageid vpn) {
 	gamesdb_frameid ppn = gamesdb_bman_find(db, vpn); //see if it is in physical memory
 
 	if (ppn == NULL) { //the page is not present in physical memory
+		db->stats.misses++;
 		ppn = gamesdb_bman_replace(db, vpn); //get a replacement page, change page table in the process
 
 		if (ppn->valid == GAMESDB_TRUE) {
@@ -63,6 +64,9 @@ static gamesdb_frameid gamesdb_translate(gamesdb* db, gamesdb_pageid vpn) {
 			//if (ppn->tag != vpn)
 			//the buffer is uninitialized, this means no record exists in the page
 		}
+		gamesdb_io_readahead(db, vpn);
+	} else {
+		db->stats.hits++;
 	}
 
 	if (GAMESDB_DEBUG) {
@@ -91,6 +95,8 @@ gamesdb* gamesdb_create(int rec_size, gamesdb_pageid max_recs, gamesdb_pageid ma
 
 	data->buf_man = bman;
 	data->buffer = bufp;
+	data->io = NULL;
+	memset(&data->stats, 0, sizeof(gamesdb_stats));
 
 	storep = gamesdb_open(data, db_name, cluster_size);
 	if (storep == NULL) {
@@ -110,12 +116,24 @@ void gamesdb_destroy(gamesdb* data){
 
 	gamesdb_bman_destroy(data->buf_man);
 	gamesdb_buf_destroy(data);
+	gamesdb_io_stop(data);
 	gamesdb_close(data->store);
 	gamesdb_SafeFree(data);
 
 }
 
 
+void gamesdb_print_stats(gamesdb* gdb){
+	gamesdb_stats* stats = &gdb->stats;
+	unsigned long long lookups = stats->hits + stats->misses;
+
+	printf("\nFile database: %llu page lookups, %.1f%% found in memory, %llu pages read ahead (%llu used), "
+	       "%llu written behind, %.2f seconds waiting on disk\n",
+	       lookups, lookups ? 100.0 * stats->hits / lookups : 100.0,
+	       stats->read_ahead, stats->read_ahead_used, stats->written_behind, stats->stall);
+}
+
+
 void gamesdb_get(gamesdb* gdb, char* mem, gamesdb_position pos){
 	gamesdb_buffer* bufp = gdb->buffer;
 
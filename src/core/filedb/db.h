@@ -38,11 +38,13 @@
 #include "db_bman.h"
 #include "db_malloc.h"
 #include "db_basichash.h"
+#include "db_io.h"
 
 
 gamesdb*        gamesdb_create  (int rec_size, gamesdb_pageid max_recs, gamesdb_pageid max_pages, int cluster_size, char* db_name);
 void            gamesdb_destroy (gamesdb* data);
 void            gamesdb_get             (gamesdb* gdb, char* mem, gamesdb_position pos);
 void            gamesdb_put             (gamesdb* gdb, char* mem, gamesdb_position pos);
+void            gamesdb_print_stats     (gamesdb* gdb);
 
 #endif /* GMCORE_GAMESDB_H */
@@ -66,31 +66,17 @@ gamesdb_frameid gamesdb_bman_find(gamesdb* db, gamesdb_pageid id){
 gamesdb_frameid gamesdb_bman_replace(gamesdb* db, gamesdb_pageid vpn) {
 	gamesdb_buffer* bufp = db->buffer;
 
-	//find free space, if found make hash changes, return
-	gamesdb_bufferpage* page = bufp->pages;
-
 	gamesdb_bhash *bhash = db->buf_man->hash;
-
-	for (; page!= NULL; page = page->next) {
-		if (page->valid == GAMESDB_FALSE) {
-			gamesdb_basichash_put(bhash, vpn, page);
-			return page;
-		}
-	}
-
-	gamesdb_bufferpage *newpage;
+	gamesdb_bufferpage* page;
 
 	//see if we have space for more physical pages, if so grow the memory pool
-	if (bufp->num_pages < bufp->max_pages || bufp->max_pages == 0) {
+	if (bufp->free_pages == NULL && (bufp->num_pages < bufp->max_pages || bufp->max_pages == 0)) {
 
 		if (GAMESDB_DEBUG) {
 			printf("db_bufman: Growing the page pool.\n");
 		}
 
-		if ((newpage = gamesdb_buf_addpage(db)) != NULL) {
-			gamesdb_basichash_put(bhash, vpn, newpage);
-			return newpage;
-		} else { //shrink
+		if (gamesdb_buf_addpage(db) == NULL) { //shrink
 			gamesdb_pageid initial = bufp->num_pages >> 1;
 			if (initial == 0) {
 				initial = 1;
@@ -101,6 +87,14 @@ gamesdb_frameid gamesdb_bman_replace(gamesdb* db, gamesdb_pageid vpn) {
 		}
 	}
 
+	//take a frame off the free list if there is one, make hash changes, return
+	if ((page = bufp->free_pages) != NULL) {
+		bufp->free_pages = page->next_free;
+		page->next_free = NULL;
+		gamesdb_basichash_put(bhash, vpn, page);
+		return page;
+	}
+
 	//otherwise, pick one from n-chance, make page table changes, and return
 	if (GAMESDB_DEBUG) {
 		printf("db_bufman: No more free pages in page table. Evicting one page using n-chance.\n");
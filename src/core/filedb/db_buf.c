@@ -33,6 +33,8 @@
 #include "db_buf.h"
 #include "db_malloc.h"
 #include "db_store.h"
+#include "db_io.h"
+#include "db_basichash.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -48,6 +50,7 @@ gamesdb_buffer* gamesdb_buf_init(gamesdb_pageid rec_size, gamesdb_pageid max_rec
 	bufp->rec_size = rec_size;
 	bufp->buf_size = max_recs;
 	bufp->pages = NULL;
+	bufp->free_pages = NULL;
 
 	return bufp;
 }
@@ -69,6 +72,8 @@ gamesdb_bufferpage *gamesdb_buf_addpage(gamesdb* db) {
 	buf->dirty = GAMESDB_FALSE;
 	buf->next = bufp->pages;
 	bufp->pages = buf;
+	buf->next_free = bufp->free_pages;
+	bufp->free_pages = buf;
 	bufp->num_pages++;
 	return buf;
 }
@@ -84,7 +89,17 @@ void gamesdb_buf_removepage(gamesdb *db) {
 		printf("db_buf: There is only one page in the pool. Cannot shrink anymore.");
 		return;
 	}
-	gamesdb_buf_write(db, oldhead);
+	if (oldhead->valid == GAMESDB_TRUE) {
+		gamesdb_buf_write(db, oldhead);
+		gamesdb_basichash_remove(db->buf_man->hash, oldhead->tag);
+	} else { //take it off the free list
+		gamesdb_bufferpage **link = &db->buffer->free_pages;
+		while (*link != oldhead)
+			link = &(*link)->next_free;
+		*link = oldhead->next_free;
+	}
+	if (db->buf_man->clock_hand == oldhead)
+		db->buf_man->clock_hand = newhead;
 	gamesdb_SafeFree(oldhead->mem);
 	gamesdb_SafeFree(oldhead);
 	db->buffer->pages = newhead;
@@ -104,14 +119,19 @@ int gamesdb_buf_flush_all(gamesdb* db) {
 			gamesdb_buf_write(db, buf);
 		}
 	}
+	gamesdb_io_drain(db);
 	return 0;
 }
 
 //reads a page from disk
 int gamesdb_buf_read(gamesdb* db, gamesdb_frameid spot, gamesdb_pageid vpn) {
 
-	//load in the new page
-	gamesdb_read(db, vpn, spot);
+	//load in the new page, from a read-ahead or write-behind copy if there is one
+	if (!gamesdb_io_read(db, spot, vpn)) {
+		double start = gamesdb_io_clock();
+		gamesdb_read(db, vpn, spot);
+		db->stats.stall += gamesdb_io_clock() - start;
+	}
 
 	assert(spot->tag == 0 || spot->tag == vpn);
 	assert(spot->dirty == GAMESDB_FALSE);
@@ -139,7 +159,11 @@ int gamesdb_buf_write(gamesdb* db, gamesdb_frameid spot){
 	//we don't have to write the page if it's clean
 	if(spot->dirty == GAMESDB_TRUE) {
 		spot->chances = 0;
-		gamesdb_write(db, spot->tag, spot);
+		if (!gamesdb_io_write(db, spot)) {
+			double start = gamesdb_io_clock();
+			gamesdb_write(db, spot->tag, spot);
+			db->stats.stall += gamesdb_io_clock() - start;
+		}
 		spot->dirty = GAMESDB_FALSE;
 		if (GAMESDB_DEBUG) {
 			printf("buf_write: spot = %u, buf_tag = %llu\n", (unsigned int)spot, spot->tag);
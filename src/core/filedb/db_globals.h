@@ -45,4 +45,7 @@
 
 #define GAMESDB_GEOMETRY_FILENAME "geometry.dat"
 
+#define GAMESDB_IO_THREADS 2 //background threads reading ahead and writing behind
+#define GAMESDB_IO_WRITE_SLOTS 8 //evicted pages that may wait to be written
+
 #endif /* GMCORE_DB_GLOBALS_H */
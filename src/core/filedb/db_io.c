@@ -0,0 +1,361 @@
+/************************************************************************
+**
+** NAME:	db_io.c
+**
+** DESCRIPTION:	Background page reads and writes.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "db_types.h"
+#include "db_io.h"
+#include "db_bman.h"
+#include "db_store.h"
+#include "db_malloc.h"
+
+/* A few threads read pages ahead of a sequential run of misses, and write
+ * out the dirty pages the buffer manager evicts, so the caller only waits on
+ * the disk for a page nobody saw coming. Every page in flight sits in one of
+ * a fixed set of slots with its own copy of the data. A miss looks there
+ * before going to the disk, since a page being written is newer than its
+ * file.
+ *
+ * Only the thread that owns the db calls in here; the I/O threads never
+ * touch the frames or the page table.
+ */
+
+#define GAMESDB_IO_FREE         0
+#define GAMESDB_IO_QUEUED_READ  1
+#define GAMESDB_IO_READING      2
+#define GAMESDB_IO_READY        3
+#define GAMESDB_IO_QUEUED_WRITE 4
+#define GAMESDB_IO_WRITING      5
+
+double gamesdb_io_clock() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//the threads belong to the process that started them, not to forked children
+static gamesdb_io* gamesdb_io_get(gamesdb* db) {
+	if (db->io == NULL || db->io->owner != getpid())
+		return NULL;
+	return db->io;
+}
+
+static void* gamesdb_io_worker(void* arg) {
+	gamesdb* db = (gamesdb*) arg;
+	gamesdb_io* io = db->io;
+	gamesdb_iopage* slot;
+
+	pthread_mutex_lock(&io->lock);
+	while (GAMESDB_TRUE) {
+		while (io->queue_len == 0 && !io->stop)
+			pthread_cond_wait(&io->work, &io->lock);
+		if (io->queue_len == 0)
+			break;
+		slot = &io->slots[io->queue[io->queue_head]];
+		io->queue_head = (io->queue_head + 1) % io->num_slots;
+		io->queue_len--;
+
+		if (slot->state == GAMESDB_IO_QUEUED_READ) {
+			slot->state = GAMESDB_IO_READING;
+			pthread_mutex_unlock(&io->lock);
+			gamesdb_read(db, slot->vpn, &slot->page);
+			pthread_mutex_lock(&io->lock);
+			slot->state = GAMESDB_IO_READY;
+		} else {
+			slot->state = GAMESDB_IO_WRITING;
+			pthread_mutex_unlock(&io->lock);
+			gamesdb_write(db, slot->vpn, &slot->page);
+			pthread_mutex_lock(&io->lock);
+			slot->state = GAMESDB_IO_FREE;
+		}
+		pthread_cond_broadcast(&io->done);
+	}
+	pthread_mutex_unlock(&io->lock);
+	return NULL;
+}
+
+//the slot holding page vpn, if any. Called with the lock held.
+static gamesdb_iopage* gamesdb_io_find(gamesdb_io* io, gamesdb_pageid vpn) {
+	int i;
+	for (i = 0; i < io->num_slots; i++) {
+		if (io->slots[i].state != GAMESDB_IO_FREE && io->slots[i].vpn == vpn) {
+			return &io->slots[i];
+		}
+	}
+	return NULL;
+}
+
+//a free slot. If drop is set and there is none, the read-ahead page least
+//likely to be used soon gives up its slot (it is still on disk).
+static gamesdb_iopage* gamesdb_io_slot(gamesdb_io* io, gamesdb_boolean drop) {
+	gamesdb_iopage *slot, *victim = NULL;
+	gamesdb_pageid distance, farthest = 0;
+	int i;
+
+	for (i = 0; i < io->num_slots; i++) {
+		slot = &io->slots[i];
+		if (slot->state == GAMESDB_IO_FREE) {
+			return slot;
+		}
+		if (drop && slot->state == GAMESDB_IO_READY) {
+			//pages the sweep went past are the first to go
+			distance = (slot->vpn <= io->last_miss) ? (gamesdb_pageid) -1 : slot->vpn - io->last_miss;
+			if (victim == NULL || distance > farthest) {
+				victim = slot;
+				farthest = distance;
+			}
+		}
+	}
+	if (victim != NULL) {
+		victim->state = GAMESDB_IO_FREE;
+	}
+	return victim;
+}
+
+static void gamesdb_io_queue(gamesdb_io* io, gamesdb_iopage* slot, int state) {
+	slot->state = state;
+	io->queue[(io->queue_head + io->queue_len) % io->num_slots] = slot - io->slots;
+	io->queue_len++;
+	pthread_cond_signal(&io->work);
+}
+
+/* Starts num_threads threads keeping up to readahead pages in flight ahead
+ * of a sequential sweep. Returns NULL (and leaves all I/O synchronous) if
+ * either is zero or no thread could be started.
+ */
+gamesdb_io* gamesdb_io_start(gamesdb* db, int num_threads, int readahead) {
+	gamesdb_buffer* bufp = db->buffer;
+	gamesdb_io* io;
+	int i;
+
+	if (num_threads <= 0 || readahead <= 0) {
+		return NULL;
+	}
+
+	io = (gamesdb_io*) gamesdb_SafeMalloc(sizeof(gamesdb_io));
+	io->num_slots = readahead + GAMESDB_IO_WRITE_SLOTS;
+	io->slots = (gamesdb_iopage*) gamesdb_SafeMalloc(sizeof(gamesdb_iopage) * io->num_slots);
+	for (i = 0; i < io->num_slots; i++) {
+		memset(&io->slots[i], 0, sizeof(gamesdb_iopage));
+		io->slots[i].page.mem = (char *) gamesdb_SafeMalloc(sizeof(char) * bufp->buf_size * bufp->rec_size);
+		io->slots[i].state = GAMESDB_IO_FREE;
+	}
+	io->queue = (int*) gamesdb_SafeMalloc(sizeof(int) * io->num_slots);
+	io->queue_head = io->queue_len = 0;
+	io->readahead = readahead;
+	io->last_miss = (gamesdb_pageid) -2; //so page 0 does not start a run
+	io->ahead = 0;
+	io->owner = getpid();
+	io->stop = GAMESDB_FALSE;
+	pthread_mutex_init(&io->lock, NULL);
+	pthread_cond_init(&io->work, NULL);
+	pthread_cond_init(&io->done, NULL);
+
+	db->io = io;
+	io->threads = (pthread_t*) gamesdb_SafeMalloc(sizeof(pthread_t) * num_threads);
+	for (io->num_threads = 0; io->num_threads < num_threads; io->num_threads++) {
+		if (pthread_create(&io->threads[io->num_threads], NULL, gamesdb_io_worker, db) != 0) {
+			break;
+		}
+	}
+	if (io->num_threads == 0) {
+		printf("db_io: could not start any I/O threads, reading and writing pages directly.\n");
+		gamesdb_io_stop(db);
+	}
+	return db->io;
+}
+
+//waits for every page on its way to disk to get there
+void gamesdb_io_drain(gamesdb* db) {
+	gamesdb_io* io = gamesdb_io_get(db);
+	int i;
+
+	if (io == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&io->lock);
+	for (i = 0; i < io->num_slots; i++) {
+		while (io->slots[i].state == GAMESDB_IO_QUEUED_WRITE || io->slots[i].state == GAMESDB_IO_WRITING) {
+			pthread_cond_wait(&io->done, &io->lock);
+		}
+	}
+	pthread_mutex_unlock(&io->lock);
+}
+
+//finishes the queued work and stops the threads
+void gamesdb_io_stop(gamesdb* db) {
+	gamesdb_io* io = db->io;
+	int i;
+
+	if (io == NULL) {
+		return;
+	}
+	if (io->owner == getpid()) {
+		pthread_mutex_lock(&io->lock);
+		io->stop = GAMESDB_TRUE;
+		pthread_cond_broadcast(&io->work);
+		pthread_mutex_unlock(&io->lock);
+		for (i = 0; i < io->num_threads; i++) {
+			pthread_join(io->threads[i], NULL);
+		}
+		pthread_mutex_destroy(&io->lock);
+		pthread_cond_destroy(&io->work);
+		pthread_cond_destroy(&io->done);
+	}
+	for (i = 0; i < io->num_slots; i++) {
+		gamesdb_SafeFree(io->slots[i].page.mem);
+	}
+	gamesdb_SafeFree(io->slots);
+	gamesdb_SafeFree(io->queue);
+	gamesdb_SafeFree(io->threads);
+	gamesdb_SafeFree(io);
+	db->io = NULL;
+}
+
+/* Fills spot with page vpn if it is in flight, waiting for it if it is
+ * still being read. Returns GAMESDB_FALSE if the page has to come from
+ * disk.
+ */
+int gamesdb_io_read(gamesdb* db, gamesdb_frameid spot, gamesdb_pageid vpn) {
+	gamesdb_io* io = gamesdb_io_get(db);
+	gamesdb_buffer* bufp = db->buffer;
+	gamesdb_iopage* slot;
+	double start;
+
+	if (io == NULL) {
+		return GAMESDB_FALSE;
+	}
+	pthread_mutex_lock(&io->lock);
+	if ((slot = gamesdb_io_find(io, vpn)) == NULL) {
+		pthread_mutex_unlock(&io->lock);
+		return GAMESDB_FALSE;
+	}
+	if (slot->state == GAMESDB_IO_QUEUED_READ || slot->state == GAMESDB_IO_READING) {
+		start = gamesdb_io_clock();
+		while (slot->state == GAMESDB_IO_QUEUED_READ || slot->state == GAMESDB_IO_READING) {
+			pthread_cond_wait(&io->done, &io->lock);
+		}
+		db->stats.stall += gamesdb_io_clock() - start;
+	}
+
+	memcpy(spot->mem, slot->page.mem, sizeof(char) * bufp->buf_size * bufp->rec_size);
+	spot->chances = slot->page.chances;
+	spot->tag = slot->page.tag;
+	//a page still being written keeps its slot until it is on disk
+	if (slot->state == GAMESDB_IO_READY) {
+		slot->state = GAMESDB_IO_FREE;
+		db->stats.read_ahead_used++;
+	}
+	pthread_mutex_unlock(&io->lock);
+	return GAMESDB_TRUE;
+}
+
+/* Queues a copy of spot to be written, so the frame can take another page
+ * right away. Returns GAMESDB_FALSE if there are no I/O threads.
+ */
+int gamesdb_io_write(gamesdb* db, gamesdb_frameid spot) {
+	gamesdb_io* io = gamesdb_io_get(db);
+	gamesdb_buffer* bufp = db->buffer;
+	gamesdb_iopage* slot;
+	double start = 0;
+
+	if (io == NULL) {
+		return GAMESDB_FALSE;
+	}
+	pthread_mutex_lock(&io->lock);
+	while (GAMESDB_TRUE) {
+		//an older copy of the page that is already being written goes first
+		slot = gamesdb_io_find(io, spot->tag);
+		if (slot != NULL && slot->state == GAMESDB_IO_QUEUED_WRITE) {
+			break;
+		}
+		if (slot == NULL && (slot = gamesdb_io_slot(io, GAMESDB_TRUE)) != NULL) {
+			slot->vpn = spot->tag;
+			gamesdb_io_queue(io, slot, GAMESDB_IO_QUEUED_WRITE);
+			db->stats.written_behind++;
+			break;
+		}
+		if (start == 0) {
+			start = gamesdb_io_clock();
+		}
+		pthread_cond_wait(&io->done, &io->lock);
+	}
+	if (start != 0) {
+		db->stats.stall += gamesdb_io_clock() - start;
+	}
+
+	memcpy(slot->page.mem, spot->mem, sizeof(char) * bufp->buf_size * bufp->rec_size);
+	slot->page.chances = spot->chances;
+	slot->page.tag = spot->tag;
+	slot->page.valid = GAMESDB_TRUE;
+	pthread_mutex_unlock(&io->lock);
+	return GAMESDB_TRUE;
+}
+
+/* Called after each miss. Once the misses run through consecutive pages,
+ * keeps the next readahead pages that are neither in the buffer nor in
+ * flight queued for reading.
+ */
+void gamesdb_io_readahead(gamesdb* db, gamesdb_pageid vpn) {
+	gamesdb_io* io = gamesdb_io_get(db);
+	gamesdb_iopage* slot;
+	gamesdb_pageid next;
+
+	if (io == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&io->lock);
+	if (vpn != io->last_miss + 1) {
+		io->last_miss = io->ahead = vpn;
+		pthread_mutex_unlock(&io->lock);
+		return;
+	}
+	io->last_miss = vpn;
+	if (io->ahead < vpn) {
+		io->ahead = vpn;
+	}
+	while (io->ahead < vpn + io->readahead) {
+		next = io->ahead + 1;
+		if (gamesdb_bman_find(db, next) == NULL && gamesdb_io_find(io, next) == NULL) {
+			if ((slot = gamesdb_io_slot(io, GAMESDB_FALSE)) == NULL) {
+				break;
+			}
+			slot->vpn = next;
+			gamesdb_io_queue(io, slot, GAMESDB_IO_QUEUED_READ);
+			db->stats.read_ahead++;
+		}
+		io->ahead = next;
+	}
+	pthread_mutex_unlock(&io->lock);
+}
@@ -0,0 +1,45 @@
+/************************************************************************
+**
+** NAME:	db_io.h
+**
+** DESCRIPTION:	Background page reads and writes.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#ifndef GMCORE_DB_IO_H
+#define GMCORE_DB_IO_H
+
+#include "db_types.h"
+
+gamesdb_io*     gamesdb_io_start        (gamesdb* db, int num_threads, int readahead);
+void            gamesdb_io_stop         (gamesdb* db);
+int             gamesdb_io_read         (gamesdb* db, gamesdb_frameid spot, gamesdb_pageid vpn);
+int             gamesdb_io_write        (gamesdb* db, gamesdb_frameid spot);
+void            gamesdb_io_readahead    (gamesdb* db, gamesdb_pageid vpn);
+void            gamesdb_io_drain        (gamesdb* db);
+double          gamesdb_io_clock        ();
+
+#endif /* GMCORE_DB_IO_H */
@@ -95,7 +95,7 @@ gamesdb_store* gamesdb_open(gamesdb* db, char* filename, int cluster_size){
 
 	gamesdb_store* db_store = (gamesdb_store*) gamesdb_SafeMalloc(sizeof(gamesdb_store));
 
-	db_store->filename = (char*) gamesdb_SafeMalloc (sizeof(char)*strlen(filename));
+	db_store->filename = (char*) gamesdb_SafeMalloc (sizeof(char)*(strlen(filename)+1));
 	strcpy(db_store->filename, filename);
 
 	db_store->dir_size = cluster_size;
@@ -165,7 +165,7 @@ int gamesdb_write(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
 	sprintf(filename, "./data/%s", dbfile->filename);
 	gamesdb_checkpath(filename, page, dbfile->dir_size);
 
-	gzFile pagefile = gzopen(filename, "w+");
+	gzFile pagefile = gzopen(filename, "wb");
 
 	if (GAMESDB_DEBUG)
 		printf ("db_write: path = %s, page = %llu\n", filename, page);
@@ -191,7 +191,7 @@ int gamesdb_read(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
 	sprintf(filename, "./data/%s", dbfile->filename);
 	gamesdb_checkpath(filename, page, dbfile->dir_size);
 
-	gzFile pagefile = gzopen(filename, "r+");
+	gzFile pagefile = gzopen(filename, "rb");
 
 	if (GAMESDB_DEBUG) {
 		printf ("db_read: path = %s, page = %llu\n", filename, page);
@@ -206,6 +206,7 @@ int gamesdb_read(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
 		//gzread(pagefile, (void*)&(buf->valid), sizeof(gamesdb_boolean));
 		buf->valid = GAMESDB_TRUE;
 		//assert(buf->valid == TRUE);
+		gzclose(pagefile);
 
 	} else { //page does not exist in disk
 		if (GAMESDB_DEBUG) {
@@ -219,8 +220,6 @@ int gamesdb_read(gamesdb* db, gamesdb_pageid page, gamesdb_bufferpage* buf){
 
 	//the caller will take care of the dirty bit
 
-	gzclose(pagefile);
-
 	return 0;
 
 }
@@ -2,6 +2,8 @@
 #define DB_TYPES_H_
 
 #include <zlib.h>
+#include <pthread.h>
+#include <sys/types.h>
 #include "db_globals.h"
 
 //basic types
@@ -23,6 +25,7 @@ typedef struct gamesdb_bufferpage_struct {
 	gamesdb_boolean dirty;
 	gamesdb_counter chances;
 	struct gamesdb_bufferpage_struct *next;
+	struct gamesdb_bufferpage_struct *next_free; //only used while the frame is not valid
 } gamesdb_bufferpage;
 
 //physical
@@ -58,6 +61,7 @@ typedef struct {
 
 typedef struct {
 	gamesdb_bufferpage* pages;
+	gamesdb_bufferpage* free_pages; //frames that hold no page yet
 	int rec_size; //number of bytes in a record
 	int buf_size; //number of records in a buffer
 	int num_pages; //number of pages in memory
@@ -72,11 +76,47 @@ typedef struct {
 	gamesdb_bufferpage *clock_hand;
 } gamesdb_bman;
 
+//a page on its way to or from the disk
+typedef struct {
+	gamesdb_bufferpage page; //private copy, so the frame can be reused at once
+	gamesdb_pageid vpn;
+	int state;
+} gamesdb_iopage;
+
+//background page I/O
+typedef struct {
+	pthread_t* threads;
+	int num_threads;
+	pthread_mutex_t lock;
+	pthread_cond_t work; //something was queued, or the threads should stop
+	pthread_cond_t done; //a read or write finished
+	gamesdb_iopage* slots;
+	int num_slots;
+	int* queue; //slots waiting for a thread, oldest first
+	int queue_head, queue_len;
+	int readahead; //pages read ahead of a sequential run of misses
+	gamesdb_pageid last_miss;
+	gamesdb_pageid ahead; //last page considered for read-ahead
+	pid_t owner; //a forked child has none of the threads
+	gamesdb_boolean stop;
+} gamesdb_io;
+
+typedef struct {
+	unsigned long long hits; //page was in the buffer
+	unsigned long long misses;
+	unsigned long long read_ahead; //pages read before they were asked for
+	unsigned long long read_ahead_used;
+	unsigned long long written_behind;
+	double stall; //seconds spent waiting on the disk
+} gamesdb_stats;
+
 //the db object, so to speak
 typedef struct {
 	gamesdb_bman* buf_man;
 	gamesdb_buffer* buffer;
 	gamesdb_store* store;
+	gamesdb_io* io; //NULL when all I/O is synchronous
+	gamesdb_stats stats;
 	//gamesdb_pageid num_page;
 } gamesdb;
 
@@ -67,7 +67,7 @@ static int maxPossibleLineLength = 256;
 ** Local function prototypes
 */
 
-static VALUE_MOVES*    SortMoves                       (POSITION, MOVE, VALUE_MOVES*);
+static VALUE_MOVES*    SortMoves                       (POSITION, MOVELIST*, VALUE_MOVES*);
 static VALUE_MOVES*    StoreMoveInList                 (MOVE, REMOTENESS, VALUE_MOVES*, int);
 static moveList*       moveListHandleUndo              (moveList*);
 static moveList*       moveListHandleNewMove           (POSITION, MOVE, moveList*, MOVELIST*);
@@ -1690,48 +1690,35 @@ MOVE GetWinByMove (POSITION position, MOVELIST* genMoves)
 	return -1;
 }
 
-/* Jiong */
-VALUE_MOVES* SortMoves (POSITION thePosition, MOVE move, VALUE_MOVES* valueMoves)
+/* Which kind of move (WINMOVE, TIEMOVE or LOSEMOVE) it is to move from
+   position to a child whose value is childValue, or -1 if the child is
+   undecided. */
+int MoveTypeOfChild(POSITION position, MOVE move, VALUE childValue)
 {
-	POSITION child;
-	VALUE childValue;
-
-	child = DoMove(thePosition, move);
-	childValue = GetValueOfPosition(child);
-	if (gGoAgain(thePosition, move)) {
-		switch(childValue) {
-		case win:
+	if (gGoAgain(position, move)) {
+		if (childValue == win)
 			childValue = lose;
-			break;
-		case lose:
+		else if (childValue == lose)
 			childValue = win;
-			break;
-		default:
-			break;
-		}
 	}
-
-	if (childValue == lose) {  //winning moves
-		valueMoves = StoreMoveInList(move, Remoteness(child), valueMoves,  WINMOVE);
-	} else if (childValue == tie) {  //tie moves
-		valueMoves = StoreMoveInList(move, Remoteness(child), valueMoves,  TIEMOVE);
-	} else if (childValue == win) {  //lose moves
-		valueMoves = StoreMoveInList(move, Remoteness(child), valueMoves, LOSEMOVE);
-	} else {
-		BadElse("SortMoves found a child with an unknown value and");
+	switch (childValue) {
+	case lose: return WINMOVE;
+	case tie: return TIEMOVE;
+	case win: return LOSEMOVE;
+	default: return -1;
 	}
-	return valueMoves;
 }
 
-
-/* GamesCrafters Network Team 4/20/06 */
-VALUE_MOVES* NetworkSortMoves (POSITION thePosition, MOVELIST* head, VALUE_MOVES* valueMoves)
+/* Jiong */
+/* Sorts the moves of head by the values of their children, which are all
+   fetched from the DB in one call (one request with netdb). */
+VALUE_MOVES* SortMoves (POSITION thePosition, MOVELIST* head, VALUE_MOVES* valueMoves)
 {
 	POSITION *childArray;
 	VALUE *childValueArray;
 	MOVELIST *ptr = head;
 	REMOTENESS *remotenessArray;
-	int lengthOfMoveList = 0, i;
+	int lengthOfMoveList = 0, i, typeofMove;
 
 	while (ptr != NULL) {         //get length of the movelist
 		lengthOfMoveList++;
@@ -1750,31 +1737,14 @@ VALUE_MOVES* NetworkSortMoves (POSITION thePosition, MOVELIST* head, VALUE_MOVES
 
 	ptr = head;
 
-	GetValueAndRemotenessOfPositionBulk(childArray, childValueArray, remotenessArray, lengthOfMoveList);
+	if (gNetworkDB)
+		GetValueAndRemotenessOfPositionBulk(childArray, childValueArray, remotenessArray, lengthOfMoveList);
+	else GetPositionDataBulk(childArray, lengthOfMoveList, childValueArray, remotenessArray, NULL, NULL);
 
 	for (i=0; (ptr != NULL); i++, ptr = ptr->next) {
-		if (gGoAgain(thePosition, ptr->move)) {
-			switch(childValueArray[i]) {
-			case win:
-				childValueArray[i] = lose;
-				break;
-			case lose:
-				childValueArray[i] = win;
-				break;
-			default:
-				childValueArray[i] = childValueArray[i];
-			}
-		}
-
-		if (childValueArray[i] == lose) {  //winning moves
-			valueMoves = StoreMoveInList(ptr->move, remotenessArray[i], valueMoves,  WINMOVE);
-		} else if (childValueArray[i] == tie) {  //tie moves
-			valueMoves = StoreMoveInList(ptr->move, remotenessArray[i], valueMoves,  TIEMOVE);
-		} else if (childValueArray[i] == win) {  //lose moves
-			valueMoves = StoreMoveInList(ptr->move, remotenessArray[i], valueMoves, LOSEMOVE);
-		} else {
-			BadElse("SortMoves found a child with an unknown value and");
-		}
+		if ((typeofMove = MoveTypeOfChild(thePosition, ptr->move, childValueArray[i])) >= 0)
+			valueMoves = StoreMoveInList(ptr->move, remotenessArray[i], valueMoves, typeofMove);
+		else BadElse("SortMoves found a child with an unknown value and");
 	}
 
 	SafeFree(childArray);
@@ -1798,14 +1768,22 @@ MOVE GetComputersMove(POSITION thePosition)
 	ptr = head = prev = NULL;
 	i = 0;
 
-	moves = GetValueMoves(thePosition);
-
 	// Play Imperfectly
 	if (GetRandomNumber(MAXSCALE+1) > scalelvl && smartness == SMART) {
 		smartness = RANDOM;
 		setBackSmartness = TRUE;
 	}
 
+	// The move table already knows the best moves, unless we must list or give them back
+	if (smartness == SMART && !gHints && !gWinBy && !gWinByClose
+	    && !(remainingGivebacks>0 && GetValueOfPosition(thePosition) < oldValueOfPosition)
+	    && (theMove = MoveTableBestMove(thePosition)) != -1) {
+		oldValueOfPosition = GetValueOfPosition(thePosition);
+		return theMove;
+	}
+
+	moves = GetValueMoves(thePosition);
+
 	// Use givebacks
 	if (remainingGivebacks>0 && GetValueOfPosition(thePosition) < oldValueOfPosition) {
 		if(gHints) {
@@ -1976,7 +1954,7 @@ MOVE GetComputersMove(POSITION thePosition)
 ****/
 VALUE_MOVES* GetValueMoves(POSITION thePosition)
 {
-	MOVELIST *ptr, *head;
+	MOVELIST *head;
 	VALUE_MOVES *valueMoves;
 	VALUE theValue;
 
@@ -1991,16 +1969,8 @@ VALUE_MOVES* GetValueMoves(POSITION thePosition)
 		return(valueMoves);                           /* undecided positions are invalid */
 
 	else {                                    /* we are guaranteed it's win | tie now */
-		head = ptr = GenerateMoves(thePosition);
-		if (gNetworkDB) {
-			valueMoves = NetworkSortMoves(thePosition, head, valueMoves);
-		}
-		else {
-			while(ptr != NULL) {                    /* otherwise  (theValue = (win|tie) */
-				valueMoves = SortMoves(thePosition, ptr->move, valueMoves);
-				ptr = ptr->next;
-			}
-		}
+		head = GenerateMoves(thePosition);
+		valueMoves = SortMoves(thePosition, head, valueMoves);
 		FreeMoveList(head);
 	}
 	return(valueMoves);
@@ -37,6 +37,7 @@ STRING          GetSEvalPrediction                      (POSITION pos, STRING pl
 MOVE            GetComputersMove                (POSITION pos);
 MOVE    GetSEvalMove        (POSITION pos);
 VALUE_MOVES*    GetValueMoves                   (POSITION pos);
+int             MoveTypeOfChild                 (POSITION pos, MOVE move, VALUE childValue);
 
 /* Player structure */
 typedef enum {Human, Computer, Evaluator} PTYPE;
@@ -24,6 +24,10 @@
 #include "types.h"
 #include "hash.h"
 #include "hashwindow.h"
+#include "posqueue.h"
+#include "parentindex.h"
+#include "childcounter.h"
+#include "movetable.h"
 #include "db.h"
 #include "analysis.h"
 #include "visualization.h"
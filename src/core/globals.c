@@ -35,6 +35,7 @@
 VALUE (*gSolver)(POSITION) = NULL;
 BOOLEAN (*gGoAgain)(POSITION,MOVE) = NULL;
 POSITION (*gCanonicalPosition)(POSITION) = NULL;
+void (*gCanonicalPositionBulkFunPtr)(POSITION*, POSITION*, int) = NULL;
 STRING (*gCustomUnhash)(POSITION) = NULL;
 char (*gReturnTurn)(POSITION) = NULL;
 void* (*linearUnhash)(POSITION) = NULL;
@@ -61,6 +62,7 @@ BOOLEAN gSEvalPerfect = FALSE;          /* TRUE iff an evaluator is never wrong
 BOOLEAN gWinBy = FALSE;               /* TRUE iff the computer is playing with WinBy */
 BOOLEAN gWinByClose = FALSE;          /* TRUE iff the computer is playing with WinByClose */
 BOOLEAN gHints = FALSE;                 /* TRUE iff possible moves should be printed */
+BOOLEAN gUseMoveTable = FALSE;          /* TRUE iff the computer's best moves are summarized after solving */
 BOOLEAN gUnsolved = FALSE;              /* TRUE iff playing without solving */
 
 BOOLEAN gStandardGame = TRUE;               /* TRUE iff game is STANDARD (not REVERSE) */
@@ -82,6 +84,7 @@ BOOLEAN gBitPerfectDBSchemes = FALSE;
 BOOLEAN gBitPerfectDBAllSchemes = FALSE;
 BOOLEAN gBitPerfectDBZeroMemoryPlayer = FALSE;
 BOOLEAN gBitPerfectDBVerbose = FALSE;
+BOOLEAN gBitPerfectDBConcurrent = FALSE;
 BOOLEAN gTwoBits = FALSE;             /* Two bit solver, default: FALSE */
 BOOLEAN gCollDB = FALSE;
 BOOLEAN gUnivDB = FALSE;
@@ -91,6 +94,7 @@ BOOLEAN gGlobalPositionSolver = FALSE;
 BOOLEAN gUseGPS = FALSE;
 BOOLEAN gBottomUp = FALSE;        /* Default is no bottom up solving, should enable for only win4 */
 BOOLEAN gZeroMemSolver = FALSE;   /* Zero Memory Overhead Solver, default: FALSE */
+BOOLEAN gValueOnlySolver = FALSE; /* Only values, into a two bit database, default: FALSE */
 BOOLEAN gAnalyzing = FALSE;       /* Write analysis for each variant
                                    * solved, default: FALSE */
 BOOLEAN gVisualizing = FALSE;     /* Write visualization for each variant solved,
@@ -130,6 +134,11 @@ BOOLEAN gGenerateNodeViz = FALSE;
 /* NetworkDB Globals */
 BOOLEAN gNetworkDB = FALSE;
 STRING ServerAddress = "nyc.cs.berkeley.edu:8080/GamesmanServlet";
+int gNetDBCacheSize = 65536;            /* Number of cells the network database keeps cached */
+
+/* FileDB Globals */
+int gFileDBMemoryMB = 0;                /* Pages beyond this go back to disk, 0 = never */
+int gFileDBReadahead = 8;               /* Pages read ahead of a sequential sweep, 0 = no I/O threads */
 
 /* MP over network Globals */
 STRING gMPServerAddress = "127.0.0.1:3000/game/request_game_url";
@@ -173,10 +182,18 @@ STRING (*gTierToStringFunPtr)(TIER) = NULL;
 // For the experimental GenerateMoves
 int (*gGenerateMovesEfficientFunPtr)(POSITION) = NULL;
 MOVE*           gGenerateMovesArray = NULL;
-int MAXFANOUT = 100;
+// For GenerateChildren; MAXFANOUT is the room callers leave in their arrays
+int (*gGenerateChildrenFunPtr)(POSITION, POSITION*, MOVE*) = NULL;
+int MAXFANOUT = 1024;
 
 /* Variables for the parallelized solver */
 BOOLEAN gParallelizing = FALSE;
+int gSolverWorkers = 1;                 /* Number of worker processes used to sweep a tier */
+int gTierJobs = 1;                      /* Worker processes the tier scheduler runs at once */
+int gFrontierMemoryMB = 0;              /* Frontier queues spill to disk beyond this, 0 = never */
+int gCheckpointSeconds = 0;             /* Seconds between checkpoints of a tier being solved, 0 = none */
+int gTierCacheMB = 256;                 /* Loaded tiers kept across hash windows when playing */
+int gAlphaBetaTableMB = 64;             /* Size of the alpha-beta solver's transposition table */
 
 /* Tcl interp for making calls to Tcl_Eval */
 Tcl_Interp *gTclInterp = NULL;
@@ -8,13 +8,13 @@
 
 extern VALUE gValue;
 extern BOOLEAN gHumanGoesFirst, gPrintPredictions, gPrintSEvalPredictions,
-               gSEvalLoaded, gSEvalPerfect, gHints, gUnsolved;
+               gSEvalLoaded, gSEvalPerfect, gHints, gUnsolved, gUseMoveTable;
 
 extern BOOLEAN gStandardGame, gSaveDatabase, gLoadDatabase,
                gPrintDatabaseInfo, gJustSolving, gMessage, gSolvingAll,
-               gBitPerfectDB, gBitPerfectDBSolver, gBitPerfectDBSchemes, gBitPerfectDBAllSchemes, gBitPerfectDBAdjust, gBitPerfectDBVerbose, gBitPerfectDBZeroMemoryPlayer,
+               gBitPerfectDB, gBitPerfectDBSolver, gBitPerfectDBSchemes, gBitPerfectDBAllSchemes, gBitPerfectDBAdjust, gBitPerfectDBVerbose, gBitPerfectDBConcurrent, gBitPerfectDBZeroMemoryPlayer,
                gTwoBits, gCollDB, gUnivDB, gFileDB,
-               gGlobalPositionSolver, gZeroMemSolver,
+               gGlobalPositionSolver, gZeroMemSolver, gValueOnlySolver,
                gAnalyzing, gSymmetries, gUseGPS, gBottomUp, gAlphaBeta, gUseOpen, gWinBy, gInterestingness, gWinByClose,
                gIncludeInterestingnessWithAnalysis,
                gVisTiers, gVisTiersPlain, gSolveOnlyTier;
@@ -93,6 +93,8 @@ extern BOOLEAN (*gGoAgain)(POSITION,MOVE);
 
 /* symmetries function pointer */
 extern POSITION (*gCanonicalPosition)(POSITION);
+/* batched gCanonicalPosition, for games that provide one */
+extern void (*gCanonicalPositionBulkFunPtr)(POSITION*, POSITION*, int);
 
 /* Custom unhash into string function pointer (useful for TCL interoperability) */
 extern STRING (*gCustomUnhash)(POSITION);
@@ -128,6 +130,11 @@ extern OPPONENT gOpponent;
 /* NetworkDB Globals */
 extern BOOLEAN gNetworkDB;
 extern STRING ServerAddress;
+extern int gNetDBCacheSize;
+
+/* FileDB Globals */
+extern int gFileDBMemoryMB;
+extern int gFileDBReadahead;
 
 /* MP over network Globals */
 extern STRING gMPServerAddress;
@@ -171,10 +178,18 @@ extern STRING (*gTierToStringFunPtr)(TIER);
 // For the experimental GenerateMoves
 extern int (*gGenerateMovesEfficientFunPtr)(POSITION);
 extern MOVE*            gGenerateMovesArray;
+// For GenerateChildren
+extern int (*gGenerateChildrenFunPtr)(POSITION, POSITION*, MOVE*);
 extern int MAXFANOUT;
 
 /* Variables for the parallelized solver */
 extern BOOLEAN gParallelizing;
+extern int gSolverWorkers;
+extern int gTierJobs;
+extern int gFrontierMemoryMB;
+extern int gCheckpointSeconds;
+extern int gTierCacheMB;
+extern int gAlphaBetaTableMB;
 
 /* Tcl interp for making calls to Tcl_Eval */
 extern Tcl_Interp*              gTclInterp;
@@ -31,6 +31,10 @@
 **************************************************************************/
 
 #include "gamesman.h"
+#include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /*********************************************************************************
 *** A *PERFECT* hash function -
@@ -51,6 +55,8 @@
 #define UNKNOWN -1
 #define RECT 0
 #define HEX 1
+#define HASH_SSE2_MAX_PIECES 4  /* more pieces than this and the lookup table counts faster */
+#define HASH_BENCH_SAMPLES 200000
 /* Global Variables */
 struct hashContext **contextList = NULL;
 int hash_tot_context = 0, currentContext = 0;
@@ -97,15 +103,27 @@ int convert(int row, int col, int boardType);
 void            hash_combiCalc();
 void            freeHashContext(int contextNum);
 int             validConfig(int *t);
-int             searchIndices(int s);
-int             searchOffset(POSITION h);
-POSITION        combiCount(int* tc);
+int             searchIndices(struct hashContext *con, int s);
+int             searchOffset(struct hashContext *con, POSITION h);
+POSITION        combiCount(struct hashContext *con, int* tc);
 int             hash_countPieces(int *pA);
-POSITION        hash_cruncher (char* board);
-POSITION        hash_cruncher_sym (char* board, struct symEntry* symIndex);
-void            hash_uncruncher (POSITION hashed, char *dest);
+POSITION        hash_cruncher (struct hashContext *con, struct hashScratch *scratch, char* board);
+POSITION        hash_cruncher_sym (struct hashContext *con, struct hashScratch *scratch, char* board, struct symEntry* symIndex);
+void            hash_uncruncher (struct hashContext *con, struct hashScratch *scratch, POSITION hashed, char *dest);
+POSITION        hash_hash_sym_legacy(struct hashContext *con, struct hashScratch *scratch, char* board, int player, POSITION offset, struct symEntry* symIndex);
+POSITION        hash_canonical_legacy(struct hashContext *con, struct hashScratch *scratch, POSITION pos);
+BOOLEAN         hash_image_less(struct hashContext *con, char* board, int* symA, int* symB);
+POSITION        hash_hash_image(struct hashContext *con, struct hashScratch *scratch, char* board, int* sym, int player);
+POSITION        hash_hash_legacy(struct hashContext *con, struct hashScratch *scratch, char* board, int player);
+char*           hash_unhash_legacy(struct hashContext *con, struct hashScratch *scratch, POSITION hashed, char* dest);
+void            hash_build_tables(struct hashContext *con);
+int             hash_count_table(struct hashContext *con, struct hashScratch *scratch, char* board);
+POSITION        hash_rank_table(struct hashContext *con, struct hashScratch *scratch, char* board, int* sym, int block);
+void            hash_unrank_table(struct hashContext *con, struct hashScratch *scratch, POSITION hashed, char* dest);
+struct hashScratch hash_context_scratch(struct hashContext *con);
+void            hash_check_scratch(struct hashContext *con, struct hashScratch *scratch);
 int             getPieceParams(int *pa,char *pi,int *mi,int *ma);
-POSITION        nCr(int n, int r);
+POSITION        nCr(struct hashContext *con, int n, int r);
 void            nCr_init(int a);
 int*            gpd (int n);
 int             gpi (int n);
@@ -198,6 +216,7 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 	cCon->gpdStore = (int*) SafeMalloc (sizeof(int) * cCon->numPieces);
 	cCon->miniOffset = (POSITION*) SafeMalloc (sizeof(POSITION) * (cCon->numPieces+2));
 	cCon->miniIndices = (int*) SafeMalloc (sizeof(int) * (cCon->numPieces+2));
+	cCon->symBoards = (char*) SafeMalloc (sizeof(char) * 2 * boardsize);
 
 	getPieceParams(pieces_array, cCon->pieces, cCon->mins,cCon->maxs);
 	for (i = 0; i < cCon->numPieces; i++) {
@@ -226,7 +245,7 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 	cCon->hashOffset[0] = 0;
 	cCon->offsetIndices[0] = 0;
 	for (k = 1; k <= cCon->usefulSpace; k++) {
-		cCon->hashOffset[k] = combiCount(gPieceDist(k-1));
+		cCon->hashOffset[k] = combiCount(cCon, gPieceDist(k-1));
 		cCon->offsetIndices[k] = gpi(k-1);
 	}
 	cCon->hashOffset[k] = -1;
@@ -247,6 +266,8 @@ POSITION generic_hash_init(int boardsize, int *pieces_array, int (*fn)(int *), i
 	cCon->hashOffset[cCon->usefulSpace + 1] = -1;
 	cCon->maxPos = sofar;
 
+	hash_build_tables(cCon);
+
 	cCon->player = player % 3;         // ensures player is either 0, 1, or 2
 
 	if (cCon->player != 0)
@@ -323,7 +344,7 @@ void hash_combiCalc()
 		for(i=0; i<cCon->numPieces; i++) {
 			sums = combiHash(sums,cCon->nums[i],thPieces[i]);
 		}
-		cCon->combiArray[sums] = combiCount(thPieces);
+		cCon->combiArray[sums] = combiCount(cCon, thPieces);
 		thPieces[0]++;
 		i=0;
 		while(i<(cCon->numPieces-1) && thPieces[i] > cCon->maxs[i]) {
@@ -343,128 +364,181 @@ void hash_combiCalc()
 
 /* hashes *board to a POSITION */
 POSITION generic_hash_hash(char* board, int player) {
+	struct hashScratch scratch = hash_context_scratch(cCon);
+	return generic_hash_hash_r(cCon, &scratch, board, player);
+}
+
+/* reentrant generic_hash_hash: only reads the context, and counts the
+   pieces in the caller's scratch space */
+POSITION generic_hash_hash_r(struct hashContext* con, struct hashScratch* scratch, char* board, int player)
+{
+	POSITION temp;
+	int block;
+
+	hash_check_scratch(con, scratch);
+
+	if (con->cfgBlock != NULL && (block = hash_count_table(con, scratch, board)) >= 0) {
+		temp = con->hashOffset[block] + hash_rank_table(con, scratch, board, NULL, block);
+		if (con->player != 0) // using single-player boards, ignore "player"
+			return temp;
+		else return temp + (player-1)*(con->maxPos); //accomodates generic_hash_turn
+	}
+	return hash_hash_legacy(con, scratch, board, player);
+}
+
+/* the original counting loop and cruncher, used when the tables can't
+   be (a board char that isn't a piece, a count out of range) and by
+   generic_hash_benchmark() */
+POSITION hash_hash_legacy(struct hashContext *con, struct hashScratch *scratch, char* board, int player)
+{
 	int i, j;
 	POSITION temp, sum;
-	int boardSize = cCon->boardSize; /*hash_boardSize;*/
+	int boardSize = con->boardSize; /*hash_boardSize;*/
 
-	for (i = 0; i < cCon->numPieces; i++)
+	for (i = 0; i < con->numPieces; i++)
 	{
-		cCon->thisCount[i] = 0;
-		cCon->localMins[i] = cCon->mins[i];
+		scratch->thisCount[i] = 0;
+		scratch->localMins[i] = con->mins[i];
 	}
 
 	for (i = 0; i < boardSize; i++)
 	{
-		for (j = 0; j < cCon->numPieces; j++) {
-			if (board[i] == cCon->pieces[j]) {
-				cCon->thisCount[j]++;
+		for (j = 0; j < con->numPieces; j++) {
+			if (board[i] == con->pieces[j]) {
+				scratch->thisCount[j]++;
 			}
 		}
 	}
 	sum = 0;
-	for (i = cCon->numPieces-1; i >= 0; i--)
+	for (i = con->numPieces-1; i >= 0; i--)
 	{
-		sum += (cCon->thisCount[i] - cCon->mins[i]);
+		sum += (scratch->thisCount[i] - con->mins[i]);
 		if (i > 0) {
-			sum *= cCon->nums[i-1];
+			sum *= con->nums[i-1];
 		}
 	}
-	temp = cCon->hashOffset[searchIndices(sum)];
-	temp += hash_cruncher(board);
-	if (temp > cCon->maxPos) {
+	temp = con->hashOffset[searchIndices(con, sum)];
+	temp += hash_cruncher(con, scratch, board);
+	if (temp > con->maxPos) {
 		ExitStageRightErrorString("generic_hash encountered position larger than maxPos.");
 	}
-	if (cCon->player != 0) // using single-player boards, ignore "player"
+	if (con->player != 0) // using single-player boards, ignore "player"
 		return temp;
-	else return temp + (player-1)*(cCon->maxPos); //accomodates generic_hash_turn
+	else return temp + (player-1)*(con->maxPos); //accomodates generic_hash_turn
 }
 
 //accomodates generic_hash_turn and symmetries
 POSITION generic_hash_hash_sym(char* board, int player, POSITION offset, struct symEntry* symIndex)
 {
-	int i, j;
+	struct hashScratch scratch = hash_context_scratch(cCon);
+	return generic_hash_hash_sym_r(cCon, &scratch, board, player, offset, symIndex);
+}
+
+POSITION generic_hash_hash_sym_r(struct hashContext* con, struct hashScratch* scratch, char* board, int player, POSITION offset, struct symEntry* symIndex)
+{
+	int block;
 	POSITION temp;
-	int boardSize = cCon->boardSize; /*hash_boardSize;*/
 
 	if (symIndex == NULL)
 		ExitStageRightErrorString("Invalid symmetry");
 
-	for (i = 0; i < cCon->numPieces; i++)
+	hash_check_scratch(con, scratch);
+
+	// a symmetry only permutes the cells, so the piece counts (and with
+	// them the configuration) are those of the board itself
+	if (con->cfgBlock != NULL && (block = hash_count_table(con, scratch, board)) >= 0) {
+		temp = offset + hash_rank_table(con, scratch, board, symIndex->sym, block);
+		if (con->player != 0) // using single-player boards, ignore "player"
+			return temp;
+		else return temp + (player-1)*(con->maxPos); //accomodates generic_hash_turn
+	}
+	return hash_hash_sym_legacy(con, scratch, board, player, offset, symIndex);
+}
+
+POSITION hash_hash_sym_legacy(struct hashContext *con, struct hashScratch *scratch, char* board, int player, POSITION offset, struct symEntry* symIndex)
+{
+	int i, j;
+	POSITION temp;
+	int boardSize = con->boardSize; /*hash_boardSize;*/
+
+	for (i = 0; i < con->numPieces; i++)
 	{
-		cCon->thisCount[i] = 0;
-		cCon->localMins[i] = cCon->mins[i];
+		scratch->thisCount[i] = 0;
+		scratch->localMins[i] = con->mins[i];
 	}
 
 	for (i = 0; i < boardSize; i++)
 	{
-		for (j = 0; j < cCon->numPieces; j++) {
-			if (board[symIndex->sym[i]] == cCon->pieces[j]) {
-				cCon->thisCount[j]++;
+		for (j = 0; j < con->numPieces; j++) {
+			if (board[symIndex->sym[i]] == con->pieces[j]) {
+				scratch->thisCount[j]++;
 			}
 		}
 	}
-	temp = offset + hash_cruncher_sym(board, symIndex);
-	if (cCon->player != 0) // using single-player boards, ignore "player"
+	temp = offset + hash_cruncher_sym(con, scratch, board, symIndex);
+	if (con->player != 0) // using single-player boards, ignore "player"
 		return temp;
-	else return temp + (player-1)*(cCon->maxPos); //accomodates generic_hash_turn
+	else return temp + (player-1)*(con->maxPos); //accomodates generic_hash_turn
 }
 
 /* helper func from generic_hash_unhash() computes lexicographic rank of *board
    among boards with the same configuration argument *thiscount */
-POSITION hash_cruncher (char* board)
+POSITION hash_cruncher (struct hashContext *con, struct hashScratch *scratch, char* board)
 {
 	POSITION sum = 0;
 	int i = 0, k = 0, max1 = 0;
-	int boardSize = cCon->boardSize;
+	int boardSize = con->boardSize;
+	int *thisCount = scratch->thisCount, *localMins = scratch->localMins;
 
 	for(; boardSize>1; boardSize--) {
 		i = 0;
 
-		while (board[boardSize - 1] != cCon->pieces[i])
+		while (board[boardSize - 1] != con->pieces[i])
 			i++;
 		for (k = 0; k < i; k++) {
 			max1 = 1;
-			if (cCon->localMins[k] > 1)
-				max1 = cCon->localMins[k];
+			if (localMins[k] > 1)
+				max1 = localMins[k];
 
-			if (cCon->thisCount[k] >= max1) {
-				cCon->thisCount[k]--;
-				sum += combiCount(cCon->thisCount);
-				cCon->thisCount[k]++;
+			if (thisCount[k] >= max1) {
+				thisCount[k]--;
+				sum += combiCount(con, thisCount);
+				thisCount[k]++;
 			}
 		}
-		cCon->thisCount[i]--;
-		cCon->localMins[i]--;
+		thisCount[i]--;
+		localMins[i]--;
 	}
 
 	return sum;
 }
 
 // symmetry version
-POSITION hash_cruncher_sym (char* board, struct symEntry* symIndex)
+POSITION hash_cruncher_sym (struct hashContext *con, struct hashScratch *scratch, char* board, struct symEntry* symIndex)
 {
 	POSITION sum = 0;
 	int i = 0, k = 0, max1 = 0;
-	int boardSize = cCon->boardSize;
+	int boardSize = con->boardSize;
+	int *thisCount = scratch->thisCount, *localMins = scratch->localMins;
 
 	for(; boardSize>1; boardSize--) {
 		i = 0;
 
-		while (board[symIndex->sym[boardSize - 1]] != cCon->pieces[i])
+		while (board[symIndex->sym[boardSize - 1]] != con->pieces[i])
 			i++;
 		for (k = 0; k < i; k++) {
 			max1 = 1;
-			if (cCon->localMins[k] > 1)
-				max1 = cCon->localMins[k];
+			if (localMins[k] > 1)
+				max1 = localMins[k];
 
-			if (cCon->thisCount[k] >= max1) {
-				cCon->thisCount[k]--;
-				sum += combiCount(cCon->thisCount);
-				cCon->thisCount[k]++;
+			if (thisCount[k] >= max1) {
+				thisCount[k]--;
+				sum += combiCount(con, thisCount);
+				thisCount[k]++;
 			}
 		}
-		cCon->thisCount[i]--;
-		cCon->localMins[i]--;
+		thisCount[i]--;
+		localMins[i]--;
 	}
 
 	return sum;
@@ -473,9 +547,14 @@ POSITION hash_cruncher_sym (char* board, struct symEntry* symIndex)
 /* tells whose move it is, given a board's hash number */
 int generic_hash_turn (POSITION hashed)
 {
-	if (cCon->player != 0)         // using single-player boards
-		return cCon->player;
-	else return hashed >= cCon->maxPos ? 2 : 1;
+	return generic_hash_turn_r(cCon, hashed);
+}
+
+int generic_hash_turn_r (struct hashContext* con, POSITION hashed)
+{
+	if (con->player != 0)         // using single-player boards
+		return con->player;
+	else return hashed >= con->maxPos ? 2 : 1;
 }
 
 
@@ -496,58 +575,81 @@ char* generic_hash_unhash_tcl(POSITION pos)
 
 /* unhashes hashed to a board */
 char* generic_hash_unhash(POSITION hashed, char* dest)
+{
+	struct hashScratch scratch = hash_context_scratch(cCon);
+	return generic_hash_unhash_r(cCon, &scratch, hashed, dest);
+}
+
+/* reentrant generic_hash_unhash; the piece distribution is decoded
+   straight into the scratch space instead of through gpd() */
+char* generic_hash_unhash_r(struct hashContext* con, struct hashScratch* scratch, POSITION hashed, char* dest)
+{
+	hash_check_scratch(con, scratch);
+
+	if (con->cfgBlock != NULL) {
+		hash_unrank_table(con, scratch, hashed % con->maxPos, dest);
+		return dest;
+	}
+	return hash_unhash_legacy(con, scratch, hashed, dest);
+}
+
+char* hash_unhash_legacy(struct hashContext *con, struct hashScratch *scratch, POSITION hashed, char* dest)
 {
 	POSITION offst;
-	int i, j, boardSize;
-	hashed %= cCon->maxPos; //accomodates generic_hash_turn
+	int i, j, k;
+	hashed %= con->maxPos; //accomodates generic_hash_turn
 
-	boardSize = cCon->boardSize;
-	j = searchOffset(hashed);
-	offst = cCon->hashOffset[j];
+	j = searchOffset(con, hashed);
+	offst = con->hashOffset[j];
 	hashed -= offst;
-	for (i = 0; i < cCon->numPieces; i++) {
-		cCon->localMins[i] = cCon->mins[i];
-		cCon->thisCount[i] = gpd(cCon->offsetIndices[j + 1] - 1)[i];
+	k = con->offsetIndices[j + 1] - 1;
+	for (i = 0; i < con->numPieces; i++) {
+		scratch->localMins[i] = con->mins[i];
+		scratch->thisCount[i] = con->mins[i] + (k % (con->nums[i]));
+		k = k/(con->nums[i]);
 	}
-	hash_uncruncher(hashed, dest);
+	hash_uncruncher(con, scratch, hashed, dest);
 	return dest;
 }
 
 /* helper func from generic_hash_hash() computes a board, given its lexicographic rank hashed
    among boards with the same configuration argument *thiscount*/
-void hash_uncruncher (POSITION hashed, char *dest)
+void hash_uncruncher (struct hashContext *con, struct hashScratch *scratch, POSITION hashed, char *dest)
 {
 	int i = 0, j = 0;
 	int max1 = 0;
-	int boardSize = cCon->boardSize;
+	int boardSize = con->boardSize;
+	int *thisCount = scratch->thisCount, *localMins = scratch->localMins;
+	POSITION *miniOffset = scratch->miniOffset;
+	int *miniIndices = scratch->miniIndices;
 
 	for(; boardSize>0; boardSize--) {
 		if (boardSize == 1) {
 			i = 0;
-			while (cCon->thisCount[i] == 0)
+			while (thisCount[i] == 0)
 				i++;
-			dest[0] = cCon->pieces[i];
+			dest[0] = con->pieces[i];
 		} else {
-			cCon->miniOffset[0] = 0;
-			cCon->miniIndices[0] = 0;
+			miniOffset[0] = 0;
+			miniIndices[0] = 0;
 			j = 1;
-			for (i = 0; (i < cCon->numPieces) && (cCon->miniOffset[j-1] <= hashed); i++) {
+			for (i = 0; (i < con->numPieces) && (miniOffset[j-1] <= hashed); i++) {
 				max1 = 1;
-				if (cCon->localMins[i] > 1)
-					max1 = cCon->localMins[i];
-				if (cCon->thisCount[i] >= max1) {
-					cCon->thisCount[i]--;
-					cCon->miniOffset[j] = cCon->miniOffset[j-1] + combiCount(cCon->thisCount);
-					cCon->thisCount[i]++;
-					cCon->miniIndices[j] = i;
+				if (localMins[i] > 1)
+					max1 = localMins[i];
+				if (thisCount[i] >= max1) {
+					thisCount[i]--;
+					miniOffset[j] = miniOffset[j-1] + combiCount(con, thisCount);
+					thisCount[i]++;
+					miniIndices[j] = i;
 					j++;
 				}
 			}
 			i = j-1;
-			cCon->thisCount[cCon->miniIndices[i]]--;
-			cCon->localMins[cCon->miniIndices[i]]--;
-			dest[boardSize-1] = cCon->pieces[cCon->miniIndices[i]];
-			hashed = hashed - cCon->miniOffset[i-1];
+			thisCount[miniIndices[i]]--;
+			localMins[miniIndices[i]]--;
+			dest[boardSize-1] = con->pieces[miniIndices[i]];
+			hashed = hashed - miniOffset[i-1];
 		}
 
 	}
@@ -556,6 +658,231 @@ void hash_uncruncher (POSITION hashed, char *dest)
 
 
 
+/*************************************
+**
+**      Table-driven Hashing
+**
+**  The crunchers above call combiCount() for every smaller piece at
+**  every cell. With n cells left and piece counts c, the boards that
+**  put piece k in the next cell number M(c) * c[k] / n, where M(c) is
+**  the number of boards with counts c. So ranking only has to carry
+**  M(c) from cell to cell, starting from the size of the
+**  configuration's block of hashOffset. The configuration's block and
+**  each board character's piece are looked up in per-context tables.
+**
+*************************************/
+
+/* a * b / n for b <= n, without the product overflowing */
+static inline POSITION hash_mul_div(POSITION a, POSITION b, POSITION n)
+{
+	return (a / n) * b + (a % n) * b / n;
+}
+
+/* builds the lookup tables; they are left out (cfgBlock == NULL) when two
+   pieces share a character, which the crunchers still handle */
+void hash_build_tables(struct hashContext *con)
+{
+	int i, k;
+
+	for (i = 0; i < 256; i++)
+		con->pieceIndex[i] = -1;
+	for (k = 0; k < con->numPieces; k++) {
+		if (con->pieceIndex[(unsigned char) con->pieces[k]] != -1)
+			return;
+		con->pieceIndex[(unsigned char) con->pieces[k]] = k;
+	}
+	con->cfgBlock = (int*) SafeMalloc(sizeof(int) * con->numCfgs);
+	for (i = 0; i < con->numCfgs; i++)
+		con->cfgBlock[i] = -1;
+	for (k = 0; k < con->usefulSpace; k++)
+		con->cfgBlock[con->pieceIndices[k]] = k;
+}
+
+/* counts the pieces of board into the scratch space and returns the
+   block of its configuration, or -1 if it isn't a valid configuration */
+int hash_count_table(struct hashContext *con, struct hashScratch *scratch, char* board)
+{
+	int i = 0, k, cfg = 0;
+	int *thisCount = scratch->thisCount;
+
+	for (k = 0; k < con->numPieces; k++)
+		thisCount[k] = 0;
+#ifdef __SSE2__
+	// with few pieces, compare 16 cells at once against each of them
+	if (con->numPieces <= HASH_SSE2_MAX_PIECES) {
+		for (; i + 16 <= con->boardSize; i += 16) {
+			__m128i cells = _mm_loadu_si128((__m128i *) (board + i));
+			for (k = 0; k < con->numPieces; k++)
+				thisCount[k] += __builtin_popcount(_mm_movemask_epi8(
+				        _mm_cmpeq_epi8(cells, _mm_set1_epi8(con->pieces[k]))));
+		}
+	}
+#endif
+	for (; i < con->boardSize; i++) {
+		k = con->pieceIndex[(unsigned char) board[i]];
+		if (k >= 0)
+			thisCount[k]++;
+	}
+	for (k = con->numPieces-1; k >= 0; k--) {
+		if (thisCount[k] < con->mins[k] || thisCount[k] > con->maxs[k])
+			return -1;
+		cfg = cfg * con->nums[k] + thisCount[k] - con->mins[k];
+	}
+	// the valid configurations fill the board, so a board with other
+	// characters on it ends up here too
+	return con->cfgBlock[cfg];
+}
+
+/* rank of board (read through sym, if given) within its block, from the
+   counts hash_count_table() left in the scratch space */
+POSITION hash_rank_table(struct hashContext *con, struct hashScratch *scratch, char* board, int* sym, int block)
+{
+	POSITION rank = 0, boards = con->hashOffset[block+1] - con->hashOffset[block];
+	int *thisCount = scratch->thisCount;
+	int n, i, k, smaller;
+
+	for (n = con->boardSize; n > 1; n--) {
+		i = con->pieceIndex[(unsigned char) board[sym == NULL ? n-1 : sym[n-1]]];
+		for (smaller = 0, k = 0; k < i; k++)
+			smaller += thisCount[k];
+		if (smaller != 0)
+			rank += hash_mul_div(boards, smaller, n);
+		boards = hash_mul_div(boards, thisCount[i], n);
+		thisCount[i]--;
+	}
+	return rank;
+}
+
+/* unhashes hashed (less than maxPos) into dest */
+void hash_unrank_table(struct hashContext *con, struct hashScratch *scratch, POSITION hashed, char* dest)
+{
+	POSITION boards, size = 0;
+	int *thisCount = scratch->thisCount;
+	int lo = 0, hi = con->usefulSpace - 1, mid, n, i, k, cfg;
+
+	// the block holding hashed starts at the last offset <= hashed
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+		if (con->hashOffset[mid] <= hashed)
+			lo = mid;
+		else hi = mid - 1;
+	}
+	hashed -= con->hashOffset[lo];
+	boards = con->hashOffset[lo+1] - con->hashOffset[lo];
+	cfg = con->pieceIndices[lo];
+	for (k = 0; k < con->numPieces; k++) {
+		thisCount[k] = con->mins[k] + (cfg % con->nums[k]);
+		cfg = cfg / con->nums[k];
+	}
+
+	for (n = con->boardSize; n > 1; n--) {
+		for (i = 0;; i++) {
+			if (thisCount[i] == 0)
+				continue;
+			size = hash_mul_div(boards, thisCount[i], n);
+			if (hashed < size)
+				break;
+			hashed -= size;
+		}
+		dest[n-1] = con->pieces[i];
+		boards = size;
+		thisCount[i]--;
+	}
+	for (i = 0; thisCount[i] == 0; i++)
+		;
+	dest[0] = con->pieces[i];
+}
+
+/*************************************
+**
+** generic_hash_benchmark()
+**
+**  Times the table-driven hash and unhash
+**  against the original crunchers in every
+**  hash context the game has set up, and
+**  checks that they agree. Run by --hashbench;
+**  "make hashbench" runs it for every game
+**  that calls generic_hash_init.
+**
+*************************************/
+
+void generic_hash_benchmark()
+{
+	int c, mismatches;
+	POSITION i, samples, seed = 12345;
+	POSITION *positions, *hashes;
+	char *boards, *tableBoards;
+	struct hashContext *con;
+	struct hashScratch *scratch;
+	clock_t start;
+	double legacyUnhash, tableUnhash, legacyHash, tableHash;
+
+	if (hash_tot_context == 0) {
+		printf("This game does not use generic_hash.\n");
+		return;
+	}
+	printf("%7s %20s %8s %12s %12s %12s %12s %10s\n", "context", "positions", "samples",
+	       "unhash(old)", "unhash(new)", "hash(old)", "hash(new)", "mismatches");
+	for (c = 0; c < hash_tot_context; c++) {
+		con = contextList[c];
+		if (con->maxPos == 0 || con->cfgBlock == NULL) {
+			printf("%7d %20llu   (no tables)\n", c, con->maxPos);
+			continue;
+		}
+		samples = con->maxPos < HASH_BENCH_SAMPLES ? con->maxPos : HASH_BENCH_SAMPLES;
+		positions = (POSITION *) SafeMalloc(sizeof(POSITION) * samples);
+		hashes = (POSITION *) SafeMalloc(sizeof(POSITION) * samples);
+		boards = (char *) SafeMalloc(samples * con->boardSize);
+		tableBoards = (char *) SafeMalloc(samples * con->boardSize);
+		scratch = generic_hash_scratch_new(con);
+		for (i = 0; i < samples; i++) {
+			if (samples == con->maxPos) {
+				positions[i] = i;
+			} else {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				positions[i] = (seed >> 11) % con->maxPos;
+			}
+		}
+
+		start = clock();
+		for (i = 0; i < samples; i++)
+			hash_unhash_legacy(con, scratch, positions[i], boards + i * con->boardSize);
+		legacyUnhash = (double) (clock() - start) / CLOCKS_PER_SEC;
+		start = clock();
+		for (i = 0; i < samples; i++)
+			hash_unrank_table(con, scratch, positions[i], tableBoards + i * con->boardSize);
+		tableUnhash = (double) (clock() - start) / CLOCKS_PER_SEC;
+		mismatches = 0;
+		for (i = 0; i < samples; i++)
+			if (memcmp(boards + i * con->boardSize, tableBoards + i * con->boardSize, con->boardSize) != 0)
+				mismatches++;
+
+		start = clock();
+		for (i = 0; i < samples; i++)
+			hashes[i] = hash_hash_legacy(con, scratch, boards + i * con->boardSize, 1);
+		legacyHash = (double) (clock() - start) / CLOCKS_PER_SEC;
+		start = clock();
+		for (i = 0; i < samples; i++)
+			positions[i] = generic_hash_hash_r(con, scratch, boards + i * con->boardSize, 1) - hashes[i];
+		tableHash = (double) (clock() - start) / CLOCKS_PER_SEC;
+		for (i = 0; i < samples; i++)
+			if (positions[i] != 0)
+				mismatches++;
+
+		printf("%7d %20llu %8llu %9.0f ns %9.0f ns %9.0f ns %9.0f ns %10d\n", c, con->maxPos, samples,
+		       legacyUnhash * 1e9 / samples, tableUnhash * 1e9 / samples,
+		       legacyHash * 1e9 / samples, tableHash * 1e9 / samples, mismatches);
+
+		generic_hash_scratch_free(scratch);
+		SafeFree(positions);
+		SafeFree(hashes);
+		SafeFree(boards);
+		SafeFree(tableBoards);
+	}
+}
+
+
+
 /************************************
 *************************************
 **
@@ -614,6 +941,10 @@ int generic_hash_context_init()
 	newHashC->maxs = NULL;
 	newHashC->thisCount = NULL;
 	newHashC->localMins = NULL;
+	newHashC->miniOffset = NULL;
+	newHashC->miniIndices = NULL;
+	newHashC->cfgBlock = NULL;
+	newHashC->symBoards = NULL;
 	newHashC->gfn = NULL;
 	newHashC->player = 0;
 	//newHashC->init = FALSE;
@@ -660,6 +991,86 @@ void generic_hash_context_switch(int context)
 	//hash_maxPos = cCon->maxPos;
 }
 
+/******************************
+**
+** generic_hash_context_get(int context)
+**
+**  Returns the handle of the indicated hash
+**  context (a custom context number when in
+**  custom contexts mode) for the reentrant
+**  generic_hash_*_r functions. The handle is
+**  only read by them, so several threads can
+**  share it as long as each has its own
+**  scratch space.
+**
+******************************/
+
+struct hashContext* generic_hash_context_get(int context)
+{
+	int index = context;
+	if (custom_contexts_mode)
+		index = hashtableGet(context);
+	if (index < 0 || index >= hash_tot_context)
+		ExitStageRightErrorString("Attempting to get a non-existant hash context");
+	return contextList[index];
+}
+
+/******************************
+**
+** generic_hash_scratch_new(struct hashContext* con)
+**
+**  Allocates the scratch space that the
+**  reentrant functions count pieces in.
+**  A scratch can be reused for any context
+**  with at most as many pieces as con.
+**
+******************************/
+
+struct hashScratch* generic_hash_scratch_new(struct hashContext* con)
+{
+	struct hashScratch *scratch = (struct hashScratch *) SafeMalloc (sizeof(struct hashScratch));
+	scratch->numPieces = con->numPieces;
+	scratch->thisCount = (int*) SafeMalloc (sizeof(int) * con->numPieces);
+	scratch->localMins = (int*) SafeMalloc (sizeof(int) * con->numPieces);
+	scratch->miniOffset = (POSITION*) SafeMalloc (sizeof(POSITION) * (con->numPieces+2));
+	scratch->miniIndices = (int*) SafeMalloc (sizeof(int) * (con->numPieces+2));
+	scratch->boardSize = con->boardSize;
+	scratch->board = (char*) SafeMalloc (sizeof(char) * 2 * con->boardSize);
+	return scratch;
+}
+
+void generic_hash_scratch_free(struct hashScratch* scratch)
+{
+	if (scratch == NULL)
+		return;
+	SafeFree(scratch->thisCount);
+	SafeFree(scratch->localMins);
+	SafeFree(scratch->miniOffset);
+	SafeFree(scratch->miniIndices);
+	SafeFree(scratch->board);
+	SafeFree(scratch);
+}
+
+/* the global interface hashes in the current context's own arrays */
+struct hashScratch hash_context_scratch(struct hashContext *con)
+{
+	struct hashScratch scratch;
+	scratch.numPieces = con->numPieces;
+	scratch.thisCount = con->thisCount;
+	scratch.localMins = con->localMins;
+	scratch.miniOffset = con->miniOffset;
+	scratch.miniIndices = con->miniIndices;
+	scratch.boardSize = con->boardSize;
+	scratch.board = con->symBoards;
+	return scratch;
+}
+
+void hash_check_scratch(struct hashContext *con, struct hashScratch *scratch)
+{
+	if (scratch->numPieces < con->numPieces || scratch->boardSize < con->boardSize)
+		ExitStageRightErrorString("generic_hash scratch space is too small for this hash context");
+}
+
 /******************************
 **
 ** generic_hash_cur_context()
@@ -686,9 +1097,14 @@ int generic_hash_cur_context()
 
 POSITION generic_hash_max_pos()
 {
-	if (cCon->player != 0)         // using single-player boards
-		return cCon->maxPos;
-	else return (cCon->maxPos)*2;
+	return generic_hash_max_pos_r(cCon);
+}
+
+POSITION generic_hash_max_pos_r(struct hashContext* con)
+{
+	if (con->player != 0)         // using single-player boards
+		return con->maxPos;
+	else return (con->maxPos)*2;
 }
 
 /******************************
@@ -745,6 +1161,10 @@ void freeHashContext(int contextNum)
 	SafeFree(contextList[contextNum]->maxs);
 	SafeFree(contextList[contextNum]->thisCount);
 	SafeFree(contextList[contextNum]->localMins);
+	SafeFree(contextList[contextNum]->miniOffset);
+	SafeFree(contextList[contextNum]->miniIndices);
+	SafeFree(contextList[contextNum]->cfgBlock);
+	SafeFree(contextList[contextNum]->symBoards);
 
 	SafeFree(contextList[contextNum]);
 
@@ -761,31 +1181,31 @@ int validConfig(int *t)
 
 
 /* function used to map a member of gHashOffset into gOffsetIndices */
-int searchIndices(int s)
+int searchIndices(struct hashContext *con, int s)
 {
-	int i = cCon->usefulSpace;
-	while(cCon->offsetIndices[i] > s)
+	int i = con->usefulSpace;
+	while(con->offsetIndices[i] > s)
 		i--;
 	return i;
 }
 
 /* function used to map a member of gOffsetIndices into gHashOffset */
-int searchOffset(POSITION h)
+int searchOffset(struct hashContext *con, POSITION h)
 {
-	int i = cCon->usefulSpace;
-	while(cCon->hashOffset[i] > h)
+	int i = con->usefulSpace;
+	while(con->hashOffset[i] > h)
 		i--;
 	return i;
 }
 
 /* helper function used to find n choose (t1,t2,t3,...,tn) where the ti's are
    the members of *tc */
-POSITION combiCount(int* tc)
+POSITION combiCount(struct hashContext *con, int* tc)
 {
 	POSITION sum = 0, prod = 1, ind = 0,old=1,hold=0;
-	for (ind = 0; ind < cCon->numPieces - 1; ind++) {
+	for (ind = 0; ind < con->numPieces - 1; ind++) {
 		sum += tc[ind];
-		hold = nCr(sum+tc[ind+1], sum);
+		hold = nCr(con, sum+tc[ind+1], sum);
 		prod *= hold;
 		if(prod/hold !=  old)
 			ExitStageRightErrorString("Combination Calculation Wraps");
@@ -844,9 +1264,9 @@ int gpi (int n)
 }
 
 /* shorthand for n choose r */
-POSITION nCr(int n, int r)
+POSITION nCr(struct hashContext *con, int n, int r)
 {
-	return cCon->NCR[n*(cCon->boardSize+1) + r];
+	return con->NCR[n*(con->boardSize+1) + r];
 }
 
 void generic_hash_destroy()
@@ -1304,12 +1724,151 @@ void printXSpaces(int x) {
 }
 
 POSITION generic_hash_canonicalPosition(POSITION pos) {
-	char* board = (char*) SafeMalloc(sizeof(char) * cCon->boardSize);
-	char* flippedboard = (char*) SafeMalloc(sizeof(char) * cCon->boardSize);
+	struct hashScratch scratch = hash_context_scratch(cCon);
+	return generic_hash_canonicalPosition_r(cCon, &scratch, pos);
+}
+
+/* reentrant generic_hash_canonicalPosition. The board is unhashed once
+   into the scratch space. Boards of one configuration hash in the order
+   of their cells from the last to the first, so each symmetry's image
+   is compared cell by cell against the smallest image so far, stopping
+   at the first cell that differs, and only the smallest is hashed. The
+   color-flipped images are handled the same way on the flipped board. */
+POSITION generic_hash_canonicalPosition_r(struct hashContext* con, struct hashScratch* scratch, POSITION pos)
+{
+	char *board, *flipped;
+	struct symEntry *symIndex, *best = symmetriesList, *bestFlipped = NULL;
+	int player, i;
+	POSITION minPos = pos, tempPos;
+
+	hash_check_scratch(con, scratch);
+	if (con->cfgBlock == NULL)
+		return hash_canonical_legacy(con, scratch, pos);
+
+	board = scratch->board;
+	flipped = scratch->board + con->boardSize;
+	player = generic_hash_turn_r(con, pos);
+	generic_hash_unhash_r(con, scratch, pos, board);
+
+	for (symIndex = symmetriesList->next; symIndex != NULL; symIndex = symIndex->next)
+		if (symIndex->flip != 1 && hash_image_less(con, board, symIndex->sym, best->sym))
+			best = symIndex;
+	if (best != symmetriesList)
+		minPos = hash_hash_image(con, scratch, board, best->sym, player);
+
+	if (symmetriesList->flip == 1) {
+		for (i = 0; i < con->boardSize; i++) {
+			if (board[i] == con->pieces[0])
+				flipped[i] = con->pieces[1];
+			else if (board[i] == con->pieces[1])
+				flipped[i] = con->pieces[0];
+			else flipped[i] = board[i];
+		}
+		if (hash_count_table(con, scratch, flipped) < 0) // not a valid configuration
+			return hash_canonical_legacy(con, scratch, pos);
+		for (symIndex = symmetriesList->next; symIndex != NULL; symIndex = symIndex->next)
+			if (symIndex->flip == 1 &&
+			    (bestFlipped == NULL || hash_image_less(con, flipped, symIndex->sym, bestFlipped->sym)))
+				bestFlipped = symIndex;
+		if (bestFlipped != NULL) {
+			tempPos = hash_hash_image(con, scratch, flipped, bestFlipped->sym, player == 1 ? 2 : 1);
+			minPos = (tempPos < minPos) ? tempPos : minPos;
+		}
+	}
+	return minPos;
+}
+
+/* canonicalizes length positions into canonical, which may be positions
+   itself; repeated positions in a row are only canonicalized once */
+void generic_hash_canonicalPositions(POSITION* positions, POSITION* canonical, int length)
+{
+	struct hashScratch scratch = hash_context_scratch(cCon);
+	POSITION previous = kBadPosition, previousCanonical = kBadPosition;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		if (positions[i] != previous) {
+			previous = positions[i];
+			previousCanonical = generic_hash_canonicalPosition_r(cCon, &scratch, previous);
+		}
+		canonical[i] = previousCanonical;
+	}
+}
+
+/* whether board read through symA hashes lower than through symB */
+BOOLEAN hash_image_less(struct hashContext *con, char* board, int* symA, int* symB)
+{
+	int i, a, b;
+
+	for (i = con->boardSize - 1; i >= 0; i--) {
+		a = con->pieceIndex[(unsigned char) board[symA[i]]];
+		b = con->pieceIndex[(unsigned char) board[symB[i]]];
+		if (a != b)
+			return a < b;
+	}
+	return FALSE;
+}
+
+/* hashes board read through sym; board must be a valid configuration */
+POSITION hash_hash_image(struct hashContext *con, struct hashScratch *scratch, char* board, int* sym, int player)
+{
+	int block = hash_count_table(con, scratch, board);
+	POSITION temp = con->hashOffset[block] + hash_rank_table(con, scratch, board, sym, block);
+
+	if (con->player != 0) // using single-player boards, ignore "player"
+		return temp;
+	else return temp + (player-1)*(con->maxPos);
+}
+
+/*************************************
+**
+** generic_hash_canonical_benchmark()
+**
+**  Times the original canonicalization
+**  against generic_hash_canonicalPosition
+**  on the given positions, and checks that
+**  they agree. Called by the --canonbench
+**  benchmark for games using generic_hash
+**  symmetries.
+**
+*************************************/
+
+void generic_hash_canonical_benchmark(POSITION* positions, int length)
+{
+	struct hashScratch scratch = hash_context_scratch(cCon);
+	POSITION *legacy = (POSITION *) SafeMalloc(sizeof(POSITION) * length);
+	POSITION *tables = (POSITION *) SafeMalloc(sizeof(POSITION) * length);
+	int i, mismatches = 0;
+	clock_t start;
+	double legacyTime, tableTime;
+
+	start = clock();
+	for (i = 0; i < length; i++)
+		legacy[i] = hash_canonical_legacy(cCon, &scratch, positions[i]);
+	legacyTime = (double) (clock() - start) / CLOCKS_PER_SEC;
+	start = clock();
+	for (i = 0; i < length; i++)
+		tables[i] = generic_hash_canonicalPosition_r(cCon, &scratch, positions[i]);
+	tableTime = (double) (clock() - start) / CLOCKS_PER_SEC;
+	for (i = 0; i < length; i++)
+		if (legacy[i] != tables[i])
+			mismatches++;
+
+	printf("generic_hash original: %9.0f ns   symmetry tables: %9.0f ns   mismatches: %d\n",
+	       legacyTime * 1e9 / length, tableTime * 1e9 / length, mismatches);
+	SafeFree(legacy);
+	SafeFree(tables);
+}
+
+/* the original canonicalization, kept for boards the tables can't handle
+   and for generic_hash_canonical_benchmark() */
+POSITION hash_canonical_legacy(struct hashContext *con, struct hashScratch *scratch, POSITION pos) {
+	char* board = (char*) SafeMalloc(sizeof(char) * con->boardSize);
+	char* flippedboard = (char*) SafeMalloc(sizeof(char) * con->boardSize);
 	struct symEntry* symIndex = symmetriesList->next;
-	generic_hash_unhash(pos, board);
-	generic_hash_unhash(pos, flippedboard);
-	int player = generic_hash_turn(pos);
+	hash_unhash_legacy(con, scratch, pos, board);
+	hash_unhash_legacy(con, scratch, pos, flippedboard);
+	int player = generic_hash_turn_r(con, pos);
 	int flippedplayer;
 	if (player == 1)
 		flippedplayer = 2;
@@ -1317,73 +1876,73 @@ POSITION generic_hash_canonicalPosition(POSITION pos) {
 		flippedplayer = 1;
 	POSITION tempPos, sum, offset, minPos;
 	POSITION flippedsum, flippedoffset;
-	int i, j, boardSize = cCon->boardSize;
+	int i, j, boardSize = con->boardSize;
 
-	for (i = 0; i < cCon->numPieces; i++)
+	for (i = 0; i < con->numPieces; i++)
 	{
-		cCon->thisCount[i] = 0;
-		cCon->localMins[i] = cCon->mins[i];
+		scratch->thisCount[i] = 0;
+		scratch->localMins[i] = con->mins[i];
 	}
 
 	for (i = 0; i < boardSize; i++)
 	{
-		for (j = 0; j < cCon->numPieces; j++) {
-			if (board[symIndex->sym[i]] == cCon->pieces[j]) {
-				cCon->thisCount[j]++;
+		for (j = 0; j < con->numPieces; j++) {
+			if (board[symIndex->sym[i]] == con->pieces[j]) {
+				scratch->thisCount[j]++;
 			}
 		}
 	}
 	sum = 0;
-	for (i = cCon->numPieces-1; i >= 0; i--)
+	for (i = con->numPieces-1; i >= 0; i--)
 	{
-		sum += (cCon->thisCount[i] - cCon->mins[i]);
+		sum += (scratch->thisCount[i] - con->mins[i]);
 		if (i > 0) {
-			sum *= cCon->nums[i-1];
+			sum *= con->nums[i-1];
 		}
 	}
-	offset = cCon->hashOffset[searchIndices(sum)];
+	offset = con->hashOffset[searchIndices(con, sum)];
 
 	if (symmetriesList->flip == 1) {
 		//for flipped:
-		for (i = 0; i < cCon->boardSize; i++) {
-			if (flippedboard[i] == cCon->pieces[0])
-				flippedboard[i] = cCon->pieces[1];
-			else if (flippedboard[i] == cCon->pieces[1])
-				flippedboard[i] = cCon->pieces[0];
+		for (i = 0; i < con->boardSize; i++) {
+			if (flippedboard[i] == con->pieces[0])
+				flippedboard[i] = con->pieces[1];
+			else if (flippedboard[i] == con->pieces[1])
+				flippedboard[i] = con->pieces[0];
 		}
 
-		for (i = 0; i < cCon->numPieces; i++) {
-			cCon->thisCount[i] = 0;
-			cCon->localMins[i] = cCon->mins[i];
+		for (i = 0; i < con->numPieces; i++) {
+			scratch->thisCount[i] = 0;
+			scratch->localMins[i] = con->mins[i];
 		}
 
 		for (i = 0; i < boardSize; i++)
 		{
-			for (j = 0; j < cCon->numPieces; j++) {
-				if (flippedboard[symIndex->sym[i]] == cCon->pieces[j]) {
-					cCon->thisCount[j]++;
+			for (j = 0; j < con->numPieces; j++) {
+				if (flippedboard[symIndex->sym[i]] == con->pieces[j]) {
+					scratch->thisCount[j]++;
 				}
 			}
 		}
 		flippedsum = 0;
-		for (i = cCon->numPieces-1; i >= 0; i--)
+		for (i = con->numPieces-1; i >= 0; i--)
 		{
-			flippedsum += (cCon->thisCount[i] - cCon->mins[i]);
+			flippedsum += (scratch->thisCount[i] - con->mins[i]);
 			if (i > 0) {
-				flippedsum *= cCon->nums[i-1];
+				flippedsum *= con->nums[i-1];
 			}
 		}
-		flippedoffset = cCon->hashOffset[searchIndices(flippedsum)];
+		flippedoffset = con->hashOffset[searchIndices(con, flippedsum)];
 	}
 
-	minPos = generic_hash_hash_sym(board, player, offset, symmetriesList);
+	minPos = hash_hash_sym_legacy(con, scratch, board, player, offset, symmetriesList);
 	// try each symmetry, keeping the lowest position hash
 	// returns as the canonical position.
 	while (symIndex != NULL) {
 		if (symIndex->flip == 1)
-			tempPos = generic_hash_hash_sym(flippedboard, flippedplayer, flippedoffset, symIndex);
+			tempPos = hash_hash_sym_legacy(con, scratch, flippedboard, flippedplayer, flippedoffset, symIndex);
 		else
-			tempPos = generic_hash_hash_sym(board, player, offset, symIndex);
+			tempPos = hash_hash_sym_legacy(con, scratch, board, player, offset, symIndex);
 		minPos = (tempPos < minPos) ? tempPos : minPos;
 		symIndex = symIndex->next;
 
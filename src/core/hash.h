@@ -58,11 +58,28 @@ struct hashContext
 
 	int (*gfn)(int *);
 
+	short pieceIndex[256];  // piece number of each board character, -1 if none
+	int *cfgBlock;          // hashOffset block of each piece configuration, -1 if invalid
+	char *symBoards;        // two boards canonicalizations work in
+
 	int player;             // 0=Both Player boards (default), 1=1st Player only, 2=2nd only
 
 	int contextNumber;
 };
 
+/* Caller-owned working space for the reentrant generic_hash_*_r
+   functions, one per thread. Allocate with generic_hash_scratch_new. */
+struct hashScratch
+{
+	int numPieces;
+	int *thisCount;
+	int *localMins;
+	POSITION *miniOffset;
+	int *miniIndices;
+	int boardSize;
+	char *board;            // two boards, for canonicalization
+};
+
 int generic_hash_context_init();
 void generic_hash_context_switch(int context);
 void generic_hash_destroy();
@@ -78,9 +95,24 @@ char* generic_hash_unhash_tcl(POSITION pos);
 char* generic_hash_unhash(POSITION hashed, char* dest);
 int generic_hash_turn (POSITION hashed);
 void hashCounting(void);
+void generic_hash_benchmark(void);
+
+/* Reentrant versions: they never touch the current context, so any
+   number of threads may call them, each with its own scratch space. */
+struct hashContext* generic_hash_context_get(int context);
+struct hashScratch* generic_hash_scratch_new(struct hashContext* con);
+void generic_hash_scratch_free(struct hashScratch* scratch);
+POSITION generic_hash_hash_r(struct hashContext* con, struct hashScratch* scratch, char* board, int player);
+POSITION generic_hash_hash_sym_r(struct hashContext* con, struct hashScratch* scratch, char* board, int player, POSITION offset, struct symEntry* symIndex);
+char* generic_hash_unhash_r(struct hashContext* con, struct hashScratch* scratch, POSITION hashed, char* dest);
+int generic_hash_turn_r(struct hashContext* con, POSITION hashed);
+POSITION generic_hash_max_pos_r(struct hashContext* con);
+POSITION generic_hash_canonicalPosition_r(struct hashContext* con, struct hashScratch* scratch, POSITION pos);
 
 void generic_hash_init_sym(int boardType, int numRows, int numCols, int* reflections, int numReflects, int* rotations, int numRots, int flippable);
 POSITION generic_hash_canonicalPosition(POSITION pos);
+void generic_hash_canonicalPositions(POSITION* positions, POSITION* canonical, int length);
+void generic_hash_canonical_benchmark(POSITION* positions, int length);
 void flipboard(char* board);
 void generic_hash_add_sym(int* symToAdd);
 #endif /* GMCORE_HASH_H */
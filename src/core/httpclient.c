@@ -220,11 +220,8 @@ void freeresponse(httpres *res)
  */
 int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg)
 {
-	header *currHdr = NULL;
-	header *tmpHdr = NULL;
 	char buffer[64];
 	int sockFd;
-	int n;
 	*res = NULL;
 	*errMsg = NULL;
 
@@ -256,26 +253,14 @@ int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg
 	}
 
 	// Submit the http request
-	n = write(sockFd, "POST ", 5);
-	n = write(sockFd, req->path, strlen(req->path));
-	n = write(sockFd, " HTTP/1.1\r\n", 11);
-	// Add the headers
-	currHdr = req->headers;
-	while (currHdr != NULL)
+	if (writerequest(sockFd, req, body, bodyLength) != 0)
 	{
-		n = write(sockFd, currHdr->name, strlen(currHdr->name));
-		n = write(sockFd, ": ", 2);
-		n = write(sockFd, currHdr->value, strlen(currHdr->value));
-		n = write(sockFd, "\r\n", 2);
-		currHdr = currHdr->next;
+		connecterror(buffer);
+		mallocstrcpyext(errMsg, "ERROR, writing to socket: ", buffer);
+		close(sockFd);
+		return errno;
 	}
 
-	// Add the extra line to separate headers from body
-	n = write(sockFd, "\r\n", 2);
-	// Add the body (if any)
-	if (bodyLength > 0)
-		n = write(sockFd, body, bodyLength);
-
 	// Create the response
 	if ((*res = malloc(sizeof(httpres))) == NULL)
 	{
@@ -296,29 +281,346 @@ int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg
 	shutdown(sockFd,2);
 
 	// Free the malloc'd memory
+	freerequest(req);
+
+	return 0;
+}
+
+/**
+ * Writes the request line, headers and body of the specified httpreq to
+ * the socket. The request is assembled into a single buffer first so it
+ * goes out in as few packets as possible, which matters once several
+ * requests are pipelined on one connection. Returns 0 if everything was
+ * written, non-zero otherwise (errno is left set).
+ *
+ * sockFd - connected socket to write to
+ * req - httpreq struct to write
+ * body - content for the body, can be NULL
+ * bodyLength - length of the body content
+ */
+int writerequest(int sockFd, httpreq *req, char body[], int bodyLength)
+{
+	header *currHdr;
+	char *buffer;
+	char *p;
+	int len;
+	int n;
+
+	len = strlen("POST ") + strlen(req->path) + strlen(" HTTP/1.1\r\n") + 2 + bodyLength;
+	for (currHdr = req->headers; currHdr != NULL; currHdr = currHdr->next)
+		len += strlen(currHdr->name) + 2 + strlen(currHdr->value) + 2;
+
+	if ((buffer = malloc(len+1)) == NULL)
+	{
+		fprintf(stderr,"ERROR, could not allocate memory for http request\n");
+		return 1;
+	}
+
+	p = buffer;
+	p += sprintf(p, "POST %s HTTP/1.1\r\n", req->path);
+	for (currHdr = req->headers; currHdr != NULL; currHdr = currHdr->next)
+		p += sprintf(p, "%s: %s\r\n", currHdr->name, currHdr->value);
+	// Add the extra line to separate headers from body
+	memcpy(p, "\r\n", 2);
+	p += 2;
+	// Add the body (if any)
+	if (bodyLength > 0)
+		memcpy(p, body, bodyLength);
+
+	for (p = buffer; len > 0; p += n, len -= n)
+	{
+#ifdef MSG_NOSIGNAL
+		n = send(sockFd, p, len, MSG_NOSIGNAL); // a dropped peer is an error, not a SIGPIPE
+#else
+		n = write(sockFd, p, len);
+#endif
+		if (n < 0 && errno == EINTR)
+			n = 0;
+		else if (n <= 0)
+		{
+			free(buffer);
+			return 1;
+		}
+	}
+	free(buffer);
+	return 0;
+}
+
+/**
+ * Frees the specified httpreq and all its request headers.
+ *
+ * req - httpreq struct to free
+ */
+void freerequest(httpreq *req)
+{
+	header *currHdr;
+	header *tmpHdr;
+
+	if (req == NULL)
+		return;
+
 	currHdr = req->headers;
 	while (currHdr != NULL)
 	{
+		tmpHdr = currHdr->next;
 		if (currHdr->name != NULL)
 			free(currHdr->name);
 		if (currHdr->value != NULL)
 			free(currHdr->value);
-		if (tmpHdr != NULL)
-			free(tmpHdr);
-		tmpHdr = currHdr;
-		currHdr = currHdr->next;
+		free(currHdr);
+		currHdr = tmpHdr;
 	}
-	if (tmpHdr != NULL)
-		free(tmpHdr);
 	if (req->hostName != NULL)
 		free(req->hostName);
 	if (req->path != NULL)
 		free(req->path);
 	free(req);
+}
+
+/**
+ * Connects the socket of the specified httpconn to its server.
+ * Returns 0 if successful, otherwise populates errMsg and returns
+ * non-zero.
+ */
+static int connectsocket(httpconn *conn, char** errMsg)
+{
+	char buffer[64];
 
+	conn->in = NULL;
+	conn->open = 0;
+	if ((conn->sockFd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+	{
+		connecterror(buffer);
+		mallocstrcpyext(errMsg, "ERROR, creating socket: ", buffer);
+		return errno;
+	}
+	if (connect(conn->sockFd, &(conn->addr->sock.res), sizeof(struct sockaddr_in)) < 0)
+	{
+		connecterror(buffer);
+		mallocstrcpyext(errMsg, "ERROR, opening socket: ", buffer);
+		close(conn->sockFd);
+		return errno;
+	}
+	if ((conn->in = fdopen(conn->sockFd, "r")) == NULL)
+	{
+		mallocstrcpy(errMsg, "ERROR, could not buffer the socket");
+		close(conn->sockFd);
+		return 1;
+	}
+	conn->open = 1;
 	return 0;
 }
 
+/**
+ * Opens a connection to the specified url that stays open across
+ * requests. Populates the handle to the httpconn struct, which must be
+ * closed later using closeconnection. Returns 0 if successful. Otherwise,
+ * returns a non-zero value and populates the errMsg string.
+ *
+ * WARNING: clobbers url
+ *
+ * url - url the requests will use (minus the http:// prefix)
+ * conn - handle to the httpconn struct
+ * errMsg - handle to the error message string
+ */
+int openconnection(char url[], httpconn** conn, char** errMsg)
+{
+	int errCode;
+
+	*conn = NULL;
+	*errMsg = NULL;
+
+	if ((*conn = malloc(sizeof(httpconn))) == NULL)
+	{
+		fprintf(stderr,"ERROR, could not allocate memory for http connection\n");
+		return 1;
+	}
+	(*conn)->in = NULL;
+	(*conn)->open = 0;
+
+	// Parse and resolve the url once for all requests
+	if ((errCode = newrequest(url, &((*conn)->addr), errMsg)) != 0 ||
+	    (errCode = connectsocket(*conn, errMsg)) != 0)
+	{
+		freerequest((*conn)->addr);
+		free(*conn);
+		*conn = NULL;
+		return errCode;
+	}
+	return 0;
+}
+
+/**
+ * Drops the socket of the specified httpconn, along with any responses
+ * still unread, and connects again to the same server. Returns 0 if
+ * successful. Otherwise, returns a non-zero value and populates the
+ * errMsg string.
+ *
+ * conn - httpconn struct to reconnect
+ * errMsg - handle to the error message string
+ */
+int reopenconnection(httpconn *conn, char** errMsg)
+{
+	*errMsg = NULL;
+	if (conn->in != NULL)
+		fclose(conn->in);
+	return connectsocket(conn, errMsg);
+}
+
+/**
+ * Creates a new httpreq to be sent over the specified connection with
+ * sendrequest. Unlike newrequest, the request asks the server to keep
+ * the connection open. Returns 0 if successful.
+ *
+ * conn - httpconn struct the request will be sent over
+ * req - handle to the httpreq struct
+ */
+int newconnrequest(httpconn *conn, httpreq** req)
+{
+	if ((*req = malloc(sizeof(httpreq))) == NULL)
+	{
+		fprintf(stderr,"ERROR, could not allocate memory for http request\n");
+		return 1;
+	}
+
+	(*req)->headers = NULL;
+	(*req)->serverAddr = conn->addr->serverAddr;
+	(*req)->sock = conn->addr->sock;
+	(*req)->portNum = conn->addr->portNum;
+	(*req)->hostName = NULL;
+	(*req)->path = NULL;
+	if (mallocstrcpy(&((*req)->hostName), conn->addr->hostName) != 0 ||
+	    mallocstrcpy(&((*req)->path), conn->addr->path) != 0)
+	{
+		freerequest(*req);
+		*req = NULL;
+		return 1;
+	}
+
+	// Add the required headers
+	addheader(*req, "Host", (*req)->hostName); // Required by HTTP 1.1
+	addheader(*req, "Connection", "keep-alive"); // Reuse the conn for the next request
+	addheader(*req, "User-Agent", "Gamesman/1.0"); // So we can identify ourselves
+	addheader(*req, "Content-Type", "application/octet-stream"); // Body content will be binary
+	return 0;
+}
+
+/**
+ * Sends the specified httpreq over the connection without waiting for
+ * the response, which is read later with receiveresponse. Frees the
+ * httpreq and all its request headers. Returns 0 if successful. If the
+ * connection is gone, returns a non-zero value and populates the errMsg
+ * string.
+ *
+ * conn - httpconn struct to send over
+ * req - httpreq struct made with newconnrequest
+ * body - content for the body of the HTTP POST, can be NULL
+ * bodyLength - length of the body content, can be 0 if body is NULL
+ * errMsg - handle to the error message string
+ */
+int sendrequest(httpconn *conn, httpreq *req, char body[], int bodyLength, char** errMsg)
+{
+	char buffer[64];
+	int errCode = 0;
+	*errMsg = NULL;
+
+	// Add the content-length header
+	net_itoa(bodyLength, buffer);
+	addheader(req, "Content-Length", buffer);
+
+	if (!conn->open || writerequest(conn->sockFd, req, body, bodyLength) != 0)
+	{
+		conn->open = 0;
+		mallocstrcpy(errMsg, "ERROR, connection to the server was lost");
+		errCode = 1;
+	}
+	freerequest(req);
+	return errCode;
+}
+
+/**
+ * Reads the response to the oldest request sent over the connection
+ * that has not been answered yet, and populates the handle to the
+ * httpres struct (which must be freed later using freeresponse).
+ * Returns 0 if successful. If the server dropped the connection before
+ * the whole response arrived, returns a non-zero value and populates
+ * the errMsg string. The open field of the connection is cleared when
+ * the server says it will close the connection after this response.
+ *
+ * conn - httpconn struct to read from
+ * res - handle to the httpres struct
+ * errMsg - handle to the error message string
+ */
+int receiveresponse(httpconn *conn, httpres** res, char** errMsg)
+{
+	char *hdrVal;
+	int expected;
+
+	*res = NULL;
+	*errMsg = NULL;
+
+	if (conn->in == NULL)
+	{
+		mallocstrcpy(errMsg, "ERROR, connection to the server was lost");
+		return 1;
+	}
+
+	if ((*res = malloc(sizeof(httpres))) == NULL)
+	{
+		fprintf(stderr,"ERROR, could not allocate memory for http response\n");
+		return 1;
+	}
+	(*res)->headers = NULL;
+	(*res)->status = NULL;
+	(*res)->body = NULL;
+	(*res)->statusCode = 0;
+	(*res)->bodyLength = 0;
+
+	readresponsefrom(conn->in, *res);
+
+	// A response cut short means the connection is gone
+	expected = 0;
+	getheader(*res, "Content-Length", &hdrVal);
+	if (hdrVal != NULL)
+	{
+		expected = atoi(hdrVal);
+		free(hdrVal);
+	}
+	if ((*res)->status == NULL || (expected > 0 && (*res)->bodyLength != expected))
+	{
+		conn->open = 0;
+		freeresponse(*res);
+		*res = NULL;
+		mallocstrcpy(errMsg, "ERROR, connection to the server was lost");
+		return 1;
+	}
+
+	getheader(*res, "Connection", &hdrVal);
+	if (hdrVal != NULL)
+	{
+		lcstrcpy(hdrVal, hdrVal);
+		if (strcmp(hdrVal, "close") == 0)
+			conn->open = 0;
+		free(hdrVal);
+	}
+	return 0;
+}
+
+/**
+ * Closes the specified connection and frees the httpconn struct.
+ *
+ * conn - httpconn struct to close
+ */
+void closeconnection(httpconn *conn)
+{
+	if (conn == NULL)
+		return;
+	if (conn->in != NULL)
+		fclose(conn->in);
+	freerequest(conn->addr);
+	free(conn);
+}
+
 /**
  * Reads the HTTP response from the specified socket and populates the specified
  * httpres struct accordingly.
@@ -327,14 +629,41 @@ int post(httpreq *req, char body[], int bodyLength, httpres** res, char** errMsg
  * res - httpres struct to populate
  */
 void readresponse(int sockFd, httpres *res)
+{
+	FILE *in;
+	int fd;
+
+	if (res == NULL)
+		return;
+
+	// Buffer the reads rather than making a system call per byte
+	if ((fd = dup(sockFd)) < 0)
+		return;
+	if ((in = fdopen(fd, "r")) == NULL)
+	{
+		close(fd);
+		return;
+	}
+	readresponsefrom(in, res);
+	fclose(in);
+}
+
+/**
+ * Reads one HTTP response from the specified stream and populates the
+ * specified httpres struct accordingly. Stops at the end of the body, so
+ * the next response on a kept-alive connection can be read afterwards.
+ *
+ * in - buffered stream from which to read
+ * res - httpres struct to populate
+ */
+void readresponsefrom(FILE *in, httpres *res)
 {
 	header *currHdr = NULL;
 	header *tmpHdr = NULL;
 	char *pos = NULL;
 	char buffer[512];
-	char c[1];
 	int p;
-	int n;
+	int c;
 
 	if (res == NULL)
 		return;
@@ -343,14 +672,10 @@ void readresponse(int sockFd, httpres *res)
 	while (1)
 	{
 		p = 0;
-		while ((n = read(sockFd, c, 1)) != EOF)
+		while ((c = getc(in)) != EOF && c != '\n')
 		{
-			if (c[0] == '\r')
-				continue;
-			else if (c[0] == '\n')
-				break;
-			else
-				buffer[p++] = c[0];
+			if (c != '\r' && p < (int)sizeof(buffer)-1)
+				buffer[p++] = c;
 		}
 		buffer[p] = '\0';
 
@@ -451,10 +776,11 @@ void readresponse(int sockFd, httpres *res)
 				fprintf(stderr,"ERROR, could not allocate memory for response body\n");
 				return;
 			}
-			res->bodyLength = read(sockFd, res->body, p);
+			res->bodyLength = fread(res->body, 1, p, in);
 			res->body[p] = '\0';
 			//printf("expected: %d read: %d body: '%s'\n", p, res->bodyLength, res->body);
 		}
+		free(pos);
 	}
 }
 
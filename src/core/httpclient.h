@@ -41,6 +41,18 @@ struct httpres_struct
 };
 typedef struct httpres_struct httpres;
 
+/* A connection kept open across requests. Requests made with
+   newconnrequest may be sent back to back before their responses
+   are read; the responses come back in the order the requests went out. */
+struct httpconn_struct
+{
+	httpreq *addr;  // the parsed url, reused for each request
+	int sockFd;
+	FILE *in;       // buffered reader over sockFd
+	int open;       // 0 once the server closed or said it will close
+};
+typedef struct httpconn_struct httpconn;
+
 
 /* FUNCTION DECLARATIONS */
 #ifndef htonll
@@ -56,6 +68,15 @@ void getheader(httpres *res, char name[], char** hdrVal); //get header
 void getstatus(httpres *res, char** status); // get a copy of the status
 void freeresponse(httpres *res); //free response when done
 void readresponse(int sockFd, httpres *res); //read response (private)
+void readresponsefrom(FILE *in, httpres *res); //read response from a buffered stream (private)
+int writerequest(int sockFd, httpreq *req, char body[], int bodyLength); //write request in one buffer (private)
+void freerequest(httpreq *req); //free a request and its headers (private)
+int openconnection(char url[], httpconn** conn, char** errMsg); //connect and keep the connection open
+int reopenconnection(httpconn *conn, char** errMsg); //reconnect to the same server after a drop
+int newconnrequest(httpconn *conn, httpreq** req); //instantiate a keep-alive request for a connection
+int sendrequest(httpconn *conn, httpreq *req, char body[], int bodyLength, char** errMsg); //send without waiting: frees req
+int receiveresponse(httpconn *conn, httpres** res, char** errMsg); //read the response to the oldest unanswered request
+void closeconnection(httpconn *conn); //close and free a connection
 void lcstrcpy(char to[], char from[]);  //lower case copy
 int responseerrorcheck(httpres *res, char** errMsg); // checks for bad server response and returns an error code and message
 void connecterror(char errMsg[]); // copies the error message corresponding to the errno into the specified buffer
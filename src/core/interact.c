@@ -214,11 +214,15 @@ STRING InteractValueCharToValueString(char value_char) {
 	}
 }
 
-void InteractPrintJSONPositionValue(POSITION pos) {
-	char value_char = gValueLetter[GetValueOfPosition(pos)];
+void InteractPrintJSONValue(VALUE value) {
+	char value_char = gValueLetter[value];
 	printf("\"value\":\"%s\"", InteractValueCharToValueString(value_char));
 }
 
+void InteractPrintJSONPositionValue(POSITION pos) {
+	InteractPrintJSONValue(GetValueOfPosition(pos));
+}
+
 void InteractFreeBoardSting(STRING board) {
 	if (!strcmp(board, "Implement Me")) {
 	} else {
@@ -234,6 +238,10 @@ void ServerInteractLoop(void) {
 	POSITION choice;
 	MOVELIST *all_next_moves = NULL;
 	MOVELIST *current_move = NULL;
+	POSITION *choices = NULL;
+	VALUE *choice_values = NULL;
+	REMOTENESS *choice_remotenesses = NULL;
+	int num_choices, max_choices = 0, i;
 	STRING invalid_board_string = 
 		"\n" RESULT "{\"status\":\"error\",\"reason\":\"Invalid board string.\"}";
 	MOVE move;
@@ -458,14 +466,31 @@ void ServerInteractLoop(void) {
 			}
 			printf(RESULT "{\"status\":\"ok\",\"response\":[");
 			if (Primitive(pos) == undecided) {
-				current_move = all_next_moves = GenerateMoves(pos);
-				while (current_move) {
-					choice = DoMove(pos, current_move->move);
+				/* Look all of the children up at once */
+				all_next_moves = GenerateMoves(pos);
+				for (num_choices = 0, current_move = all_next_moves; current_move; current_move = current_move->next)
+					num_choices++;
+				if (num_choices > max_choices) {
+					if (choices) {
+						SafeFree(choices);
+						SafeFree(choice_values);
+						SafeFree(choice_remotenesses);
+					}
+					max_choices = num_choices;
+					choices = (POSITION *) SafeMalloc(max_choices * sizeof(POSITION));
+					choice_values = (VALUE *) SafeMalloc(max_choices * sizeof(VALUE));
+					choice_remotenesses = (REMOTENESS *) SafeMalloc(max_choices * sizeof(REMOTENESS));
+				}
+				for (i = 0, current_move = all_next_moves; current_move; current_move = current_move->next)
+					choices[i++] = DoMove(pos, current_move->move);
+				MoveTableChildData(pos, all_next_moves, choices, num_choices, choice_values, choice_remotenesses);
+				for (i = 0, current_move = all_next_moves; current_move; i++) {
+					choice = choices[i];
 					board = PositionToString(choice);
 					printf("{\"board\":\"%s\",", board);
 					InteractFreeBoardSting(board);
-					printf("\"remoteness\":%d,", Remoteness(choice));
-					InteractPrintJSONPositionValue(choice);
+					printf("\"remoteness\":%d,", choice_remotenesses[i]);
+					InteractPrintJSONValue(choice_values[i]);
 					move_string = MoveToString(current_move->move);
 					printf(",\"move\":\"%s\"", move_string);
 					SafeFree(move_string);
@@ -525,6 +550,11 @@ void ServerInteractLoop(void) {
 		}
 	}
 	SafeFree(input);
+	if (choices) {
+		SafeFree(choices);
+		SafeFree(choice_values);
+		SafeFree(choice_remotenesses);
+	}
 	#undef RESULT
 }
 
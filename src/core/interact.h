@@ -16,6 +16,7 @@ STRING InteractReadPosition(STRING input, POSITION * result);
 STRING InteractReadLong(STRING input, long * result);
 STRING InteractReadBoardString(STRING input, char ** result);
 STRING InteractValueCharToValueString(char value_char);
+void InteractPrintJSONValue(VALUE value);
 void InteractPrintJSONPositionValue(POSITION pos);
 void InteractFreeBoardSting(STRING board);
 void InteractCheckErrantExtra(STRING input, int max_words);
@@ -34,6 +34,7 @@
 #include "solveloopyga.h"
 #include "solveloopy.h"
 #include "solvezero.h"
+#include "solvevalueonly.h"
 #include "solvestd.h"
 #include "solvevsstd.h"
 #include "solvevsloopy.h"
@@ -103,7 +104,9 @@ void SetSolver()
 	/* if solver set externally, leave alone */
 	if (gSolver != NULL)
 		return;
-	else if(kLoopy) {
+	else if(gValueOnlySolver) {
+		gSolver = &DetermineValueOnly;
+	} else if(kLoopy) {
 		if (gGoAgain == DefaultGoAgain) {
 			if(gBitPerfectDBSolver) {
 				gSolver = &VSDetermineLoopyValue;
@@ -117,6 +120,7 @@ void SetSolver()
 	} else if(gZeroMemSolver) {
 		gSolver = &DetermineZeroValue;
 	} else if(gBottomUp) {
+		gBitPerfectDBSolver = FALSE; // it stores through the legacy slots
 		gSolver = &DetermineValueBU;
 	} else if(gAlphaBeta) {
 		gSolver = &DetermineValueAlphaBeta;
@@ -140,6 +144,8 @@ BOOLEAN InitializeGetMoveValuesStuff()
 }
 VALUE DetermineValue(POSITION position)
 {
+	BOOLEAN solved = TRUE; // FALSE if the database was loaded as it was
+
 	gUseGPS = gGlobalPositionSolver && gUndoMove != NULL;
 
 	if (gAnalyzing && !LoadAnalysis()) {
@@ -170,7 +176,9 @@ VALUE DetermineValue(POSITION position)
 		//}
 
 	} else if(gLoadDatabase && LoadDatabase() && LoadOpenPositionsData()) {
+		solved = FALSE;
 		if (GetValueOfPosition(position) == undecided) {
+			solved = TRUE;
 			if (gPrintDatabaseInfo)
 				printf("\nRe-evaluating the value of %s...", kGameName);
 			gSolver(position);
@@ -211,6 +219,8 @@ VALUE DetermineValue(POSITION position)
 	gUseGPS = FALSE;
 	gValue = GetValueOfPosition(position);
 
+	MoveTableInitialize(solved);
+
 	return gValue;
 }
 
@@ -294,6 +304,30 @@ void HandleArguments (int argc, char *argv[])
 			gBitPerfectDB = FALSE;
 			gBitPerfectDBSolver = FALSE;
 		}
+		else if(!strcasecmp(argv[i], "--filedbmem")) {
+			if ((i + 1) < argc) {
+				gFileDBMemoryMB = atoi(argv[++i]);
+				if (gFileDBMemoryMB < 0) {
+					fprintf(stderr, "File database memory must not be negative\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for filedbmem option\n\n");
+				gMessage = TRUE;
+			}
+		}
+		else if(!strcasecmp(argv[i], "--filedbreadahead")) {
+			if ((i + 1) < argc) {
+				gFileDBReadahead = atoi(argv[++i]);
+				if (gFileDBReadahead < 0) {
+					fprintf(stderr, "File database read-ahead must not be negative\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for filedbreadahead option\n\n");
+				gMessage = TRUE;
+			}
+		}
 		else if(!strcasecmp(argv[i], "--numoptions")) {
 			fprintf(stderr, "\nNumber of Options: %d\n", NumberOfOptions());
 			gMessage = TRUE;
@@ -317,6 +351,11 @@ void HandleArguments (int argc, char *argv[])
 			gBitPerfectDBSolver = FALSE;
 		} else if(!strcasecmp(argv[i], "--2bit")) {
 			gTwoBits = TRUE;
+		} else if(!strcasecmp(argv[i], "--valueonly")) {
+			gValueOnlySolver = TRUE;
+			gTwoBits = TRUE;
+			gBitPerfectDB = FALSE;
+			gBitPerfectDBSolver = FALSE;
 		} else if(!strcasecmp(argv[i], "--colldb")) {
 			gCollDB = TRUE;
 		}
@@ -335,6 +374,17 @@ void HandleArguments (int argc, char *argv[])
 			gBottomUp = TRUE;
 		} else if(!strcasecmp(argv[i], "--alpha-beta")) {
 			gAlphaBeta = TRUE;
+		} else if(!strcasecmp(argv[i], "--abtable")) {
+			if ((i + 1) < argc) {
+				gAlphaBetaTableMB = atoi(argv[++i]);
+				if (gAlphaBetaTableMB < 1) {
+					fprintf(stderr, "Alpha-beta table size must be at least 1 MB\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for abtable option\n\n");
+				gMessage = TRUE;
+			}
 		} else if(!strcasecmp(argv[i], "--lowmem")) {
 			gZeroMemSolver = TRUE;
 		} else if(!strcasecmp(argv[i], "--slicessolver")) {
@@ -355,6 +405,8 @@ void HandleArguments (int argc, char *argv[])
 			gBitPerfectDBAdjust = FALSE;
 		} else if(!strcasecmp(argv[i], "--bpdbverbose")) {
 			gBitPerfectDBVerbose = TRUE;
+		} else if(!strcasecmp(argv[i], "--bpdbconcurrent")) {
+			gBitPerfectDBConcurrent = TRUE;
 		} else if(!strcasecmp(argv[i], "--bpdbzeroplayer")) {
 			gBitPerfectDBZeroMemoryPlayer = TRUE;
 		} else if(!strcasecmp(argv[i], "--notiers")) {
@@ -376,6 +428,63 @@ void HandleArguments (int argc, char *argv[])
 				fprintf(stderr, "No tier given for solve only tier option\n\n");
 				gMessage = TRUE;
 			}
+		} else if(!strcasecmp(argv[i], "--workers")) {
+			if ((i + 1) < argc) {
+				gSolverWorkers = atoi(argv[++i]);
+				if (gSolverWorkers < 1) {
+					fprintf(stderr, "Number of workers must be at least 1\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for workers option\n\n");
+				gMessage = TRUE;
+			}
+		} else if(!strcasecmp(argv[i], "--tierjobs")) {
+			if ((i + 1) < argc) {
+				gTierJobs = atoi(argv[++i]);
+				if (gTierJobs < 1) {
+					fprintf(stderr, "Number of tier jobs must be at least 1\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for tierjobs option\n\n");
+				gMessage = TRUE;
+			}
+		} else if(!strcasecmp(argv[i], "--frontiermem")) {
+			if ((i + 1) < argc) {
+				gFrontierMemoryMB = atoi(argv[++i]);
+				if (gFrontierMemoryMB < 0) {
+					fprintf(stderr, "Frontier memory must not be negative\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for frontiermem option\n\n");
+				gMessage = TRUE;
+			}
+		} else if(!strcasecmp(argv[i], "--checkpoint")) {
+			if ((i + 1) < argc) {
+				gCheckpointSeconds = atoi(argv[++i]);
+				if (gCheckpointSeconds < 0) {
+					fprintf(stderr, "Seconds between checkpoints must not be negative\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for checkpoint option\n\n");
+				gMessage = TRUE;
+			}
+		} else if(!strcasecmp(argv[i], "--tiercache")) {
+			if ((i + 1) < argc) {
+				gTierCacheMB = atoi(argv[++i]);
+				if (gTierCacheMB < 0) {
+					fprintf(stderr, "Tier cache size must not be negative\n\n");
+					gMessage = TRUE;
+				}
+			} else {
+				fprintf(stderr, "No number given for tiercache option\n\n");
+				gMessage = TRUE;
+			}
+		} else if(!strcasecmp(argv[i], "--movetable")) {
+			gUseMoveTable = TRUE;
 		} else if(!strcasecmp(argv[i], "--notiermenu")) {
 			gTierSolverMenu = FALSE;
 		} else if(!strcasecmp(argv[i], "--notierprint")) {
@@ -468,12 +577,29 @@ void HandleArguments (int argc, char *argv[])
 			gNetworkDB = TRUE;
 			gBitPerfectDB = FALSE;
 			gBitPerfectDBSolver = FALSE;
+			if ((i + 1) < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+				ServerAddress = argv[++i];
+			}
+		} else if(!strcasecmp(argv[i], "--netcache")) {
 			if ((i + 1) < argc) {
-				ServerAddress = argv[i++];
+				gNetDBCacheSize = atoi(argv[++i]);
+				if (gNetDBCacheSize < 0) {
+					gNetDBCacheSize = 0;
+				}
 			}
 		} else if(!strcasecmp(argv[i],"--hashCounting")) {
 			hashCounting();
 			return;
+		} else if(!strcasecmp(argv[i],"--canonbench")) {
+			InitializeGame();
+			CanonicalBenchmark();
+			gMessage = TRUE;
+			i += argc;
+		} else if(!strcasecmp(argv[i],"--hashbench")) {
+			InitializeGame();
+			generic_hash_benchmark();
+			gMessage = TRUE;
+			i += argc;
 		} else if(!strcasecmp(argv[i],"--hashtable_buckets")) {
 			if(argc < (i + 2)) {
 				fprintf(stderr, "\nUsage: %s --hashtable_buckets <n>\n\n",
@@ -68,6 +68,11 @@ MEX             memdb_get_mex                   (POSITION pos);
 MEX             memdb_get_mex_file              (POSITION pos);
 void            memdb_set_mex                   (POSITION pos, MEX mex);
 
+/* Bulk */
+void            memdb_get_bulk_data             (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void            memdb_get_range_data            (POSITION start, int length, VALUE* values, REMOTENESS* remotenesses);
+void            memdb_put_bulk_data             (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+
 /* saving to/reading from a file */
 BOOLEAN         memdb_save_database             ();
 BOOLEAN         memdb_load_database             ();
@@ -137,6 +142,8 @@ void memdb_init(DB_Table *new_db)
 		new_db->unmark_visited = memdb_unmark_visited;
 		new_db->put_mex = memdb_set_mex;
 		new_db->put_winby = (void (*)(POSITION, WINBY))memdb_set_mex;
+		new_db->put_bulk_data = memdb_put_bulk_data;
+		new_db->get_range_data = memdb_get_range_data;
 		new_db->free_db = memdb_free;
 	}
 
@@ -145,6 +152,7 @@ void memdb_init(DB_Table *new_db)
 	new_db->check_visited = memdb_check_visited;
 	new_db->get_mex = memdb_get_mex;
 	new_db->get_winby = (WINBY (*)(POSITION))memdb_get_mex;
+	new_db->get_bulk_data = memdb_get_bulk_data;
 	new_db->save_database = memdb_save_database;
 	new_db->load_database = memdb_load_database;
 }
@@ -281,6 +289,58 @@ MEX memdb_get_mex(POSITION pos)
 	return (MEX)(((int)*ptr & MEX_MASK) >> MEX_SHIFT);
 }
 
+/* Each cell is read once for all of the fields asked for (WinBy shares the
+   mex bits). Children's cells are scattered over the table, so they are all
+   prefetched before the first one is read. */
+void memdb_get_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i, cell;
+
+	if (memdb_get_raw == memdb_get_raw_ptr)
+		for (i = 0; i < length; i++)
+			__builtin_prefetch(&memdb_array[positions[i]]);
+	for (i = 0; i < length; i++) {
+		cell = *memdb_get_raw(positions[i]);
+		db_unpack_cell(cell, i, values, remotenesses, mexes);
+		if (winbys != NULL)
+			winbys[i] = (WINBY)((cell & MEX_MASK) >> MEX_SHIFT);
+	}
+}
+
+/* A straight run over the array, which touches nothing else, so threads
+   can each read their own range. */
+void memdb_get_range_data(POSITION start, int length, VALUE* values, REMOTENESS* remotenesses)
+{
+	cellValue *cells = memdb_array + start;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		values[i] = (VALUE)(cells[i] & VALUE_MASK);
+		remotenesses[i] = (REMOTENESS)((cells[i] & REMOTENESS_MASK) >> REMOTENESS_SHIFT);
+	}
+}
+
+void memdb_put_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i, cell;
+	cellValue *ptr;
+
+	for (i = 0; i < length; i++)
+		__builtin_prefetch(&memdb_array[positions[i]], 1);
+	for (i = 0; i < length; i++) {
+		if (remotenesses != NULL && remotenesses[i] > REMOTENESS_MAX) {
+			printf("Remoteness request (%d) for " POSITION_FORMAT  " larger than Max Remoteness (%d)\n",remotenesses[i],positions[i],REMOTENESS_MAX);
+			ExitStageRight();
+			exit(0);
+		}
+		ptr = memdb_get_raw(positions[i]);
+		cell = db_pack_cell(*ptr, i, values, remotenesses, mexes);
+		if (winbys != NULL)
+			cell = (cell & ~MEX_MASK) | ((winbys[i] & MEX_MAX) << MEX_SHIFT);
+		*ptr = (cellValue) cell;
+	}
+}
+
 
 /***********
  ************
@@ -490,8 +490,106 @@ BOOLEAN DefaultGoAgain(POSITION pos,MOVE move)
 	return FALSE; /* Always toggle turn by default */
 }
 
+/* Fills children and moves (room for MAXFANOUT of each) with the children
+   of pos and the moves that lead to them, in GenerateMoves order, and
+   returns how many there are. Modules that set gGenerateChildrenFunPtr
+   fill the arrays themselves; for the rest this walks their MOVELIST. */
+int GenerateChildren(POSITION pos, POSITION* children, MOVE* moves)
+{
+	MOVELIST *head, *ptr;
+	int n = 0;
+
+	if (gGenerateChildrenFunPtr != NULL)
+		return gGenerateChildrenFunPtr(pos, children, moves);
+	head = GenerateMoves(pos);
+	for (ptr = head; ptr != NULL; ptr = ptr->next, n++) {
+		if (n == MAXFANOUT) {
+			fprintf(stderr, "\n*** ERROR: " POSITION_FORMAT " has more than MAXFANOUT (%d) moves\n", pos, MAXFANOUT);
+			ExitStageRight();
+		}
+		moves[n] = ptr->move;
+		children[n] = DoMove(pos, ptr->move);
+		if (gUseGPS)
+			gUndoMove(ptr->move);
+	}
+	FreeMoveList(head);
+	return n;
+}
 
 
+
+/* Canonicalizes length positions into canonical (which may be positions
+   itself), as a batch when the game sets gCanonicalPositionBulkFunPtr or
+   uses generic_hash symmetries */
+void CanonicalPositionBulk(POSITION* positions, POSITION* canonical, int length)
+{
+	int i;
+
+	if (gCanonicalPositionBulkFunPtr != NULL)
+		gCanonicalPositionBulkFunPtr(positions, canonical, length);
+	else if (gCanonicalPosition == generic_hash_canonicalPosition)
+		generic_hash_canonicalPositions(positions, canonical, length);
+	else
+		for (i = 0; i < length; i++)
+			canonical[i] = gCanonicalPosition(positions[i]);
+}
+
+/* --canonbench: times gCanonicalPosition on positions met in random
+   playouts, one at a time and as a batch (and for generic_hash
+   symmetries against the original canonicalization too) */
+void CanonicalBenchmark()
+{
+	POSITION *positions, *single, *batch;
+	POSITION pos = gInitialPosition;
+	MOVELIST *moves, *ptr;
+	int i, pick, depth = 0, mismatches = 0, length = 200000;
+	clock_t start;
+	double singleTime, batchTime;
+
+	if (gCanonicalPosition == NULL) {
+		printf("This game has no symmetries to canonicalize.\n");
+		return;
+	}
+	positions = (POSITION *) SafeMalloc(sizeof(POSITION) * length);
+	single = (POSITION *) SafeMalloc(sizeof(POSITION) * length);
+	batch = (POSITION *) SafeMalloc(sizeof(POSITION) * length);
+	for (i = 0; i < length; i++) {
+		moves = NULL;
+		if (depth > 500 || Primitive(pos) != undecided || (moves = GenerateMoves(pos)) == NULL) {
+			pos = gInitialPosition;
+			depth = 0;
+		} else {
+			for (ptr = moves, pick = GetRandomNumber(MoveListLength(moves)); pick > 0; pick--)
+				ptr = ptr->next;
+			pos = DoMove(pos, ptr->move);
+			depth++;
+		}
+		FreeMoveList(moves);
+		positions[i] = pos;
+	}
+
+	start = clock();
+	for (i = 0; i < length; i++)
+		single[i] = gCanonicalPosition(positions[i]);
+	singleTime = (double) (clock() - start) / CLOCKS_PER_SEC;
+	start = clock();
+	CanonicalPositionBulk(positions, batch, length);
+	batchTime = (double) (clock() - start) / CLOCKS_PER_SEC;
+	for (i = 0; i < length; i++)
+		if (single[i] != batch[i])
+			mismatches++;
+
+	printf("%d positions from random playouts\n", length);
+	printf("gCanonicalPosition:    %9.0f ns   CanonicalPositionBulk: %9.0f ns   mismatches: %d\n",
+	       singleTime * 1e9 / length, batchTime * 1e9 / length, mismatches);
+	if (gCanonicalPosition == generic_hash_canonicalPosition)
+		generic_hash_canonical_benchmark(positions, length);
+
+	SafeFree(positions);
+	SafeFree(single);
+	SafeFree(batch);
+}
+
 POSITION GetNextPosition()
 {
 	static POSITION thePosition = 0; /* Cycle through every position */
@@ -57,6 +57,9 @@ void            FoundBadPosition                (POSITION pos, POSITION parent,
 
 BOOLEAN         DefaultGoAgain                  (POSITION pos, MOVE move);
 POSITION        GetNextPosition                 ();             // TODO: Move to solve
+int             GenerateChildren                (POSITION pos, POSITION* children, MOVE* moves);
+void            CanonicalPositionBulk           (POSITION* positions, POSITION* canonical, int length);
+void            CanonicalBenchmark              ();
 
 MEXCALC         MexAdd                          (MEXCALC calc, MEX mex);
 MEX             MexCompute                      (MEXCALC calc);
@@ -28,6 +28,12 @@
 **                        OneDMatch.
 **              5/07/06 - Implemented and confirmed functionality of
 **                        transparencies in OneDMatch.
+**              10/18/26 - Bitboard versions of statelessNinaRow,
+**                        OneDMatch and amountOfWhat for boards of up to
+**                        64 slots. Stateful NinaRow walks out from the
+**                        last move using precomputed edge distances. The
+**                        old versions are kept as the ...ByCell functions
+**                        (see mlibtest.c).
 **              TO DO- Revise structure of functions to make them
 **                        more general (for use in seval.c). NinaRow,
 **                        statelessNinaRow, and OneDMatch should count
@@ -40,6 +46,8 @@
 #include "string.h"
 
 void overflowGuard(int);
+void lineStartsGuard(int);
+void edgeGuard();
 
 LocalBoard lBoard;
 int bSize;
@@ -69,7 +77,179 @@ void LibInitialize(int eltSize, int rows, int cols, BOOLEAN diagonals) {
 	}
 	for(i=0; i<MLIB_MAXPATTERN; i++) {
 		overflowGuard(i);
+		lineStartsGuard(i);
 	}
+
+	lBoard.bitboards = (lBoard.size <= MLIB_MAXBOARDSIZE);
+	if (lBoard.bitboards) {
+		edgeGuard();
+	}
+}
+
+/*Bitboards: bit z of a bitboard is slot z of the board. A line of n slots
+   starting at z in some direction is found by ANDing the board's bitboard
+   with itself shifted by the direction's step, n-1 times, over the slots
+   from which such a line stays on the board (lBoard.lineStarts).*/
+
+/*Bitboard of the slots of boardArray holding type*/
+unsigned long long BoardToBitboard(void* boardArray, void* type) {
+	unsigned long long bits = 0;
+	int z;
+
+	switch (lBoard.eltSize) { //compare whole elements rather than calling memcmp
+	case 1: {
+		unsigned char t = *(unsigned char*) type, *b = (unsigned char*) boardArray;
+		for(z=0; z<lBoard.size; z++)
+			bits |= (unsigned long long) (b[z] == t) << z;
+		break;
+	}
+	case 2: {
+		unsigned short t, *b = (unsigned short*) boardArray;
+		memcpy(&t, type, sizeof(t));
+		for(z=0; z<lBoard.size; z++)
+			bits |= (unsigned long long) (b[z] == t) << z;
+		break;
+	}
+	case 4: {
+		unsigned int t, *b = (unsigned int*) boardArray;
+		memcpy(&t, type, sizeof(t));
+		for(z=0; z<lBoard.size; z++)
+			bits |= (unsigned long long) (b[z] == t) << z;
+		break;
+	}
+	default:
+		for(z=0; z<lBoard.size; z++)
+			if (!memcmp(boardArray + lBoard.eltSize*z, type, lBoard.eltSize))
+				bits |= 1ULL << z;
+	}
+	return bits;
+}
+
+/*Moves slot z+by of bits to slot z*/
+static inline unsigned long long bitboardStep(unsigned long long bits, int by) {
+	return (by >= 0) ? bits >> by : bits << -by;
+}
+
+/*Slots from which n pieces of bits run in the given direction. While any
+   start is left the line ends on the board, so no shift reaches 64.*/
+static inline unsigned long long bitboardRuns(unsigned long long bits, int n, int direction) {
+	unsigned long long runs = lBoard.lineStarts[n][direction] & bits;
+	int k;
+
+	for(k=1; k<n && runs; k++)
+		runs &= bitboardStep(bits, k*lBoard.directionMap[direction]);
+	return runs;
+}
+
+/*Whether slot z of boardArray holds type; t4 is type when eltSize is 4*/
+#define MLIB_SLOT_IS(z) (lBoard.eltSize == 4 ? ((unsigned int*) boardArray)[z] == t4 : \
+                         !memcmp(boardArray + lBoard.eltSize*(z), type, lBoard.eltSize))
+
+/*Stateful NinaRow: only the lines through indexOfLast can be new, so they
+   are walked out from it, as far as lBoard.edgeSteps allows, and the walk
+   stops at the first slot that doesn't match. That reads fewer slots than
+   building a bitboard would.*/
+BOOLEAN NinaRow(void* boardArray,void* type, int indexOfLast, int n) {
+	unsigned int t4 = 0;
+	int direction, step, reach, count, i;
+
+	if (indexOfLast<0) { //No valid last index passed, call stateless NinaRow
+		return statelessNinaRow(boardArray,type,n);
+	}
+	if (!lBoard.bitboards || n < 1 || n >= MLIB_MAXPATTERN) {
+		return NinaRowByCell(boardArray,type,indexOfLast,n);
+	}
+
+	if (lBoard.eltSize == 4) {
+		memcpy(&t4, type, sizeof(t4));
+	}
+	if (!MLIB_SLOT_IS(indexOfLast)) { //piece at last index isn't desired type
+		return FALSE;
+	}
+
+	for(direction = 3; direction<7; direction+= (lBoard.diagonals ? 1 : 2)) {
+		count = 1;
+		step = lBoard.directionMap[direction];
+		reach = lBoard.edgeSteps[indexOfLast][direction];
+		for(i=1; i<=reach && count<n && MLIB_SLOT_IS(indexOfLast + i*step); i++) {
+			count++;
+		}
+		reach = lBoard.edgeSteps[indexOfLast][direction^4]; //the opposite direction
+		for(i=1; i<=reach && count<n && MLIB_SLOT_IS(indexOfLast - i*step); i++) {
+			count++;
+		}
+		if (count >= n) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*Bitboard version of statelessNinaRow*/
+BOOLEAN statelessNinaRow(void* boardArray,void* type,int n) {
+	unsigned long long bits;
+	int direction;
+
+	if (!lBoard.bitboards || n < 1 || n >= MLIB_MAXPATTERN) {
+		return statelessNinaRowByCell(boardArray,type,n);
+	}
+
+	bits = BoardToBitboard(boardArray, type);
+	for(direction = 3; direction<7; direction+= (lBoard.diagonals ? 1 : 2)) {
+		if (bitboardRuns(bits, n, direction)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*Bitboard version of amountOfWhat*/
+BOOLEAN amountOfWhat(void* boardArray,void* what,int amount,BOOLEAN atLeast) {
+	int count;
+
+	if (!lBoard.bitboards) {
+		return amountOfWhatByCell(boardArray,what,amount,atLeast);
+	}
+
+	count = __builtin_popcountll(BoardToBitboard(boardArray, what));
+	return atLeast ? (amount >= 0 && count >= amount) : (count == amount);
+}
+
+/*Bitboard version of OneDMatch. Each distinct element of the pattern gets
+   one bitboard; slot count of the pattern is matched by shifting its
+   bitboard count steps back.*/
+BOOLEAN OneDMatch(void* boardArray, void* pattern, BOOLEAN* transparencies, BOOLEAN symmetrical, int len) {
+	unsigned long long bits[MLIB_MAXPATTERN], runs;
+	int direction, count, j;
+
+	if (!lBoard.bitboards || len < 1 || len >= MLIB_MAXPATTERN) {
+		return OneDMatchByCell(boardArray,pattern,transparencies,symmetrical,len);
+	}
+
+	for(count=0; count<len; count++) {
+		if (count > 0 && transparencies != 0 && transparencies[count]) {
+			continue;
+		}
+		for(j=0; j<count; j++) { //reuse the bitboard of an equal element
+			if (!memcmp(pattern + lBoard.eltSize*j, pattern + lBoard.eltSize*count, lBoard.eltSize)) {
+				break;
+			}
+		}
+		bits[count] = (j < count) ? bits[j] : BoardToBitboard(boardArray, pattern + lBoard.eltSize*count);
+	}
+
+	for(direction = (symmetrical ? 3 : (lBoard.diagonals ? 0 : 1)); direction < (symmetrical ? 7 : 8); direction+= (lBoard.diagonals ? 1 : 2)) {
+		runs = lBoard.lineStarts[len][direction] & bits[0];
+		for(count=1; count<len && runs; count++) {
+			if (transparencies == 0 || !transparencies[count]) {
+				runs &= bitboardStep(bits[count], count*lBoard.directionMap[direction]);
+			}
+		}
+		if (runs) {
+			return TRUE;
+		}
+	}
+	return FALSE;
 }
 
 
@@ -80,12 +260,12 @@ void LibInitialize(int eltSize, int rows, int cols, BOOLEAN diagonals) {
  **
  ****boardArray is any array of some element, while type is a type of that element.
  **memcmp is used to match elements of boardArray with type*/
-BOOLEAN NinaRow(void* boardArray,void* type, int indexOfLast, int n) {
+BOOLEAN NinaRowByCell(void* boardArray,void* type, int indexOfLast, int n) {
 	int i, direction,location,count;
 	BOOLEAN soFar,overflow;
 
 	if (indexOfLast<0) { //No valid last index passed, call stateless NinaRow
-		return statelessNinaRow(boardArray,type,n);
+		return statelessNinaRowByCell(boardArray,type,n);
 	}
 
 	if (memcmp(boardArray + lBoard.eltSize*indexOfLast, type, lBoard.eltSize)) { //piece at last index isn't desired type
@@ -163,7 +343,7 @@ BOOLEAN NinaRow(void* boardArray,void* type, int indexOfLast, int n) {
 
 /*stateless version of NinaRow, which is called when no indexOfLast is kept.
  **Checks the entire board for NinaRow, with minimal redundant calculations.*/
-BOOLEAN statelessNinaRow(void* boardArray,void* type,int n) {
+BOOLEAN statelessNinaRowByCell(void* boardArray,void* type,int n) {
 	int z;
 	int direction,location,count;
 	BOOLEAN soFar;
@@ -211,7 +391,7 @@ BOOLEAN statelessNinaRow(void* boardArray,void* type,int n) {
 
 /*Returns whether the board contains amount of given item 'what'
    //if atLeast is true, function will short curcuit once amount is found*/
-BOOLEAN amountOfWhat(void* boardArray,void* what,int amount,BOOLEAN atLeast) {
+BOOLEAN amountOfWhatByCell(void* boardArray,void* what,int amount,BOOLEAN atLeast) {
 	int i,count=0;
 
 	if (atLeast) {
@@ -237,7 +417,7 @@ BOOLEAN amountOfWhat(void* boardArray,void* what,int amount,BOOLEAN atLeast) {
 	return FALSE;
 }
 
-BOOLEAN OneDMatch(void* boardArray, void* pattern, BOOLEAN* transparencies, BOOLEAN symmetrical, int len) {
+BOOLEAN OneDMatchByCell(void* boardArray, void* pattern, BOOLEAN* transparencies, BOOLEAN symmetrical, int len) {
 	int z;
 	int direction,location,count;
 	BOOLEAN soFar; //overflow;
@@ -306,6 +486,40 @@ void overflowGuard(int len) {
 	}
 }
 
+/*Turns the overflow guard of each slot into one bitboard per direction*/
+void lineStartsGuard(int len) {
+	int z, direction;
+
+	for(direction=0; direction<8; direction++) {
+		lBoard.lineStarts[len][direction] = 0;
+		for(z=0; z<lBoard.rows*lBoard.cols && z<MLIB_MAXBOARDSIZE; z++) {
+			if (lBoard.overflowBoards[len][z] & (1 << direction)) {
+				lBoard.lineStarts[len][direction] |= 1ULL << z;
+			}
+		}
+	}
+}
+
+/*Computes, for each slot and direction, how many steps can be taken before
+   leaving the board*/
+void edgeGuard() {
+	int rowStep[8] = {-1, -1, -1, 0, 1, 1, 1, 0};
+	int colStep[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+	int z, direction, row, col, steps;
+
+	for(z=0; z<lBoard.size; z++) {
+		for(direction=0; direction<8; direction++) {
+			row = z/lBoard.cols + rowStep[direction];
+			col = z%lBoard.cols + colStep[direction];
+			for(steps=0; row >= 0 && row < lBoard.rows && col >= 0 && col < lBoard.cols; steps++) {
+				row += rowStep[direction];
+				col += colStep[direction];
+			}
+			lBoard.edgeSteps[z][direction] = steps;
+		}
+	}
+}
+
 //can I call functions from this module remotely?
 void Test() {
 	printf("Now using game function libraries\n");
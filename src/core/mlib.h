@@ -9,12 +9,19 @@ BOOLEAN statelessNinaRow(void*,void*,int);
 BOOLEAN amountOfWhat(void*,void*,int,BOOLEAN);
 BOOLEAN OneDMatch(void*,void*,BOOLEAN*,BOOLEAN,int);
 BOOLEAN TwoDMatch(void*,void*);
+unsigned long long BoardToBitboard(void*,void*);
+
+/*cell-by-cell versions, used when the board is too big for a bitboard*/
+BOOLEAN NinaRowByCell(void*,void*,int,int);
+BOOLEAN statelessNinaRowByCell(void*,void*,int);
+BOOLEAN amountOfWhatByCell(void*,void*,int,BOOLEAN);
+BOOLEAN OneDMatchByCell(void*,void*,BOOLEAN*,BOOLEAN,int);
 void Test();
 
 BOOLEAN mymemcmp(void*,void*,int);
 
 //watch out for collisions of these constant names. Always prepend the module name before them.
-#define MLIB_MAXBOARDSIZE 64
+#define MLIB_MAXBOARDSIZE 64     /* also the bits in a bitboard */
 #define MLIB_MAXPATTERN 16
 
 typedef struct lb {
@@ -29,6 +36,9 @@ typedef struct lb {
 	int directionMap[8];
 	int scratchBoard[MLIB_MAXBOARDSIZE];
 	int overflowBoards[MLIB_MAXPATTERN][MLIB_MAXBOARDSIZE];
+	unsigned long long lineStarts[MLIB_MAXPATTERN][8]; /* overflowBoards by direction */
+	unsigned char edgeSteps[MLIB_MAXBOARDSIZE][8]; /* steps to the edge by direction */
+	BOOLEAN bitboards;
 } LocalBoard;
 
 extern LocalBoard lBoard;
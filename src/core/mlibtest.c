@@ -0,0 +1,145 @@
+/************************************************************************
+**
+** NAME:	mlibtest.c
+**
+** DESCRIPTION:	Checks the bitboard versions of the mlib functions against
+**		the cell-by-cell ones, and times both when given --time.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gamesman.h"
+#include "mlib.h"
+
+#define BOARDS_PER_SHAPE        200
+#define TIMED_BOARDS            1000000
+
+int mismatches = 0;
+
+void randomBoard(void* board, int eltSize, int size, int blanks)
+{
+	int z, piece;
+
+	for (z = 0; z < size; z++) {
+		piece = (rand() % 100 < blanks) ? 2 : rand() % 2;
+		if (eltSize == 1)
+			((char*) board)[z] = (char) piece;
+		else
+			((int*) board)[z] = piece;
+	}
+}
+
+void check(BOOLEAN fast, BOOLEAN slow, const char* what, int n)
+{
+	if (fast != slow) {
+		if (mismatches++ < 10)
+			printf("%s mismatch: %dx%d%s, n = %d, bitboard %d, by cell %d\n", what,
+			       lBoard.rows, lBoard.cols, lBoard.diagonals ? " with diagonals" : "", n, fast, slow);
+	}
+}
+
+/* every function on random boards of every shape and element size */
+void checkAll()
+{
+	int board[MLIB_MAXBOARDSIZE], pattern[MLIB_MAXPATTERN];
+	BOOLEAN transparencies[MLIB_MAXPATTERN];
+	int eltSize, rows, cols, diagonals, b, n, z, k, piece;
+
+	for (eltSize = 1; eltSize <= 4; eltSize += 3)
+		for (rows = 1; rows <= 8; rows++)
+			for (cols = 1; cols <= 8; cols++)
+				for (diagonals = 0; diagonals < 2; diagonals++) {
+					LibInitialize(eltSize, rows, cols, diagonals);
+					for (b = 0; b < BOARDS_PER_SHAPE; b++) {
+						randomBoard(board, eltSize, rows*cols, rand() % 100);
+						for (n = 1; n <= 9; n++)
+							for (piece = 0; piece < 3; piece++) {
+								if (eltSize == 1)
+									*(char*) pattern = (char) piece;
+								else
+									*pattern = piece;
+								check(statelessNinaRow(board, pattern, n), statelessNinaRowByCell(board, pattern, n), "statelessNinaRow", n);
+								// NinaRowByCell misses a diagonal that wraps around the
+								// board back to its own column, which takes n > cols
+								if (!diagonals || n <= cols)
+									for (z = 0; z < rows*cols; z++)
+										check(NinaRow(board, pattern, z, n), NinaRowByCell(board, pattern, z, n), "NinaRow", n);
+								check(amountOfWhat(board, pattern, n, b & 1), amountOfWhatByCell(board, pattern, n, b & 1), "amountOfWhat", n);
+							}
+						for (n = 1; n <= 9; n++) {
+							randomBoard(pattern, eltSize, n, 20);
+							for (k = 0; k < n; k++)
+								transparencies[k] = (rand() % 4 == 0);
+							check(OneDMatch(board, pattern, NULL, b & 1, n), OneDMatchByCell(board, pattern, NULL, b & 1, n), "OneDMatch", n);
+							check(OneDMatch(board, pattern, transparencies, b & 1, n), OneDMatchByCell(board, pattern, transparencies, b & 1, n), "OneDMatch with transparencies", n);
+						}
+					}
+				}
+}
+
+/* Connect Four's board and Primitive's calls, as mwin4 makes them */
+void timeWin4()
+{
+	int *boards = (int*) malloc(TIMED_BOARDS * 42 * sizeof(int));
+	int i, xx = 0, found;
+	clock_t start;
+
+	LibInitialize(sizeof(int), 6, 7, TRUE);
+	for (i = 0; i < TIMED_BOARDS; i++)
+		randomBoard(boards + 42*i, sizeof(int), 42, 50);
+
+	start = clock(); found = 0;
+	for (i = 0; i < TIMED_BOARDS; i++)
+		found += statelessNinaRowByCell(boards + 42*i, &xx, 4);
+	printf("statelessNinaRow by cell: %.3fs (%d found)\n", (double) (clock() - start) / CLOCKS_PER_SEC, found);
+	start = clock(); found = 0;
+	for (i = 0; i < TIMED_BOARDS; i++)
+		found += statelessNinaRow(boards + 42*i, &xx, 4);
+	printf("statelessNinaRow: %.3fs (%d found)\n", (double) (clock() - start) / CLOCKS_PER_SEC, found);
+	start = clock(); found = 0;
+	for (i = 0; i < TIMED_BOARDS; i++)
+		found += NinaRowByCell(boards + 42*i, &xx, i % 42, 4);
+	printf("NinaRow by cell: %.3fs (%d found)\n", (double) (clock() - start) / CLOCKS_PER_SEC, found);
+	start = clock(); found = 0;
+	for (i = 0; i < TIMED_BOARDS; i++)
+		found += NinaRow(boards + 42*i, &xx, i % 42, 4);
+	printf("NinaRow: %.3fs (%d found)\n", (double) (clock() - start) / CLOCKS_PER_SEC, found);
+	free(boards);
+}
+
+int main(int argc, char *argv[])
+{
+	srand(1);
+	printf("Checking the bitboard functions against the cell-by-cell ones...\n");
+	checkAll();
+	printf("%d mismatches\n", mismatches);
+	if (argc > 1 && !strcmp(argv[1], "--time"))
+		timeWin4();
+	return mismatches != 0;
+}
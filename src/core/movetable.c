@@ -0,0 +1,572 @@
+/************************************************************************
+**
+** NAME:	movetable.c
+**
+** DESCRIPTION:	The move table: a fixed-size summary of the best moves of
+**		every position, built in one pass once the game is solved
+**		and saved next to the database, so that the computer and
+**		the interact next move values don't look up every child
+**		each turn.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+
+#include <sys/mman.h>
+#include "gamesman.h"
+#include "solveretrograde.h"
+
+/* Saved tables are uncompressed so they can be mmap'd: a header, then the
+   records from dataOffset on, then the move lists. Fields of more than one
+   byte in records and lists are stored low byte first, so only the header
+   depends on the byte order of the machine that wrote it. */
+#define MOVETABLE_MAGIC "GMMOVTBL"
+#define MOVETABLE_VERSION 2
+#define MOVETABLE_BYTEORDER 0x0102
+#define MOVETABLE_DATAOFFSET 64
+
+typedef struct movetable_header {
+	char magic[8];
+	unsigned short version;
+	unsigned short byteOrder;       // MOVETABLE_BYTEORDER as the writer saw it
+	unsigned short recordBytes;
+	unsigned short unused;
+	unsigned long long numPos;
+	unsigned long long numListWords; // 4 byte words of move lists after the records
+	unsigned long long dataOffset;
+} MOVETABLE_HEADER;
+
+/* The summary of a position. type is MOVETABLE_NONE for the positions the
+   table doesn't know (primitive, unsolved, or without a decided child).
+   moves is the bitmask of the optimal moves, or, with MOVETABLE_LIST in
+   flags, the word of the side-table their list starts at: the number of
+   optimal moves, then their indices in increasing order. */
+typedef struct movetable_record {
+	unsigned char type;
+	unsigned char flags;
+	unsigned char minRemoteness;    // of the children of moves of that type
+	unsigned char maxRemoteness;
+	unsigned char moves[4];
+} MOVETABLE_RECORD;
+
+#define MOVETABLE_NONE  0xFF
+#define MOVETABLE_LIST  1
+
+static MOVETABLE_RECORD* movetable = NULL;
+static POSITION         movetableSize = 0;
+static unsigned char*   movetableLists = NULL;  // movetableListWords words
+static POSITION         movetableListWords = 0;
+static POSITION         movetableListBytes = 0; // allocated, while building
+static void*            movetableMapBase = NULL; // the mapping movetable points into, if loaded that way
+static size_t           movetableMapBytes = 0;
+static TIER             movetableTier = 0;      // with Tier-Gamesman, the tier the table is of
+static BOOLEAN          movetableTierKnown = FALSE;
+
+/* The children of one position, their data and the optimal moves, grown
+   as needed */
+static POSITION*        mtChildren = NULL;
+static VALUE*           mtValues = NULL;
+static REMOTENESS*      mtRemotenesses = NULL;
+static int*             mtTypes = NULL;
+static int*             mtOptimal = NULL;
+static int              mtMaxChildren = 0;
+
+static void             GrowScratch             (int numChildren);
+static void             FreeScratch             (void);
+static MOVETABLE_RECORD* GetRecord              (POSITION position);
+static int              OptimalMoves            (MOVETABLE_RECORD *record, int numMoves);
+static void             Summarize               (POSITION position, MOVELIST *head, MOVETABLE_RECORD *record);
+static void             BuildTable              (POSITION numPositions);
+static void             MoveTableFileName       (char *filename, TIER tier);
+static BOOLEAN          SaveTable               (TIER tier);
+static BOOLEAN          LoadTable               (TIER tier, POSITION numPositions);
+
+static unsigned int GetWord(unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static void SetWord(unsigned char *p, unsigned int word)
+{
+	p[0] = (unsigned char) word;
+	p[1] = (unsigned char) (word >> 8);
+	p[2] = (unsigned char) (word >> 16);
+	p[3] = (unsigned char) (word >> 24);
+}
+
+/* Called once the database is ready: solved says whether the game was
+   just solved, so that a saved table is out of date, or loaded. Without
+   Tier-Gamesman the saved table is mapped in (or, with --movetable, built
+   if there is none); with it, the table of a tier is mapped in when the
+   hash window moves there. */
+void MoveTableInitialize(BOOLEAN solved)
+{
+	char filename[256];
+
+	if (kSupportsTierGamesman && gTierGamesman) {
+		if (gUseMoveTable)
+			MoveTableBuild();
+		return;
+	}
+	if (gNetworkDB)
+		return;
+	MoveTableFileName(filename, 0);
+	if (!solved && MoveTableLoad())
+		return;
+	if (gUseMoveTable)
+		MoveTableBuild();
+	else if (solved && gSaveDatabase)
+		remove(filename);
+}
+
+/* Builds the table, and saves it if databases are saved. With
+   Tier-Gamesman every tier has its own, and only the tiers without one
+   yet are built. */
+void MoveTableBuild(void)
+{
+	char filename[256];
+	TIERLIST *tiers, *ptr;
+	int built = 0;
+
+	MoveTableFree();
+	if (gNetworkDB) {
+		printf("\nThe move table isn't available with a network database.\n");
+		return;
+	}
+
+	if (kSupportsTierGamesman && gTierGamesman) {
+		printf("\nBuilding the move tables of the tiers...");
+		fflush(stdout);
+		tiers = checkAndDefineTierTree();
+		for (ptr = tiers; ptr != NULL; ptr = ptr->next) {
+			MoveTableFileName(filename, ptr->tier);
+			if (access(filename, F_OK) == 0)
+				continue;
+			gInitializeHashWindow(ptr->tier, TRUE);
+			BuildTable(gCurrentTierSize);
+			SaveTable(ptr->tier);
+			MoveTableFree();
+			built++;
+		}
+		FreeTierList(tiers);
+		gInitializeHashWindow(gInitialTier, TRUE);
+		printf("done, %d built.\n", built);
+	} else {
+		printf("\nBuilding the move table...");
+		fflush(stdout);
+		BuildTable(gNumberOfPositions);
+		if (gSaveDatabase)
+			SaveTable(0);
+		printf("done.\n");
+	}
+	FreeScratch();
+}
+
+/* Maps (or reads) the saved table in, or returns FALSE if there is none
+   for this game */
+BOOLEAN MoveTableLoad(void)
+{
+	if (kSupportsTierGamesman && gTierGamesman)
+		return gHashWindowInitialized && LoadTable(gCurrentTier, gCurrentTierSize);
+	return LoadTable(0, gNumberOfPositions);
+}
+
+void MoveTableFree(void)
+{
+	if (movetableMapBase != NULL) {
+		munmap(movetableMapBase, movetableMapBytes);
+	} else {
+		if (movetable != NULL)
+			SafeFree(movetable);
+		if (movetableLists != NULL)
+			SafeFree(movetableLists);
+	}
+	movetable = NULL;
+	movetableLists = NULL;
+	movetableMapBase = NULL;
+	movetableMapBytes = 0;
+	movetableSize = 0;
+	movetableListWords = movetableListBytes = 0;
+	movetableTierKnown = FALSE;
+}
+
+/* The values and remotenesses of the children of position, which its
+   moves (in GenerateMoves order) lead to. Those of the optimal moves come
+   from the table, and the rest (all of them if the table doesn't know
+   position) are looked up in one bulk call. With Tier-Gamesman, position
+   must be in the tier of the hash window. */
+void MoveTableChildData(POSITION position, MOVELIST *moves, POSITION *children, int numChildren, VALUE *values, REMOTENESS *remotenesses)
+{
+	MOVETABLE_RECORD *record;
+	MOVELIST *ptr;
+	VALUE childValue;
+	REMOTENESS remoteness;
+	int numOptimal, i, j, n;
+
+	GrowScratch(numChildren);
+	if ((record = GetRecord(position)) == NULL || (numOptimal = OptimalMoves(record, numChildren)) <= 0) {
+		GetPositionDataBulk(children, numChildren, values, remotenesses, NULL, NULL);
+		return;
+	}
+
+	for (i = j = n = 0; i < numChildren; i++) {
+		if (j < numOptimal && mtOptimal[j] == i)
+			j++;
+		else mtChildren[n++] = children[i];
+	}
+	if (n > 0)
+		GetPositionDataBulk(mtChildren, n, mtValues, mtRemotenesses, NULL, NULL);
+
+	// the inverse of MoveTypeOfChild
+	childValue = (record->type == WINMOVE) ? lose : (record->type == TIEMOVE) ? tie : win;
+	remoteness = (record->type == LOSEMOVE) ? record->maxRemoteness : record->minRemoteness;
+	for (i = j = n = 0, ptr = moves; i < numChildren; i++, ptr = ptr->next) {
+		if (j < numOptimal && mtOptimal[j] == i) {
+			j++;
+			values[i] = childValue;
+			if (childValue != tie && gGoAgain(position, ptr->move))
+				values[i] = (childValue == win) ? lose : win;
+			remotenesses[i] = remoteness;
+		} else {
+			values[i] = mtValues[n];
+			remotenesses[i] = mtRemotenesses[n++];
+		}
+	}
+}
+
+/* One of the best moves at random, or -1 if the table can't tell. The
+   best moves are the quickest wins or ties, or the slowest losses, and
+   the pick is the one RandomSmallestRemotenessMove (or, for losses,
+   RandomLargestRemotenessMove) would make from the same random number:
+   SortMoves lists the best moves last generated first. */
+MOVE MoveTableBestMove(POSITION position)
+{
+	MOVETABLE_RECORD *record;
+	MOVELIST *head, *ptr;
+	MOVE move = -1;
+	int numMoves, numOptimal, i;
+
+	/* Draws are played with the open positions data (see ChooseSmartComputerMove) */
+	if (OpenIsInitialized() && GetValueOfPosition(position) == tie && Remoteness(position) == REMOTENESS_MAX)
+		return -1;
+	if ((record = GetRecord(position)) == NULL)
+		return -1;
+
+	head = GenerateMoves(position);
+	for (numMoves = 0, ptr = head; ptr != NULL; ptr = ptr->next)
+		numMoves++;
+	GrowScratch(numMoves);
+	if ((numOptimal = OptimalMoves(record, numMoves)) > 0) {
+		i = mtOptimal[numOptimal - 1 - GetRandomNumber(numOptimal)];
+		for (ptr = head; i > 0; i--)
+			ptr = ptr->next;
+		move = ptr->move;
+	}
+	FreeMoveList(head);
+	return move;
+}
+
+/* The record of position, or NULL if the table doesn't know it. With
+   Tier-Gamesman, position must be in the tier of the hash window. */
+static MOVETABLE_RECORD *GetRecord(POSITION position)
+{
+	if (kSupportsTierGamesman && gTierGamesman && gHashWindowInitialized
+	    && !(movetableTierKnown && movetableTier == gCurrentTier)) {
+		MoveTableLoad(); // the hash window moved to another tier
+		movetableTier = gCurrentTier;
+		movetableTierKnown = TRUE;
+	}
+	if (movetable == NULL || position >= movetableSize || movetable[position].type == MOVETABLE_NONE)
+		return NULL;
+	return &movetable[position];
+}
+
+/* Puts the indices of the optimal moves of record in mtOptimal, which
+   must have room for numMoves, and returns how many there are. Returns
+   -1 if they don't fit a position of numMoves moves, as when the table
+   is of another version of the game. */
+static int OptimalMoves(MOVETABLE_RECORD *record, int numMoves)
+{
+	unsigned int moves = GetWord(record->moves), n, i;
+	unsigned char *list;
+
+	if (record->flags & MOVETABLE_LIST) {
+		if (moves >= movetableListWords)
+			return -1;
+		list = movetableLists + 4 * (POSITION) moves;
+		n = GetWord(list);
+		if (n > (unsigned int) numMoves || moves + 1 + (POSITION) n > movetableListWords)
+			return -1;
+		for (i = 0; i < n; i++)
+			if ((mtOptimal[i] = (int) GetWord(list + 4 * (i + 1))) >= numMoves)
+				return -1;
+		return (int) n;
+	}
+	for (n = i = 0; i < MOVETABLE_MASK_MOVES; i++) {
+		if (!(moves >> i & 1))
+			continue;
+		if ((int) i >= numMoves)
+			return -1;
+		mtOptimal[n++] = i;
+	}
+	return (int) n;
+}
+
+static void GrowScratch(int numChildren)
+{
+	if (numChildren <= mtMaxChildren)
+		return;
+	FreeScratch();
+	mtMaxChildren = numChildren;
+	mtChildren = (POSITION *) SafeMalloc(mtMaxChildren * sizeof(POSITION));
+	mtValues = (VALUE *) SafeMalloc(mtMaxChildren * sizeof(VALUE));
+	mtRemotenesses = (REMOTENESS *) SafeMalloc(mtMaxChildren * sizeof(REMOTENESS));
+	mtTypes = (int *) SafeMalloc(mtMaxChildren * sizeof(int));
+	mtOptimal = (int *) SafeMalloc(mtMaxChildren * sizeof(int));
+}
+
+static void FreeScratch(void)
+{
+	if (mtChildren != NULL) {
+		SafeFree(mtChildren);
+		SafeFree(mtValues);
+		SafeFree(mtRemotenesses);
+		SafeFree(mtTypes);
+		SafeFree(mtOptimal);
+	}
+	mtChildren = NULL;
+	mtValues = NULL;
+	mtRemotenesses = NULL;
+	mtTypes = NULL;
+	mtOptimal = NULL;
+	mtMaxChildren = 0;
+}
+
+/* Fills in the record of position from the data of its children in
+   mtValues and mtRemotenesses. Children without a value are passed over,
+   as SortMoves does. */
+static void Summarize(POSITION position, MOVELIST *head, MOVETABLE_RECORD *record)
+{
+	MOVELIST *ptr;
+	int numMoves, numOptimal = 0, best = LOSEMOVE + 1, i;
+	REMOTENESS minRemoteness = REMOTENESS_MAX, maxRemoteness = 0, target;
+	unsigned int moves = 0;
+
+	for (i = 0, ptr = head; ptr != NULL; i++, ptr = ptr->next)
+		if ((mtTypes[i] = MoveTypeOfChild(position, ptr->move, mtValues[i])) >= 0 && mtTypes[i] < best)
+			best = mtTypes[i];
+	if (best > LOSEMOVE)
+		return;
+	numMoves = i;
+	for (i = 0; i < numMoves; i++) {
+		if (mtTypes[i] != best)
+			continue;
+		if (mtRemotenesses[i] < minRemoteness) minRemoteness = mtRemotenesses[i];
+		if (mtRemotenesses[i] > maxRemoteness) maxRemoteness = mtRemotenesses[i];
+	}
+	target = (best == LOSEMOVE) ? maxRemoteness : minRemoteness;
+	for (i = 0; i < numMoves; i++)
+		if (mtTypes[i] == best && mtRemotenesses[i] == target)
+			mtOptimal[numOptimal++] = i;
+
+	if (mtOptimal[numOptimal - 1] < MOVETABLE_MASK_MOVES) {
+		for (i = 0; i < numOptimal; i++)
+			moves |= 1u << mtOptimal[i];
+	} else {
+		if (movetableListWords + 1 + numOptimal > UINT_MAX)
+			return; // no room left to say where the list is
+		if (4 * (movetableListWords + 1 + numOptimal) > movetableListBytes) {
+			movetableListBytes = 2 * movetableListBytes + 4 * (1 + numOptimal);
+			movetableLists = (movetableLists == NULL)
+			                 ? (unsigned char *) SafeMalloc(movetableListBytes)
+			                 : (unsigned char *) SafeRealloc(movetableLists, movetableListBytes);
+		}
+		moves = (unsigned int) movetableListWords;
+		SetWord(movetableLists + 4 * movetableListWords++, numOptimal);
+		for (i = 0; i < numOptimal; i++)
+			SetWord(movetableLists + 4 * movetableListWords++, mtOptimal[i]);
+		record->flags = MOVETABLE_LIST;
+	}
+	record->type = (unsigned char) best;
+	record->minRemoteness = (unsigned char) minRemoteness;
+	record->maxRemoteness = (unsigned char) maxRemoteness;
+	SetWord(record->moves, moves);
+}
+
+/* Builds the table of positions 0 to numPositions-1 */
+static void BuildTable(POSITION numPositions)
+{
+	POSITION position;
+	MOVETABLE_RECORD *record;
+	MOVELIST *head, *ptr;
+	int numMoves, i;
+
+	MoveTableFree();
+	movetable = (MOVETABLE_RECORD *) SafeMalloc((numPositions > 0 ? numPositions : 1) * sizeof(MOVETABLE_RECORD));
+	for (position = 0; position < numPositions; position++) {
+		record = &movetable[position];
+		memset(record, 0, sizeof(MOVETABLE_RECORD));
+		record->type = MOVETABLE_NONE;
+		if (GetValueOfPosition(position) == undecided || Primitive(position) != undecided)
+			continue;
+		head = GenerateMoves(position);
+		for (numMoves = 0, ptr = head; ptr != NULL; ptr = ptr->next)
+			numMoves++;
+		if (numMoves > 0) {
+			GrowScratch(numMoves);
+			for (i = 0, ptr = head; ptr != NULL; i++, ptr = ptr->next)
+				mtChildren[i] = DoMove(position, ptr->move);
+			GetPositionDataBulk(mtChildren, numMoves, mtValues, mtRemotenesses, NULL, NULL);
+			Summarize(position, head, record);
+		}
+		FreeMoveList(head);
+	}
+	movetableSize = numPositions;
+}
+
+static void MoveTableFileName(char *filename, TIER tier)
+{
+	if (kSupportsTierGamesman && gTierGamesman)
+		sprintf(filename, "./data/m%s_%d_tierdb/m%s_%d_%llu_movetable.dat",
+		        kDBName, getOption(), kDBName, getOption(), tier);
+	else
+		sprintf(filename, "./data/m%s_%d_movetable.dat", kDBName, getOption());
+}
+
+static BOOLEAN SaveTable(TIER tier)
+{
+	char filename[256], tmpfilename[270];
+	MOVETABLE_HEADER header;
+	char padding[MOVETABLE_DATAOFFSET - sizeof(MOVETABLE_HEADER)];
+	size_t size = movetableSize * sizeof(MOVETABLE_RECORD), listSize = 4 * movetableListWords;
+	FILE* filep;
+	BOOLEAN good;
+
+	mkdir("data", 0755);
+	MoveTableFileName(filename, tier);
+	sprintf(tmpfilename, "%s.tmp", filename);
+	if ((filep = fopen(tmpfilename, "wb")) == NULL) {
+		if (kDebugDetermineValue) {
+			printf("Unable to create move table file\n");
+		}
+		return FALSE;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MOVETABLE_MAGIC, sizeof(header.magic));
+	header.version = MOVETABLE_VERSION;
+	header.byteOrder = MOVETABLE_BYTEORDER;
+	header.recordBytes = sizeof(MOVETABLE_RECORD);
+	header.numPos = movetableSize;
+	header.numListWords = movetableListWords;
+	header.dataOffset = MOVETABLE_DATAOFFSET;
+	memset(padding, 0, sizeof(padding));
+	good = (fwrite(&header, sizeof(header), 1, filep) == 1 &&
+	        fwrite(padding, sizeof(padding), 1, filep) == 1 &&
+	        (size == 0 || fwrite(movetable, 1, size, filep) == size) &&
+	        (listSize == 0 || fwrite(movetableLists, 1, listSize, filep) == listSize));
+	good = (fclose(filep) == 0) && good;
+
+	if (good && rename(tmpfilename, filename) == 0)
+		return TRUE;
+	if (kDebugDetermineValue) {
+		fprintf(stderr, "\nError writing %s\n", filename);
+	}
+	remove(tmpfilename);
+	return FALSE;
+}
+
+/* Reads length bytes at offset of fd into dest */
+static BOOLEAN ReadFully(int fd, void *dest, size_t length, off_t offset)
+{
+	ssize_t got;
+
+	while (length > 0) {
+		if ((got = pread(fd, dest, length, offset)) <= 0)
+			return FALSE;
+		dest = (char*) dest + got;
+		offset += got;
+		length -= got;
+	}
+	return TRUE;
+}
+
+/* Maps the saved table of numPositions positions in. If the file can't
+   be mapped it is read in. */
+static BOOLEAN LoadTable(TIER tier, POSITION numPositions)
+{
+	char filename[256];
+	MOVETABLE_HEADER header;
+	struct stat st;
+	void* base;
+	size_t size, listSize, length;
+	int fd;
+
+	MoveTableFree();
+	MoveTableFileName(filename, tier);
+	if ((fd = open(filename, O_RDONLY)) < 0)
+		return FALSE;
+	if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+	    memcmp(header.magic, MOVETABLE_MAGIC, sizeof(header.magic)) != 0)
+		goto bad;
+	if (header.byteOrder != MOVETABLE_BYTEORDER) { // written by a machine of the other endianness
+		header.byteOrder = __builtin_bswap16(header.byteOrder);
+		header.version = __builtin_bswap16(header.version);
+		header.recordBytes = __builtin_bswap16(header.recordBytes);
+		header.numPos = __builtin_bswap64(header.numPos);
+		header.numListWords = __builtin_bswap64(header.numListWords);
+		header.dataOffset = __builtin_bswap64(header.dataOffset);
+	}
+	size = header.numPos * sizeof(MOVETABLE_RECORD);
+	listSize = 4 * header.numListWords;
+	if (header.byteOrder != MOVETABLE_BYTEORDER || header.version != MOVETABLE_VERSION ||
+	    header.recordBytes != sizeof(MOVETABLE_RECORD) || header.numPos != numPositions ||
+	    fstat(fd, &st) != 0 || (unsigned long long) st.st_size < header.dataOffset + size + listSize)
+		goto bad;
+
+	length = header.dataOffset + size + listSize;
+	base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (base != MAP_FAILED) {
+		movetableMapBase = base;
+		movetableMapBytes = length;
+		movetable = (MOVETABLE_RECORD*) ((char*) base + header.dataOffset);
+		movetableLists = (unsigned char*) movetable + size;
+	} else {
+		movetable = (MOVETABLE_RECORD*) SafeMalloc(size + 1);
+		movetableLists = (unsigned char*) SafeMalloc(listSize + 1);
+		if (!ReadFully(fd, movetable, size, header.dataOffset) ||
+		    !ReadFully(fd, movetableLists, listSize, header.dataOffset + size)) {
+			MoveTableFree();
+			goto bad;
+		}
+	}
+	close(fd);
+	movetableSize = header.numPos;
+	movetableListWords = header.numListWords;
+	return TRUE;
+bad:
+	close(fd);
+	fprintf(stderr, "\n%s is not a move table of this game, ignoring it\n", filename);
+	return FALSE;
+}
@@ -0,0 +1,24 @@
+#ifndef GMCORE_MOVETABLE_H
+#define GMCORE_MOVETABLE_H
+
+/* The move table keeps an 8 byte summary of every position: the type of
+   its best moves (WINMOVE, TIEMOVE or LOSEMOVE), which of its moves (in
+   GenerateMoves order) are the optimal ones, and the smallest and largest
+   remoteness of the children of moves of that type. That is what the
+   computer needs to pick its move, and it answers the interact next move
+   values for the optimal moves without a DoMove and DB lookup each. The
+   optimal moves are a bitmask of the first MOVETABLE_MASK_MOVES moves, or,
+   if one of them comes later, a list of move indices in a side-table. It
+   is saved next to the database (one file per tier with Tier-Gamesman),
+   and mapped in rather than read when it is used again. */
+
+#define MOVETABLE_MASK_MOVES    32
+
+void            MoveTableInitialize             (BOOLEAN solved);
+void            MoveTableBuild                  (void);
+BOOLEAN         MoveTableLoad                   (void);
+void            MoveTableFree                   (void);
+void            MoveTableChildData              (POSITION position, MOVELIST *moves, POSITION *children, int numChildren, VALUE *values, REMOTENESS *remotenesses);
+MOVE            MoveTableBestMove               (POSITION position);
+
+#endif /* GMCORE_MOVETABLE_H */
@@ -38,6 +38,7 @@
 **************************************************************************/
 
 #include <zlib.h>
+#include <pthread.h>
 #include <netinet/in.h>
 #include "gamesman.h"
 #include "netdb.h"
@@ -49,8 +50,7 @@
 
 typedef short cellValue;
 
-void            netdb_close                     (){
-};                                                    //nothing
+void            netdb_close                     ();
 /* Value */
 VALUE           netdb_get_value                 (POSITION pos);
 
@@ -62,35 +62,52 @@ MEX             netdb_get_mex                   (POSITION pos);
 
 /*bulk pos/remoteness request*/
 void netdb_get_bulk (POSITION* positions, VALUE* ValueArray, REMOTENESS* remotenessArray, int length);
+void netdb_get_bulk_data (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
 
 
 /* saving to/reading from a file */
 BOOLEAN         netdb_load_database             ();
 
-/*LUI replacement algorithm using nth-chance clock*/
-/*This would probably be faster as a hash, but for small cache_Size < 100
- * naive looping may be better*/
-/*for smart db*/
-#define CACHE_SIZE 100
-#define CLOCK_LOOPS 5 //number of clock interations
-POSITION p_cache[CACHE_SIZE];
-cellValue v_cache[CACHE_SIZE];
-uint8_t cache_sweep[CACHE_SIZE]; //0 = fresh; CLOCK_LOOPS = replace
-short valid_num = 0; //index of first invalid entry
-short c_clock =0;         //the clock hand
-
-//cache prototypes:
-
-//FIXME: exact LRU should be used!
-//linked list?
-
+/*Query cache: a hashed, set-associative table of cells. Each set holds
+ * NETDB_WAYS entries replaced by CLOCK (second chance), and sets are
+ * striped over NETDB_SHARDS locks so lookups from several threads do not
+ * queue on one mutex. A miss claims its entry as PENDING before the
+ * request goes out; anyone else asking for that position while it is in
+ * flight waits for it instead of sending a second query.*/
+#define NETDB_WAYS 8
+#define NETDB_SHARDS 16
+#define NETDB_BATCH 1024    //positions per GetValueOfPositions request
+#define NETDB_PIPELINE 4    //requests in flight on the connection
+#define NETDB_RETRIES 3     //reconnects before giving up on a request
+
+#define NETDB_EMPTY 0
+#define NETDB_PENDING 1
+#define NETDB_READY 2
+
+typedef struct {
+	POSITION pos;
+	cellValue cell;
+	uint8_t state;
+	uint8_t ref; //CLOCK reference bit
+} NETDB_ENTRY;
 
-//get cached position
-BOOLEAN get_position (POSITION pos, cellValue * outcell);
+static NETDB_ENTRY *netdb_cache = NULL;
+static uint8_t *netdb_hands = NULL; //CLOCK hand of each set
+static UINT64 netdb_set_mask = 0;
+static pthread_mutex_t netdb_shard_lock[NETDB_SHARDS];
+static pthread_cond_t netdb_shard_filled[NETDB_SHARDS];
 
+/*one kept-alive connection, shared by all queries*/
+static pthread_mutex_t netdb_conn_lock = PTHREAD_MUTEX_INITIALIZER;
+static httpconn *netdb_conn = NULL;
+static POSITION netdb_wire[NETDB_BATCH]; //request body in net order
 
-//set cached position:
-void set_position (POSITION pos, cellValue cv);
+//cache prototypes:
+static UINT64 netdb_hash(POSITION pos);
+static void netdb_cache_init(void);
+static NETDB_ENTRY *netdb_cache_claim(POSITION pos, cellValue *outcell, int *state);
+static void netdb_cache_fill(NETDB_ENTRY *entry, cellValue cell);
+static void netdb_fetch(POSITION *positions, cellValue *cells, int length);
 
 void checkResponseForErrors(httpres *res);
 
@@ -100,6 +117,8 @@ void checkResponseForErrors(httpres *res);
 
 void netdb_init(DB_Table *new_db)
 {
+	netdb_cache_init();
+
 	//set function pointers
 	new_db->put_value = NULL;
 	new_db->put_remoteness = NULL;
@@ -112,6 +131,7 @@ void netdb_init(DB_Table *new_db)
 	new_db->check_visited = NULL;
 	new_db->get_mex = netdb_get_mex;
 	new_db->get_bulk =  netdb_get_bulk; //bulk request
+	new_db->get_bulk_data = netdb_get_bulk_data;
 	new_db->save_database = NULL;
 	new_db->load_database = netdb_load_database;
 }
@@ -131,41 +151,107 @@ void badResponseCode(char * reason, int code)
 	exit(1);
 }
 
-//warning: syncronous net sending
-//will need to rewrite to be asynch
+void netdb_close()
+{
+	int i;
 
-void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispatch to get cells
-	httpreq *req;
-	httpres *res;
-	char* errMsg;
+	pthread_mutex_lock(&netdb_conn_lock);
+	closeconnection(netdb_conn);
+	netdb_conn = NULL;
+	pthread_mutex_unlock(&netdb_conn_lock);
 
-	//byte found[] = malloc(sizeof(int)*length); //array to note found items
-	//fixme: reduce server request based on a bitmap!
+	if (netdb_cache != NULL) {
+		for (i = 0; i < NETDB_SHARDS; i++) {
+			pthread_mutex_destroy(&netdb_shard_lock[i]);
+			pthread_cond_destroy(&netdb_shard_filled[i]);
+		}
+		SafeFree(netdb_cache);
+		SafeFree(netdb_hands);
+		netdb_cache = NULL;
+	}
+}
 
-	//before we do anything, access the cache:
-	BOOLEAN allcached = TRUE;
-	int i;
-	for (i = 0; i< length; i++) {
-		if (!get_position(positions[i], cells + i))
-			allcached = FALSE;
+//Look up every position in the cache, then fetch the misses in one
+//pipelined exchange. Repeats of a position, in this call or in flight
+//from another thread, are only asked for once.
+void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispatch to get cells
+	NETDB_ENTRY **claimed = SafeMalloc(length * sizeof(NETDB_ENTRY*));
+	int *misses = SafeMalloc(length * sizeof(int));
+	int *waits = SafeMalloc(length * sizeof(int));
+	POSITION *fetchpos = SafeMalloc(length * sizeof(POSITION));
+	cellValue *fetchcells = SafeMalloc(length * sizeof(cellValue));
+	int nmisses = 0, nwaits = 0, nfetch, i, state;
+
+	for (i = 0; i < length; i++) {
+		claimed[nmisses] = netdb_cache_claim(positions[i], cells + i, &state);
+		if (state == NETDB_PENDING)
+			waits[nwaits++] = i;
+		else if (state != NETDB_READY)
+			misses[nmisses++] = i;
 	}
-	if (allcached) //done
-		return;
 
+	if (nmisses > 0) {
+		for (i = 0; i < nmisses; i++)
+			fetchpos[i] = positions[misses[i]];
+		netdb_fetch(fetchpos, fetchcells, nmisses);
+		for (i = 0; i < nmisses; i++) {
+			cells[misses[i]] = fetchcells[i];
+			if (claimed[i] != NULL)
+				netdb_cache_fill(claimed[i], fetchcells[i]);
+		}
+	}
 
+	//collect positions somebody else was already fetching; if the entry
+	//was replaced before we got to it, ask for the position ourselves
+	nfetch = 0;
+	for (i = 0; i < nwaits; i++) {
+		POSITION pos = positions[waits[i]];
+		UINT64 set = netdb_hash(pos) & netdb_set_mask;
+		NETDB_ENTRY *e = netdb_cache + set * NETDB_WAYS;
+		int shard = set % NETDB_SHARDS, w;
+		BOOLEAN found = FALSE;
+
+		pthread_mutex_lock(&netdb_shard_lock[shard]);
+		for (w = 0; w < NETDB_WAYS; w++) {
+			if (e[w].state != NETDB_EMPTY && e[w].pos == pos) {
+				while (e[w].state == NETDB_PENDING && e[w].pos == pos)
+					pthread_cond_wait(&netdb_shard_filled[shard], &netdb_shard_lock[shard]);
+				if (e[w].state == NETDB_READY && e[w].pos == pos) {
+					cells[waits[i]] = e[w].cell;
+					e[w].ref = 1;
+					found = TRUE;
+				}
+				break;
+			}
+		}
+		pthread_mutex_unlock(&netdb_shard_lock[shard]);
+		if (!found) {
+			fetchpos[nfetch] = pos;
+			misses[nfetch++] = waits[i];
+		}
+	}
+	if (nfetch > 0) {
+		netdb_fetch(fetchpos, fetchcells, nfetch);
+		for (i = 0; i < nfetch; i++)
+			cells[misses[i]] = fetchcells[i];
+	}
 
-	char * url = malloc(strlen(ServerAddress)+1);
-	memcpy(url,ServerAddress,strlen(ServerAddress)+1);
+	SafeFree(claimed);
+	SafeFree(misses);
+	SafeFree(waits);
+	SafeFree(fetchpos);
+	SafeFree(fetchcells);
+}
 
+//Send one GetValueOfPositions request for up to NETDB_BATCH positions.
+static int netdb_send_batch(POSITION *positions, int length, char **errMsg){
+	httpreq *req;
 	char option[32]; //option encoding
 	char length_str[32]; //length encoding
+	int i;
 
-	//connect to the server
-	if (newrequest(url, &req, &errMsg) != 0)
-	{
-		fprintf(stderr, "Problem creating request: %s\n", errMsg);
-		exit(1);
-	}
+	if (newconnrequest(netdb_conn, &req) != 0)
+		error("Could not create request", 1);
 
 	settype(req, HD_GET_VALUE_OF_POSITIONS);
 
@@ -177,37 +263,22 @@ void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispa
 	net_itoa(length,length_str);
 	addheader(req,HD_LENGTH,length_str);
 
-	//now generate the body:
-	POSITION * positions_copy = malloc(sizeof(POSITION)*length);
 	//position is 64 bit.. must convert
-
 	for (i=0; i<length; i++) {
-		positions_copy[i] = htonll(positions[i]); //convert to net order
-	}
-
-	//now post
-	if ((post(req,(char*)positions_copy,length*sizeof(POSITION), &res, &errMsg)) != 0)
-	{
-		fprintf(stderr, "Problem posting to the server: %s\n", errMsg);
-		exit(1);
+		netdb_wire[i] = htonll(positions[i]); //convert to net order
 	}
 
-	free (positions_copy);
-	//now check errors:
-
-	//debug:
-	//printf("%s: %s\n", "Date", getheader(res, "date"));
-	//	printf("%s: %s\n", "Content-Length", getheader(res, "Content-Length"));
-	//	printf("%s: %s\n", "ReturnCode", getheader(res, HD_RETURN_CODE));
-	//	printf("%s: %s\n", "ReturnMessage", getheader(res, HD_RETURN_MESSAGE));
+	return sendrequest(netdb_conn, req, (char*)netdb_wire, length*sizeof(POSITION), errMsg);
+}
 
-	//normal:
-	//FIXME: check status
+//Check a GetValueOfPositions response and copy out its cells.
+static void netdb_read_batch(httpres *res, cellValue *cells, int length){
 	char* tmpVal;
 	getheader(res,"date",&tmpVal);
 	if (tmpVal == NULL) { //all real responses have this
 		error("Server did not respond to http request",10);
 	}
+	free(tmpVal);
 
 	char * ecode_str;
 	getheader(res,HD_RETURN_CODE,&ecode_str);
@@ -215,7 +286,7 @@ void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispa
 		error("Server sent back invalid response",11);
 	}
 	int ecode = atoi(ecode_str);
-	// printf("return code - %d\n",ecode);
+	free(ecode_str);
 	if (ecode != 0) { //error
 		getheader(res,HD_RETURN_MESSAGE,&tmpVal);
 		error(tmpVal,ecode);
@@ -228,27 +299,74 @@ void netdb_get_raw(POSITION * positions, cellValue * cells, int length){ //dispa
 	if (len_str == NULL || length!=atoi(len_str) || res->bodyLength != length*sizeof(cellValue)) {
 		error("Server sent back invalid response",10);
 	}
-
-
+	free(len_str);
 
 	//now safe - just read out the body (length should be the same or we errored)
 	cellValue * resvals = (cellValue*)(res->body);
 
 	//must do byte conversion (16 bit)
+	int i;
 	for (i=0; i<length; i++) {
 		cells[i] = ntohs(resvals[i]);
 	}
+}
 
+//Fetch cells from the server, NETDB_BATCH positions per request with up
+//to NETDB_PIPELINE requests in flight on the kept-alive connection. If
+//the server drops the connection (or closes it after a response), the
+//requests not answered yet are sent again on a new one.
+static void netdb_fetch(POSITION *positions, cellValue *cells, int length){
+	int batches = (length + NETDB_BATCH - 1) / NETDB_BATCH;
+	int sent = 0, received = 0, retries = 0;
+	httpres *res;
+	char *errMsg;
+
+	pthread_mutex_lock(&netdb_conn_lock);
+
+	while (received < batches) {
+		if (netdb_conn == NULL) {
+			char * url = malloc(strlen(ServerAddress)+1);
+			memcpy(url,ServerAddress,strlen(ServerAddress)+1);
+			if (openconnection(url, &netdb_conn, &errMsg) != 0) {
+				fprintf(stderr, "Problem connecting to the server: %s\n", errMsg);
+				exit(1);
+			}
+			free(url);
+		} else if (!netdb_conn->open) {
+			if (reopenconnection(netdb_conn, &errMsg) != 0) {
+				fprintf(stderr, "Problem connecting to the server: %s\n", errMsg);
+				exit(1);
+			}
+			sent = received;
+		}
 
-	for (i = 0; i< length; i++) //cache what we got back
-		set_position(positions[i], cells[i]);
-
+		while (sent < batches && sent - received < NETDB_PIPELINE) {
+			int first = sent * NETDB_BATCH;
+			int n = (length - first < NETDB_BATCH) ? length - first : NETDB_BATCH;
+			if (netdb_send_batch(positions + first, n, &errMsg) != 0)
+				break;
+			sent++;
+		}
 
+		if (sent == received || receiveresponse(netdb_conn, &res, &errMsg) != 0) {
+			if (++retries > NETDB_RETRIES) {
+				fprintf(stderr, "Problem posting to the server: %s\n", errMsg);
+				exit(1);
+			}
+			free(errMsg);
+			netdb_conn->open = 0; //reconnect and resend what is unanswered
+			continue;
+		}
 
-	//done - free response
-	freeresponse(res);
-	free(url);
+		int first = received * NETDB_BATCH;
+		int n = (length - first < NETDB_BATCH) ? length - first : NETDB_BATCH;
+		netdb_read_batch(res, cells + first, n);
+		freeresponse(res);
+		received++;
+		retries = 0;
+	}
 
+	pthread_mutex_unlock(&netdb_conn_lock);
 }
 
 void netdb_init_db()
@@ -318,45 +436,97 @@ void checkResponseForErrors(httpres *res)
 
 
 //cache support:
-//return False if not found
-//If true, set the cached value appropriately
-BOOLEAN get_position (POSITION pos, cellValue * outcell){
-	int i;
-	for (i=0; i<valid_num; i++) {
-		if (p_cache[i] == pos) {
-			*outcell = v_cache[i];
-			cache_sweep[i] = 0; //reset
-			return TRUE;
-		}
-	}
-	return FALSE;
+static UINT64 netdb_hash(POSITION pos){
+	UINT64 h = (UINT64)pos * 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 29);
 }
 
-//this will push entries to the cache
-void set_position (POSITION pos, cellValue cv){
-	//check if already cached
-	if (get_position(pos,&cv))
+//Size the cache from gNetDBCacheSize, rounded down to a power of two
+//number of sets. A size of 0 turns caching off.
+static void netdb_cache_init(void){
+	UINT64 sets = 1;
+	int i;
+
+	netdb_cache = NULL;
+	if (gNetDBCacheSize < NETDB_WAYS * NETDB_SHARDS)
 		return;
+	while (sets * 2 * NETDB_WAYS <= (UINT64)gNetDBCacheSize)
+		sets *= 2;
+	netdb_set_mask = sets - 1;
+	netdb_cache = SafeMalloc(sets * NETDB_WAYS * sizeof(NETDB_ENTRY));
+	netdb_hands = SafeMalloc(sets * sizeof(uint8_t));
+	memset(netdb_cache, 0, sets * NETDB_WAYS * sizeof(NETDB_ENTRY));
+	memset(netdb_hands, 0, sets * sizeof(uint8_t));
+	for (i = 0; i < NETDB_SHARDS; i++) {
+		pthread_mutex_init(&netdb_shard_lock[i], NULL);
+		pthread_cond_init(&netdb_shard_filled[i], NULL);
+	}
+}
 
-	if (valid_num < CACHE_SIZE) {
-		p_cache[valid_num] = pos;
-		v_cache[valid_num] = cv;
-		cache_sweep[valid_num] = 0;
-		valid_num++;
+//Look pos up. Sets *state to NETDB_READY (and *outcell) on a hit, or
+//NETDB_PENDING if the position is already being fetched. Otherwise sets
+//*state to NETDB_EMPTY and returns the entry claimed for the position,
+//which the caller must fill once it has the cell; NULL means there was
+//no entry to spare and the answer will not be cached.
+static NETDB_ENTRY *netdb_cache_claim(POSITION pos, cellValue *outcell, int *state){
+	UINT64 set;
+	NETDB_ENTRY *e, *victim = NULL;
+	int shard, w, hand;
+
+	*state = NETDB_EMPTY;
+	if (netdb_cache == NULL)
+		return NULL;
+
+	set = netdb_hash(pos) & netdb_set_mask;
+	e = netdb_cache + set * NETDB_WAYS;
+	shard = set % NETDB_SHARDS;
+	pthread_mutex_lock(&netdb_shard_lock[shard]);
+
+	for (w = 0; w < NETDB_WAYS; w++) {
+		if (e[w].state != NETDB_EMPTY && e[w].pos == pos) {
+			*state = e[w].state;
+			if (e[w].state == NETDB_READY) {
+				*outcell = e[w].cell;
+				e[w].ref = 1;
+			}
+			pthread_mutex_unlock(&netdb_shard_lock[shard]);
+			return NULL;
+		}
 	}
-	//replacement (nth-chance clock)
-	while (TRUE) {
-		if (cache_sweep[c_clock] == CLOCK_LOOPS) { //replace
-			cache_sweep[c_clock] = 0; //reset
-			p_cache[c_clock] = pos;
-			v_cache[c_clock] = cv;
-			c_clock=(c_clock+1)%CACHE_SIZE;
-			return;
+
+	//second chance: clear reference bits until an unreferenced entry
+	//comes under the hand; entries still in flight are never replaced
+	hand = netdb_hands[set];
+	for (w = 0; w < 2 * NETDB_WAYS; w++, hand = (hand + 1) % NETDB_WAYS) {
+		if (e[hand].state == NETDB_PENDING)
+			continue;
+		if (e[hand].state == NETDB_EMPTY || !e[hand].ref) {
+			victim = e + hand;
+			hand = (hand + 1) % NETDB_WAYS;
+			break;
 		}
-		//otherwise increment clock and sweep counter
-		cache_sweep[c_clock]++;
-		c_clock=(c_clock+1)%CACHE_SIZE;
+		e[hand].ref = 0;
+	}
+	netdb_hands[set] = hand;
+
+	if (victim != NULL) {
+		victim->pos = pos;
+		victim->state = NETDB_PENDING;
+		victim->ref = 1;
 	}
+	pthread_mutex_unlock(&netdb_shard_lock[shard]);
+	return victim;
+}
+
+//Publish the cell of an entry claimed by netdb_cache_claim.
+static void netdb_cache_fill(NETDB_ENTRY *entry, cellValue cell){
+	int shard = ((entry - netdb_cache) / NETDB_WAYS) % NETDB_SHARDS;
+
+	pthread_mutex_lock(&netdb_shard_lock[shard]);
+	entry->cell = cell;
+	entry->state = NETDB_READY;
+	pthread_cond_broadcast(&netdb_shard_filled[shard]);
+	pthread_mutex_unlock(&netdb_shard_lock[shard]);
 }
 
 //FIXME: add a cache clear function
@@ -383,6 +553,22 @@ void netdb_get_bulk (POSITION* positions, VALUE* ValueArray, REMOTENESS* remoten
 }
 
 
+//same request, any of the fields
+void netdb_get_bulk_data (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys){
+	if (!length)
+		return;
+	cellValue * cells = malloc(length*sizeof(cellValue)); //for receiving data
+	netdb_get_raw(positions,cells,length);
+	int i;
+	for (i=0; i<length; i++) {
+		db_unpack_cell(cells[i], i, values, remotenesses, mexes);
+		if (winbys != NULL)
+			winbys[i] = 0;
+	}
+	free(cells);
+}
+
+
 //easy way to issue a single query
 //really should be inlined
 cellValue netdb_single_query(POSITION pos){
@@ -0,0 +1,377 @@
+/************************************************************************
+**
+** NAME:	netdbtest.c
+**
+** DESCRIPTION:	Runs netdb against a local stand-in for the database
+**		server and checks its query cache (hits, misses, repeats,
+**		concurrent misses for the same positions), that requests
+**		are pipelined on one connection, and that requests the
+**		server closes on or drops are sent again on a new one.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "gamesman.h"
+#include "netdb.h"
+#include "httpclient.h"
+
+#define TEST_POSITIONS          5000
+#define TEST_REPEATED           100
+#define TEST_THREADS            4
+#define TEST_MAX_PENDING        64      // requests the server reads before answering
+
+/* Only netdb, httpclient and globals are linked in; these stand in for
+   the rest. */
+STRING kGameName = "netdbtest";
+STRING kDBName = "netdbtest";
+int getOption(void) {
+	return 1;
+}
+GENERIC_PTR SafeMalloc(size_t amt) {
+	GENERIC_PTR ptr = malloc(amt);
+	if (ptr == NULL) {
+		printf("Out of memory\n");
+		exit(1);
+	}
+	return ptr;
+}
+void SafeFree(GENERIC_PTR ptr) {
+	free(ptr);
+}
+
+/* The stand-in server. It answers InitDatabase and GetValueOfPositions
+   like the servlet, one connection at a time. Before answering, it reads
+   every request the client has already sent (so a client that pipelines
+   gets all of its responses back in one write), and it can be told to
+   close the connection or to drop a request after some responses. */
+int serverFd;
+char serverUrl[64];
+pthread_mutex_t serverLock = PTHREAD_MUTEX_INITIALIZER;
+int serverConnections = 0;      // connections accepted
+int serverRequests = 0;         // GetValueOfPositions requests answered
+int serverPositions = 0;        // positions asked for in them
+int serverMaxPending = 0;       // most requests read before answering
+int serverCloseAfter = 0;       // responses to go, the last says "Connection: close"
+int serverDropAfter = -1;       // responses to go before dropping the connection
+
+/* The cell the server holds for a position */
+int cellOf(POSITION p)
+{
+	return (int) (((p * 7 % 120) << REMOTENESS_SHIFT) | (p / 3 % 4));
+}
+
+typedef struct {
+	char type[64];
+	int length;
+	char *body;
+	int bodyLength;
+} TEST_REQUEST;
+
+/* Takes one whole request off the front of buf, if there is one. */
+BOOLEAN takeRequest(char *buf, int *used, TEST_REQUEST *req)
+{
+	char *end, *line, *next;
+	int headerLength, total;
+
+	buf[*used] = '\0';
+	if ((end = strstr(buf, "\r\n\r\n")) == NULL)
+		return FALSE;
+	headerLength = end + 4 - buf;
+
+	req->type[0] = '\0';
+	req->length = 0;
+	req->bodyLength = 0;
+	for (line = strstr(buf, "\r\n") + 2; line < end; line = next + 2) {
+		next = strstr(line, "\r\n");
+		*next = '\0';
+		if (strncasecmp(line, "TYPE: ", 6) == 0)
+			snprintf(req->type, sizeof(req->type), "%s", line + 6);
+		else if (strncasecmp(line, HD_LENGTH ": ", strlen(HD_LENGTH) + 2) == 0)
+			req->length = atoi(line + strlen(HD_LENGTH) + 2);
+		else if (strncasecmp(line, "Content-Length: ", 16) == 0)
+			req->bodyLength = atoi(line + 16);
+		*next = '\r';
+	}
+
+	total = headerLength + req->bodyLength;
+	if (*used < total)
+		return FALSE;
+	req->body = SafeMalloc(req->bodyLength + 1);
+	memcpy(req->body, buf + headerLength, req->bodyLength);
+	memmove(buf, buf + total, *used - total);
+	*used -= total;
+	return TRUE;
+}
+
+/* Appends the response to req to out. */
+int writeResponse(char *out, TEST_REQUEST *req, BOOLEAN closing)
+{
+	char *p = out;
+	int i;
+	unsigned short cell;
+	POSITION pos;
+
+	p += sprintf(p, "HTTP/1.1 200 OK\r\nDate: Sun, 18 Oct 2026 00:00:00 GMT\r\n%s: 0\r\n", HD_RETURN_CODE);
+	if (closing)
+		p += sprintf(p, "Connection: close\r\n");
+	if (strcmp(req->type, HD_GET_VALUE_OF_POSITIONS) != 0)
+		return p - out + sprintf(p, "Content-Length: 0\r\n\r\n");
+
+	p += sprintf(p, "%s: %d\r\nContent-Length: %d\r\n\r\n", HD_LENGTH, req->length, req->length * (int) sizeof(short));
+	for (i = 0; i < req->length; i++) {
+		memcpy(&pos, req->body + i * sizeof(POSITION), sizeof(POSITION));
+		cell = htons((unsigned short) cellOf((POSITION) htonll(pos)));
+		memcpy(p, &cell, sizeof(short));
+		p += sizeof(short);
+	}
+
+	pthread_mutex_lock(&serverLock);
+	serverRequests++;
+	serverPositions += req->length;
+	pthread_mutex_unlock(&serverLock);
+	return p - out;
+}
+
+/* Stops sending, then reads until the client hangs up, so a close never
+   throws away a response the client has not read yet. */
+void hangUp(int fd)
+{
+	char drain[4096];
+
+	shutdown(fd, SHUT_WR);
+	while (read(fd, drain, sizeof(drain)) > 0)
+		;
+	close(fd);
+}
+
+void serveConnection(int fd)
+{
+	int size = 1 << 16, used = 0, pending, i, n, outLength, outSize;
+	char *buf = SafeMalloc(size + 1), *out;
+	TEST_REQUEST reqs[TEST_MAX_PENDING];
+	struct pollfd pfd;
+	BOOLEAN closing = FALSE, eof = FALSE;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	while (!closing && !eof) {
+		// read requests until the client stops sending for a moment
+		pending = 0;
+		while (pending < TEST_MAX_PENDING) {
+			if (takeRequest(buf, &used, &reqs[pending])) {
+				pending++;
+				continue;
+			}
+			if (poll(&pfd, 1, pending > 0 ? 100 : 5000) <= 0)
+				break;
+			if (used == size)
+				buf = realloc(buf, (size *= 2) + 1);
+			if ((n = read(fd, buf + used, size - used)) <= 0) {
+				eof = TRUE;
+				break;
+			}
+			used += n;
+		}
+
+		pthread_mutex_lock(&serverLock);
+		if (pending > serverMaxPending)
+			serverMaxPending = pending;
+		pthread_mutex_unlock(&serverLock);
+
+		for (outSize = 1, i = 0; i < pending; i++)
+			outSize += 256 + reqs[i].length * sizeof(short);
+		out = SafeMalloc(outSize);
+		outLength = 0;
+		for (i = 0; i < pending; i++) {
+			if (!closing && serverDropAfter >= 0 && serverDropAfter-- == 0)
+				closing = TRUE;
+			if (!closing) {
+				if (serverCloseAfter > 0 && --serverCloseAfter == 0)
+					closing = TRUE;
+				outLength += writeResponse(out + outLength, &reqs[i], closing);
+			}
+			SafeFree(reqs[i].body);
+		}
+		for (i = 0; i < outLength; i += n)
+			if ((n = write(fd, out + i, outLength - i)) <= 0)
+				break;
+		SafeFree(out);
+	}
+	SafeFree(buf);
+	hangUp(fd);
+}
+
+void* serverMain(void* arg)
+{
+	int fd;
+
+	while ((fd = accept(serverFd, NULL, NULL)) >= 0) {
+		pthread_mutex_lock(&serverLock);
+		serverConnections++;
+		pthread_mutex_unlock(&serverLock);
+		serveConnection(fd);
+	}
+	return NULL;
+}
+
+BOOLEAN startServer(void)
+{
+	struct sockaddr_in addr;
+	socklen_t addrLength = sizeof(addr);
+	pthread_t thread;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+	if ((serverFd = socket(AF_INET, SOCK_STREAM, 0)) < 0
+	    || bind(serverFd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+	    || listen(serverFd, 4) < 0
+	    || getsockname(serverFd, (struct sockaddr *) &addr, &addrLength) < 0)
+		return FALSE;
+	snprintf(serverUrl, sizeof(serverUrl), "127.0.0.1:%d/GamesmanServlet", ntohs(addr.sin_port));
+	return pthread_create(&thread, NULL, serverMain, NULL) == 0;
+}
+
+/* The client side */
+DB_Table table;
+int failures = 0;
+
+void expect(BOOLEAN ok, const char *what)
+{
+	printf("%-60s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok)
+		failures++;
+}
+
+/* Asks for count positions from first on and checks every answer. */
+BOOLEAN askRange(POSITION first, int count, int times)
+{
+	POSITION *positions = SafeMalloc(count * times * sizeof(POSITION));
+	VALUE *values = SafeMalloc(count * times * sizeof(VALUE));
+	REMOTENESS *remotenesses = SafeMalloc(count * times * sizeof(REMOTENESS));
+	BOOLEAN ok = TRUE;
+	int i;
+
+	for (i = 0; i < count * times; i++)
+		positions[i] = first + i % count;
+	table.get_bulk(positions, values, remotenesses, count * times);
+	for (i = 0; i < count * times; i++)
+		if (values[i] != (VALUE) (cellOf(positions[i]) & VALUE_MASK)
+		    || remotenesses[i] != (REMOTENESS) ((cellOf(positions[i]) & REMOTENESS_MASK) >> REMOTENESS_SHIFT))
+			ok = FALSE;
+
+	SafeFree(positions);
+	SafeFree(values);
+	SafeFree(remotenesses);
+	return ok;
+}
+
+POSITION sharedFirst;
+BOOLEAN sharedOk[TEST_THREADS];
+
+void* askWorker(void* arg)
+{
+	size_t t = (size_t) arg;
+
+	sharedOk[t] = askRange(sharedFirst, TEST_POSITIONS, 1);
+	return NULL;
+}
+
+void initTable(int cacheSize)
+{
+	gNetDBCacheSize = cacheSize;
+	memset(&table, 0, sizeof(DB_Table));
+	netdb_init(&table);
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t threads[TEST_THREADS];
+	int connections, positions;
+	BOOLEAN ok;
+	size_t t;
+
+	alarm(120); // a client stuck waiting on the server fails the test
+	if (!startServer()) {
+		printf("Could not start the stand-in server\n");
+		return 1;
+	}
+	ServerAddress = serverUrl;
+	initTable(65536);
+	table.load_database();
+
+	ok = askRange(0, TEST_POSITIONS, 1);
+	expect(ok && serverPositions == TEST_POSITIONS, "misses are fetched once each");
+	expect(serverMaxPending >= 2, "bulk requests are pipelined");
+	expect(serverConnections == 2, "one connection is kept for all of them");
+
+	positions = serverPositions;
+	ok = askRange(0, TEST_POSITIONS, 1);
+	ok = ok && table.get_value(17) == (VALUE) (cellOf(17) & VALUE_MASK);
+	expect(ok && serverPositions == positions, "hits are not fetched again");
+
+	positions = serverPositions;
+	ok = askRange(10000, TEST_REPEATED, 3);
+	expect(ok && serverPositions == positions + TEST_REPEATED, "a position repeated in one call is fetched once");
+
+	positions = serverPositions;
+	sharedFirst = 20000;
+	for (t = 0; t < TEST_THREADS; t++)
+		pthread_create(&threads[t], NULL, askWorker, (void*) t);
+	for (ok = TRUE, t = 0; t < TEST_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+		ok = ok && sharedOk[t];
+	}
+	expect(ok && serverPositions == positions + TEST_POSITIONS, "concurrent misses for the same positions are fetched once");
+
+	connections = serverConnections;
+	serverCloseAfter = 2;
+	expect(askRange(30000, TEST_POSITIONS, 1) && serverConnections == connections + 1,
+	       "requests the server closed on are sent again");
+
+	connections = serverConnections;
+	serverDropAfter = 1;
+	expect(askRange(40000, TEST_POSITIONS, 1) && serverConnections == connections + 1,
+	       "requests the server dropped are sent again");
+
+	table.free_db();
+	initTable(0);
+	positions = serverPositions;
+	ok = askRange(0, TEST_POSITIONS, 1) && askRange(0, TEST_POSITIONS, 1);
+	expect(ok && serverPositions == positions + 2 * TEST_POSITIONS, "--netcache 0 fetches every time");
+	table.free_db();
+
+	printf("%d failures\n", failures);
+	return failures != 0;
+}
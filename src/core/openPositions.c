@@ -20,10 +20,9 @@ POSITIONLIST* headNodeDP;
 POSITIONLIST* tailNodeDP;
 char* corruptedPositions;
 char* fringePositions;
-extern char* gNumberChildren;
-extern char* gNumberChildrenOriginal;
+extern CHILDCOUNTER gNumberChildren;
+extern CHILDCOUNTER gNumberChildrenOriginal;
 extern POSITION gNumberOfPositions;
-extern POSITIONLIST** gParents;
 FILE *openData;
 
 static void             DrawParentInitialize                (void);
@@ -134,7 +133,7 @@ void PrintChildrenCounts()
 {
 	POSITION x;
 	for(x=0; x<gNumberOfPositions; x++)
-		printf("Parent: %d  NumChildren: %d  Orig: %d\n",(int)x,(int)gNumberChildren[x],(int)gNumberChildrenOriginal[x]);
+		printf("Parent: %d  NumChildren: %d  Orig: %d\n",(int)x,(int)ChildCounterGet(&gNumberChildren, x),(int)ChildCounterGet(&gNumberChildrenOriginal, x));
 }
 void PropogateFreAndCorUp(POSITION p)
 {
@@ -174,18 +173,19 @@ OPEN_POS_DATA DetermineFreAndCorDown1LevelForWin(POSITION p)
 void PropogateFreAndCorUpFringe(POSITION p, char fringe)
 {
 	OPEN_POS_DATA dat=GetOpenData(p);
-	POSITIONLIST* parents=gParents[p];
+	POSITION* parents=ParentIndexBegin(&gParents,p);
+	POSITION* parentsEnd=ParentIndexEnd(&gParents,p);
 	if(GetDrawValue(dat)==undecided) return;
-	for(; parents; parents=parents->next)
+	for(; parents<parentsEnd; parents++)
 	{
-		OPEN_POS_DATA pdat=GetOpenData(parents->position);
+		OPEN_POS_DATA pdat=GetOpenData(*parents);
 		OPEN_POS_DATA old=pdat;
 		if(GetLevelNumber(pdat)!=GetLevelNumber(dat)) continue;
 		if(!fringe && GetFringe(pdat))
 		{
 			pdat=SetFremoteness(pdat,0);
 			pdat=SetFringe(pdat,1);
-			SetOpenData(parents->position,pdat);
+			SetOpenData(*parents,pdat);
 			continue;
 		}
 		switch(GetDrawValue(dat))
@@ -200,13 +200,13 @@ void PropogateFreAndCorUpFringe(POSITION p, char fringe)
 				{
 					pdat=SetCorruptionLevel(pdat,GetCorruptionLevel(dat));
 					pdat=SetFremoteness(pdat,GetFremoteness(dat)+1);
-					corruptedPositions[parents->position]=corruptedPositions[parents->position]||corruptedPositions[p];
+					corruptedPositions[*parents]=corruptedPositions[*parents]||corruptedPositions[p];
 					if(!fringe) pdat=SetFringe(pdat,0);
 				}
 				else if(GetCorruptionLevel(dat)==GetCorruptionLevel(pdat) && GetFremoteness(dat)+1>GetFremoteness(pdat))
 				{
 					pdat=SetFremoteness(pdat,GetFremoteness(dat)+1);
-					corruptedPositions[parents->position]=corruptedPositions[parents->position]||corruptedPositions[p];
+					corruptedPositions[*parents]=corruptedPositions[*parents]||corruptedPositions[p];
 					if(!fringe) pdat=SetFringe(pdat,0);
 				}
 				break;
@@ -219,18 +219,18 @@ void PropogateFreAndCorUpFringe(POSITION p, char fringe)
 				   {
 				        pdat=SetCorruptionLevel(pdat,GetCorruptionLevel(dat));
 				        pdat=SetFremoteness(pdat,GetFremoteness(dat)+1);
-				        corruptedPositions[parents->position]=corruptedPositions[parents->position]||corruptedPositions[p];
+				        corruptedPositions[*parents]=corruptedPositions[*parents]||corruptedPositions[p];
 				        if(!fringe) pdat=SetFringe(pdat,0);
 				   }
 				   else if(GetCorruptionLevel(dat)==GetCorruptionLevel(pdat) && GetFremoteness(dat)+1<GetFremoteness(pdat))
 				   {
 				        pdat=SetFremoteness(pdat,GetFremoteness(dat)+1);
-				        corruptedPositions[parents->position]=corruptedPositions[parents->position]||corruptedPositions[p];
+				        corruptedPositions[*parents]=corruptedPositions[*parents]||corruptedPositions[p];
 				        if(!fringe) pdat=SetFringe(pdat,0);
 				   }
 				   else
 				   {*/
-				pdat=DetermineFreAndCorDown1LevelForWin(parents->position);
+				pdat=DetermineFreAndCorDown1LevelForWin(*parents);
 				if(!fringe) pdat=SetFringe(pdat,0);        /*
 				                                              }*/
 			}
@@ -244,17 +244,18 @@ void PropogateFreAndCorUpFringe(POSITION p, char fringe)
 		}
 		if(pdat!=old)
 		{
-			SetOpenData(parents->position,pdat);
-			PropogateFreAndCorUpFringe(parents->position,fringe);
+			SetOpenData(*parents,pdat);
+			PropogateFreAndCorUpFringe(*parents,fringe);
 		}
 		if(GetFringe(pdat) && GetFremoteness(pdat)) printf("DAVID!!!!\n");
 	}
 }
 void AddToParentsChildrenCount(POSITION child, int amt)
 {
-	POSITIONLIST* parents=gParents[child];
-	for(; parents; parents=parents->next)
-		gNumberChildren[parents->position]+=amt;
+	POSITION* parents=ParentIndexBegin(&gParents,child);
+	POSITION* parentsEnd=ParentIndexEnd(&gParents,child);
+	for(; parents<parentsEnd; parents++)
+		ChildCounterAdd(&gNumberChildren, *parents, amt);
 }
 void ComputeOpenPositions()
 {
@@ -280,7 +281,7 @@ void ComputeOpenPositions()
 			/* if the number of children of an undecided value is less than the original number of children but >0, it
 			   has a winning child and is therefore a fringe */
 			//printf("Pos %d has %d/%d children\n",iter,(int)gNumberChildren[iter],(int)gNumberChildrenOriginal[iter]);
-			if(gNumberChildren[iter]>0&&gNumberChildren[iter]<gNumberChildrenOriginal[iter]&&GetDrawValue(dat)==undecided && GetValueOfPosition(iter)==tie && Remoteness(iter)==REMOTENESS_MAX)
+			if(ChildCounterGet(&gNumberChildren, iter)>0&&ChildCounterGet(&gNumberChildren, iter)<ChildCounterGet(&gNumberChildrenOriginal, iter)&&GetDrawValue(dat)==undecided && GetValueOfPosition(iter)==tie && Remoteness(iter)==REMOTENESS_MAX)
 			{
 				if(curLevel==1) dat=SetCorruptionLevel(dat,0);
 				else
@@ -312,35 +313,36 @@ void ComputeOpenPositions()
 			break;
 		}
 		/* do paper-ish solving of the level.  Corruption and Fremoteness propogate up here */
-		while(gHeadLoseFR || gHeadWinFR)
+		while(!PosQueueIsEmpty(&gLoseFR) || !PosQueueIsEmpty(&gWinFR))
 		{
 			//printf("HERE\n");
-			while(gHeadLoseFR)
+			while(!PosQueueIsEmpty(&gLoseFR))
 			{
 				POSITION pos=DeQueueLoseFR();
-				POSITIONLIST* parents=gParents[pos];
+				POSITION* parents=ParentIndexBegin(&gParents,pos);
+				POSITION* parentsEnd=ParentIndexEnd(&gParents,pos);
 				OPEN_POS_DATA dat=GetOpenData(pos);
 				//printf("Looping!\n");
-				for(; parents; parents=parents->next)
+				for(; parents<parentsEnd; parents++)
 				{
 					OPEN_POS_DATA pdat;
 					OPEN_POS_DATA old;
-					if(!(GetValueOfPosition(parents->position)==tie && Remoteness(parents->position)==REMOTENESS_MAX)) continue;
-					pdat=GetOpenData(parents->position);
+					if(!(GetValueOfPosition(*parents)==tie && Remoteness(*parents)==REMOTENESS_MAX)) continue;
+					pdat=GetOpenData(*parents);
 					/* If my parent is already a lose and not already corrupted, corrupt it and move on */
 					if(GetDrawValue(pdat)==lose)
 					{
-						if(!corruptedPositions[parents->position]&&GetFringe(pdat))
+						if(!corruptedPositions[*parents]&&GetFringe(pdat))
 						{
-							corruptedPositions[parents->position]=1;
+							corruptedPositions[*parents]=1;
 							pdat=SetCorruptionLevel(pdat,GetCorruptionLevel(pdat)+1);
-							SetOpenData(parents->position,pdat);
+							SetOpenData(*parents,pdat);
 							if(GetCorruptionLevel(pdat)>curLevel)
 							{
 								printf("This is not good!\n");
-								PrintSingleOpenData(parents->position);
+								PrintSingleOpenData(*parents);
 							}
-							PropogateFreAndCorUp(parents->position);
+							PropogateFreAndCorUp(*parents);
 							if(GetCorruptionLevel(pdat)>maxCorruption)
 							{
 								maxCorruption=GetCorruptionLevel(pdat);
@@ -352,7 +354,7 @@ void ComputeOpenPositions()
 						}
 						continue;
 					}
-					//printf("Parent: %d\n",parents->position);
+					//printf("Parent: %d\n",*parents);
 					if(GetFringe(pdat)) continue;
 					old=pdat;
 					pdat=SetDrawValue(pdat,win);
@@ -362,41 +364,42 @@ void ComputeOpenPositions()
 					if(GetCorruptionLevel(pdat)>GetCorruptionLevel(dat) || GetCorruptionLevel(pdat)==CORRUPTION_MAX)
 					{
 						pdat=SetCorruptionLevel(pdat,GetCorruptionLevel(dat));
-						corruptedPositions[parents->position]=corruptedPositions[pos];
+						corruptedPositions[*parents]=corruptedPositions[pos];
 					}
-					SetOpenData(parents->position,pdat);
+					SetOpenData(*parents,pdat);
 					if(pdat!=old)
 					{
-						InsertWinFR(parents->position);
+						InsertWinFR(*parents);
 					}
 					if(GetCorruptionLevel(pdat)!=GetCorruptionLevel(old) || GetFremoteness(pdat)!=GetFremoteness(old))
 					{
-						PropogateFreAndCorUp(parents->position);
+						PropogateFreAndCorUp(*parents);
 					}
 				}
 			}
 			//PrintOpenDataFormatted();
 			//printf("HERE1\n");
-			while(gHeadWinFR)
+			while(!PosQueueIsEmpty(&gWinFR))
 			{
 				POSITION pos=DeQueueWinFR();
-				POSITIONLIST* parents=gParents[pos];
+				POSITION* parents=ParentIndexBegin(&gParents,pos);
+				POSITION* parentsEnd=ParentIndexEnd(&gParents,pos);
 				OPEN_POS_DATA dat=GetOpenData(pos);
 				char timeToBreak=0;
 				if(pos==kBadPosition) continue;
-				for(; parents; parents=parents->next)
+				for(; parents<parentsEnd; parents++)
 				{
 					OPEN_POS_DATA pdat;
 					OPEN_POS_DATA old;
-					if(!(GetValueOfPosition(parents->position)==tie && Remoteness(parents->position)==REMOTENESS_MAX)) continue;
-					pdat=GetOpenData(parents->position);
+					if(!(GetValueOfPosition(*parents)==tie && Remoteness(*parents)==REMOTENESS_MAX)) continue;
+					pdat=GetOpenData(*parents);
 					if(GetFringe(pdat)) continue;
-					if(--gNumberChildren[parents->position]==0)
+					if(ChildCounterGet(&gNumberChildren, *parents)!=0&&ChildCounterDecrement(&gNumberChildren, *parents)==0)
 					{
 						pdat=SetDrawValue(pdat,lose);
 						pdat=SetLevelNumber(pdat,curLevel);
-						SetOpenData(parents->position,pdat);
-						InsertLoseFR(parents->position);
+						SetOpenData(*parents,pdat);
+						InsertLoseFR(*parents);
 						timeToBreak=1;
 					}
 					old=pdat;
@@ -405,10 +408,10 @@ void ComputeOpenPositions()
 					if((GetCorruptionLevel(pdat)<GetCorruptionLevel(dat) || GetCorruptionLevel(pdat)==CORRUPTION_MAX) && GetDrawValue(pdat)==lose)
 					{
 						pdat=SetCorruptionLevel(pdat,GetCorruptionLevel(dat));
-						corruptedPositions[parents->position]=corruptedPositions[pos];
+						corruptedPositions[*parents]=corruptedPositions[pos];
 					}
-					SetOpenData(parents->position,pdat);
-					if(pdat!=old) PropogateFreAndCorUp(parents->position);
+					SetOpenData(*parents,pdat);
+					if(pdat!=old) PropogateFreAndCorUp(*parents);
 				}
 				if(timeToBreak) break;
 			}
@@ -442,25 +445,26 @@ void ComputeOpenPositions()
 			}
 			/* solve, fixing */
 			printf("here1\n");
-			while(gHeadLoseFR || gHeadWinFR)
+			while(!PosQueueIsEmpty(&gLoseFR) || !PosQueueIsEmpty(&gWinFR))
 			{
 				printf("here1.1\n");
-				while(gHeadLoseFR)
+				while(!PosQueueIsEmpty(&gLoseFR))
 				{
 					POSITION pos=DeQueueLoseFR();
-					POSITIONLIST* parents=gParents[pos];
+					POSITION* parents=ParentIndexBegin(&gParents,pos);
+					POSITION* parentsEnd=ParentIndexEnd(&gParents,pos);
 					OPEN_POS_DATA dat=GetOpenData(pos);
-					for(; parents; parents=parents->next)
+					for(; parents<parentsEnd; parents++)
 					{
-						OPEN_POS_DATA pdat=GetOpenData(parents->position);
+						OPEN_POS_DATA pdat=GetOpenData(*parents);
 						OPEN_POS_DATA old;
-						if(!(GetValueOfPosition(parents->position)==tie && Remoteness(parents->position)==REMOTENESS_MAX)) continue;
+						if(!(GetValueOfPosition(*parents)==tie && Remoteness(*parents)==REMOTENESS_MAX)) continue;
 						old=pdat;
 						/* If I've got a losing parent of the same corruption level, it's legit. */
 						if(GetDrawValue(pdat)==lose && GetCorruptionLevel(pdat)==i) continue;
 						pdat=SetDrawValue(pdat,win);
 						pdat=SetLevelNumber(pdat,curLevel);
-						fringePositions[parents->position]=0;
+						fringePositions[*parents]=0;
 						pdat=SetFringe(pdat, 0);
 						if(GetCorruptionLevel(pdat)<i) continue;
 						if(GetCorruptionLevel(pdat)>i)
@@ -471,49 +475,50 @@ void ComputeOpenPositions()
 						if((GetFremoteness(pdat)>GetFremoteness(dat)+1 || GetDrawValue(old)!=GetDrawValue(pdat)) && !GetFringe(old))
 							pdat=SetFremoteness(pdat,GetFremoteness(dat)+1);
 						if(GetDrawValue(old)==GetDrawValue(pdat) && GetCorruptionLevel(old)==GetCorruptionLevel(pdat) && GetFringe(old)) continue;
-						SetOpenData(parents->position,pdat);
+						SetOpenData(*parents,pdat);
 						if(GetFremoteness(pdat) && GetFringe(pdat)) printf("Dis not good\n");
 						//printf("start propogating\n");
-						//PrintSingleOpenData(parents->position);
-						if(pdat!=old) PropogateFreAndCorUpFringe(parents->position,0);
+						//PrintSingleOpenData(*parents);
+						if(pdat!=old) PropogateFreAndCorUpFringe(*parents,0);
 						//printf("done propogating\n");
 						if(pdat!=old || GetDrawValue(pdat)!=GetDrawValue(old))
 						{
-							InsertWinFR(parents->position);
+							InsertWinFR(*parents);
 						}
 						if(GetDrawValue(pdat)==win && GetDrawValue(old)==lose)
 						{
-							AddToParentsChildrenCount(parents->position,1);
-							//if(GetLevelNumber(pdat)==2) printf("l-->w%d\n",parents->position);
+							AddToParentsChildrenCount(*parents,1);
+							//if(GetLevelNumber(pdat)==2) printf("l-->w%d\n",*parents);
 						}
-						//else if(pdat!=old && GetLevelNumber(pdat)==2) printf("-->w%d\n",parents->position);
+						//else if(pdat!=old && GetLevelNumber(pdat)==2) printf("-->w%d\n",*parents);
 					}
 				}
 				printf("here1.2\n");
-				while(gHeadWinFR)
+				while(!PosQueueIsEmpty(&gWinFR))
 				{
 					POSITION pos=DeQueueWinFR();
-					POSITIONLIST* parents=gParents[pos];
+					POSITION* parents=ParentIndexBegin(&gParents,pos);
+					POSITION* parentsEnd=ParentIndexEnd(&gParents,pos);
 					OPEN_POS_DATA dat=GetOpenData(pos);
 					char timeToBreak=0;
 
-					for(; parents; parents=parents->next)
+					for(; parents<parentsEnd; parents++)
 					{
 						OPEN_POS_DATA pdat;
 						OPEN_POS_DATA old;
-						if(!(GetValueOfPosition(parents->position)==tie && Remoteness(parents->position)==REMOTENESS_MAX)) continue;
-						pdat=GetOpenData(parents->position);
+						if(!(GetValueOfPosition(*parents)==tie && Remoteness(*parents)==REMOTENESS_MAX)) continue;
+						pdat=GetOpenData(*parents);
 						old=pdat;
 						if(GetCorruptionLevel(pdat)<i) continue;
-						if(--gNumberChildren[parents->position]==0)
+						if(ChildCounterGet(&gNumberChildren, *parents)!=0&&ChildCounterDecrement(&gNumberChildren, *parents)==0)
 						{
 							pdat=SetDrawValue(pdat,lose);
 							pdat=SetLevelNumber(pdat,curLevel);
 							pdat=SetCorruptionLevel(pdat,i);
-							SetOpenData(parents->position,pdat);
-							fringePositions[parents->position]=0;
+							SetOpenData(*parents,pdat);
+							fringePositions[*parents]=0;
 							pdat=SetFringe(pdat,0);
-							InsertLoseFR(parents->position);
+							InsertLoseFR(*parents);
 							timeToBreak=1;
 						}
 						if(GetFremoteness(pdat) && GetFringe(pdat)) printf("Dis not good2.0\n");
@@ -530,10 +535,10 @@ void ComputeOpenPositions()
 							if(GetFremoteness(pdat) && GetFringe(pdat)) printf("Dis not good2.2\n");
 						}
 						if(GetDrawValue(old)==GetDrawValue(pdat) && GetCorruptionLevel(old)==GetCorruptionLevel(pdat) && GetFringe(old)) continue;
-						SetOpenData(parents->position,pdat);
+						SetOpenData(*parents,pdat);
 						if(GetFremoteness(pdat) && GetFringe(pdat)) printf("Dis not good2\n");
-						if(pdat!=old) PropogateFreAndCorUpFringe(parents->position,0);
-						if(GetDrawValue(old)==win && GetDrawValue(pdat)==lose) AddToParentsChildrenCount(parents->position,1);
+						if(pdat!=old) PropogateFreAndCorUpFringe(*parents,0);
+						if(GetDrawValue(old)==win && GetDrawValue(pdat)==lose) AddToParentsChildrenCount(*parents,1);
 					}
 					//printf("Done fixing:\n");
 					if(timeToBreak) break;
@@ -0,0 +1,90 @@
+/************************************************************************
+**
+** NAME:	parentindex.c
+**
+** DESCRIPTION:	Compressed sparse row parent pointers for the loopy
+**		solvers. The solver walks its edges twice: the first
+**		pass only counts each position's parents, and the
+**		second, after the counts have become offsets, fills one
+**		flat array. Nothing is logged per edge, and the offsets
+**		are 32 bits whenever the edge count allows.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-17
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include "gamesman.h"
+
+void ParentIndexInit(PARENTINDEX *index, POSITION numPositions)
+{
+	index->numPositions = numPositions;
+	index->offsets32 = (unsigned int *) SafeMalloc((numPositions + 1) * sizeof(unsigned int));
+	memset(index->offsets32, 0, (numPositions + 1) * sizeof(unsigned int));
+	index->offsets64 = NULL;
+	index->parents = NULL;
+}
+
+void ParentIndexAdd(PARENTINDEX *index, POSITION child, POSITION parent)
+{
+	if (index->parents == NULL)
+		index->offsets32[child]++;
+	// filling each run from its end leaves its offset at its start
+	else if (index->offsets32 != NULL)
+		index->parents[--index->offsets32[child]] = parent;
+	else index->parents[--index->offsets64[child]] = parent;
+}
+
+// Ends the counting pass: counts -> end of each position's run
+void ParentIndexFill(PARENTINDEX *index)
+{
+	POSITION p, numEdges = 0;
+
+	for (p = 0; p < index->numPositions; p++)
+		numEdges += index->offsets32[p];
+	if (numEdges > UINT_MAX) {
+		index->offsets64 = (POSITION *) SafeMalloc((index->numPositions + 1) * sizeof(POSITION));
+		for (numEdges = 0, p = 0; p < index->numPositions; p++)
+			index->offsets64[p] = (numEdges += index->offsets32[p]);
+		index->offsets64[index->numPositions] = numEdges;
+		SafeFree(index->offsets32);
+		index->offsets32 = NULL;
+	} else {
+		for (numEdges = 0, p = 0; p < index->numPositions; p++)
+			index->offsets32[p] = (unsigned int) (numEdges += index->offsets32[p]);
+		index->offsets32[index->numPositions] = (unsigned int) numEdges;
+	}
+	index->parents = (POSITION *) SafeMalloc((numEdges > 0 ? numEdges : 1) * sizeof(POSITION));
+}
+
+void ParentIndexFree(PARENTINDEX *index)
+{
+	if (index->offsets32 != NULL) SafeFree(index->offsets32);
+	if (index->offsets64 != NULL) SafeFree(index->offsets64);
+	if (index->parents != NULL) SafeFree(index->parents);
+	index->offsets32 = NULL;
+	index->offsets64 = index->parents = NULL;
+	index->numPositions = 0;
+}
+
+// End ParentIndex
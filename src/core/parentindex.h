@@ -0,0 +1,30 @@
+#ifndef GMCORE_PARENTINDEX_H
+#define GMCORE_PARENTINDEX_H
+
+/* Parent pointers in compressed sparse row form, built in two passes over
+   the same edges. While counting, ParentIndexAdd only counts in-degrees;
+   ParentIndexFill turns the counts into offsets, and from then on
+   ParentIndexAdd puts each parent in its place. The second pass has to
+   add exactly the edges the first one counted. Offsets are 32 bits unless
+   there are too many edges for that. */
+typedef struct parent_index
+{
+	POSITION numPositions;
+	unsigned int *offsets32;        /* counts, then offsets, if they fit */
+	POSITION *offsets64;            /* offsets otherwise */
+	POSITION *parents;              /* NULL while counting */
+}
+PARENTINDEX;
+
+void            ParentIndexInit                 (PARENTINDEX *index, POSITION numPositions);
+void            ParentIndexAdd                  (PARENTINDEX *index, POSITION child, POSITION parent);
+void            ParentIndexFill                 (PARENTINDEX *index);
+void            ParentIndexFree                 (PARENTINDEX *index);
+
+/* Only valid once the second pass is done */
+#define ParentIndexOffset(index, p) ((index)->offsets32 != NULL ? (POSITION) (index)->offsets32[p] : (index)->offsets64[p])
+#define ParentIndexBegin(index, p) ((index)->parents + ParentIndexOffset(index, p))
+#define ParentIndexEnd(index, p) ((index)->parents + ParentIndexOffset(index, (p)+1))
+#define ParentIndexCount(index, p) (ParentIndexOffset(index, (p)+1) - ParentIndexOffset(index, p))
+
+#endif /* GMCORE_PARENTINDEX_H */
@@ -0,0 +1,358 @@
+/************************************************************************
+**
+** NAME:	posqueue.c
+**
+** DESCRIPTION:	Chunked, append-only position queues for the solvers'
+**		frontiers. Positions are kept POSQUEUE_CHUNK_SIZE at a time
+**		in arrays instead of one list node each, and full chunks
+**		can be spilled to a temporary file, shared by all the
+**		queues, once the frontiers use more than gFrontierMemoryMB
+**		megabytes.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-17
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include "gamesman.h"
+
+/* Chunks held in memory by all queues together */
+static POSITION posqueue_chunksInMemory = 0;
+
+/* The spill file. The retrograde solver alone keeps three queues per
+   remoteness, so they share one file rather than each opening its own.
+   It is cut in slots of one chunk each: the number of positions in the
+   chunk, the slot the queue's next chunk goes in, and the positions.
+   Freed slots are reused, and the file is emptied once none is in use. */
+#define POSQUEUE_SLOT_BYTES ((2 + POSQUEUE_CHUNK_SIZE) * sizeof(POSITION))
+
+static FILE *posqueue_spill = NULL;
+static POSITION posqueue_slots = 0;             /* slots in the file */
+static POSITION *posqueue_freeSlots = NULL;
+static POSITION posqueue_numFreeSlots = 0, posqueue_maxFreeSlots = 0;
+
+static POSQUEUE_CHUNK*  NewChunk                (void);
+static void             FreeChunk               (POSQUEUE_CHUNK *chunk);
+static BOOLEAN          ShouldSpill             (POSQUEUE *queue);
+static void             SpillChunk              (POSQUEUE *queue, POSQUEUE_CHUNK *chunk);
+static POSQUEUE_CHUNK*  UnspillChunk            (POSQUEUE *queue);
+static void             DropSpilled             (POSQUEUE *queue);
+static BOOLEAN          ReadSlot                (POSITION slot, POSITION *next, POSITION *positions, unsigned int *count);
+static POSITION         NewSlot                 (void);
+static void             FreeSlot                (POSITION slot);
+static POSQUEUE_CHUNK*  FrontChunk              (POSQUEUE *queue);
+
+void PosQueueInit(POSQUEUE *queue)
+{
+	queue->front = queue->frontLast = queue->back = NULL;
+	queue->size = 0;
+	queue->spilledChunks = 0;
+	queue->spillHead = queue->spillTail = 0;
+}
+
+void PosQueueFree(POSQUEUE *queue)
+{
+	POSQUEUE_CHUNK *next;
+	for (; queue->front != NULL; queue->front = next) {
+		next = queue->front->next;
+		FreeChunk(queue->front);
+	}
+	if (queue->back != NULL)
+		FreeChunk(queue->back);
+	DropSpilled(queue);
+	PosQueueInit(queue);
+}
+
+void PosQueuePush(POSQUEUE *queue, POSITION position)
+{
+	POSQUEUE_CHUNK *back = queue->back;
+	if (back == NULL) {
+		back = queue->back = NewChunk();
+	} else if (back->tail == POSQUEUE_CHUNK_SIZE) {
+		// Retire the full back chunk, either to the front list or to disk.
+		// Once something is on disk, everything after it must go there too.
+		if (ShouldSpill(queue)) {
+			SpillChunk(queue, back);
+			back->head = back->tail = 0;
+		} else {
+			back->next = NULL;
+			if (queue->frontLast == NULL)
+				queue->front = back;
+			else queue->frontLast->next = back;
+			queue->frontLast = back;
+			back = queue->back = NewChunk();
+		}
+	}
+	back->positions[back->tail++] = position;
+	queue->size++;
+}
+
+/* Returns kBadPosition if the queue is empty, like DeQueueFR */
+POSITION PosQueuePop(POSQUEUE *queue)
+{
+	POSITION position;
+	POSQUEUE_CHUNK *chunk = FrontChunk(queue);
+	if (chunk == NULL)
+		return kBadPosition;
+	position = chunk->positions[chunk->head++];
+	if (--queue->size == 0)
+		FrontChunk(queue); // releases the drained chunks
+	return position;
+}
+
+/* Pops up to max positions into the given array, returning how many */
+POSITION PosQueuePopBulk(POSQUEUE *queue, POSITION *positions, POSITION max)
+{
+	POSITION count = 0, n;
+	POSQUEUE_CHUNK *chunk;
+	while (count < max && (chunk = FrontChunk(queue)) != NULL) {
+		n = chunk->tail - chunk->head;
+		if (n > max - count)
+			n = max - count;
+		memcpy(positions + count, chunk->positions + chunk->head, n * sizeof(POSITION));
+		chunk->head += n;
+		count += n;
+	}
+	queue->size -= count;
+	if (count != 0 && queue->size == 0)
+		FrontChunk(queue);
+	return count;
+}
+
+/* Moves every position of src to the end of dest, leaving src empty */
+void PosQueueAppend(POSQUEUE *dest, POSQUEUE *src)
+{
+	POSITION i, n;
+	POSITION *buffer;
+	if (PosQueueIsEmpty(src)) {
+		PosQueueFree(src);
+		return;
+	}
+	buffer = (POSITION *) SafeMalloc(POSQUEUE_CHUNK_SIZE * sizeof(POSITION));
+	while ((n = PosQueuePopBulk(src, buffer, POSQUEUE_CHUNK_SIZE)) != 0)
+		for (i = 0; i < n; i++)
+			PosQueuePush(dest, buffer[i]);
+	SafeFree(buffer);
+	PosQueueFree(src);
+}
+
+/* Writes the size of the queue and then its positions, front to back,
+   without popping them. Returns FALSE if the file couldn't be written. */
+BOOLEAN PosQueueWrite(POSQUEUE *queue, FILE *fp)
+{
+	POSQUEUE_CHUNK *chunk;
+	POSITION *buffer;
+	POSITION i, slot;
+	unsigned int count, n;
+	BOOLEAN good;
+
+	good = (fwrite(&queue->size, sizeof(POSITION), 1, fp) == 1);
+	for (chunk = queue->front; good && chunk != NULL; chunk = chunk->next) {
+		n = chunk->tail - chunk->head;
+		good = (fwrite(chunk->positions + chunk->head, sizeof(POSITION), n, fp) == n);
+	}
+	if (good && queue->spilledChunks != 0) { // the spilled chunks, in the order they'd be read back
+		buffer = (POSITION *) SafeMalloc(POSQUEUE_CHUNK_SIZE * sizeof(POSITION));
+		slot = queue->spillHead;
+		for (i = 0; good && i < queue->spilledChunks; i++)
+			good = (ReadSlot(slot, &slot, buffer, &count) &&
+			        fwrite(buffer, sizeof(POSITION), count, fp) == count);
+		SafeFree(buffer);
+	}
+	if (good && (chunk = queue->back) != NULL) {
+		n = chunk->tail - chunk->head;
+		good = (fwrite(chunk->positions + chunk->head, sizeof(POSITION), n, fp) == n);
+	}
+	return good;
+}
+
+/* Pushes the positions written by PosQueueWrite onto the queue */
+BOOLEAN PosQueueRead(POSQUEUE *queue, FILE *fp)
+{
+	POSITION size, i, n;
+	POSITION *buffer;
+
+	if (fread(&size, sizeof(POSITION), 1, fp) != 1)
+		return FALSE;
+	buffer = (POSITION *) SafeMalloc(POSQUEUE_CHUNK_SIZE * sizeof(POSITION));
+	for (; size > 0; size -= n) {
+		n = (size < POSQUEUE_CHUNK_SIZE) ? size : POSQUEUE_CHUNK_SIZE;
+		if (fread(buffer, sizeof(POSITION), n, fp) != n) {
+			SafeFree(buffer);
+			return FALSE;
+		}
+		for (i = 0; i < n; i++)
+			PosQueuePush(queue, buffer[i]);
+	}
+	SafeFree(buffer);
+	return TRUE;
+}
+
+/*
+** Helpers
+*/
+
+static POSQUEUE_CHUNK* NewChunk()
+{
+	POSQUEUE_CHUNK *chunk = (POSQUEUE_CHUNK *) SafeMalloc(sizeof(POSQUEUE_CHUNK));
+	chunk->head = chunk->tail = 0;
+	chunk->next = NULL;
+	posqueue_chunksInMemory++;
+	return chunk;
+}
+
+static void FreeChunk(POSQUEUE_CHUNK *chunk)
+{
+	SafeFree(chunk);
+	posqueue_chunksInMemory--;
+}
+
+static BOOLEAN ShouldSpill(POSQUEUE *queue)
+{
+	if (queue->spilledChunks != 0)
+		return TRUE;
+	return gFrontierMemoryMB > 0 &&
+	       posqueue_chunksInMemory * sizeof(POSQUEUE_CHUNK) >= (POSITION) gFrontierMemoryMB << 20;
+}
+
+static void SpillChunk(POSQUEUE *queue, POSQUEUE_CHUNK *chunk)
+{
+	POSITION header[2];
+	if (queue->spilledChunks == 0)
+		queue->spillHead = queue->spillTail = NewSlot();
+	header[0] = chunk->tail - chunk->head;
+	header[1] = NewSlot();
+	if (fseeko(posqueue_spill, (off_t) queue->spillTail * POSQUEUE_SLOT_BYTES, SEEK_SET) != 0 ||
+	    fwrite(header, sizeof(POSITION), 2, posqueue_spill) != 2 ||
+	    fwrite(chunk->positions + chunk->head, sizeof(POSITION), header[0], posqueue_spill) != header[0]) {
+		printf("ERROR: Couldn't spill the frontier to disk!\n");
+		ExitStageRight();
+	}
+	queue->spillTail = header[1];
+	queue->spilledChunks++;
+}
+
+static POSQUEUE_CHUNK* UnspillChunk(POSQUEUE *queue)
+{
+	POSQUEUE_CHUNK *chunk = NewChunk();
+	POSITION slot = queue->spillHead;
+	if (!ReadSlot(slot, &queue->spillHead, chunk->positions, &chunk->tail)) {
+		printf("ERROR: Couldn't read the frontier back from disk!\n");
+		ExitStageRight();
+	}
+	FreeSlot(slot);
+	if (--queue->spilledChunks == 0) // drained, so give back the slot kept for the next one
+		FreeSlot(queue->spillTail);
+	return chunk;
+}
+
+/* Gives back the slots of a queue's spilled chunks without reading them */
+static void DropSpilled(POSQUEUE *queue)
+{
+	POSITION slot;
+	if (queue->spilledChunks == 0)
+		return;
+	for (; queue->spilledChunks > 0; queue->spilledChunks--) {
+		slot = queue->spillHead;
+		if (fseeko(posqueue_spill, (off_t) slot * POSQUEUE_SLOT_BYTES + sizeof(POSITION), SEEK_SET) != 0 ||
+		    fread(&queue->spillHead, sizeof(POSITION), 1, posqueue_spill) != 1) {
+			printf("ERROR: Couldn't read the frontier back from disk!\n");
+			ExitStageRight();
+		}
+		FreeSlot(slot);
+	}
+	FreeSlot(queue->spillTail);
+}
+
+/* Reads the chunk in a slot, and the slot the chunk after it is in */
+static BOOLEAN ReadSlot(POSITION slot, POSITION *next, POSITION *positions, unsigned int *count)
+{
+	POSITION header[2];
+	if (fseeko(posqueue_spill, (off_t) slot * POSQUEUE_SLOT_BYTES, SEEK_SET) != 0 ||
+	    fread(header, sizeof(POSITION), 2, posqueue_spill) != 2 ||
+	    header[0] > POSQUEUE_CHUNK_SIZE ||
+	    fread(positions, sizeof(POSITION), header[0], posqueue_spill) != header[0])
+		return FALSE;
+	*next = header[1];
+	*count = (unsigned int) header[0];
+	return TRUE;
+}
+
+static POSITION NewSlot()
+{
+	if (posqueue_spill == NULL && (posqueue_spill = tmpfile()) == NULL) {
+		printf("ERROR: Couldn't create a file to spill the frontier to!\n");
+		ExitStageRight();
+	}
+	if (posqueue_numFreeSlots != 0)
+		return posqueue_freeSlots[--posqueue_numFreeSlots];
+	return posqueue_slots++;
+}
+
+static void FreeSlot(POSITION slot)
+{
+	if (posqueue_freeSlots == NULL) {
+		posqueue_maxFreeSlots = 64;
+		posqueue_freeSlots = (POSITION *) SafeMalloc(posqueue_maxFreeSlots * sizeof(POSITION));
+	} else if (posqueue_numFreeSlots == posqueue_maxFreeSlots) {
+		posqueue_maxFreeSlots *= 2;
+		posqueue_freeSlots = (POSITION *) SafeRealloc(posqueue_freeSlots, posqueue_maxFreeSlots * sizeof(POSITION));
+	}
+	posqueue_freeSlots[posqueue_numFreeSlots++] = slot;
+	if (posqueue_numFreeSlots == posqueue_slots) { // nothing spilled anywhere, so start the file over
+		posqueue_numFreeSlots = posqueue_slots = 0;
+		if (ftruncate(fileno(posqueue_spill), 0) != 0) {
+			fclose(posqueue_spill);
+			posqueue_spill = NULL;
+		}
+	}
+}
+
+/* The chunk the next position will be popped from, or NULL if empty */
+static POSQUEUE_CHUNK* FrontChunk(POSQUEUE *queue)
+{
+	POSQUEUE_CHUNK *chunk;
+	for (;;) {
+		chunk = queue->front;
+		if (chunk == NULL) {
+			if (queue->spilledChunks != 0) {
+				chunk = queue->front = queue->frontLast = UnspillChunk(queue);
+			} else {
+				chunk = queue->back;
+				if (chunk == NULL || chunk->head < chunk->tail)
+					return chunk;
+				FreeChunk(chunk); // empty queues hold no memory
+				queue->back = NULL;
+				return NULL;
+			}
+		}
+		if (chunk->head < chunk->tail)
+			return chunk;
+		queue->front = chunk->next;
+		if (queue->front == NULL)
+			queue->frontLast = NULL;
+		FreeChunk(chunk);
+	}
+}
+
+// End PosQueue
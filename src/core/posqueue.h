@@ -0,0 +1,46 @@
+#ifndef GMCORE_POSQUEUE_H
+#define GMCORE_POSQUEUE_H
+
+#include <stdio.h>
+
+/* Positions per chunk: 32 KB with 64-bit POSITIONs */
+#define POSQUEUE_CHUNK_SIZE 4096
+
+typedef struct posqueue_chunk
+{
+	unsigned int head;              /* next position to pop */
+	unsigned int tail;              /* next free slot */
+	struct posqueue_chunk *next;
+	POSITION positions[POSQUEUE_CHUNK_SIZE];
+}
+POSQUEUE_CHUNK;
+
+/* A FIFO of positions stored in chunks rather than one node per position.
+   Positions are popped from the front list, then from the chunks spilled
+   to disk (if any), then from the back chunk that is being appended to.
+   Spilled chunks go in slots of a file shared by all queues; each slot
+   names the slot of the queue's next spilled chunk. */
+typedef struct posqueue
+{
+	POSQUEUE_CHUNK *front, *frontLast;
+	POSQUEUE_CHUNK *back;
+	POSITION size;
+	POSITION spilledChunks;
+	POSITION spillHead;             /* slot of the next chunk to read back */
+	POSITION spillTail;             /* slot the next spilled chunk goes in */
+}
+POSQUEUE;
+
+void            PosQueueInit                    (POSQUEUE *queue);
+void            PosQueueFree                    (POSQUEUE *queue);
+void            PosQueuePush                    (POSQUEUE *queue, POSITION position);
+POSITION        PosQueuePop                     (POSQUEUE *queue);
+POSITION        PosQueuePopBulk                 (POSQUEUE *queue, POSITION *positions, POSITION max);
+void            PosQueueAppend                  (POSQUEUE *dest, POSQUEUE *src);
+BOOLEAN         PosQueueWrite                   (POSQUEUE *queue, FILE *fp);
+BOOLEAN         PosQueueRead                    (POSQUEUE *queue, FILE *fp);
+
+#define PosQueueIsEmpty(queue) ((queue)->size == 0)
+#define PosQueueSize(queue) ((queue)->size)
+
+#endif /* GMCORE_POSQUEUE_H */
@@ -30,112 +30,500 @@
 **************************************************************************/
 
 #include "gamesman.h"
+#include <pthread.h>
 
-#define MAX_FN_LEN 40
+#define MAX_FN_LEN 80
 
 //DO NOT USE THIS WITH A LOOPY GAME, IT WILL SPIN IN AN INFINITE LOOP
 
+/* Stage files are binary: the magic, the number of positions, then the
+   positions in increasing order, each one stored as the difference from
+   the one before it in 7-bit groups (the high bit says another group
+   follows). Stages are read and written through big buffers, and the
+   next stage is built by an external sort, so only STAGE_RUN_MB of it
+   is ever in memory. */
+
+#define STAGE_MAGIC "GMSTAGE1"
+#define STAGE_BUFFER_SIZE (1 << 20)     // bytes buffered per open stage or run file
+#define STAGE_RUN_MB 64                 // default size of the in-memory sort buffer
+
+typedef struct stage_file {
+	FILE *file;
+	unsigned char *buffer;
+	size_t used, filled;
+	POSITION last, count, left;
+} STAGE_FILE;
+
 int TotalStages;
 
-FILE *StageFile;
+void stageFileName(char *filename, int stagenum)
+{
+	sprintf(filename, "./stages/%s_stage%d.bin", kDBName, stagenum);
+}
+
+void stageWriteFlush(STAGE_FILE *stage)
+{
+	if (stage->used != 0 && fwrite(stage->buffer, 1, stage->used, stage->file) != stage->used) {
+		printf("Unable to write positions to a stage file. Aborting.");
+		ExitStageRight();
+		exit(1);
+	}
+	stage->used = 0;
+}
 
-void newStageFile()
+// file must be open for writing; it is written from its start
+void stageWriteBegin(STAGE_FILE *stage, FILE *file)
+{
+	stage->file = file;
+	stage->buffer = (unsigned char *) SafeMalloc(STAGE_BUFFER_SIZE);
+	stage->used = 0;
+	stage->last = stage->count = 0;
+	memcpy(stage->buffer, STAGE_MAGIC, 8);
+	memcpy(stage->buffer + 8, &stage->count, sizeof(POSITION)); // patched when done
+	stage->used = 8 + sizeof(POSITION);
+}
+
+// positions must come in increasing order; repeats are dropped
+void stageWrite(STAGE_FILE *stage, POSITION position)
+{
+	POSITION delta;
+	if (stage->count != 0 && position <= stage->last)
+		return;
+	if (stage->used + 10 > STAGE_BUFFER_SIZE)
+		stageWriteFlush(stage);
+	delta = position - stage->last;
+	while (delta >= 0x80) {
+		stage->buffer[stage->used++] = (unsigned char) (delta | 0x80);
+		delta >>= 7;
+	}
+	stage->buffer[stage->used++] = (unsigned char) delta;
+	stage->last = position;
+	stage->count++;
+}
+
+// Returns the number of positions written. The file stays open.
+POSITION stageWriteEnd(STAGE_FILE *stage)
+{
+	stageWriteFlush(stage);
+	if (fseeko(stage->file, 8, SEEK_SET) != 0
+	    || fwrite(&stage->count, sizeof(POSITION), 1, stage->file) != 1
+	    || fflush(stage->file) != 0) {
+		printf("Unable to finish a stage file. Aborting.");
+		ExitStageRight();
+		exit(1);
+	}
+	SafeFree(stage->buffer);
+	return stage->count;
+}
+
+// Starts (or restarts) reading file from its first position
+void stageReadBegin(STAGE_FILE *stage, FILE *file)
+{
+	char magic[8];
+	stage->file = file;
+	if (fseeko(file, 0, SEEK_SET) != 0
+	    || fread(magic, 1, 8, file) != 8 || memcmp(magic, STAGE_MAGIC, 8) != 0
+	    || fread(&stage->count, sizeof(POSITION), 1, file) != 1) {
+		printf("Unable to read a stage file. Aborting.");
+		ExitStageRight();
+		exit(1);
+	}
+	stage->used = stage->filled = 0;
+	stage->last = 0;
+	stage->left = stage->count;
+}
+
+// Returns FALSE once every position has been read
+BOOLEAN stageRead(STAGE_FILE *stage, POSITION *position)
+{
+	POSITION delta = 0;
+	int shift = 0;
+	unsigned char byte;
+	if (stage->left == 0)
+		return FALSE;
+	do {
+		if (stage->used == stage->filled) {
+			stage->filled = fread(stage->buffer, 1, STAGE_BUFFER_SIZE, stage->file);
+			stage->used = 0;
+			if (stage->filled == 0) {
+				printf("A stage file ended early. Aborting.");
+				ExitStageRight();
+				exit(1);
+			}
+		}
+		byte = stage->buffer[stage->used++];
+		delta |= (POSITION) (byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	stage->last += delta;
+	stage->left--;
+	*position = stage->last;
+	return TRUE;
+}
+
+FILE* newStageFile(int stagenum)
 {
 	char filename[MAX_FN_LEN];
-	int i;
+	FILE *file;
 
-	for (i = 0; i < MAX_FN_LEN; i++)
-		filename[i] = ' ';
-	sprintf(filename, "./stages/%s_stage%d.txt", kDBName, TotalStages);
-	if ((StageFile = fopen(filename, "wb")) == NULL) {
+	stageFileName(filename, stagenum);
+	if ((file = fopen(filename, "w+b")) == NULL) {
 		printf("Unable to create file for writing positions in a stage. Aborting.");
 		ExitStageRight();
 		exit(1);
 	}
+	return file;
 }
 
 void openStageFile(FILE **filep, int stagenum)
 {
-	int i;
 	char filen[MAX_FN_LEN];
 
-	for (i = 0; i < MAX_FN_LEN; i++)
-		filen[i]=' ';
-	sprintf(filen, "./stages/%s_stage%d.txt", kDBName, stagenum);
-	if (((*filep) = fopen(filen, "r")) == NULL) {
+	stageFileName(filen, stagenum);
+	if (((*filep) = fopen(filen, "rb")) == NULL) {
 		printf("unable to create file for reading positions in a stage. Aborting.");
 		ExitStageRight();
 		exit(1);
 	}
 }
 
+int comparePositions(const void *a, const void *b)
+{
+	POSITION x = *(const POSITION *) a, y = *(const POSITION *) b;
+	return (x > y) - (x < y);
+}
+
+/* The next stage, one sorted run at a time: the buffer is sorted and
+   spilled to a temporary file whenever it fills up, and the runs are
+   merged into the stage file at the end. */
+typedef struct stage_sorter {
+	POSITION *buffer, size, max;
+	FILE **runs;
+	int numRuns;
+} STAGE_SORTER;
+
+void stageSortAdd(STAGE_SORTER *sorter, POSITION position)
+{
+	STAGE_FILE run;
+	POSITION i;
+	if (sorter->size == sorter->max) {
+		qsort(sorter->buffer, sorter->size, sizeof(POSITION), comparePositions);
+		sorter->runs = (sorter->numRuns == 0)
+		               ? (FILE **) SafeMalloc(sizeof(FILE *))
+		               : (FILE **) SafeRealloc(sorter->runs, (sorter->numRuns+1) * sizeof(FILE *));
+		if ((sorter->runs[sorter->numRuns] = tmpfile()) == NULL) {
+			printf("Unable to create a file to sort a stage with. Aborting.");
+			ExitStageRight();
+			exit(1);
+		}
+		stageWriteBegin(&run, sorter->runs[sorter->numRuns++]);
+		for (i = 0; i < sorter->size; i++)
+			stageWrite(&run, sorter->buffer[i]);
+		stageWriteEnd(&run);
+		sorter->size = 0;
+	}
+	sorter->buffer[sorter->size++] = position;
+}
+
+// Writes every position added since the last call to stage, in order
+POSITION stageSortFinish(STAGE_SORTER *sorter, FILE *file)
+{
+	STAGE_FILE stage, *runs;
+	POSITION *heads, i, count;
+	BOOLEAN *live;
+	int r, best, numRuns = sorter->numRuns;
+
+	qsort(sorter->buffer, sorter->size, sizeof(POSITION), comparePositions);
+	stageWriteBegin(&stage, file);
+	if (numRuns == 0) {
+		for (i = 0; i < sorter->size; i++)
+			stageWrite(&stage, sorter->buffer[i]);
+	} else { // merge the runs and the buffer, the buffer being the last "run"
+		runs = (STAGE_FILE *) SafeMalloc(numRuns * sizeof(STAGE_FILE));
+		heads = (POSITION *) SafeMalloc((numRuns+1) * sizeof(POSITION));
+		live = (BOOLEAN *) SafeMalloc((numRuns+1) * sizeof(BOOLEAN));
+		for (r = 0; r < numRuns; r++) {
+			runs[r].buffer = (unsigned char *) SafeMalloc(STAGE_BUFFER_SIZE);
+			stageReadBegin(&runs[r], sorter->runs[r]);
+			live[r] = stageRead(&runs[r], &heads[r]);
+		}
+		i = 0;
+		live[numRuns] = (sorter->size != 0);
+		if (live[numRuns])
+			heads[numRuns] = sorter->buffer[i++];
+		for (;;) {
+			best = -1;
+			for (r = 0; r <= numRuns; r++)
+				if (live[r] && (best == -1 || heads[r] < heads[best]))
+					best = r;
+			if (best == -1)
+				break;
+			stageWrite(&stage, heads[best]);
+			if (best < numRuns)
+				live[best] = stageRead(&runs[best], &heads[best]);
+			else if ((live[best] = (i < sorter->size)))
+				heads[best] = sorter->buffer[i++];
+		}
+		for (r = 0; r < numRuns; r++) {
+			SafeFree(runs[r].buffer);
+			fclose(sorter->runs[r]);
+		}
+		SafeFree(runs);
+		SafeFree(heads);
+		SafeFree(live);
+		SafeFree(sorter->runs);
+		sorter->runs = NULL;
+		sorter->numRuns = 0;
+	}
+	sorter->size = 0;
+	count = stageWriteEnd(&stage);
+	return count;
+}
+
 /* walk the game tree in a BFS (no graphs please) and generate files with the names
-        "./stages/1210_stage1_positions.txt"
-   to aid solving the stuff*/
+        "./stages/1210_stage1.bin"
+   to aid solving the stuff. Each stage is read back from its file to
+   generate the next one, so the frontier never has to fit in memory. */
 void WalkGameTree()
 {
-	POSITIONQUEUE *head, *tail, *stagetail;
-	BOOLEAN isPrimitive, beginNewStage;
-	MOVELIST      *currentMoves, *currentMovesHead;
+	STAGE_FILE current;
+	STAGE_SORTER sorter;
+	BOOLEAN isPrimitive;
+	POSITION *children = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	MOVE *moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+	int i, numChildren = 0;
 	POSITION currentPos, childPos;
-
-	tail = NULL;
-	AddPositionToQueue(gInitialPosition, &tail);
-	head = tail;
-	stagetail = tail;
-	TotalStages = -1;
+	FILE *StageFile;
+	int runMB = (gFrontierMemoryMB > 0) ? gFrontierMemoryMB : STAGE_RUN_MB;
 
 	mkdir("stages", 0755);
 
 	printf("I am walking the game tree now.\n");
 
-	beginNewStage = TRUE;
-
 	UnMarkAllAsVisited();
 
-	do {
-		currentPos = head->position;
-
-		/*write the position to the first file;*/
-		if (beginNewStage) {
-			TotalStages++;
-			printf("walking stage %d\n", TotalStages);
-			newStageFile();
-			beginNewStage = FALSE;
+	sorter.max = ((POSITION) runMB << 20) / sizeof(POSITION);
+	sorter.buffer = (POSITION *) SafeMalloc(sorter.max * sizeof(POSITION));
+	sorter.size = 0;
+	sorter.runs = NULL;
+	sorter.numRuns = 0;
+	current.buffer = (unsigned char *) SafeMalloc(STAGE_BUFFER_SIZE);
+
+	TotalStages = 0;
+	printf("walking stage %d\n", TotalStages);
+	StageFile = newStageFile(TotalStages);
+	stageSortAdd(&sorter, gInitialPosition);
+	stageSortFinish(&sorter, StageFile);
+
+	for (;;) {
+		stageReadBegin(&current, StageFile);
+		while (stageRead(&current, &currentPos)) {
+			//this must hold true since we are always considering legal positions
+			//they can only lead to valid positions
+			//and even if primitives might have more moves ahead we stop already
+			isPrimitive = (Primitive(currentPos) != undecided
+			               || (numChildren = GenerateChildren(currentPos, children, moves)) == 0);
+
+			if (!isPrimitive) {
+				for(i = 0; i < numChildren; i++) {
+					childPos = children[i];
+					if (!Visited(childPos)) {
+						stageSortAdd(&sorter, childPos);
+						MarkAsVisited(childPos);
+					}
+				}
+			}
 		}
+		fclose(StageFile);
+
+		if (sorter.size == 0 && sorter.numRuns == 0) // nothing new, we're done
+			break;
+		TotalStages++;
+		printf("walking stage %d\n", TotalStages);
+		StageFile = newStageFile(TotalStages);
+		stageSortFinish(&sorter, StageFile);
+	}
 
-		fprintf(StageFile, POSITION_FORMAT "\n", currentPos);
-		fflush(StageFile);
+	SafeFree(current.buffer);
+	SafeFree(sorter.buffer);
+	SafeFree(children);
+	SafeFree(moves);
+}
 
-		currentMoves = currentMovesHead = GenerateMoves(currentPos);
+/* With --workers and a DB that takes concurrent stores (bpdb with
+   --bpdbconcurrent), a pass over a stage goes in batches. For each
+   batch this thread runs Primitive and GenerateChildren (module code
+   keeps globals, so it never runs on the workers); then the workers
+   work out the new values from the children's, and only once they have
+   all finished reading, store the ones that changed. Positions of one
+   stage only depend on each other acyclically, so the passes end at the
+   same values as the serial pass does. */
+
+#define BU_BATCH_SIZE (1 << 16)         // positions per batch
+#define BU_GRAIN 256                    // positions handed out per claim
+
+typedef struct bu_batch {
+	POSITION *positions;
+	VALUE *primitive;               // undecided if the position isn't primitive
+	POSITION *firstChild;           // children of i: children[firstChild[i]] to children[firstChild[i+1]-1]
+	POSITION *children;
+	POSITION maxChildren;
+	VALUE *values;                  // the new value and remoteness of each position
+	REMOTENESS *remotenesses;
+	BOOLEAN *changed;
+	POSITION count;
+	POSITION next;                  // next unclaimed position, bumped atomically
+	BOOLEAN storing;                // which half of the batch the workers do
+} BU_BATCH;
+
+BU_BATCH *buBatchNew()
+{
+	BU_BATCH *batch = (BU_BATCH *) SafeMalloc(sizeof(BU_BATCH));
+	batch->positions = (POSITION *) SafeMalloc(BU_BATCH_SIZE * sizeof(POSITION));
+	batch->primitive = (VALUE *) SafeMalloc(BU_BATCH_SIZE * sizeof(VALUE));
+	batch->firstChild = (POSITION *) SafeMalloc((BU_BATCH_SIZE + 1) * sizeof(POSITION));
+	batch->maxChildren = 4 * BU_BATCH_SIZE;
+	batch->children = (POSITION *) SafeMalloc(batch->maxChildren * sizeof(POSITION));
+	batch->values = (VALUE *) SafeMalloc(BU_BATCH_SIZE * sizeof(VALUE));
+	batch->remotenesses = (REMOTENESS *) SafeMalloc(BU_BATCH_SIZE * sizeof(REMOTENESS));
+	batch->changed = (BOOLEAN *) SafeMalloc(BU_BATCH_SIZE * sizeof(BOOLEAN));
+	return batch;
+}
 
-		//this must hold true since we are always considering legal positions
-		//they can only lead to valid positions
-		//and even if primitives might have more moves ahead we stop already
-		isPrimitive = (currentMoves == NULL || Primitive(currentPos) != undecided);
+void buBatchFree(BU_BATCH *batch)
+{
+	SafeFree(batch->positions);
+	SafeFree(batch->primitive);
+	SafeFree(batch->firstChild);
+	SafeFree(batch->children);
+	SafeFree(batch->values);
+	SafeFree(batch->remotenesses);
+	SafeFree(batch->changed);
+	SafeFree(batch);
+}
+
+void* buBatchWorker(void *arg)
+{
+	BU_BATCH *batch = (BU_BATCH *) arg;
+	VALUE *childValues = NULL, oldValue;
+	REMOTENESS *childRemotenesses = NULL, oldRemoteness;
+	REMOTENESS winRemoteness, loseRemoteness, tieRemoteness;
+	BOOLEAN foundTie, foundLose, foundWin;
+	POSITION i, last, c, numChildren;
 
-		if (!isPrimitive) {
-			for(; currentMovesHead != NULL; currentMovesHead = currentMovesHead->next) {
-				childPos = DoMove(currentPos, currentMovesHead->move);
-				if (!Visited(childPos)) {
-					AddPositionToQueue(childPos, &tail);
-					MarkAsVisited(childPos);
+	if (!batch->storing) {
+		childValues = (VALUE *) SafeMalloc(MAXFANOUT * sizeof(VALUE));
+		childRemotenesses = (REMOTENESS *) SafeMalloc(MAXFANOUT * sizeof(REMOTENESS));
+	}
+	while ((i = __sync_fetch_and_add(&batch->next, BU_GRAIN)) < batch->count) {
+		last = (i + BU_GRAIN < batch->count) ? i + BU_GRAIN : batch->count;
+		for (; i < last; i++) {
+			if (batch->storing) {
+				if (batch->changed[i])
+					StoreValueAndRemotenessOfCanonical(batch->positions[i], batch->values[i], batch->remotenesses[i]);
+				continue;
+			}
+			GetPositionDataBulk(&batch->positions[i], 1, &oldValue, &oldRemoteness, NULL, NULL);
+			batch->values[i] = oldValue;
+			batch->remotenesses[i] = oldRemoteness;
+			if (batch->primitive[i] != undecided) {
+				batch->values[i] = batch->primitive[i];
+				batch->remotenesses[i] = 0;
+			} else {
+				numChildren = batch->firstChild[i+1] - batch->firstChild[i];
+				GetPositionDataBulk(&batch->children[batch->firstChild[i]], numChildren, childValues, childRemotenesses, NULL, NULL);
+				foundTie = foundLose = foundWin = FALSE;
+				winRemoteness = tieRemoteness = REMOTENESS_MAX;
+				loseRemoteness = 0;
+				for (c = 0; c < numChildren; c++) {
+					if (childValues[c] == lose) {
+						foundLose = TRUE;
+						if (winRemoteness > childRemotenesses[c])
+							winRemoteness = childRemotenesses[c];
+					} else if (childValues[c] == tie) {
+						foundTie = TRUE;
+						if (tieRemoteness > childRemotenesses[c])
+							tieRemoteness = childRemotenesses[c];
+					} else if (childValues[c] == win) {
+						foundWin = TRUE;
+						if (loseRemoteness < childRemotenesses[c])
+							loseRemoteness = childRemotenesses[c];
+					}
+				}
+				if (foundLose) {
+					batch->values[i] = win;
+					batch->remotenesses[i] = winRemoteness + 1;
+				} else if (foundTie) {
+					batch->values[i] = tie;
+					batch->remotenesses[i] = tieRemoteness + 1;
+				} else if (foundWin) {
+					batch->values[i] = lose;
+					batch->remotenesses[i] = loseRemoteness + 1;
 				}
 			}
+			batch->changed[i] = (batch->values[i] != oldValue) || (batch->remotenesses[i] != oldRemoteness);
 		}
+	}
+	if (childValues != NULL) {
+		SafeFree(childValues);
+		SafeFree(childRemotenesses);
+	}
+	return NULL;
+}
 
-		if (head == stagetail) //we have finished this stage, rotating
-		{
-			fclose(StageFile);
-			stagetail = tail;
-			beginNewStage = TRUE;
-		}
-
-		FreeMoveList(currentMoves);
+void buRunWorkers(BU_BATCH *batch, BOOLEAN storing)
+{
+	pthread_t *threads = (pthread_t *) SafeMalloc(gSolverWorkers * sizeof(pthread_t));
+	int w, started;
+
+	batch->next = 0;
+	batch->storing = storing;
+	// this thread is worker 0; if a thread can't start, the rest pick up its share
+	for (started = 1; started < gSolverWorkers; started++)
+		if (pthread_create(&threads[started], NULL, buBatchWorker, batch) != 0)
+			break;
+	buBatchWorker(batch);
+	for (w = 1; w < started; w++)
+		pthread_join(threads[w], NULL);
+	SafeFree(threads);
+}
 
-		RemovePositionFromQueue(&head);
+// One pass over the stage with the workers; returns whether any value or remoteness changed
+BOOLEAN buSolvePass(BU_BATCH *batch, STAGE_FILE *stage)
+{
+	BOOLEAN foundnewvalue = FALSE, more = TRUE;
+	POSITION i;
+	int numChildren;
+	MOVE *moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+
+	while (more) {
+		batch->count = 0;
+		batch->firstChild[0] = 0;
+		while (batch->count < BU_BATCH_SIZE && (more = stageRead(stage, &batch->positions[batch->count]))) {
+			i = batch->count++;
+			batch->firstChild[i+1] = batch->firstChild[i];
+			if ((batch->primitive[i] = Primitive(batch->positions[i])) != undecided)
+				continue;
+			if (batch->maxChildren - batch->firstChild[i] < MAXFANOUT) {
+				batch->maxChildren = 2 * batch->maxChildren + MAXFANOUT;
+				batch->children = (POSITION *) SafeRealloc(batch->children, batch->maxChildren * sizeof(POSITION));
+			}
+			numChildren = GenerateChildren(batch->positions[i], &batch->children[batch->firstChild[i]], moves);
+			batch->firstChild[i+1] += numChildren;
+		}
+		if (batch->count == 0)
+			break;
+
+		buRunWorkers(batch, FALSE);
+		for (i = 0; i < batch->count; i++)
+			foundnewvalue = foundnewvalue || batch->changed[i];
+		BeginConcurrentStores();
+		buRunWorkers(batch, TRUE);
+		EndConcurrentStores();
+	}
 
-	} while (head != NULL);
+	SafeFree(moves);
+	return foundnewvalue;
 }
 
 VALUE DetermineValueBU(POSITION position)
@@ -147,19 +535,27 @@ VALUE DetermineValueBU(POSITION position)
 
 	int CurrentStage;
 
-	MOVELIST        *mhead = NULL, *MoveList = NULL;
+	POSITION        *children = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	MOVE            *moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+	int i, numChildren;
 
 	FILE            *OutFile = NULL;
+	STAGE_FILE stage;
 
 	BOOLEAN foundTie, foundLose, foundWin;
 	VALUE currentValue, oldValue;
-	REMOTENESS winRemoteness, loseRemoteness, tieRemoteness, childrmt;
+	REMOTENESS winRemoteness, loseRemoteness, tieRemoteness, childrmt, oldRemoteness;
 	POSITION postosolve, child;
+	BU_BATCH *batch = NULL;
 
 	//status
 	//TODO: just put the results in a colldb for now....
 
 	printf("\nSolving %s with the bottom up solver.\n", kGameName);
+	if (gSolverWorkers > 1 && ConcurrentStoresSupported()) {
+		printf("Each stage is solved with %d workers.\n", gSolverWorkers);
+		batch = buBatchNew();
+	}
 
 	WalkGameTree();
 
@@ -173,6 +569,7 @@ VALUE DetermineValueBU(POSITION position)
 		printf("I am starting to solve stage %d\n", CurrentStage);
 
 		openStageFile(&OutFile, CurrentStage);
+		stage.buffer = (unsigned char *) SafeMalloc(STAGE_BUFFER_SIZE);
 
 		//if(CurrentStage == TotalStages) {  //primitives
 
@@ -190,11 +587,16 @@ VALUE DetermineValueBU(POSITION position)
 		while(foundnewvalue) {
 
 			//reset to start reading from the beginning
-			fseek(OutFile, 0, SEEK_SET);
+			stageReadBegin(&stage, OutFile);
 
 			foundnewvalue = FALSE;
 
-			while(!feof(OutFile)) {
+			if (batch != NULL) {
+				foundnewvalue = buSolvePass(batch, &stage);
+				continue;
+			}
+
+			while(stageRead(&stage, &postosolve)) {
 
 				foundTie = FALSE;
 				foundLose = FALSE;
@@ -203,9 +605,6 @@ VALUE DetermineValueBU(POSITION position)
 				winRemoteness = tieRemoteness = REMOTENESS_MAX;
 				loseRemoteness = 0;
 
-				//read in the positions we need to solve with
-				fscanf(OutFile, POSITION_FORMAT "\n", &postosolve);
-
 				//            printf("read out position "POSITION_FORMAT"\n", postosolve);
 
 				//if the position is not solved yet, or is depending on other positions in the stage
@@ -213,15 +612,16 @@ VALUE DetermineValueBU(POSITION position)
 
 				//MarkAsVisited(postosolve);
 				oldValue = GetValueOfPosition(postosolve);
+				oldRemoteness = Remoteness(postosolve);
 
 				if ((currentValue = Primitive(postosolve)) != undecided) {
 					SetRemoteness(postosolve,0);
 					StoreValueOfPosition(postosolve, currentValue);
 				} else {
 					//infer the value from children, but does not recurse
-					mhead = MoveList = GenerateMoves(postosolve);
-					for(; mhead != NULL; mhead = mhead->next) {
-						child = DoMove(postosolve, mhead->move);
+					numChildren = GenerateChildren(postosolve, children, moves);
+					for(i = 0; i < numChildren; i++) {
+						child = children[i];
 						currentValue = GetValueOfPosition(child);
 						childrmt = Remoteness(child);
 
@@ -248,8 +648,6 @@ VALUE DetermineValueBU(POSITION position)
 						//        maxrmt = childrmt;
 					}
 
-					FreeMoveList(MoveList);
-
 					if(foundLose) {
 						SetRemoteness(postosolve, winRemoteness + 1);
 						StoreValueOfPosition(postosolve, win);
@@ -265,16 +663,17 @@ VALUE DetermineValueBU(POSITION position)
 					//                      printf("I am looking at "POSITION_FORMAT" and got a %s\n", postosolve, gValueString[GetValueOfPosition(postosolve)]);
 				}
 
-				foundnewvalue = (foundnewvalue || (oldValue != GetValueOfPosition(postosolve)));
+				//a remoteness that moved counts too, or the pass order would decide it
+				foundnewvalue = (foundnewvalue || (oldValue != GetValueOfPosition(postosolve))
+				                 || (oldRemoteness != Remoteness(postosolve)));
 				//}
-			}  //while(!feof(OutFile)) - find value for one position
+			}  //while(stageRead(...)) - find value for one position
 		} //while(foundnewvalue) - find value for all deducable positions in a stage
 
-		fseek(OutFile, 0, SEEK_SET);
+		stageReadBegin(&stage, OutFile);
 
 		//take care of the all the draws
-		while (!feof(OutFile)) {
-			fscanf(OutFile, POSITION_FORMAT "\n", &postosolve);
+		while (stageRead(&stage, &postosolve)) {
 			if (GetValueOfPosition(postosolve) == undecided) {
 				SetRemoteness(postosolve, REMOTENESS_MAX);
 				StoreValueOfPosition(postosolve, tie);
@@ -288,6 +687,7 @@ VALUE DetermineValueBU(POSITION position)
 		//TODO: save db for this stage
 
 		fclose(OutFile);
+		SafeFree(stage.buffer);
 
 		printf("I have finished solving stage %d.\n", CurrentStage);
 		// Do you want to continue solving the next stage? (y/n)", CurrentStage);
@@ -300,6 +700,10 @@ VALUE DetermineValueBU(POSITION position)
 	} while (CurrentStage >= 0)
 	;
 
+	SafeFree(children);
+	SafeFree(moves);
+	if (batch != NULL)
+		buBatchFree(batch);
 	return (GetValueOfPosition(gInitialPosition));
 
 }
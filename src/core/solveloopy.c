@@ -38,15 +38,12 @@
 ** Globals
 */
 
-FRnode*         gHeadWinFR = NULL;      /* The FRontier Win Queue */
-FRnode*         gTailWinFR = NULL;
-FRnode*         gHeadLoseFR = NULL;     /* The FRontier Lose Queue */
-FRnode*         gTailLoseFR = NULL;
-FRnode*         gHeadTieFR = NULL;      /* The FRontier Tie Queue */
-FRnode*         gTailTieFR = NULL;
-POSITIONLIST**  gParents = NULL;        /* The Parent of each node in a list */
-char*           gNumberChildren = NULL; /* The Number of children (used for Loopy games) */
-char*       gNumberChildrenOriginal = NULL;
+POSQUEUE        gWinFR;                 /* The FRontier Win Queue */
+POSQUEUE        gLoseFR;                /* The FRontier Lose Queue */
+POSQUEUE        gTieFR;                 /* The FRontier Tie Queue */
+PARENTINDEX     gParents;               /* The Parents of each node */
+CHILDCOUNTER    gNumberChildren;        /* The Number of children (used for Loopy games) */
+CHILDCOUNTER    gNumberChildrenOriginal;
 
 
 /*
@@ -57,6 +54,7 @@ static void             ParentInitialize                (void);
 static VALUE    DetermineLoopyValue1            (POSITION pos);
 static void             ParentFree                      (void);
 static void             SetParents                      (POSITION bad, POSITION root);
+static void             FillParents                     (POSITION bad, POSITION root);
 
 
 /*
@@ -66,19 +64,16 @@ static void             SetParents                      (POSITION bad, POSITION
 void MyPrintParents()
 {
 	POSITION i;
-	POSITIONLIST *ptr;
+	POSITION *ptr;
 
 	printf("PARENTS | #Children | Value\n");
 
 	for(i=0; i<gNumberOfPositions; i++)
 		if(Visited(i)) {
-			ptr = gParents[i];
 			printf(POSITION_FORMAT ": ",i);
-			while (ptr != NULL) {
-				printf("[" POSITION_FORMAT "] ",ptr->position);
-				ptr = ptr->next;
-			}
-			printf("| %d children | %s value",(int)gNumberChildren[i],gValueString[GetValueOfPosition((POSITION)i)]);
+			for (ptr = ParentIndexBegin(&gParents, i); ptr < ParentIndexEnd(&gParents, i); ptr++)
+				printf("[" POSITION_FORMAT "] ",*ptr);
+			printf("| %d children | %s value",(int)ChildCounterGet(&gNumberChildren, i),gValueString[GetValueOfPosition((POSITION)i)]);
 			printf("\n");
 		}
 }
@@ -112,7 +107,7 @@ VALUE DetermineLoopyValue(POSITION position)
 VALUE DetermineLoopyValue1(POSITION position)
 {
 	POSITION child=kBadPosition, parent;
-	POSITIONLIST *ptr;
+	POSITION *ptr, *end;
 	VALUE childValue;
 	REMOTENESS remotenessChild;
 	POSITION i;
@@ -123,6 +118,8 @@ VALUE DetermineLoopyValue1(POSITION position)
 	/* Do DFS to set up Parent pointers and initialize KnownList w/Primitives */
 
 	SetParents(kBadPosition,position);
+	ParentIndexFill(&gParents);
+	FillParents(kBadPosition,position);
 	if(kDebugDetermineValue) {
 		printf("---------------------------------------------------------------\n");
 		printf("Number of Positions = [" POSITION_FORMAT "]\n",gNumberOfPositions);
@@ -135,11 +132,14 @@ VALUE DetermineLoopyValue1(POSITION position)
 
 	/* Now, the fun part. Starting from the children, work your way back up. */
 	//@@ separate lose/win frontiers
-	while ((gHeadLoseFR != NULL) ||
-	       (gHeadWinFR != NULL)) {
+	while (!PosQueueIsEmpty(&gLoseFR) ||
+	       !PosQueueIsEmpty(&gWinFR)) {
 
-		if ((child = DeQueueLoseFR()) == kBadPosition)
+		if (!PosQueueIsEmpty(&gLoseFR)) {
+			child = DeQueueLoseFR();
+		} else {
 			child = DeQueueWinFR();
+		}
 
 		/* Might as well grab these now, they'll be used later */
 		childValue = GetValueOfPosition(child);
@@ -153,11 +153,11 @@ VALUE DetermineLoopyValue1(POSITION position)
 		/* With losing children, every parent is winning, so we just go through
 		** all the parents and declare them winning */
 		if (childValue == lose) {
-			ptr = gParents[child];
-			while (ptr != NULL) {
+			end = ParentIndexEnd(&gParents, child);
+			for (ptr = ParentIndexBegin(&gParents, child); ptr < end; ptr++) {
 
 				/* Make code easier to read */
-				parent = ptr->position;
+				parent = *ptr;
 
 				/* Skip if this is the initial position (parent is kBadPosition) */
 				if (parent != kBadPosition) {
@@ -181,23 +181,22 @@ VALUE DetermineLoopyValue1(POSITION position)
 						assert((remotenessChild + 1) >= Remoteness(parent));
 					}
 				}
-				ptr = ptr->next;
 			} /* while there are still parents */
 
 			/* With winning children */
 		} else if (childValue == win) {
-			ptr = gParents[child];
-			while (ptr != NULL) {
+			end = ParentIndexEnd(&gParents, child);
+			for (ptr = ParentIndexBegin(&gParents, child); ptr < end; ptr++) {
 
 				/* Make code easier to read */
-				parent = ptr->position;
+				parent = *ptr;
 
 				/* Skip if this is the initial position (parent is kBadPosition) */
 				/* If this is the last unknown child and they were all wins, parent is lose */
-				if(parent != kBadPosition && --gNumberChildren[parent] == 0) {
+				if(parent != kBadPosition && ChildCounterDecrement(&gNumberChildren, parent) == 0) {
 					/* no more kids, it's not been seen before, assign it as losing, put at head */
 					assert(GetValueOfPosition(parent) == undecided);
-					F0EdgeCount -= (gNumberChildrenOriginal[parent] - 1);
+					F0EdgeCount -= (ChildCounterGet(&gNumberChildrenOriginal, parent) - 1);
 					InsertLoseFR(parent);
 					if(kDebugDetermineValue) printf("Inserting " POSITION_FORMAT " (%s) into FR head\n",parent,"lose");
 					/* We always need to change the remoteness because we examine winning node with
@@ -207,7 +206,6 @@ VALUE DetermineLoopyValue1(POSITION position)
 				} else if (parent != kBadPosition) {
 					F0EdgeCount++;
 				}
-				ptr = ptr->next;
 			} /* while there are still parents */
 
 			/* With children set to other than win/lose. So stop */
@@ -215,24 +213,17 @@ VALUE DetermineLoopyValue1(POSITION position)
 			BadElse("DetermineLoopyValue found FR member with other than win/lose value");
 		} /* else */
 
-		/* We are done with this position and no longer need to keep around its list of parents
-		** The tie frontier will not need this, either, because this child's value has already
-		** been determined.  It cannot be a tie. */
-		FreePositionList(gParents[child]);
-		gParents[child] = NULL;
-
 	} /* while still positions in FR */
 
 	/* Now process the tie frontier */
 
-	while(gHeadTieFR != NULL) {
+	while(!PosQueueIsEmpty(&gTieFR)) {
 		child = DeQueueTieFR();
 		remotenessChild = Remoteness(child);
 
-		ptr = gParents[child];
-
-		while (ptr != NULL) {
-			parent = ptr->position;
+		end = ParentIndexEnd(&gParents, child);
+		for (ptr = ParentIndexBegin(&gParents, child); ptr < end; ptr++) {
+			parent = *ptr;
 
 			if(parent != kBadPosition && GetValueOfPosition(parent) == undecided) {
 				/* this position has no losing children but has a tieing position so it must be a
@@ -253,10 +244,7 @@ VALUE DetermineLoopyValue1(POSITION position)
 				   gNumberChildrenOriginal[parent] -=1; //As it is now, fringe0 can't have tie children
 				 */
 			}
-			ptr = ptr->next;
 		}
-		FreePositionList(gParents[child]);
-		gParents[child] = NULL;
 	}
 
 	/* Now set all remaining positions to tie with remoteness of REMOTENESS_MAX */
@@ -277,8 +265,8 @@ VALUE DetermineLoopyValue1(POSITION position)
 			if(GetValueOfPosition((POSITION)i) == undecided) {
 				SetRemoteness((POSITION)i,REMOTENESS_MAX);
 				StoreValueOfPosition((POSITION)i,tie);
-				if (gNumberChildren[i] < gNumberChildrenOriginal[i]) {
-					F0DrawEdgeCount += gNumberChildren[i];
+				if (ChildCounterGet(&gNumberChildren, i) < ChildCounterGet(&gNumberChildrenOriginal, i)) {
+					F0DrawEdgeCount += ChildCounterGet(&gNumberChildren, i);
 					F0NodeCount+=1;
 				}
 				//we are done with this position and no longer need to keep around its list of parents
@@ -321,13 +309,13 @@ void DFS_SetParents (POSITION parent, POSITION position)
 	if(Visited(position)) { /* We've been down this path before, don't DFS */
 		if(kDebugDetermineValue) printf("Seen\n");
 		/* PARENT me */
-		gParents[position] = StorePositionInList(parent, gParents[position]);
+		ParentIndexAdd(&gParents, position, parent);
 	} else if((value = Primitive(position)) != undecided) { /* Primitive */
 		if(kDebugDetermineValue) printf("PRIM value = %s\n", gValueString[value]);
 		SetRemoteness(position,0); /* Primitives are leaves, remoteness = 0 */
 		MarkAsVisited(position);
 		/* PARENT me */
-		gParents[position] = StorePositionInList(parent, gParents[position]);
+		ParentIndexAdd(&gParents, position, parent);
 		/* Add me to FR. (I know i'm not already in the frontier because
 		 * this is the first time i've been visited) */
 		if(value == lose)
@@ -342,14 +330,14 @@ void DFS_SetParents (POSITION parent, POSITION position)
 		StoreValueOfPosition(position,value);
 	} else { /* first time, need to recursively determine value */
 		/* PARENT me */
-		gParents[position] = StorePositionInList(parent, gParents[position]);
+		ParentIndexAdd(&gParents, position, parent);
 		if(kDebugDetermineValue) printf("normal, continue searching\n");
 		MarkAsVisited(position);
 		movehead = GenerateMoves(position);
 		poshead = NULL;
 
 		for (moveptr = movehead; moveptr != NULL; moveptr = moveptr->next) {
-			gNumberChildren[(int)position]++; /* Record the number of kids */
+			ChildCounterAdd(&gNumberChildren, position, 1); /* Record the number of kids */
 			child = DoMove(position, moveptr->move); /* Create the child */
 			if (Visited(child)) {        /* Visited? */
 				DFS_SetParents(position, child); /* Go ahead and call (it'll be quick) */
@@ -383,21 +371,23 @@ void DFS_SetParents (POSITION parent, POSITION position)
 
 void SetParents (POSITION parent, POSITION root)
 {
-	MOVELIST*       moveptr;
-	MOVELIST*       movehead;
 	POSITIONLIST*   posptr;
 	POSITIONLIST*   thisLevel;
 	POSITIONLIST*   nextLevel;
 	POSITION pos;
 	POSITION child;
+	POSITION*       children;
+	MOVE*           moves;
 	VALUE value;
+	int i, numChildren;
 
 	posptr = thisLevel = nextLevel = NULL;
-	moveptr = movehead = NULL;
 
 	// Check if the top is primitive.
 	MarkAsVisited(root);
-	gParents[root] = StorePositionInList(parent, gParents[root]);
+	// the root's parent is kBadPosition, which is not worth an entry
+	if (parent != kBadPosition)
+		ParentIndexAdd(&gParents, root, parent);
 	if ((value = Primitive(root)) != undecided) {
 		SetRemoteness(root, 0);
 		switch (value) {
@@ -412,6 +402,8 @@ void SetParents (POSITION parent, POSITION root)
 	}
 
 	thisLevel = StorePositionInList(root, thisLevel);
+	children = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
 
 	while (thisLevel != NULL) {
 		POSITIONLIST* next;
@@ -420,18 +412,18 @@ void SetParents (POSITION parent, POSITION root)
 			next = posptr->next;
 			pos = posptr->position;
 
-			movehead = GenerateMoves(pos);
+			numChildren = GenerateChildren(pos, children, moves);
+			ChildCounterSet(&gNumberChildren, pos, numChildren);
+			ChildCounterSet(&gNumberChildrenOriginal, pos, numChildren);
 
-			for (moveptr = movehead; moveptr != NULL; moveptr = moveptr->next) {
-				child = DoMove(pos, moveptr->move);
+			for (i = 0; i < numChildren; i++) {
+				child = children[i];
 				if (gSymmetries)
 					child = gCanonicalPosition(child);
 
 				if (child >= gNumberOfPositions)
-					FoundBadPosition(child, pos, moveptr->move);
-				++gNumberChildren[(int)pos];
-				++gNumberChildrenOriginal[(int)pos];
-				gParents[(int)child] = StorePositionInList(pos, gParents[(int)child]);
+					FoundBadPosition(child, pos, moves[i]);
+				ParentIndexAdd(&gParents, child, pos);
 
 				if (Visited(child)) continue;
 				MarkAsVisited(child);
@@ -451,8 +443,6 @@ void SetParents (POSITION parent, POSITION root)
 				gTotalMoves++;
 			}
 
-			FreeMoveList(movehead);
-
 			/* Free as we go */
 			free(posptr);
 		}
@@ -460,6 +450,42 @@ void SetParents (POSITION parent, POSITION root)
 		thisLevel = nextLevel;
 		nextLevel = NULL;
 	}
+	SafeFree(children);
+	SafeFree(moves);
+}
+
+
+/*
+** The second pass over the parent pointers: the edges SetParents counted,
+** found again by giving children to every position it gave children to.
+*/
+
+void FillParents (POSITION parent, POSITION root)
+{
+	POSITION pos;
+	POSITION child;
+	POSITION*       children;
+	MOVE*           moves;
+	int i, numChildren;
+
+	if (parent != kBadPosition)
+		ParentIndexAdd(&gParents, root, parent);
+	children = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+
+	for (pos = 0; pos < gNumberOfPositions; pos++) {
+		if (ChildCounterGet(&gNumberChildrenOriginal, pos) == 0)
+			continue;
+		numChildren = GenerateChildren(pos, children, moves);
+		for (i = 0; i < numChildren; i++) {
+			child = children[i];
+			if (gSymmetries)
+				child = gCanonicalPosition(child);
+			ParentIndexAdd(&gParents, child, pos);
+		}
+	}
+	SafeFree(children);
+	SafeFree(moves);
 }
 
 
@@ -478,130 +504,99 @@ void SetParents (POSITION parent, POSITION root)
 
 void ParentInitialize()
 {
-	POSITION i;
-
-	gParents = (POSITIONLIST **) SafeMalloc (gNumberOfPositions * sizeof(POSITIONLIST *));
-	for(i = 0; i < gNumberOfPositions; i++)
-		gParents[i] = NULL;
+	ParentIndexInit(&gParents, gNumberOfPositions);
 }
 
 void ParentFree()
 {
-	POSITION i;
+	ParentIndexFree(&gParents);
+}
 
-	for (i = 0; i < gNumberOfPositions; i++) {
-		FreePositionList(gParents[i]);
-	}
+/* The counter width, from the fanouts met along a few random games */
+static int NumberChildrenBits()
+{
+	int fanouts[CHILDCOUNTER_SAMPLE];
+	int numFanouts = 0, n, plies;
+	unsigned int seed = 12345;
+	POSITION pos;
+	MOVELIST *movehead, *moveptr;
 
-	SafeFree(gParents);
+	while (numFanouts < CHILDCOUNTER_SAMPLE) {
+		pos = gInitialPosition;
+		for (plies = 0; numFanouts < CHILDCOUNTER_SAMPLE && Primitive(pos) == undecided; plies++) {
+			movehead = GenerateMoves(pos);
+			for (n = 0, moveptr = movehead; moveptr != NULL; moveptr = moveptr->next)
+				n++;
+			if (n == 0) break;
+			fanouts[numFanouts++] = n;
+			seed = seed * 1103515245 + 12345; /* not rand(), to leave its state alone */
+			for (moveptr = movehead, n = (seed >> 16) % n; n > 0; n--)
+				moveptr = moveptr->next;
+			pos = DoMove(pos, moveptr->move);
+			FreeMoveList(movehead);
+		}
+		if (plies == 0) break;
+	}
+	return ChildCounterBitsFor(fanouts, numFanouts);
 }
 
 void NumberChildrenInitialize()
 {
 	POSITION i;
+	int bits = NumberChildrenBits();
 
-	gNumberChildren = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
-	gNumberChildrenOriginal = (char *) SafeMalloc (gNumberOfPositions * sizeof(signed char));
+	ChildCounterInit(&gNumberChildren, gNumberOfPositions, bits);
+	ChildCounterInit(&gNumberChildrenOriginal, gNumberOfPositions, bits);
 	if (gInterestingness) {
 		gAnalysis.Interestingness = (float *) SafeMalloc (gNumberOfPositions * sizeof(float)); /* Interestingness */
-	}
-	if (gInterestingness) {
-		for(i = 0; i < gNumberOfPositions; i++) {
-			gNumberChildren[i] = 0;
-			gNumberChildrenOriginal[i] = 0;
+		for(i = 0; i < gNumberOfPositions; i++)
 			gAnalysis.Interestingness[i] = 0.0;
-		}
-	} else {
-		for(i = 0; i < gNumberOfPositions; i++) {
-			gNumberChildren[i] = 0;
-			gNumberChildrenOriginal[i] = 0;
-		}
 	}
 }
 
 void NumberChildrenFree()
 {
-	SafeFree(gNumberChildren);
-	SafeFree(gNumberChildrenOriginal);
+	ChildCounterFree(&gNumberChildren);
+	ChildCounterFree(&gNumberChildrenOriginal);
 }
 
 void InitializeFR()
 {
-	gHeadWinFR = NULL;
-	gTailWinFR = NULL;
-	gHeadLoseFR = NULL;
-	gTailLoseFR = NULL;
-	gHeadTieFR = NULL;
-	gTailTieFR = NULL;
-}
-
-static POSITION DeQueueFR(FRnode **gHeadFR, FRnode **gTailFR)
-{
-	POSITION position;
-	FRnode *tmp;
-
-	if (*gHeadFR == NULL)
-		return kBadPosition;
-	else {
-		position = (*gHeadFR)->position;
-		tmp = *gHeadFR;
-		(*gHeadFR) = (*gHeadFR)->next;
-		SafeFree(tmp);
-
-		if (*gHeadFR == NULL)
-			*gTailFR = NULL;
-	}
-	return position;
+	PosQueueFree(&gWinFR);
+	PosQueueFree(&gLoseFR);
+	PosQueueFree(&gTieFR);
 }
 
 POSITION DeQueueWinFR()
 {
-	return DeQueueFR(&gHeadWinFR, &gTailWinFR);
+	return PosQueuePop(&gWinFR);
 }
 
 POSITION DeQueueLoseFR()
 {
-	return DeQueueFR(&gHeadLoseFR, &gTailLoseFR);
+	return PosQueuePop(&gLoseFR);
 }
 
 POSITION DeQueueTieFR()
 {
-	return DeQueueFR(&gHeadTieFR, &gTailTieFR);
-}
-
-static void InsertFR(POSITION position, FRnode **firstnode,
-                     FRnode **lastnode)
-{
-	FRnode *tmp = (FRnode *) SafeMalloc(sizeof(FRnode));
-	tmp->position = position;
-	tmp->next = NULL;
-
-	if (*lastnode == NULL) {
-		assert(*firstnode == NULL);
-		*firstnode = tmp;
-		*lastnode = tmp;
-	} else {
-		assert((*lastnode)->next == NULL);
-		(*lastnode)->next = tmp;
-		*lastnode = tmp;
-	}
+	return PosQueuePop(&gTieFR);
 }
 
 void InsertWinFR(POSITION position)
 {
 	/* printf("Inserting WinFR...\n"); */
-	InsertFR(position, &gHeadWinFR, &gTailWinFR);
+	PosQueuePush(&gWinFR, position);
 }
 
 void InsertLoseFR(POSITION position)
 {
 	/* printf("Inserting LoseFR...\n"); */
-	InsertFR(position, &gHeadLoseFR, &gTailLoseFR);
+	PosQueuePush(&gLoseFR, position);
 }
 
 void InsertTieFR(POSITION position)
 {
-	InsertFR(position, &gHeadTieFR, &gTailTieFR);
+	PosQueuePush(&gTieFR, position);
 }
 
 // End Loopy
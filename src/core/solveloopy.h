@@ -22,14 +22,12 @@ void            InsertTieFR                     (POSITION pos);
 
 /* Loopy globals */
 
-extern FRnode*          gHeadWinFR;
-extern FRnode*          gTailWinFR;
-extern FRnode*          gHeadLoseFR;
-extern FRnode*          gTailLoseFR;
-extern FRnode*          gHeadTieFR;
-extern FRnode*          gTailTieFR;
-
-extern POSITIONLIST**   gParents;
-extern char*            gNumberChildren;
+extern POSQUEUE         gWinFR;
+extern POSQUEUE         gLoseFR;
+extern POSQUEUE         gTieFR;
+
+extern PARENTINDEX      gParents;
+extern CHILDCOUNTER      gNumberChildren;
+extern CHILDCOUNTER      gNumberChildrenOriginal;
 
 #endif /* GMCORE_SOLVELOOPY_H */
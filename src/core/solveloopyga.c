@@ -117,10 +117,11 @@ POSITION position;
 
 	/* Now, the fun part. Starting from the children, work your way back up. */
 	//@@ separate lose/win frontiers
-	while ((gHeadLoseFR != NULL) ||
-	       (gHeadWinFR != NULL)) {
-		if ((child = DeQueueLoseFR()) == kBadPosition)
-			child = DeQueueWinFR();
+	while (!PosQueueIsEmpty(&gLoseFR) ||
+	       !PosQueueIsEmpty(&gWinFR)) {
+		if (!PosQueueIsEmpty(&gLoseFR))
+			child = DeQueueLoseFR();
+			else child = DeQueueWinFR();
 
 		/* Might as well grab these now, they'll be used later */
 		childValue = GetValueOfPosition(child);
@@ -179,7 +180,7 @@ POSITION position;
 
 				/* Skip if this is the initial position (parent is kBadPosition) */
 				/* If this is the last unknown child and they were all wins, parent is lose */
-				if(parent != kBadPosition && --gNumberChildren[parent] == 0) {
+				if(parent != kBadPosition && ChildCounterDecrement(&gNumberChildren, parent) == 0) {
 					/* no more kids, it's not been seen before, assign it as losing, put at head */
 					assert(GetValueOfPosition(parent) == undecided);
 
@@ -207,7 +208,7 @@ POSITION position;
 
 	/* Now process the tie frontier */
 
-	while(gHeadTieFR != NULL) {
+	while(!PosQueueIsEmpty(&gTieFR)) {
 		child = DeQueueTieFR();
 		remotenessChild = Remoteness(child);
 
@@ -313,7 +314,7 @@ void lgas_SetParents (POSITION parent, POSITION root)
 			for (moveptr = movehead; moveptr != NULL; moveptr = moveptr->next) {
 				move = moveptr->move;
 				child = DoMove(pos, move);
-				++gNumberChildren[(int)pos];
+				ChildCounterAdd(&gNumberChildren, pos, 1);
 				lgas_gParents[(int)child] = CreatePositionMoveNode(pos, move, lgas_gParents[(int)child]);
 
 				if (Visited(child)) continue;
@@ -39,6 +39,9 @@
 #include "dirent.h"
 #include "levelfile_generator.h"
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <pthread.h>
 
 // TIER VARIABLES
 TIERLIST* tierSolveList; // the total list for the game, w/initial at start
@@ -74,13 +77,28 @@ BOOLEAN ConfirmAction(char);
 // Solver Heart
 void SolveTier(POSITION, POSITION);
 void SolveWithNonLoopyAlgorithm(POSITION, POSITION);
+BOOLEAN SolveNonLoopyPosition(POSITION, BOOLEAN);
+BOOLEAN SolveNonLoopyWithWorkers(POSITION, POSITION, BOOLEAN);
 void SolveWithLoopyAlgorithm(POSITION, POSITION);
-void LoopyParentsHelper(POSITIONLIST*, VALUE, REMOTENESS);
+void LoopyParentsHelper(POSQUEUE*, VALUE, REMOTENESS);
+void ProcessLoopyFrontiers(int, REMOTENESS);
+void ProcessLoopyFrontiersInParallel(int, REMOTENESS);
+void ExpandLoopyLevel(POSQUEUE*, VALUE, REMOTENESS, POSQUEUE*);
 // Solver ChildCounter and Hashtable functions
-void rInitFRStuff();
+int rChildCounterBits(POSITION, POSITION);
+void rInitFRStuff(POSITION, POSITION);
 void rFreeFRStuff();
-POSITIONLIST* rRemoveFRList(VALUE, REMOTENESS);
+void rAddParents();
+POSQUEUE* rGetFR(VALUE, REMOTENESS);
 void rInsertFR(VALUE, POSITION, REMOTENESS);
+
+void CheckpointInit(POSITION, POSITION, BOOLEAN);
+BOOLEAN CheckpointDue();
+POSITION CheckpointResumeNonLoopy(POSITION);
+void CheckpointNonLoopy(POSITION);
+void CheckpointResumeLoopy(int*, POSITION*, REMOTENESS*);
+void CheckpointLoopyIfDue(int, POSITION, REMOTENESS);
+void CheckpointDone();
 // Sanity Checkers
 void checkForCorrectness(POSITION, POSITION);
 TIERLIST* checkAndDefineTierTree();
@@ -121,9 +139,6 @@ void DoTierDependencies(TIER, FILE*);
 
 VALUE DetermineRetrogradeValue(POSITION position) {
 	gDontLoadTierDB = FALSE;
-	// for the experimental GenerateMoves (commented out for now)
-	//if (gGenerateMovesEfficientFunPtr != NULL)
-	//    gGenerateMovesArray = (MOVE*) SafeMalloc(MAXFANOUT * sizeof(MOVE));
 	// initialize global variables
 	variant = getOption();
 	tierNames = TRUE;
@@ -336,6 +351,12 @@ VALUE DetermineRetrogradeValue(POSITION position) {
 				gInitializeHashWindow(gTierToOnlySolve, TRUE);
 				SolveTier(0,gCurrentTierSize);
 			}
+			else if (gTierJobs > 1)
+			{
+				//Hand the tiers to the scheduler's worker processes
+				if (!RemoteScheduleAllTiers(gTierJobs))
+					ExitStageRight();
+			}
 			else
 			{
 				//Auto solve all of 'em
@@ -739,21 +760,18 @@ POSITION InitTierGamesman() {
 **
 ************************************************************************/
 
-//This will be my "children counter" until this goes to file
-//or I think of something better.
-//Oh, and I use chars as a hack way to get 8-bits
-typedef unsigned char CHILDCOUNT;
-CHILDCOUNT* childCounts;
+//The children counters: 4 or 8 bits each, picked from the tier's fanout
+CHILDCOUNTER childCounts;
 
 //The Parent Pointers
-POSITIONLIST** rParents;
+PARENTINDEX rParents;
 
 /* Rather than a Frontier Queue, this uses a sort of hashtable,
-   with a POSITIONLIST for every REMOTENESS from 0 to REMOTENESS_MAX-1.
+   with a POSQUEUE for every REMOTENESS from 0 to REMOTENESS_MAX-1.
    It's constant time insert and remove, so it works just fine. */
-FRnode**        rWinFR = NULL;  // The FRontier Win Hashtable
-FRnode**        rLoseFR = NULL; // The FRontier Lose Hashtable
-FRnode**        rTieFR = NULL;  // The FRontier Tie Hashtable
+POSQUEUE*       rWinFR = NULL;  // The FRontier Win Hashtable
+POSQUEUE*       rLoseFR = NULL; // The FRontier Lose Hashtable
+POSQUEUE*       rTieFR = NULL;  // The FRontier Tie Hashtable
 
 // A "hack" for dealing with a later-explained partial solve case
 POSITIONLIST* solveTheseTooList;
@@ -788,61 +806,294 @@ POSITIONLIST* solveTheseTooList;
    equal to lowestList or currentList.
  */
 
-void rInitFRStuff() {
+// Counts the moves of up to CHILDCOUNTER_SAMPLE positions spread over
+// [start, end) to choose the counter width for this tier.
+int rChildCounterBits(POSITION start, POSITION end) {
+	int fanouts[CHILDCOUNTER_SAMPLE];
+	int numFanouts = 0, n;
+	POSITION pos, step = (end - start + CHILDCOUNTER_SAMPLE - 1) / CHILDCOUNTER_SAMPLE;
+	MOVELIST *moves, *movesptr;
+
+	if (step == 0) step = 1;
+	for (pos = start; pos < end && numFanouts < CHILDCOUNTER_SAMPLE; pos += step) {
+		if (checkLegality && !gIsLegalFunPtr(pos)) continue;
+		if (gSymmetries && pos != gCanonicalPosition(pos)) continue;
+		if (Primitive(pos) != undecided) continue;
+		moves = GenerateMoves(pos);
+		for (n = 0, movesptr = moves; movesptr != NULL; movesptr = movesptr->next)
+			n++;
+		FreeMoveList(moves);
+		fanouts[numFanouts++] = n;
+	}
+	return ChildCounterBitsFor(fanouts, numFanouts);
+}
+
+void rInitFRStuff(POSITION start, POSITION end) {
 	int i;
-	childCounts = (CHILDCOUNT*) SafeMalloc (gCurrentTierSize * sizeof(CHILDCOUNT));
-	for (i = 0; i < gCurrentTierSize; i++)
-		childCounts[i] = 0;
-	if (!useUndo) {
-		rParents = (POSITIONLIST**) SafeMalloc (gNumberOfPositions * sizeof(POSITIONLIST*));
-		for (i = 0; i < gNumberOfPositions; i++)
-			rParents[i] = NULL;
-	}
-	// 255 * 4 bytes = 1,020 bytes = ~1 KB
-	rWinFR = (FRnode**) SafeMalloc (REMOTENESS_MAX * sizeof(FRnode*));
-	rLoseFR = (FRnode**) SafeMalloc (REMOTENESS_MAX * sizeof(FRnode*)); // ~1 KB
-	rTieFR = (FRnode**) SafeMalloc (REMOTENESS_MAX * sizeof(FRnode*)); // ~1 KB
-	for (i = 0; i < REMOTENESS_MAX; i++)
-		rWinFR[i] = rLoseFR[i] = rTieFR[i] = NULL;
+	ChildCounterInit(&childCounts, gCurrentTierSize, rChildCounterBits(start, end));
+	if (!useUndo)
+		ParentIndexInit(&rParents, gNumberOfPositions);
+	// 255 * 64 bytes = ~16 KB each; chunks are only allocated when used
+	rWinFR = (POSQUEUE*) SafeMalloc (REMOTENESS_MAX * sizeof(POSQUEUE));
+	rLoseFR = (POSQUEUE*) SafeMalloc (REMOTENESS_MAX * sizeof(POSQUEUE));
+	rTieFR = (POSQUEUE*) SafeMalloc (REMOTENESS_MAX * sizeof(POSQUEUE));
+	for (i = 0; i < REMOTENESS_MAX; i++) {
+		PosQueueInit(&rWinFR[i]);
+		PosQueueInit(&rLoseFR[i]);
+		PosQueueInit(&rTieFR[i]);
+	}
 	solveTheseTooList = NULL;
 }
 
 void rFreeFRStuff() {
-	if (childCounts != NULL) SafeFree(childCounts);
-	if (!useUndo) {
-		// Free the Position Lists
-		int i;
-		for (i = 0; i < gNumberOfPositions; i++)
-			FreePositionList(rParents[i]);
-		if (rParents != NULL) SafeFree(rParents);
-	}
-	// Free the Position Lists
+	ChildCounterFree(&childCounts);
+	if (!useUndo)
+		ParentIndexFree(&rParents);
+	// Free the Frontier Queues
+	int i;
+	for (i = 0; rWinFR != NULL && i < REMOTENESS_MAX; i++) {
+		PosQueueFree(&rWinFR[i]);
+		PosQueueFree(&rLoseFR[i]);
+		PosQueueFree(&rTieFR[i]);
+	}
 	if (rWinFR != NULL) SafeFree(rWinFR);
 	if (rLoseFR != NULL) SafeFree(rLoseFR);
 	if (rTieFR != NULL) SafeFree(rTieFR);
+	rWinFR = rLoseFR = rTieFR = NULL;
 }
 
-POSITIONLIST* rRemoveFRList(VALUE value, REMOTENESS r) {
+POSQUEUE* rGetFR(VALUE value, REMOTENESS r) {
 	if (value == win)
-		return rWinFR[r];
+		return &rWinFR[r];
 	else if (value == lose)
-		return rLoseFR[r];
+		return &rLoseFR[r];
 	else if (value == tie)
-		return rTieFR[r];
+		return &rTieFR[r];
 	return NULL;
 }
 
 void rInsertFR(VALUE value, POSITION position, REMOTENESS r) {
 	// this is probably the best place to put this:
 	assert(r >= 0 && r < REMOTENESS_MAX);
-	if(value == win)
-		rWinFR[r] = StorePositionInList(position, rWinFR[r]);
-	else if (value == lose)
-		rLoseFR[r] = StorePositionInList(position, rLoseFR[r]);
-	else if (value == tie)
-		rTieFR[r] = StorePositionInList(position, rTieFR[r]);
+	PosQueuePush(rGetFR(value, r), position);
+}
+
+
+
+/************************************************************************
+**
+** CHECKPOINTS
+**
+************************************************************************/
+
+/* With --checkpoint <seconds>, the state of the tier being solved is saved
+   every so often, and SolveTier picks up from the last save if a killed
+   run is started again.
+   Non-loopy tiers are solved in order, so a checkpoint is just the cells
+   solved so far: each save appends the cells since the one before, then
+   moves the cursor in the header.
+   Loopy tiers change cells and child counters all over the tier, so each
+   save is a snapshot of the tier's cells, childCounts and every frontier
+   queue, written under a temporary name and renamed. The parent pointers
+   aren't saved: a resumed run finds them again from the positions whose
+   child counters are set. */
+
+#define CHECKPOINT_MAGIC "GMTIERCK"
+#define CHECKPOINT_VERSION 3
+#define CHECKPOINT_BYTEORDER 0x0102
+#define CHECKPOINT_GRAIN (1 << 20)      // positions of a sweep between looks at the clock
+
+#define CHECKPOINT_SWEEP 0              // sweeping the tier, at cursor
+#define CHECKPOINT_LOSEWIN 1            // walking the lose/win frontiers, at level
+#define CHECKPOINT_TIES 2               // walking the tie frontiers, at level
+
+typedef struct tier_checkpoint_header {
+	char magic[8];
+	unsigned short version;
+	unsigned short byteOrder;
+	unsigned short loopy;
+	unsigned short useUndo;
+	int phase;
+	int level;
+	unsigned long long tier, tierSize, start, end;
+	unsigned long long cursor;
+	unsigned long long numSolved, trueSizeOfTier;
+} TIERCHECKPOINT_HEADER;
+
+POSITION numSolved, trueSizeOfTier;
+
+TIERCHECKPOINT_HEADER ckHeader;     // of the tier being solved
+BOOLEAN ckResuming = FALSE;         // TRUE iff a checkpoint of it was found
+time_t ckLastSave;
+char ckFilename[256];
+FILE* ckFile = NULL;                // the non-loopy checkpoint being appended to
+
+// Flushes fp all the way to the disk
+BOOLEAN CheckpointSync(FILE* fp) {
+	return (fflush(fp) == 0 && fsync(fileno(fp)) == 0);
 }
 
+void CheckpointFailed(char* what) {
+	printf("ERROR: Couldn't %s checkpoint %s!\n", what, ckFilename);
+	ExitStageRight();
+}
+
+// Names the checkpoint of this (part of a) tier and looks for one on disk
+void CheckpointInit(POSITION start, POSITION end, BOOLEAN loopy) {
+	TIERCHECKPOINT_HEADER found;
+	char dirname[100];
+	FILE* fp;
+
+	sprintf(dirname, "./data/m%s_%d_tierdb", kDBName, getOption());
+	sprintf(ckFilename, "%s/m%s_%d_%llu_%llu_%llu_checkpoint.dat",
+	        dirname, kDBName, getOption(), gCurrentTier, start, end);
+	if (gCheckpointSeconds > 0) {
+		mkdir("data", 0755);
+		mkdir(dirname, 0755);
+	}
+
+	memset(&ckHeader, 0, sizeof(ckHeader));
+	memcpy(ckHeader.magic, CHECKPOINT_MAGIC, sizeof(ckHeader.magic));
+	ckHeader.version = CHECKPOINT_VERSION;
+	ckHeader.byteOrder = CHECKPOINT_BYTEORDER;
+	ckHeader.loopy = loopy;
+	ckHeader.useUndo = useUndo;
+	ckHeader.tier = gCurrentTier;
+	ckHeader.tierSize = gCurrentTierSize;
+	ckHeader.start = ckHeader.cursor = start;
+	ckHeader.end = end;
+
+	ckResuming = FALSE;
+	if ((fp = fopen(ckFilename, "rb")) != NULL) {
+		if (fread(&found, sizeof(found), 1, fp) == 1
+		    && memcmp(found.magic, ckHeader.magic, sizeof(found.magic)) == 0
+		    && found.version == ckHeader.version && found.byteOrder == ckHeader.byteOrder
+		    && found.loopy == ckHeader.loopy && found.useUndo == ckHeader.useUndo
+		    && found.tier == ckHeader.tier && found.tierSize == ckHeader.tierSize
+		    && found.start == ckHeader.start && found.end == ckHeader.end) {
+			ckHeader = found;
+			ckResuming = TRUE;
+			ifprintf(gTierSolvePrint, "Found a checkpoint of this tier, resuming from it...\n");
+		} else printf("WARNING: Ignoring checkpoint %s, it isn't of this tier\n", ckFilename);
+		fclose(fp);
+	}
+	ckLastSave = time(NULL);
+}
+
+BOOLEAN CheckpointDue() {
+	return (gCheckpointSeconds > 0 && time(NULL) - ckLastSave >= gCheckpointSeconds);
+}
+
+// Reads the cells of a non-loopy checkpoint back in, and returns where
+// the sweep is to carry on from. Leaves the checkpoint open for appending.
+POSITION CheckpointResumeNonLoopy(POSITION start) {
+	if (ckResuming) {
+		if ((ckFile = fopen(ckFilename, "r+b")) == NULL
+		    || fseeko(ckFile, sizeof(ckHeader), SEEK_SET) != 0
+		    || !tierdb_read_cells(ckFile, ckHeader.start, ckHeader.cursor))
+			CheckpointFailed("read");
+		// drop whatever was appended after the cursor last moved
+		if (ftruncate(fileno(ckFile), ftello(ckFile)) != 0)
+			CheckpointFailed("truncate");
+		trueSizeOfTier = ckHeader.trueSizeOfTier;
+		ifprintf(gTierSolvePrint, "--Resuming the sweep at %llu\n", ckHeader.cursor);
+	} else if (gCheckpointSeconds > 0) {
+		if ((ckFile = fopen(ckFilename, "w+b")) == NULL
+		    || fwrite(&ckHeader, sizeof(ckHeader), 1, ckFile) != 1)
+			CheckpointFailed("write");
+	}
+	if (ckFile != NULL && gCheckpointSeconds <= 0) { // resumed, but not saving any more
+		fclose(ckFile);
+		ckFile = NULL;
+	}
+	return (ckHeader.cursor > start) ? ckHeader.cursor : start;
+}
+
+// Appends the cells solved since the last checkpoint, then moves the cursor
+void CheckpointNonLoopy(POSITION cursor) {
+	time_t began = time(NULL);
+	if (fseeko(ckFile, 0, SEEK_END) != 0
+	    || !tierdb_write_cells(ckFile, ckHeader.cursor, cursor)
+	    || !CheckpointSync(ckFile))
+		CheckpointFailed("write");
+	ckHeader.cursor = cursor;
+	ckHeader.trueSizeOfTier = trueSizeOfTier;
+	if (fseeko(ckFile, 0, SEEK_SET) != 0
+	    || fwrite(&ckHeader, sizeof(ckHeader), 1, ckFile) != 1
+	    || !CheckpointSync(ckFile))
+		CheckpointFailed("write");
+	ckLastSave = time(NULL);
+	ifprintf(gTierSolvePrint, "--Checkpoint saved at %llu (%ld s)\n", cursor, (long)(ckLastSave - began));
+}
+
+// Reads a loopy snapshot back in, and counts the parent pointers of the
+// positions swept so far. Expects rInitFRStuff to have been called.
+void CheckpointResumeLoopy(int* phase, POSITION* cursor, REMOTENESS* level) {
+	FILE* fp;
+	int r;
+
+	if (!ckResuming)
+		return;
+	if ((fp = fopen(ckFilename, "rb")) == NULL
+	    || fseeko(fp, sizeof(ckHeader), SEEK_SET) != 0
+	    || !tierdb_read_cells(fp, 0, gCurrentTierSize)
+	    || !ChildCounterRead(&childCounts, fp))
+		CheckpointFailed("read");
+	for (r = 0; r < REMOTENESS_MAX; r++)
+		if (!PosQueueRead(&rWinFR[r], fp) || !PosQueueRead(&rLoseFR[r], fp) || !PosQueueRead(&rTieFR[r], fp))
+			CheckpointFailed("read");
+	fclose(fp);
+	if (!useUndo)
+		rAddParents();
+
+	numSolved = ckHeader.numSolved;
+	trueSizeOfTier = ckHeader.trueSizeOfTier;
+	*phase = ckHeader.phase;
+	*cursor = ckHeader.cursor;
+	*level = ckHeader.level;
+	if (*phase == CHECKPOINT_SWEEP)
+		ifprintf(gTierSolvePrint, "--Resuming the sweep at %llu\n", *cursor);
+	else ifprintf(gTierSolvePrint, "--Resuming the %s frontier walk at remoteness %d\n",
+		          (*phase == CHECKPOINT_TIES) ? "tie" : "lose/win", *level);
+}
+
+void CheckpointLoopyIfDue(int phase, POSITION cursor, REMOTENESS level) {
+	char tmpfilename[270];
+	time_t began;
+	FILE* fp;
+	int r;
+
+	if (!CheckpointDue())
+		return;
+	began = time(NULL);
+	ckHeader.phase = phase;
+	ckHeader.cursor = cursor;
+	ckHeader.level = level;
+	ckHeader.numSolved = numSolved;
+	ckHeader.trueSizeOfTier = trueSizeOfTier;
+
+	sprintf(tmpfilename, "%s.tmp", ckFilename);
+	if ((fp = fopen(tmpfilename, "wb")) == NULL
+	    || fwrite(&ckHeader, sizeof(ckHeader), 1, fp) != 1
+	    || !tierdb_write_cells(fp, 0, gCurrentTierSize)
+	    || !ChildCounterWrite(&childCounts, fp))
+		CheckpointFailed("write");
+	for (r = 0; r < REMOTENESS_MAX; r++)
+		if (!PosQueueWrite(&rWinFR[r], fp) || !PosQueueWrite(&rLoseFR[r], fp) || !PosQueueWrite(&rTieFR[r], fp))
+			CheckpointFailed("write");
+	if (!CheckpointSync(fp) || fclose(fp) != 0 || rename(tmpfilename, ckFilename) != 0)
+		CheckpointFailed("write");
+	ckLastSave = time(NULL);
+	ifprintf(gTierSolvePrint, "--Checkpoint saved (%ld s)\n", (long)(ckLastSave - began));
+}
+
+// The tier is saved, so its checkpoint is of no more use
+void CheckpointDone() {
+	if (ckFile != NULL) fclose(ckFile);
+	ckFile = NULL;
+	remove(ckFilename);
+	ckResuming = FALSE;
+}
 
 
 /************************************************************************
@@ -859,8 +1110,6 @@ void rInsertFR(VALUE value, POSITION position, REMOTENESS r) {
 **
 ************************************************************************/
 
-POSITION numSolved, trueSizeOfTier;
-
 void SolveTier(POSITION start, POSITION end) {
 	numSolved = trueSizeOfTier = 0;
 
@@ -883,6 +1132,7 @@ void SolveTier(POSITION start, POSITION end) {
 	ifprintf(gTierSolvePrint, "\nSolver Type: %sLOOPY\n",((forceLoopy||gCurrentTierIsLoopy) ? "" : "NON-"));
 	ifprintf(gTierSolvePrint, "Using Symmetries: %s\n",(gSymmetries ? "YES" : "NO"));
 	ifprintf(gTierSolvePrint, "Checking Legality (using IsLegal): %s\n",(checkLegality ? "YES" : "NO"));
+	CheckpointInit(start, end, forceLoopy || gCurrentTierIsLoopy);
 	// now actually SOLVE depending on which solver to use
 	if (forceLoopy || gCurrentTierIsLoopy) { // LOOPY SOLVER
 		ifprintf(gTierSolvePrint, "Using UndoMove Functions: %s\n",(useUndo ? "YES" : "NO"));
@@ -891,6 +1141,7 @@ void SolveTier(POSITION start, POSITION end) {
 		rFreeFRStuff();
 	} else SolveWithNonLoopyAlgorithm(start,end); // NON-LOOPY SOLVER
 	// successfully finished solving!
+	AnalysisScanRange(start, end);
 	if (partialSolve)
 		ifprintf(gTierSolvePrint, "\nPartial Tier solved!\n");
 	else ifprintf(gTierSolvePrint, "\nTier fully solved!\n");
@@ -910,18 +1161,210 @@ void SolveTier(POSITION start, POSITION end) {
 		printf("Couldn't save tierDB!\n");
 		ExitStageRight();
 	}
+	CheckpointDone();
 }
 
-// Note, the NonLoopyAlgorithm works regardless of whether this
-// is a partial tier or not (that's what's nice about it)...
-void SolveWithNonLoopyAlgorithm(POSITION start, POSITION end) {
-	ifprintf(gTierSolvePrint, "\n-----PREPARING NON-LOOPY SOLVER-----\n");
-	POSITION pos, child;
-	MOVELIST *moves, *movesptr;
+// The children of one position, fetched from the DB in one call.
+// MAXFANOUT of each, allocated once; every process has its own.
+POSITION* nlChildren = NULL;
+MOVE* nlMoves = NULL;
+VALUE* nlValues = NULL;
+REMOTENESS* nlRemotenesses = NULL;
+
+void nlAllocChildren() {
+	if (nlChildren != NULL) return;
+	nlChildren = (POSITION*) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	nlMoves = (MOVE*) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+	nlValues = (VALUE*) SafeMalloc(MAXFANOUT * sizeof(VALUE));
+	nlRemotenesses = (REMOTENESS*) SafeMalloc(MAXFANOUT * sizeof(REMOTENESS));
+}
+
+// One pass over the parent pointers of the loopy sweep: the positions it
+// gave child counters to, in or out of the bounds of a partial solve.
+// Counters only go down after the sweep, so once it is over the counting
+// pass (run at its end, or on resuming past it) and the filling pass see
+// the same positions. Edges to parents solved before a resumed snapshot
+// are left out; the frontier walks never follow those anyway.
+void rAddParents() {
+	POSITION pos;
+	int i, numMoves;
+
+	for (pos = 0; pos < gCurrentTierSize; pos++) {
+		if (ChildCounterGet(&childCounts, pos) == 0) continue;
+		numMoves = GenerateChildren(pos, nlChildren, nlMoves);
+		for (i = 0; i < numMoves; i++)
+			ParentIndexAdd(&rParents, nlChildren[i], pos);
+	}
+}
+
+// Solves one position of a non-loopy tier, given that every child tier is
+// already solved. Returns FALSE if the position was skipped.
+BOOLEAN SolveNonLoopyPosition(POSITION pos, BOOLEAN usingLevelFiles) {
 	VALUE value;
 	REMOTENESS remoteness;
 	REMOTENESS maxWinRem, minLoseRem, minTieRem;
 	BOOLEAN seenLose, seenTie;
+	int i, numChildren;
+
+	if (usingLevelFiles && !l_isInLevelFile(pos)) return FALSE; //just skip
+	if (checkLegality && !gIsLegalFunPtr(pos)) return FALSE; //skip
+	if (gSymmetries && pos != gCanonicalPosition(pos))
+		return FALSE; // skip, since we'll do canon one later
+	value = Primitive(pos);
+	if (value != undecided) { // check for primitive-ness
+		SetRemoteness(pos,0);
+		StoreValueOfPosition(pos,value);
+		return TRUE;
+	}
+	nlAllocChildren();
+	numChildren = GenerateChildren(pos, nlChildren, nlMoves);
+	if (numChildren == 0) { // no chillins
+		printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
+		ExitStageRight();
+	}
+	// else, solve me
+	if (gSymmetries)
+		CanonicalPositionBulk(nlChildren, nlChildren, numChildren);
+	if (gValueOnlySolver) { // --valueonly: no remoteness, so the first lose child decides it
+		GetPositionDataBulk(nlChildren, numChildren, nlValues, NULL, NULL, NULL);
+		seenTie = FALSE;
+		for (i = 0; i < numChildren; i++) {
+			if (nlValues[i] == lose) {
+				StoreValueOfPosition(pos, win);
+				return TRUE;
+			} else if (nlValues[i] == tie)
+				seenTie = TRUE;
+			else if (nlValues[i] == undecided) {
+				printf("ERROR: GenerateMoves on %llu found undecided child, %llu!\n", pos, nlChildren[i]);
+				ExitStageRight();
+			}
+		}
+		StoreValueOfPosition(pos, seenTie ? tie : lose);
+		return TRUE;
+	}
+	GetPositionDataBulk(nlChildren, numChildren, nlValues, nlRemotenesses, NULL, NULL);
+	maxWinRem = -1;
+	minLoseRem = minTieRem = REMOTENESS_MAX;
+	seenLose = seenTie = FALSE;
+	for (i = 0; i < numChildren; i++) {
+		value = nlValues[i];
+		if (value != undecided) {
+			remoteness = nlRemotenesses[i];
+			if (value == tie) {
+				seenTie = TRUE;
+				if (remoteness < minTieRem)
+					minTieRem = remoteness;
+				continue;
+			} else if (value == lose) {
+				seenLose = TRUE;
+				if (remoteness < minLoseRem)
+					minLoseRem = remoteness;
+				continue;
+			} else if (remoteness > maxWinRem) //win
+				maxWinRem = remoteness;
+		} else {
+			printf("ERROR: GenerateMoves on %llu found undecided child, %llu!\n", pos, nlChildren[i]);
+			ExitStageRight();
+		}
+	}
+	if (seenLose) {
+		SetRemoteness(pos,minLoseRem+1);
+		StoreValueOfPosition(pos, win);
+	} else if (seenTie) {
+		if (minTieRem == REMOTENESS_MAX)
+			SetRemoteness(pos,REMOTENESS_MAX); // a draw
+		else SetRemoteness(pos,minTieRem+1); // else a tie
+		StoreValueOfPosition(pos, tie);
+	} else {
+		SetRemoteness(pos,maxWinRem+1);
+		StoreValueOfPosition(pos, lose);
+	}
+	return TRUE;
+}
+
+/* Parallel sweep for non-loopy tiers. Every position only depends on the
+   (already solved) child tiers, so the range is cut into chunks and handed
+   out to gSolverWorkers forked processes. Module code keeps its own globals
+   in each process; the results land in the shared tierdb table, and each
+   worker only ever writes the cells of the chunks it claimed. */
+
+#define NONLOOPY_CHUNK_SIZE 4096
+
+typedef struct nonloopy_worker_state {
+	POSITION nextChunk;     // next unclaimed position, bumped atomically
+	POSITION solved[1];     // per worker: positions solved (really gSolverWorkers long)
+} NONLOOPY_WORKERS;
+
+void SolveNonLoopyChunks(NONLOOPY_WORKERS* shared, int worker, POSITION end, BOOLEAN usingLevelFiles) {
+	POSITION pos, chunk, chunkEnd, count = 0;
+	while ((chunk = __sync_fetch_and_add(&shared->nextChunk, NONLOOPY_CHUNK_SIZE)) < end) {
+		chunkEnd = (chunk + NONLOOPY_CHUNK_SIZE < end) ? chunk + NONLOOPY_CHUNK_SIZE : end;
+		for (pos = chunk; pos < chunkEnd; pos++)
+			if (SolveNonLoopyPosition(pos, usingLevelFiles))
+				count++;
+	}
+	shared->solved[worker] = count;
+}
+
+// Returns FALSE if the workers couldn't be started, in which case nothing
+// was solved and the caller should fall back to the serial sweep.
+BOOLEAN SolveNonLoopyWithWorkers(POSITION start, POSITION end, BOOLEAN usingLevelFiles) {
+	int i, workers = gSolverWorkers, status, started = 0;
+	BOOLEAN ok = TRUE;
+	size_t sharedSize = sizeof(NONLOOPY_WORKERS) + workers * sizeof(POSITION);
+	NONLOOPY_WORKERS* shared;
+	pid_t* pids;
+
+	if (!tierdb_is_shared())
+		return FALSE;
+	shared = (NONLOOPY_WORKERS*) mmap(NULL, sharedSize, PROT_READ | PROT_WRITE,
+	                                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+		return FALSE;
+	shared->nextChunk = start;
+	for (i = 0; i < workers; i++)
+		shared->solved[i] = INVALID_POSITION; // stays invalid unless the worker finishes
+	pids = (pid_t*) SafeMalloc(workers * sizeof(pid_t));
+
+	ifprintf(gTierSolvePrint, "Sweeping the tier with %d workers...\n", workers);
+	fflush(stdout); fflush(stderr);
+	for (i = 0; i < workers; i++) {
+		pids[i] = fork();
+		if (pids[i] == 0) { // worker: solve, then leave without touching parent state
+			SolveNonLoopyChunks(shared, i, end, usingLevelFiles);
+			fflush(stdout);
+			_exit(0);
+		} else if (pids[i] < 0) {
+			printf("WARNING: Could only start %d of %d workers\n", i, workers);
+			break;
+		}
+		started++;
+	}
+	if (started == 0) { // not a single worker, nothing touched yet
+		munmap(shared, sharedSize);
+		SafeFree(pids);
+		return FALSE;
+	}
+	for (i = 0; i < started; i++) {
+		if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status)
+		    || WEXITSTATUS(status) != 0 || shared->solved[i] == INVALID_POSITION)
+			ok = FALSE;
+		else trueSizeOfTier += shared->solved[i];
+	}
+	munmap(shared, sharedSize);
+	SafeFree(pids);
+	if (!ok) {
+		printf("ERROR: A worker failed while solving tier %llu!\n", gCurrentTier);
+		ExitStageRight();
+	}
+	return TRUE;
+}
+
+// Note, the NonLoopyAlgorithm works regardless of whether this
+// is a partial tier or not (that's what's nice about it)...
+void SolveWithNonLoopyAlgorithm(POSITION start, POSITION end) {
+	ifprintf(gTierSolvePrint, "\n-----PREPARING NON-LOOPY SOLVER-----\n");
+	POSITION pos, stop;
 
 	BOOLEAN usingLevelFiles = FALSE;
 	if (levelFiles && l_levelFileExists(gCurrentTier)) {
@@ -937,64 +1380,19 @@ void SolveWithNonLoopyAlgorithm(POSITION start, POSITION end) {
 	}
 
 	ifprintf(gTierSolvePrint, "Doing an sweep of the tier, and solving it in one go...\n");
-	for (pos = start; pos < end; pos++) { // Solve only parents
-		if (usingLevelFiles && !l_isInLevelFile(pos)) continue; //just skip
-		if (checkLegality && !gIsLegalFunPtr(pos)) continue; //skip
-		if (gSymmetries && pos != gCanonicalPosition(pos))
-			continue; // skip, since we'll do canon one later
-		trueSizeOfTier++;
-		value = Primitive(pos);
-		if (value != undecided) { // check for primitive-ness
-			SetRemoteness(pos,0);
-			StoreValueOfPosition(pos,value);
-		} else {
-			moves = movesptr = GenerateMoves(pos);
-			if (moves == NULL) { // no chillins
-				printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
-				ExitStageRight();
-			} else { // else, solve me
-				maxWinRem = -1;
-				minLoseRem = minTieRem = REMOTENESS_MAX;
-				seenLose = seenTie = FALSE;
-				for (; movesptr != NULL; movesptr = movesptr->next) {
-					child = DoMove(pos, movesptr->move);
-					if (gSymmetries)
-						child = gCanonicalPosition(child);
-					value = GetValueOfPosition(child);
-					if (value != undecided) {
-						remoteness = Remoteness(child);
-						if (value == tie) {
-							seenTie = TRUE;
-							if (remoteness < minTieRem)
-								minTieRem = remoteness;
-							continue;
-						} else if (value == lose) {
-							seenLose = TRUE;
-							if (remoteness < minLoseRem)
-								minLoseRem = remoteness;
-							continue;
-						} else if (remoteness > maxWinRem) //win
-							maxWinRem = remoteness;
-					} else {
-						printf("ERROR: GenerateMoves on %llu found undecided child, %llu!\n", pos, child);
-						ExitStageRight();
-					}
-				}
-				FreeMoveList(moves);
-				if (seenLose) {
-					SetRemoteness(pos,minLoseRem+1);
-					StoreValueOfPosition(pos, win);
-				} else if (seenTie) {
-					if (minTieRem == REMOTENESS_MAX)
-						SetRemoteness(pos,REMOTENESS_MAX); // a draw
-					else SetRemoteness(pos,minTieRem+1); // else a tie
-					StoreValueOfPosition(pos, tie);
-				} else {
-					SetRemoteness(pos,maxWinRem+1);
-					StoreValueOfPosition(pos, lose);
-				}
-			}
+	pos = CheckpointResumeNonLoopy(start);
+	while (pos < end) {
+		// with checkpoints, go a slice at a time so there are places to stop
+		stop = (gCheckpointSeconds > 0 && end - pos > CHECKPOINT_GRAIN) ? pos + CHECKPOINT_GRAIN : end;
+		if (gSolverWorkers <= 1 || stop - pos <= NONLOOPY_CHUNK_SIZE
+		    || !SolveNonLoopyWithWorkers(pos, stop, usingLevelFiles)) {
+			for (; pos < stop; pos++) // Solve only parents
+				if (SolveNonLoopyPosition(pos, usingLevelFiles))
+					trueSizeOfTier++;
 		}
+		pos = stop;
+		if (pos < end && CheckpointDue())
+			CheckpointNonLoopy(pos);
 	}
 	if (checkLegality) {
 		ifprintf(gTierSolvePrint, "--True size of tier: %lld\n",trueSizeOfTier);
@@ -1020,9 +1418,9 @@ void SolveWithLoopyAlgorithm(POSITION start, POSITION end) {
 	ifprintf(gTierSolvePrint, "\n-----PREPARING LOOPY SOLVER-----\n");
 	POSITION pos, posSaver, canonPos, child;
 	POSITIONLIST* tmp;
-	MOVELIST *moves, *movesptr;
 	VALUE value;
-	REMOTENESS remoteness;
+	REMOTENESS remoteness, level = 0;
+	int phase = CHECKPOINT_SWEEP, numMoves, i;
 
 	BOOLEAN usingLevelFiles = FALSE;
 	if (levelFiles && l_levelFileExists(gCurrentTier)) {
@@ -1037,14 +1435,19 @@ void SolveWithLoopyAlgorithm(POSITION start, POSITION end) {
 		}
 	}
 
-	//int i,numMoves; // the generateMovesEfficient stuff is commented out for now
 	ifprintf(gTierSolvePrint, "--Setting up Child Counters and Frontier Hashtables...\n");
-	rInitFRStuff();
-	ifprintf(gTierSolvePrint, "--Doing an sweep of the tier, and setting up the frontier...\n");
-	for (pos = start; pos < end; pos++) { // SET UP PARENTS
+	rInitFRStuff(start, end);
+	nlAllocChildren();
+	pos = start;
+	CheckpointResumeLoopy(&phase, &pos, &level);
+	if (phase == CHECKPOINT_SWEEP)
+		ifprintf(gTierSolvePrint, "--Doing an sweep of the tier, and setting up the frontier...\n");
+	for (; phase == CHECKPOINT_SWEEP && pos < end; pos++) { // SET UP PARENTS
+		if ((pos - start) % CHECKPOINT_GRAIN == 0)
+			CheckpointLoopyIfDue(CHECKPOINT_SWEEP, pos, 0);
 		posSaver = pos;
 solve_start: // GASP!! A LABEL!!
-		if (childCounts[pos] == 0) { // else, ignore this child, it was already solved
+		if (ChildCounterGet(&childCounts, pos) == 0) { // else, ignore this child, it was already solved
 			if (usingLevelFiles && !l_isInLevelFile(pos)) continue; //just skip
 			if (checkLegality && !gIsLegalFunPtr(pos)) continue; //skip
 			if (gSymmetries && pos != gCanonicalPosition(pos))
@@ -1057,52 +1460,28 @@ solve_start: // GASP!! A LABEL!!
 				numSolved++;
 				rInsertFR(value, pos, 0);
 			} else {
-				//if (gGenerateMovesEfficientFunPtr == NULL) { // do the normal stuff
-				moves = movesptr = GenerateMoves(pos);
-				if (moves == NULL) { // no chillins
+				numMoves = GenerateChildren(pos, nlChildren, nlMoves);
+				if (numMoves == 0) { // no chillins
 					printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
 					ExitStageRight();
 				} else {
 					//otherwise, make a Child Counter for it
-					movesptr = moves;
-					for (; movesptr != NULL; movesptr = movesptr->next) {
-						childCounts[pos]++;
-						child = DoMove(pos, movesptr->move);
+					ChildCounterSet(&childCounts, pos, numMoves);
+					for (i = 0; i < numMoves; i++) {
+						child = nlChildren[i];
 						// here's the "partial solving" complication: to solve a position,
 						// we might have to solve another in this tier that's not part of our
 						// bounds! So, we need to run this loop for those guys too. To do this,
 						// we maintain a list of guys to run it for too.
 						// It uses the childCounts to ensure no duplicate iterations
-						if (partialSolve && child < gCurrentTierSize && childCounts[child] == 0
+						if (partialSolve && child < gCurrentTierSize && ChildCounterGet(&childCounts, child) == 0
 						    && (child < start || child >= end)) {
 							solveTheseTooList = StorePositionInList(child, solveTheseTooList);
 						}
-						if (!useUndo) { // if parent pointers, add to parent pointer list
-							rParents[child] = StorePositionInList(pos, rParents[child]);
-						}
+						if (!useUndo) // if parent pointers, count them for the index
+							ParentIndexAdd(&rParents, child, pos);
 					}
-					FreeMoveList(moves);
 				}
-				//} else { // do the experimental stuff!
-				//    numMoves = gGenerateMovesEfficientFunPtr(pos);
-				//    if (numMoves == 0) { // no chillins
-				//        printf("ERROR: GenerateMoves on %llu returned NULL\n", pos);
-				//        ExitStageRight();
-				//    } else {
-				//        //otherwise, make a Child Counter for it
-				//        for (i = 0; i < numMoves; i++) {
-				//            childCounts[pos]++;
-				//            child = DoMove(pos, gGenerateMovesArray[i]);
-				//            if (partialSolve && child < gCurrentTierSize && childCounts[child] == 0
-				//                    && child < start && child >= end) {
-				//                solveTheseTooList = StorePositionInList(child, solveTheseTooList);
-				//            }
-				//            if (!useUndo) {// if parent pointers, add to parent pointer list
-				//                rParents[child] = StorePositionInList(pos, rParents[child]);
-				//            }
-				//        }
-				//    }
-				//}
 			}
 		}
 		// before ending the for-loop, we need to go through the solveTheseTooList
@@ -1117,6 +1496,8 @@ solve_start: // GASP!! A LABEL!!
 		}
 		pos = posSaver;
 	}
+	ifprintf(gTierSolvePrint, "Child counters: %d bits, %llu KB\n", childCounts.bits,
+	         ChildCounterBytes(&childCounts) >> 10);
 	if (checkLegality) {
 		ifprintf(gTierSolvePrint, "True size of tier: %lld\n",trueSizeOfTier);
 		ifprintf(gTierSolvePrint, "Tier %llu's hash efficiency: %.1f%c\n",gCurrentTier, 100*(double)trueSizeOfTier/gCurrentTierSize, '%');
@@ -1126,53 +1507,38 @@ solve_start: // GASP!! A LABEL!!
 		ifprintf(gTierSolvePrint, "Tier is all primitives! No loopy algorithm needed!\n");
 		return;
 	}
-	// SET UP FRONTIER!
-	ifprintf(gTierSolvePrint, "--Doing an sweep of child tiers, and setting up the frontier...\n");
-	for (pos = gCurrentTierSize; pos < gNumberOfPositions; pos++) {
-		if (usingLevelFiles && !l_isInLevelFile(pos)) continue; //just skip
-		if (!useUndo && rParents[pos] == NULL) // if we didn't even see this child, don't put it on frontier!
-			continue;
-		if (gSymmetries) // use the canonical position's values
-			canonPos = gCanonicalPosition(pos); //to tell where i go!
-		else canonPos = pos; // else ignore
-		value = GetValueOfPosition(canonPos);
-		remoteness = Remoteness(canonPos);
-		if (!((value == tie && remoteness == REMOTENESS_MAX)
-		      || value == undecided))
-			rInsertFR(value, pos, remoteness);
+	if (!useUndo) { // the same edges again, into their places
+		ParentIndexFill(&rParents);
+		rAddParents();
 	}
-	if (usingLevelFiles) l_freeBitArray();
-	ifprintf(gTierSolvePrint, "\n--Beginning the loopy algorithm...\n");
-	REMOTENESS r; POSITIONLIST* list;
-	ifprintf(gTierSolvePrint, "--Processing Lose/Win Frontiers!\n");
-	for (r = 0; r <= REMOTENESS_MAX; r++) {
-		if (r!=REMOTENESS_MAX) {
-			list = rRemoveFRList(lose,r);
-			if (list != NULL)
-				LoopyParentsHelper(list, win, r);
-		}
-		if (r!=0) {
-			list = rRemoveFRList(win,r-1);
-			if (list != NULL)
-				LoopyParentsHelper(list, lose, r-1);
+	// SET UP FRONTIER! (a checkpoint past the sweep already has it)
+	if (phase == CHECKPOINT_SWEEP) {
+		ifprintf(gTierSolvePrint, "--Doing an sweep of child tiers, and setting up the frontier...\n");
+		for (pos = gCurrentTierSize; pos < gNumberOfPositions; pos++) {
+			if (usingLevelFiles && !l_isInLevelFile(pos)) continue; //just skip
+			if (!useUndo && ParentIndexCount(&rParents, pos) == 0) // if we didn't even see this child, don't put it on frontier!
+				continue;
+			if (gSymmetries) // use the canonical position's values
+				canonPos = gCanonicalPosition(pos); //to tell where i go!
+			else canonPos = pos; // else ignore
+			value = GetValueOfPosition(canonPos);
+			remoteness = Remoteness(canonPos);
+			if (!((value == tie && remoteness == REMOTENESS_MAX)
+			      || value == undecided))
+				rInsertFR(value, pos, remoteness);
 		}
+		phase = CHECKPOINT_LOSEWIN;
 	}
-	ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
-	if (numSolved == trueSizeOfTier)
-		return; // Else, we must process ties!
-	ifprintf(gTierSolvePrint, "--Processing Tie Frontier!\n");
-	for (r = 0; r < REMOTENESS_MAX; r++) {
-		list = rRemoveFRList(tie,r);
-		if (list != NULL)
-			LoopyParentsHelper(list, tie, r);
-	}
-
-	ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+	if (usingLevelFiles) l_freeBitArray();
+	ifprintf(gTierSolvePrint, "\n--Beginning the loopy algorithm...\n");
+	if (gSolverWorkers > 1 && !useUndo)
+		ProcessLoopyFrontiersInParallel(phase, level);
+	else ProcessLoopyFrontiers(phase, level);
 	if (numSolved == trueSizeOfTier)
 		return; // Else, we have undecideds... must make them DRAWs
 	ifprintf(gTierSolvePrint, "--Setting undecided to DRAWs...\n");
 	for(pos = 0; pos < gCurrentTierSize; pos++) {
-		if (childCounts[pos] > 0) { // no lose/tie children, no/some wins = draw
+		if (ChildCounterGet(&childCounts, pos) > 0) { // no lose/tie children, no/some wins = draw
 			SetRemoteness(pos,REMOTENESS_MAX); // a draw
 			StoreValueOfPosition(pos, tie);
 			numSolved++;
@@ -1181,74 +1547,254 @@ solve_start: // GASP!! A LABEL!!
 	assert(numSolved == trueSizeOfTier);
 }
 
-void LoopyParentsHelper(POSITIONLIST* list, VALUE valueParents, REMOTENESS remotenessChild) {
-	POSITION child, parent;
-	FRnode *miniLoseFR = NULL;
+// The serial frontier walk, see the PROOFS OF CORRECTNESS above
+// Starts at the given phase and level when resuming from a checkpoint.
+void ProcessLoopyFrontiers(int phase, REMOTENESS level) {
+	REMOTENESS r;
+	if (phase == CHECKPOINT_LOSEWIN) {
+		ifprintf(gTierSolvePrint, "--Processing Lose/Win Frontiers!\n");
+		for (r = level; r <= REMOTENESS_MAX; r++) {
+			CheckpointLoopyIfDue(CHECKPOINT_LOSEWIN, 0, r);
+			if (r!=REMOTENESS_MAX)
+				LoopyParentsHelper(rGetFR(lose,r), win, r);
+			if (r!=0)
+				LoopyParentsHelper(rGetFR(win,r-1), lose, r-1);
+		}
+		ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+		if (numSolved == trueSizeOfTier)
+			return; // Else, we must process ties!
+		level = 0;
+	}
+	ifprintf(gTierSolvePrint, "--Processing Tie Frontier!\n");
+	for (r = level; r < REMOTENESS_MAX; r++) {
+		CheckpointLoopyIfDue(CHECKPOINT_TIES, 0, r);
+		LoopyParentsHelper(rGetFR(tie,r), tie, r);
+	}
+	ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+}
+
+void LoopyParentsHelper(POSQUEUE* queue, VALUE valueParents, REMOTENESS remotenessChild) {
+	POSITION child, parent, i, numChildren, bufferSize;
+	POSITION* children;
+	POSQUEUE miniLoseFR;
 	UNDOMOVELIST *parents, *parentsPtr;
-	POSITIONLIST *parentList;
-	for (; list != NULL; list = list->next) {
-		child = list->position;
-		if (useUndo) { // use the UndoMove lists
-			parents = parentsPtr = gGenerateUndoMovesToTierFunPtr(child, gCurrentTier);
-			for (; parentsPtr != NULL; parentsPtr = parentsPtr->next) {
-				parent = gUnDoMoveFunPtr(child, parentsPtr->undomove);
-				if (parent >= gCurrentTierSize) {
-					TIERPOSITION tp; TIER t;
-					gUnhashToTierPosition(parent, &tp, &t);
-					printf("ERROR: %llu generated undo-parent %llu (Tier: %llu, TierPosition: %llu),\n"
-					       "which is not in the current tier being solved!\n", child, parent, t, tp);
-					ExitStageRight();
+	POSITION *parentPtr, *parentEnd;
+	if (PosQueueIsEmpty(queue)) return;
+	bufferSize = (PosQueueSize(queue) < POSQUEUE_CHUNK_SIZE) ? PosQueueSize(queue) : POSQUEUE_CHUNK_SIZE;
+	children = (POSITION*) SafeMalloc(bufferSize * sizeof(POSITION));
+	PosQueueInit(&miniLoseFR);
+	while ((numChildren = PosQueuePopBulk(queue, children, bufferSize)) != 0) {
+		for (i = 0; i < numChildren; i++) {
+			child = children[i];
+			if (useUndo) { // use the UndoMove lists
+				parents = parentsPtr = gGenerateUndoMovesToTierFunPtr(child, gCurrentTier);
+				for (; parentsPtr != NULL; parentsPtr = parentsPtr->next) {
+					parent = gUnDoMoveFunPtr(child, parentsPtr->undomove);
+					if (parent >= gCurrentTierSize) {
+						TIERPOSITION tp; TIER t;
+						gUnhashToTierPosition(parent, &tp, &t);
+						printf("ERROR: %llu generated undo-parent %llu (Tier: %llu, TierPosition: %llu),\n"
+						       "which is not in the current tier being solved!\n", child, parent, t, tp);
+						ExitStageRight();
+					}
+					// if childCounts is already 0, we don't mess with this parent
+					// (already dealt with OR illegal)
+					if (ChildCounterGet(&childCounts, parent) != 0) {
+						// With losing children, every parent is winning, so we just go through
+						// all the parents and declare them winning.
+						// Same with tie children.
+						if (valueParents == win || valueParents == tie) {
+							ChildCounterSet(&childCounts, parent, 0); // reset child counter
+							if (remotenessChild+1 < REMOTENESS_MAX)
+								rInsertFR(valueParents, parent, remotenessChild+1);
+							// With winning children, first decrement the child counter by one. If
+							// child counter reaches 0, put the parent not in the FR but in the miniFR.
+						} else if (valueParents == lose) {
+							if (ChildCounterDecrement(&childCounts, parent) != 0) continue;
+							PosQueuePush(&miniLoseFR, parent);
+						}
+						SetRemoteness(parent, remotenessChild+1);
+						StoreValueOfPosition(parent, valueParents);
+						numSolved++;
+					}
 				}
-				// if childCounts is already 0, we don't mess with this parent
-				// (already dealt with OR illegal)
-				if (childCounts[parent] != 0) {
-					// With losing children, every parent is winning, so we just go through
-					// all the parents and declare them winning.
-					// Same with tie children.
-					if (valueParents == win || valueParents == tie) {
-						childCounts[parent] = 0; // reset child counter
-						rInsertFR(valueParents, parent, remotenessChild+1);
-						// With winning children, first decrement the child counter by one. If
-						// child counter reaches 0, put the parent not in the FR but in the miniFR.
-					} else if (valueParents == lose) {
-						childCounts[parent] -= 1;
-						if (childCounts[parent] != 0) continue;
-						miniLoseFR = StorePositionInList(parent, miniLoseFR);
+				FreeUndoMoveList(parents);
+			} else { // use the parents pointers
+				parentEnd = ParentIndexEnd(&rParents, child);
+				for (parentPtr = ParentIndexBegin(&rParents, child); parentPtr < parentEnd; parentPtr++) {
+					parent = *parentPtr;
+					if (ChildCounterGet(&childCounts, parent) != 0) {
+						if (valueParents == win || valueParents == tie) {
+							ChildCounterSet(&childCounts, parent, 0);
+							if (remotenessChild+1 < REMOTENESS_MAX)
+								rInsertFR(valueParents, parent, remotenessChild+1);
+						} else if (valueParents == lose) {
+							if (ChildCounterDecrement(&childCounts, parent) != 0) continue;
+							PosQueuePush(&miniLoseFR, parent);
+						}
+						SetRemoteness(parent, remotenessChild+1);
+						StoreValueOfPosition(parent, valueParents);
+						numSolved++;
 					}
-					SetRemoteness(parent, remotenessChild+1);
-					StoreValueOfPosition(parent, valueParents);
-					numSolved++;
 				}
 			}
-			FreeUndoMoveList(parents);
-		} else { // use the parents pointers
-			parentList = rParents[child];
-			for (; parentList != NULL; parentList = parentList->next) {
-				parent = parentList->position;
-				if (childCounts[parent] != 0) {
-					if (valueParents == win || valueParents == tie) {
-						childCounts[parent] = 0;
-						rInsertFR(valueParents, parent, remotenessChild+1);
-					} else if (valueParents == lose) {
-						childCounts[parent] -= 1;
-						if (childCounts[parent] != 0) continue;
-						miniLoseFR = StorePositionInList(parent, miniLoseFR);
+			// if we inserted into LOSE, deal with them now
+			if (valueParents == lose && !PosQueueIsEmpty(&miniLoseFR))
+				LoopyParentsHelper(&miniLoseFR, win, remotenessChild+1); // will be emptied here too
+		}
+	}
+	SafeFree(children);
+	PosQueueFree(queue); // no longer need it!
+}
+
+
+/************************************************************************
+**
+** NAME:        ProcessLoopyFrontiersInParallel
+**
+** DESCRIPTION: A level-synchronous version of the frontier walk above,
+**				used with parent pointers when there is more than one
+**				worker. Each remoteness level is expanded by gSolverWorkers
+**				threads: child counters are decremented atomically, every
+**				parent is claimed by exactly one thread, and the parents
+**				each thread solves go to its own buffer. The buffers are
+**				merged into the frontier at the end of the level.
+**				Only rParents and childCounts are touched while the
+**				threads run (no module code), and each level depends only
+**				on lower ones, so the result equals the serial walk.
+**
+************************************************************************/
+
+#define LOOPY_LEVEL_GRAIN       1024    // children handed out per claim
+#define LOOPY_LEVEL_MIN_THREAD  4096    // smaller levels aren't worth threads
+
+typedef struct loopy_level_job {
+	POSITION* children;             // the frontier level being expanded
+	POSITION numChildren;
+	POSITION next;                  // next unclaimed child, bumped atomically
+	VALUE valueParents;
+	REMOTENESS remotenessParents;
+} LOOPY_LEVEL_JOB;
+
+typedef struct loopy_level_worker {
+	LOOPY_LEVEL_JOB* job;
+	POSITION* found;                // the parents this worker solved
+	POSITION numFound, maxFound;
+} LOOPY_LEVEL_WORKER;
+
+void* LoopyLevelWorker(void* arg) {
+	LOOPY_LEVEL_WORKER* worker = (LOOPY_LEVEL_WORKER*) arg;
+	LOOPY_LEVEL_JOB* job = worker->job;
+	POSITION i, last, parent;
+	POSITION *parentPtr, *parentEnd;
+
+	while ((i = __sync_fetch_and_add(&job->next, LOOPY_LEVEL_GRAIN)) < job->numChildren) {
+		last = (i + LOOPY_LEVEL_GRAIN < job->numChildren) ? i + LOOPY_LEVEL_GRAIN : job->numChildren;
+		for (; i < last; i++) {
+			parentEnd = ParentIndexEnd(&rParents, job->children[i]);
+			for (parentPtr = ParentIndexBegin(&rParents, job->children[i]); parentPtr < parentEnd; parentPtr++) {
+				parent = *parentPtr;
+				// 0 means solved or illegal. Nothing zeroes a counter that is
+				// being decremented in the same level, so this read is stable.
+				if (ChildCounterGet(&childCounts, parent) == 0) continue;
+				if (job->valueParents == lose) {
+					if (ChildCounterDecrement(&childCounts, parent) != 0) continue;
+				} else if (!ChildCounterClaim(&childCounts, parent))
+					continue; // another worker claimed it first
+				StoreValueAndRemotenessOfCanonical(parent, job->valueParents, job->remotenessParents);
+				if (worker->numFound == worker->maxFound) {
+					if (worker->maxFound == 0) {
+						worker->maxFound = LOOPY_LEVEL_GRAIN;
+						worker->found = (POSITION*) SafeMalloc(worker->maxFound * sizeof(POSITION));
+					} else {
+						worker->maxFound *= 2;
+						worker->found = (POSITION*) SafeRealloc(worker->found, worker->maxFound * sizeof(POSITION));
 					}
-					SetRemoteness(parent, remotenessChild+1);
-					StoreValueOfPosition(parent, valueParents);
-					numSolved++;
 				}
+				worker->found[worker->numFound++] = parent;
 			}
 		}
-		// if we inserted into LOSE, deal with them now
-		if (valueParents == lose && miniLoseFR != NULL) {
-			LoopyParentsHelper(miniLoseFR, win, remotenessChild+1); // will be freed here too
-			miniLoseFR = NULL;
-		}
 	}
-	FreePositionList(list); // no longer need it!
+	return NULL;
 }
 
+// Expands one frontier level (and empties it), pushing the parents solved
+// as valueParents in remotenessParents onto found (unless it is NULL).
+void ExpandLoopyLevel(POSQUEUE* level, VALUE valueParents, REMOTENESS remotenessParents, POSQUEUE* found) {
+	LOOPY_LEVEL_JOB job;
+	LOOPY_LEVEL_WORKER* workers;
+	pthread_t* threads;
+	POSITION i;
+	int w, numWorkers = gSolverWorkers, started;
+
+	if (PosQueueIsEmpty(level)) return;
+	job.numChildren = PosQueueSize(level);
+	job.children = (POSITION*) SafeMalloc(job.numChildren * sizeof(POSITION));
+	PosQueuePopBulk(level, job.children, job.numChildren);
+	PosQueueFree(level);
+	job.next = 0;
+	job.valueParents = valueParents;
+	job.remotenessParents = remotenessParents;
+
+	if (job.numChildren < LOOPY_LEVEL_MIN_THREAD)
+		numWorkers = 1;
+	workers = (LOOPY_LEVEL_WORKER*) SafeMalloc(numWorkers * sizeof(LOOPY_LEVEL_WORKER));
+	threads = (pthread_t*) SafeMalloc(numWorkers * sizeof(pthread_t));
+	for (w = 0; w < numWorkers; w++) {
+		workers[w].job = &job;
+		workers[w].found = NULL;
+		workers[w].numFound = workers[w].maxFound = 0;
+	}
+	// this thread is worker 0; if a thread can't start, the rest pick up its share
+	for (started = 1; started < numWorkers; started++)
+		if (pthread_create(&threads[started], NULL, LoopyLevelWorker, &workers[started]) != 0)
+			break;
+	LoopyLevelWorker(&workers[0]);
+	for (w = 1; w < started; w++)
+		pthread_join(threads[w], NULL);
+
+	// merge the buffers at the level boundary
+	for (w = 0; w < numWorkers; w++) {
+		if (found != NULL)
+			for (i = 0; i < workers[w].numFound; i++)
+				PosQueuePush(found, workers[w].found[i]);
+		numSolved += workers[w].numFound;
+		if (workers[w].found != NULL) SafeFree(workers[w].found);
+	}
+	SafeFree(workers);
+	SafeFree(threads);
+	SafeFree(job.children);
+}
+
+void ProcessLoopyFrontiersInParallel(int phase, REMOTENESS level) {
+	REMOTENESS r;
+	POSQUEUE lastLoses;
+	POSQUEUE *loses, *wins;
+	if (phase == CHECKPOINT_LOSEWIN) {
+		ifprintf(gTierSolvePrint, "--Processing Lose/Win Frontiers level by level with %d workers!\n", gSolverWorkers);
+		PosQueueInit(&lastLoses);
+		for (r = level; r <= REMOTENESS_MAX; r++) {
+			CheckpointLoopyIfDue(CHECKPOINT_LOSEWIN, 0, r);
+			// WINs of r-1 give LOSEs of r, which join the LOSE queue of r...
+			loses = (r != REMOTENESS_MAX) ? rGetFR(lose,r) : &lastLoses;
+			if (r != 0)
+				ExpandLoopyLevel(rGetFR(win,r-1), lose, r, loses);
+			// ...and all of those LOSEs give WINs of r+1
+			wins = (r+1 < REMOTENESS_MAX) ? rGetFR(win,r+1) : NULL;
+			ExpandLoopyLevel(loses, win, r+1, wins);
+		}
+		ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+		if (numSolved == trueSizeOfTier)
+			return; // Else, we must process ties!
+		level = 0;
+	}
+	ifprintf(gTierSolvePrint, "--Processing Tie Frontier level by level!\n");
+	for (r = level; r < REMOTENESS_MAX; r++) {
+		CheckpointLoopyIfDue(CHECKPOINT_TIES, 0, r);
+		ExpandLoopyLevel(rGetFR(tie,r), tie, r+1, (r+1 < REMOTENESS_MAX) ? rGetFR(tie,r+1) : NULL);
+	}
+	ifprintf(gTierSolvePrint, "Amount now solved: %lld (%.1f%c)\n",numSolved, 100*(double)numSolved/trueSizeOfTier, '%');
+}
 
 /************************************************************************
 **
@@ -1690,7 +2236,8 @@ void TestRemote() {
 		       "\t5)\t(5)SolveTier(TIER,START,FINISH)\n\n"
 		       "\t6)\t(6)MergeToMakeTierDBIfCan(TIER)\n\n"
 		       "\tC)\t(C)alculate Next Tiers\n"
-		       "\tS)\t(S)imulate ODeepaBlue\n\n"
+		       "\tS)\t(S)imulate ODeepaBlue\n"
+		       "\tR)\t(R)un all tiers with the scheduler\n\n"
 		       "\tq)\t(Q)uit using the interface\n"
 		       "\nSelect an option:  ");
 		c = GetMyChar();
@@ -1791,6 +2338,12 @@ void TestRemote() {
 			FreeTierList(list);
 			SafeFree(starts);
 			break;
+		case 'r': case 'R':
+			printf("Number of worker processes: > ");
+			tier = GetMyPosition();
+			if (tier == kBadPosition || tier < 1) break;
+			printf("Returned: %d", RemoteScheduleAllTiers((int)tier));
+			break;
 		case 'q': case 'Q':
 			ExitStageRight();
 		default:
@@ -1946,7 +2499,7 @@ BOOLEAN RemoteMergeToMakeTierDBIfCan(TIER tier) {
 	gInitializeHashWindow(tier, TRUE);
 	// keep an array of visited nums
 	BOOLEAN* seen = (BOOLEAN*) SafeMalloc(gCurrentTierSize * sizeof(BOOLEAN));
-	int i;
+	POSITION i;
 	for (i = 0; i < gCurrentTierSize; i++)
 		seen[i] = FALSE;
 	// check through all the minifiles
@@ -1994,6 +2547,240 @@ BOOLEAN RemoteMergeToMakeTierDBIfCan(TIER tier) {
 	return TRUE;
 }
 
+/* The tier scheduler: solves every tier in tierSolveList with up to jobs
+   worker processes at a time, so a whole game is one unattended run.
+   A tier is ready once all of its child tiers have a DB. Big non-loopy
+   tiers are cut into slices that go to minitierdbs, and one last job per
+   tier merges them. Everything already on disk (tier DBs and the
+   minitierdbs of unmerged slices) counts as done, so rerunning after a
+   crash picks up where the last run stopped. Slices depend only on the
+   tier's size, so this works even if the rerun has a different number
+   of jobs. Each job runs in a forked process, which loads what it needs
+   and leaves the scheduler untouched. */
+
+#define TIERSCHED_SLICE (1 << 18)       // positions per slice of a big tier
+#define TIERSCHED_MERGE (-1)            // slice number of a merge job
+
+typedef struct tiersched_tier {
+	TIER tier;
+	TIERPOSITION size;
+	int deps;                       // child tiers that have no DB yet
+	int *parents, numParents;       // tiers waiting on this one
+	int slices;                     // 1 if solved in one go
+	int nextSlice;                  // next slice to hand out
+	int slicesLeft;                 // slices not finished yet
+	BOOLEAN merging, done;
+} TIERSCHED_TIER;
+
+typedef struct tiersched_job {
+	pid_t pid;                      // 0 if this slot is free
+	int index, slice;
+} TIERSCHED_JOB;
+
+typedef struct tiersched_index {
+	TIER tier;
+	int index;
+} TIERSCHED_INDEX;
+
+int tiersched_compare(const void* a, const void* b) {
+	TIER x = ((TIERSCHED_INDEX*) a)->tier, y = ((TIERSCHED_INDEX*) b)->tier;
+	return (x > y) - (x < y);
+}
+
+TIERPOSITION tiersched_sliceStart(TIERSCHED_TIER* t, int slice) {
+	return t->size / t->slices * slice + (t->size % t->slices) * slice / t->slices;
+}
+
+void tiersched_sliceFile(char* filename, TIERSCHED_TIER* t, int slice) {
+	sprintf(filename, "./data/m%s_%d_tierdb/m%s_%d_%llu__%llu_%llu_minitierdb.dat.gz",
+	        kDBName, variant, kDBName, variant, t->tier,
+	        tiersched_sliceStart(t, slice), tiersched_sliceStart(t, slice+1));
+}
+
+// Runs in the forked worker. The exit status says whether the job's file
+// is there, since the solver itself gives up through ExitStageRight.
+void tiersched_runJob(TIERSCHED_TIER* t, int slice) {
+	char filename[MAXINPUTLENGTH];
+	BOOLEAN ok;
+	if (slice == TIERSCHED_MERGE) {
+		ok = RemoteMergeToMakeTierDBIfCan(t->tier);
+	} else if (t->slices == 1) {
+		RemoteSolveTier(t->tier, 0, t->size);
+		ok = (CheckTierDB(t->tier, variant) == 1);
+	} else {
+		RemoteSolveTier(t->tier, tiersched_sliceStart(t, slice), tiersched_sliceStart(t, slice+1));
+		tiersched_sliceFile(filename, t, slice);
+		ok = (access(filename, F_OK) == 0);
+	}
+	fflush(stdout);
+	_exit(ok ? 0 : 1);
+}
+
+// Returns FALSE if any job failed; the DBs that were finished stay.
+BOOLEAN RemoteScheduleAllTiers(int jobs) {
+	TIERSCHED_TIER* tiers;
+	TIERSCHED_INDEX *index, key, *found;
+	TIERSCHED_JOB* running;
+	TIERLIST *ptr, *children, *childPtr;
+	TIERSCHED_TIER* t;
+	char filename[MAXINPUTLENGTH];
+	int n = 0, i, j, slot, status, numRunning = 0, left = 0;
+	int *ready, readyHead = 0, readyTail = 0;
+	BOOLEAN failed = FALSE, loopy;
+	pid_t pid;
+
+	for (ptr = tierSolveList; ptr != NULL; ptr = ptr->next)
+		n++;
+	tiers = (TIERSCHED_TIER*) SafeMalloc((n ? n : 1) * sizeof(TIERSCHED_TIER));
+	index = (TIERSCHED_INDEX*) SafeMalloc((n ? n : 1) * sizeof(TIERSCHED_INDEX));
+	ready = (int*) SafeMalloc((n ? n : 1) * sizeof(int));
+	running = (TIERSCHED_JOB*) SafeMalloc(jobs * sizeof(TIERSCHED_JOB));
+	for (slot = 0; slot < jobs; slot++)
+		running[slot].pid = 0;
+	gDBLoadMainTier = FALSE; // workers start their tier as undecided
+
+	// the tiers, and which of them are already solved
+	for (i = 0, ptr = tierSolveList; ptr != NULL; ptr = ptr->next, i++) {
+		t = &tiers[i];
+		t->tier = index[i].tier = ptr->tier;
+		index[i].index = i;
+		t->size = gNumberOfTierPositionsFunPtr(ptr->tier);
+		t->deps = t->numParents = 0;
+		t->parents = NULL;
+		t->merging = FALSE;
+		t->done = (CheckTierDB(ptr->tier, variant) == 1);
+		if (!t->done) left++;
+	}
+	qsort(index, n, sizeof(TIERSCHED_INDEX), tiersched_compare);
+
+	// the dependency DAG, keeping only the edges to unsolved tiers
+	for (i = 0; i < n; i++) {
+		t = &tiers[i];
+		loopy = forceLoopy;
+		children = gTierChildrenFunPtr(t->tier);
+		for (childPtr = children; childPtr != NULL; childPtr = childPtr->next) {
+			if (childPtr->tier == t->tier) {
+				loopy = TRUE;
+				continue;
+			}
+			key.tier = childPtr->tier;
+			found = (TIERSCHED_INDEX*) bsearch(&key, index, n, sizeof(TIERSCHED_INDEX), tiersched_compare);
+			if (found == NULL || tiers[found->index].done)
+				continue;
+			t->deps++;
+			j = found->index;
+			tiers[j].parents = (tiers[j].numParents == 0)
+			                   ? (int*) SafeMalloc(sizeof(int))
+			                   : (int*) SafeRealloc(tiers[j].parents, (tiers[j].numParents+1) * sizeof(int));
+			tiers[j].parents[tiers[j].numParents++] = i;
+		}
+		FreeTierList(children);
+		// loopy tiers need all of their positions in one solve
+		t->slices = 1;
+		if (!loopy && t->size >= 2 * TIERSCHED_SLICE)
+			t->slices = (int) ((t->size + TIERSCHED_SLICE - 1) / TIERSCHED_SLICE);
+		t->nextSlice = 0;
+		t->slicesLeft = t->slices;
+		if (t->slices > 1) { // slices finished before a crash are kept
+			for (j = 0; j < t->slices; j++) {
+				tiersched_sliceFile(filename, t, j);
+				if (access(filename, F_OK) == 0)
+					t->slicesLeft--;
+			}
+		}
+	}
+	for (i = 0; i < n; i++)
+		if (!tiers[i].done && tiers[i].deps == 0)
+			ready[readyTail++] = i;
+
+	ifprintf(gTierSolvePrint, "\n----- Scheduling %d of %d tiers on %d worker processes -----\n", left, n, jobs);
+	while (left > 0 && (numRunning > 0 || !failed)) {
+		// hand out jobs, oldest ready tier first
+		for (i = readyHead; i < readyTail && numRunning < jobs && !failed; i++) {
+			t = &tiers[ready[i]];
+			while (numRunning < jobs && (t->nextSlice < t->slices
+			                             || (t->slicesLeft == 0 && t->slices > 1 && !t->merging))) {
+				if (t->nextSlice < t->slices) {
+					j = t->nextSlice++;
+					if (t->slices > 1) {
+						tiersched_sliceFile(filename, t, j);
+						if (access(filename, F_OK) == 0)
+							continue; // solved by an earlier run
+					}
+				} else {
+					j = TIERSCHED_MERGE;
+					t->merging = TRUE;
+				}
+				for (slot = 0; running[slot].pid != 0; slot++) ;
+				fflush(stdout); fflush(stderr);
+				if ((pid = fork()) == 0)
+					tiersched_runJob(t, j);
+				if (pid < 0) {
+					printf("ERROR: Couldn't start a worker for tier %llu!\n", t->tier);
+					failed = TRUE;
+					break;
+				}
+				running[slot].pid = pid;
+				running[slot].index = ready[i];
+				running[slot].slice = j;
+				numRunning++;
+			}
+		}
+		if (numRunning == 0)
+			break;
+		// then wait for one to come back
+		if ((pid = wait(&status)) < 0)
+			break;
+		for (slot = 0; slot < jobs && running[slot].pid != pid; slot++) ;
+		if (slot == jobs)
+			continue; // not one of ours
+		running[slot].pid = 0;
+		numRunning--;
+		t = &tiers[running[slot].index];
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			printf("ERROR: The worker for tier %llu failed", t->tier);
+			if (running[slot].slice == TIERSCHED_MERGE)
+				printf(" to merge its slices");
+			else if (t->slices > 1)
+				printf(" on slice %d of %d", running[slot].slice+1, t->slices);
+			printf("!\n");
+			failed = TRUE;
+			continue;
+		}
+		if (running[slot].slice != TIERSCHED_MERGE && t->slices > 1) {
+			t->slicesLeft--;
+			ifprintf(gTierSolvePrint, "  Tier %llu: slice %d of %d solved\n",
+			         t->tier, running[slot].slice+1, t->slices);
+			continue;
+		}
+		// the whole tier is done, so its parents may be ready now
+		t->done = TRUE;
+		left--;
+		tiersSolved++;
+		for (j = 0; j < t->numParents; j++)
+			if (--tiers[t->parents[j]].deps == 0)
+				ready[readyTail++] = t->parents[j];
+		while (readyHead < readyTail && tiers[ready[readyHead]].done)
+			readyHead++;
+		ifprintf(gTierSolvePrint, "  Tier %llu solved (%d left)\n", t->tier, left);
+	}
+	if (left > 0 && !failed) { // nothing could run, so the tier tree is broken
+		printf("ERROR: %d tiers could never be solved!\n", left);
+		failed = TRUE;
+	}
+	if (failed)
+		printf("Stopped the tier scheduler. Run it again to continue from the tiers solved so far.\n");
+
+	for (i = 0; i < n; i++)
+		if (tiers[i].parents != NULL)
+			SafeFree(tiers[i].parents);
+	SafeFree(tiers);
+	SafeFree(index);
+	SafeFree(ready);
+	SafeFree(running);
+	return !failed;
+}
+
 // HELPERS
 
 // this is a helper that parses the mini-tierdb filename for info
@@ -2034,7 +2821,7 @@ void r_getBounds(TIER tier, char* name, BOOLEAN tierdb) {
 		index++; i++;
 	}
 	startStr[index] = '\0';
-	int start = atoi(startStr);
+	POSITION start = strtoull(startStr, NULL, 10);
 	// check _
 	if (r_checkChar('_','_',name,&i)) return;
 	// check end
@@ -2044,8 +2831,8 @@ void r_getBounds(TIER tier, char* name, BOOLEAN tierdb) {
 		index++; i++;
 	}
 	endStr[index] = '\0';
-	int end = atoi(endStr);
-	if (start < 0 || start >= end || end > gCurrentTierSize) return;
+	POSITION end = strtoull(endStr, NULL, 10);
+	if (index == 0 || start >= end || end > gCurrentTierSize) return;
 	// check _minitierdb.dat.gz
 	if (r_checkStr((tierdb ? "_minitierdb.dat.gz" : "_minilevelfile.dat.gz"),name,&i)) return;
 	// sucess! set the vars and return
@@ -2077,8 +2864,8 @@ char* r_intToString(int n) {
 	if (n < 0) // just in case
 		n = -n;
 	// we need to find out how many digits it is:
-	int tmp = n, digits = 0;
-	while (tmp != 0) {
+	int tmp = n, digits = 1;
+	while (tmp >= 10) {
 		tmp /= 10;
 		digits++;
 	}
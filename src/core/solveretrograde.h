@@ -3,6 +3,7 @@
 
 VALUE DetermineRetrogradeValue(POSITION);
 POSITION InitTierGamesman();
+TIERLIST* checkAndDefineTierTree();
 
 // ODeepaBlue (parallelization)
 void RemoteInitialize();
@@ -13,6 +14,7 @@ int RemoteGetTierDependencies(TIER);
 BOOLEAN RemoteCanISolveTier(TIER);
 void RemoteSolveTier(TIER, TIERPOSITION, TIERPOSITION);
 BOOLEAN RemoteMergeToMakeTierDBIfCan(TIER);
+BOOLEAN RemoteScheduleAllTiers(int);
 
 BOOLEAN RemoteCanISolveLevelFile(TIER);
 void RemoteSolveLevelFile(TIER, TIERPOSITION, TIERPOSITION);
@@ -31,6 +31,16 @@
 
 #include "gamesman.h"
 
+/* Children per position that DetermineValueSTD keeps on the stack */
+#define STD_CHILDREN_BUFFER 32
+
+/* The children and moves of every position on the recursion path, from
+   GenerateChildren. Frames keep offsets, since the arrays move when they
+   grow. */
+static POSITION *stdChildStack = NULL;
+static MOVE *stdMoveStack = NULL;
+static POSITION stdStackTop = 0, stdStackSize = 0;
+
 
 /*
 ** Code
@@ -39,13 +49,24 @@
 VALUE DetermineValueSTD(POSITION position)
 {
 	BOOLEAN foundTie = FALSE, foundLose = FALSE, foundWin = FALSE;
-	MOVELIST *ptr, *head;
+	MOVELIST *ptr = NULL, *head = NULL;
 	VALUE value;
 	POSITION child;
 	REMOTENESS maxRemoteness = 0, minRemoteness = MAXINT2;
 	REMOTENESS minTieRemoteness = MAXINT2, remoteness;
 	MEXCALC theMexCalc = 0; /* default to satisfy compiler */
 	int winByValue = 0, minWinByValue = ((1 << (MEX_BITS-1))-1), maxWinByValue = -(1 << (MEX_BITS-1));
+	/* The children's values come back from the recursion; their other
+	   fields are fetched in one call once all of them are solved. */
+	POSITION childrenBuffer[STD_CHILDREN_BUFFER], *children = childrenBuffer;
+	VALUE valuesBuffer[STD_CHILDREN_BUFFER], *values = valuesBuffer;
+	REMOTENESS remotenessesBuffer[STD_CHILDREN_BUFFER], *remotenesses = remotenessesBuffer;
+	MEX mexesBuffer[STD_CHILDREN_BUFFER], *mexes = mexesBuffer;
+	WINBY winbysBuffer[STD_CHILDREN_BUFFER], *winbys = winbysBuffer;
+	BOOLEAN useMex = !kPartizan && !gTwoBits, useWinBy = kPartizan && gPutWinBy && !gTwoBits;
+	POSITION base = stdStackTop;
+	MOVE move;
+	int i, numChildren;
 
 	if(Visited(position)) { /* Cycle! */
 		printf("Sorry, but I think this is a loopy game. I give up.");
@@ -68,11 +89,42 @@ VALUE DetermineValueSTD(POSITION position)
 		MarkAsVisited(position);
 		if(!kPartizan && !gTwoBits)
 			theMexCalc = MexCalcInit();
-		head = ptr = GenerateMoves(position);
-		while (ptr != NULL) {
-			MOVE move = ptr->move;
+		if (gUseGPS) { // the children have to be made one at a time
+			head = ptr = GenerateMoves(position);
+			for (numChildren = 0; ptr != NULL; ptr = ptr->next)
+				numChildren++;
+			ptr = head;
+		} else {
+			if (base + MAXFANOUT > stdStackSize) {
+				stdStackSize = (base + MAXFANOUT > 2 * stdStackSize) ? base + MAXFANOUT : 2 * stdStackSize;
+				if (stdChildStack == NULL) {
+					stdChildStack = (POSITION *) SafeMalloc(stdStackSize * sizeof(POSITION));
+					stdMoveStack = (MOVE *) SafeMalloc(stdStackSize * sizeof(MOVE));
+				} else {
+					stdChildStack = (POSITION *) SafeRealloc(stdChildStack, stdStackSize * sizeof(POSITION));
+					stdMoveStack = (MOVE *) SafeRealloc(stdMoveStack, stdStackSize * sizeof(MOVE));
+				}
+			}
+			numChildren = GenerateChildren(position, stdChildStack + base, stdMoveStack + base);
+			stdStackTop = base + numChildren;
+		}
+		if (numChildren > STD_CHILDREN_BUFFER) {
+			children = (POSITION *) SafeMalloc(numChildren * sizeof(POSITION));
+			values = (VALUE *) SafeMalloc(numChildren * sizeof(VALUE));
+			remotenesses = (REMOTENESS *) SafeMalloc(numChildren * sizeof(REMOTENESS));
+			mexes = (MEX *) SafeMalloc(numChildren * sizeof(MEX));
+			winbys = (WINBY *) SafeMalloc(numChildren * sizeof(WINBY));
+		}
+		for (i = 0; i < numChildren; i++) {
 			gAnalysis.TotalMoves++;
-			child = DoMove(position,ptr->move); /* Create the child */
+			if (gUseGPS) {
+				move = ptr->move;
+				child = DoMove(position,move); /* Create the child */
+				ptr = ptr->next;
+			} else {
+				move = stdMoveStack[base + i];
+				child = stdChildStack[base + i];
+			}
 
 			if(gSymmetries)
 				child = gCanonicalPosition(child);
@@ -82,14 +134,6 @@ VALUE DetermineValueSTD(POSITION position)
 
 			value = DetermineValueSTD(child); /* DFS call */
 
-			if (kPartizan && gPutWinBy && !gTwoBits) {
-				int childWinByValue = WinByLoad(child);
-				if (childWinByValue < minWinByValue)
-					minWinByValue = childWinByValue;
-				if (childWinByValue > maxWinByValue)
-					maxWinByValue = childWinByValue;
-			}
-
 			if (gGoAgain(position,move))
 				switch(value)
 				{
@@ -98,9 +142,30 @@ VALUE DetermineValueSTD(POSITION position)
 				default: break; /* value stays the same */
 				}
 
-			remoteness = Remoteness(child);
-			if(!kPartizan && !gTwoBits)
-				theMexCalc = MexAdd(theMexCalc,MexLoad(child));
+			children[i] = child;
+			values[i] = value;
+
+			if (gUseGPS)
+				gUndoMove(move);
+		} //for
+		if (gUseGPS)
+			FreeMoveList(head);
+		stdStackTop = base;
+		GetPositionDataBulk(children, numChildren, NULL, remotenesses,
+		                    useMex ? mexes : NULL, useWinBy ? winbys : NULL);
+		for (i = 0; i < numChildren; i++) {
+			value = values[i];
+			remoteness = remotenesses[i];
+
+			if (useWinBy) {
+				if (winbys[i] < minWinByValue)
+					minWinByValue = winbys[i];
+				if (winbys[i] > maxWinByValue)
+					maxWinByValue = winbys[i];
+			}
+
+			if(useMex)
+				theMexCalc = MexAdd(theMexCalc,mexes[i]);
 			if(value == lose) { /* found a way to give you a lose */
 				foundLose = TRUE; /* thus, it's a winning move      */
 				if (remoteness < minRemoteness) minRemoteness = remoteness;
@@ -115,13 +180,14 @@ VALUE DetermineValueSTD(POSITION position)
 			}
 			else
 				BadElse("DetermineValue[1]");
-
-			if (gUseGPS)
-				gUndoMove(move);
-
-			ptr = ptr->next;
-		} //while
-		FreeMoveList(head);
+		}
+		if (children != childrenBuffer) {
+			SafeFree(children);
+			SafeFree(values);
+			SafeFree(remotenesses);
+			SafeFree(mexes);
+			SafeFree(winbys);
+		}
 		UnMarkAsVisited(position);
 		if(!kPartizan && !gTwoBits)
 			MexStore(position,MexCompute(theMexCalc));
@@ -0,0 +1,137 @@
+/************************************************************************
+**
+** NAME:	solvevalueonly.c
+**
+** DESCRIPTION:	Value-only solver for two-bit databases.
+**
+** AUTHOR:	GamesCrafters Research Group, UC Berkeley
+**		Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+**
+** DATE:	2026-10-18
+**
+** LICENSE:	This file is part of GAMESMAN,
+**		The Finite, Two-person Perfect-Information Game Generator
+**		Released under the GPL:
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program, in COPYING; if not, write to the Free Software
+** Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+**
+**************************************************************************/
+
+#include "gamesman.h"
+#include "solvevalueonly.h"
+
+/*
+** Finds only whether each position is a win, lose or tie: no remoteness
+** or mex, for games that fit in memory only at two bits a position
+** (--valueonly, which also picks twobitdb). Tier games instead keep their
+** tier solver, which then skips remoteness where it can.
+**
+** There is no room for parent pointers, so, as in the zero solver, the
+** reached positions are swept over until nothing changes. A position is
+** decided once a child is a lose or every child is decided, and what one
+** sweep decides is seen by the rest of it. When a sweep neither decides
+** nor reaches anything, the positions left undecided are draws, which are
+** stored as ties.
+**
+** The only other memory is one bit a position, set while a position has
+** been reached but is still undecided; a position has been reached iff it
+** has a value or that bit. The bits are freed when the solve is done.
+*/
+
+static unsigned int *voReached;
+
+#define REACHED(pos)            ((voReached[(pos) >> 5] >> ((pos) & 31)) & 1)
+#define SET_REACHED(pos)        (voReached[(pos) >> 5] |= 1U << ((pos) & 31))
+#define CLEAR_REACHED(pos)      (voReached[(pos) >> 5] &= ~(1U << ((pos) & 31)))
+
+/* Records a position seen for the first time */
+static void ReachValueOnly(POSITION pos)
+{
+	VALUE value = Primitive(pos);
+
+	if (value != undecided)
+		StoreValueOfPosition(pos, value);
+	else
+		SET_REACHED(pos);
+}
+
+VALUE DetermineValueOnly(POSITION position)
+{
+	POSITION *children = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	MOVE *moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+	POSITION pos, child, lowSeen, highSeen, numDecided, numNew;
+	int c, numChildren, numWin, numTie;
+	VALUE value, childValue;
+
+	if (gSymmetries)
+		position = gCanonicalPosition(position);
+	voReached = (unsigned int *) SafeMalloc(((gNumberOfPositions >> 5) + 1) * sizeof(unsigned int));
+	memset(voReached, 0, ((gNumberOfPositions >> 5) + 1) * sizeof(unsigned int));
+	ReachValueOnly(position);
+	lowSeen = highSeen = position;
+
+	do {
+		numDecided = numNew = 0;
+		for (pos = lowSeen; pos <= highSeen; pos++) {
+			if (!REACHED(pos))
+				continue; /* not reached, or already decided */
+
+			numChildren = GenerateChildren(pos, children, moves);
+			numWin = numTie = 0;
+			value = undecided;
+			/* every child is looked at, so all of them get reached */
+			for (c = 0; c < numChildren; c++) {
+				child = gSymmetries ? gCanonicalPosition(children[c]) : children[c];
+				childValue = GetValueOfPosition(child);
+				if (childValue == undecided && !REACHED(child)) {
+					ReachValueOnly(child);
+					childValue = GetValueOfPosition(child);
+					numNew++;
+					if (child < lowSeen) lowSeen = child;
+					if (child > highSeen) highSeen = child;
+				}
+				if (gGoAgain(pos, moves[c])) {
+					if (childValue == win) childValue = lose;
+					else if (childValue == lose) childValue = win;
+				}
+				if (childValue == lose)
+					value = win;
+				else if (childValue == win)
+					numWin++;
+				else if (childValue == tie)
+					numTie++;
+			}
+			if (value == undecided && numWin + numTie == numChildren)
+				value = (numTie == 0) ? lose : tie;
+
+			if (value != undecided) {
+				StoreValueOfPosition(pos, value);
+				CLEAR_REACHED(pos);
+				numDecided++;
+			}
+		}
+	} while (numDecided != 0 || numNew != 0);
+
+	/* nothing left can be decided, so these are draws */
+	for (pos = lowSeen; pos <= highSeen; pos++)
+		if (REACHED(pos))
+			StoreValueOfPosition(pos, tie);
+
+	SafeFree(voReached);
+	SafeFree(children);
+	SafeFree(moves);
+
+	return GetValueOfPosition(position);
+}
@@ -0,0 +1,6 @@
+#ifndef GMCORE_SOLVEVALUEONLY_H
+#define GMCORE_SOLVEVALUEONLY_H
+
+VALUE   DetermineValueOnly      (POSITION position);
+
+#endif /* GMCORE_SOLVEVALUEONLY_H */
@@ -1,11 +1,16 @@
 #include "solveweakab.h"
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 /* INFINITY can sometimes already be defined in math.h. */
 #ifdef INFINITY
 #undef INFINITY
 #endif
 
-#define INFINITY (gMaxRemoteness + 1)
+#define INFINITY (ab_max_remoteness + 1)
+
+REMOTENESS ab_max_remoteness;          /* gMaxRemoteness, or a default if the game has none */
 
 /*
    Function: invert_score
@@ -16,7 +21,7 @@
     max_remoteness - maximum remoteness (determines range scores for win/lose/tie)
 
  */
-int ctra = 0;
+long long ctra = 0;
 
 SCORE invert_score(SCORE score, REMOTENESS max_remoteness) {
 
@@ -29,14 +34,14 @@ SCORE invert_score(SCORE score, REMOTENESS max_remoteness) {
    ALL DRAWS MUST BE 0 as there are no score symmetries
  */
 
+/* min_remoteness goes down by one per ply and is NOT clamped at 0: the
+   parent's score must be exactly the inverse of its best child's, or the
+   bounds handed down the tree (and kept in the table) would be off by one
+   past that depth. */
 SCORE generate_score(VALUE value, REMOTENESS remoteness, REMOTENESS min_remoteness, REMOTENESS max_remoteness) {
 
 	SCORE score;
 
-	/* Normalize minimum remoteness in case it goes below 0 */
-	if (min_remoteness < 0)
-		min_remoteness = 0;
-
 	switch(value) {
 
 	case win:
@@ -66,169 +71,369 @@ SCORE generate_score(VALUE value, REMOTENESS remoteness, REMOTENESS min_remotene
 
 }
 
+/* The transposition table. Besides the exact values in the DB, it keeps
+   what each search found out about a position: an exact score, or just a
+   lower or upper bound when the window cut it short, along with the best
+   move, which is tried first the next time around. Entries come in pairs:
+   the first one is only replaced by a deeper search, the second always.
 
+   With several workers the table is shared between their processes
+   without locks. An entry is three words written and read one at a time,
+   and the first holds the position XORed with the other two, so an entry
+   torn by two writers just doesn't match any position. */
 
-SCORE alpha_beta(POSITION position, SCORE alpha, SCORE beta, REMOTENESS min_remoteness, REMOTENESS max_remoteness) {
+#define AB_EMPTY 0
+#define AB_EXACT 1
+#define AB_LOWER 2
+#define AB_UPPER 3
 
-	VALUE value;
-	REMOTENESS remoteness;
-	MOVELIST *moves_list, *move_node;
-	POSITION child, best_child;
-	SCORE score, best_score;
-	BOOLEAN set = FALSE;
-	BOOLEAN run = FALSE;
+#define AB_COMPLETE INT_MAX     /* depth of a result that never hit the horizon */
 
-	if (alpha>=beta) {
+typedef struct ab_entry {
+	POSITION check;                 /* position ^ the other two words */
+	SCORE score;
+	MOVE best_move;
+	int depth;                      /* plies searched below the position */
+	short min_remoteness;           /* the score is relative to this */
+	unsigned char flag;
+	unsigned char remoteness;       /* of an exact score from a complete search */
+} AB_ENTRY;
+
+#define AB_ENTRY_WORDS (sizeof(AB_ENTRY) / sizeof(UINT64))
+
+AB_ENTRY *ab_table = NULL;
+POSITION ab_table_mask;                 /* buckets - 1 */
+int ab_table_hits = 0;
+BOOLEAN ab_table_shared = FALSE;
+
+void ab_table_init(BOOLEAN shared) {
+	POSITION entries = ((POSITION) gAlphaBetaTableMB << 20) / sizeof(AB_ENTRY), buckets = 1;
+	while (buckets * 4 <= entries)
+		buckets <<= 1;
+	ab_table_shared = shared;
+	if (shared) { // fresh anonymous pages are already zero
+		ab_table = (AB_ENTRY *) mmap(NULL, 2 * buckets * sizeof(AB_ENTRY), PROT_READ | PROT_WRITE,
+		                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (ab_table == MAP_FAILED) {
+			fprintf(stderr, "Error: couldn't map a shared alpha-beta table\n");
+			ExitStageRight();
+		}
+	} else {
+		ab_table = (AB_ENTRY *) SafeMalloc(2 * buckets * sizeof(AB_ENTRY));
+		memset(ab_table, 0, 2 * buckets * sizeof(AB_ENTRY));
+	}
+	ab_table_mask = buckets - 1;
+	ab_table_hits = 0;
+}
 
-		fprintf(stderr, "alpha_beta invoked with alpha=%d, beta=%d\n", alpha, beta);
+void ab_table_free() {
+	if (ab_table_shared)
+		munmap(ab_table, 2 * (ab_table_mask + 1) * sizeof(AB_ENTRY));
+	else SafeFree(ab_table);
+	ab_table = NULL;
+}
 
-	}
+AB_ENTRY *ab_table_bucket(POSITION position) {
+	return ab_table + 2 * (((position * 0x9E3779B97F4A7C15ULL) >> 17) & ab_table_mask);
+}
 
-	best_score = -INFINITY;
-	ctra++;
-	if (!(ctra & 0xFFFF)) {
-		printf("evaluated %d positions\n", ctra);
+void ab_entry_read(AB_ENTRY *slot, AB_ENTRY *entry) {
+	UINT64 words[AB_ENTRY_WORDS];
+	int i;
+	for (i = 0; i < AB_ENTRY_WORDS; i++)
+		words[i] = __atomic_load_n((UINT64 *) slot + i, __ATOMIC_RELAXED);
+	memcpy(entry, words, sizeof(AB_ENTRY));
+}
+
+void ab_entry_write(AB_ENTRY *slot, AB_ENTRY *entry) {
+	UINT64 words[AB_ENTRY_WORDS];
+	int i;
+	memcpy(words, entry, sizeof(AB_ENTRY));
+	for (i = 0; i < AB_ENTRY_WORDS; i++)
+		__atomic_store_n((UINT64 *) slot + i, words[i], __ATOMIC_RELAXED);
+}
+
+POSITION ab_entry_position(AB_ENTRY *entry) {
+	UINT64 *words = (UINT64 *) entry;
+	return words[0] ^ words[1] ^ words[2];
+}
+
+BOOLEAN ab_table_probe(POSITION position, REMOTENESS min_remoteness, AB_ENTRY *entry) {
+	AB_ENTRY *bucket = ab_table_bucket(position);
+	int i;
+	for (i = 0; i < 2; i++) {
+		ab_entry_read(&bucket[i], entry);
+		if (entry->flag != AB_EMPTY && ab_entry_position(entry) == position
+		    && entry->min_remoteness == min_remoteness)
+			return TRUE;
 	}
+	return FALSE;
+}
 
-	/* First examine if the game value of position is known already */
-	value = GetValueOfPosition(position);
+void ab_table_store(POSITION position, REMOTENESS min_remoteness, SCORE score, int flag, int depth,
+                    MOVE best_move, REMOTENESS remoteness) {
+	AB_ENTRY *bucket = ab_table_bucket(position), first, entry;
+	ab_entry_read(&bucket[0], &first);
+	memset(&entry, 0, sizeof(AB_ENTRY));
+	entry.score = score;
+	entry.best_move = best_move;
+	entry.depth = depth;
+	entry.min_remoteness = min_remoteness;
+	entry.flag = flag;
+	entry.remoteness = remoteness;
+	entry.check = 0;
+	entry.check = position ^ ab_entry_position(&entry);
+	if ((ab_entry_position(&first) == position && first.min_remoteness == min_remoteness)
+	    || first.flag == AB_EMPTY || depth >= first.depth)
+		ab_entry_write(&bucket[0], &entry);
+	else ab_entry_write(&bucket[1], &entry);
+}
 
-	/* If game value of position is known already */
-	if (value != undecided) {
+/* Children are searched in this order: the table's best move, then moves
+   to children the DB knows we beat (quickest first), children nobody
+   knows about yet, known ties, and last the children that beat us
+   (slowest first). Within a null window at or below 0 a tie is enough for
+   a cutoff, so then ties go before the unknown children. */
+typedef struct ab_child {
+	MOVE move;
+	POSITION position;
+	int order;
+} AB_CHILD;
+
+int ab_compare_children(const void *a, const void *b) {
+	return ((AB_CHILD *) a)->order - ((AB_CHILD *) b)->order;
+}
 
-		/* Extract remoteness of position */
-		remoteness = Remoteness(position);
+/* Workers other than the first each try the unknown children in their own
+   rotation, so that they don't all search the same subtree. */
+int ab_worker = 0;
+
+/* Where GenerateChildren puts a position's children before they are
+   copied out and sorted (one per process, like everything else here) */
+POSITION *ab_child_positions = NULL;
+MOVE *ab_child_moves = NULL;
+
+int ab_child_order(POSITION child, SCORE beta, int index) {
+	switch (GetValueOfPosition(child)) {
+	case lose: return Remoteness(child);
+	case tie: return (beta <= 0) ? REMOTENESS_MAX + 1 : 3 * REMOTENESS_MAX;
+	case win: return 5 * REMOTENESS_MAX - Remoteness(child);
+	default: return 2 * REMOTENESS_MAX + (ab_worker ? (index + 3 * ab_worker) % REMOTENESS_MAX : 0);
+	}
+}
 
+/* Puts an exact, complete score in the DB (and the shared table) */
+void ab_store_exact(POSITION position, SCORE score, REMOTENESS min_remoteness, REMOTENESS max_remoteness,
+                    REMOTENESS tie_remoteness) {
+	VALUE value;
+	REMOTENESS remoteness;
+	if (score > 0) {
+		value = win;
+		remoteness = max_remoteness + min_remoteness - score;
+	} else if (score < 0) {
+		value = lose;
+		remoteness = score + max_remoteness + min_remoteness;
+	} else {
+		value = tie;
+		remoteness = tie_remoteness;
 	}
-	/* If game value of position is not known yet */
-	else {
 
-		/* Check if the position is terminal and extract value */
-		value = Primitive(position);
+	/* Store remoteness of value in database */
+	SetRemoteness(position, remoteness);
 
-		/* If position is terminal (i.e. value can be determined directly) */
-		if (value != undecided) {
+	/* Store value of position in database */
+	StoreValueOfPosition(position, value);
 
-			/* Set remoteness as 0 (terminal position) */
-			remoteness = 0;
+	/* Other workers can't see this DB, so tell them through the table */
+	if (ab_table_shared)
+		ab_table_store(position, min_remoteness, score, AB_EXACT, AB_COMPLETE, 0, remoteness);
+}
 
-		}
-		/* If this position is non-terminal and has never been visited */
-		else {
+/* Positions searched by each worker, published every so often */
+long long *ab_nodes = NULL;
 
-			/* Generate possible moves from this position */
-			moves_list = GenerateMoves(position);
+/* Fail-soft negamax. depth is the number of plies left before the horizon,
+   where an unknown position scores as a tie; *complete says whether the
+   result held without ever reaching it. Only exact, complete results go
+   to the DB. */
+SCORE alpha_beta(POSITION position, SCORE alpha, SCORE beta, REMOTENESS min_remoteness, REMOTENESS max_remoteness,
+                 int depth, BOOLEAN *complete) {
 
-			if (moves_list == NULL) {
-				fprintf(stderr,"ERROR: empty move list\n");
-			}
+	VALUE value;
+	AB_CHILD *children;
+	AB_ENTRY entry;
+	BOOLEAN found;
+	MOVE best_move = 0;
+	SCORE score, best_score, alpha_in = alpha;
+	REMOTENESS tie_remoteness = REMOTENESS_MAX;
+	BOOLEAN child_complete;
+	int i, num_children, flag;
 
-			/* For every possible move until alpha >= beta */
-			for (move_node = moves_list;
-			     move_node != NULL && alpha < beta;
-			     move_node = move_node->next)
-			{
-				/*SCORE tempa, tempb;*/
-				run = TRUE;
+	if (alpha>=beta) {
 
-				/* Obtain position resulting from application of move */
-				child = DoMove(position, move_node->move);
+		fprintf(stderr, "alpha_beta invoked with alpha=%d, beta=%d\n", alpha, beta);
 
-				/* Normalize child position if symmetry handling is enabled */
-				if (gSymmetries) {
+	}
 
-					/* Normalize child position */
-					child = gCanonicalPosition(child);
+	*complete = TRUE;
+	ctra++;
+	if (!(ctra & 0xFFFF) && ab_worker == 0) {
+		printf("evaluated %lld positions\n", ctra);
+	}
+	if (ab_nodes != NULL && !(ctra & 0xFFF))
+		ab_nodes[ab_worker] = ctra;
 
-				}
+	/* First examine if the game value of position is known already */
+	value = GetValueOfPosition(position);
 
-				/* If position hash value is illegal, report error */
-				if (child >= gNumberOfPositions) {
+	/* If game value of position is known already */
+	if (value != undecided)
+		return generate_score(value, Remoteness(position), min_remoteness, max_remoteness);
 
-					/* Report bad position */
-					FoundBadPosition(child, position, move_node->move);
+	/* Check if the position is terminal and extract value */
+	value = Primitive(position);
 
-				}
+	/* If position is terminal (i.e. value can be determined directly) */
+	if (value != undecided) {
+		SetRemoteness(position, 0);
+		StoreValueOfPosition(position, value);
+		return generate_score(value, 0, min_remoteness, max_remoteness);
+	}
 
-				/* Run the alpha_beta algorithm on the child board with inverted alpha and beta */
-				score = invert_score(alpha_beta(child,
-				                                invert_score(beta, max_remoteness),
-				                                invert_score(alpha, max_remoteness),
-				                                min_remoteness - 1,
-				                                max_remoteness),
-				                     max_remoteness);
+	/* Past the horizon, nothing is known */
+	if (depth == 0) {
+		*complete = FALSE;
+		return 0;
+	}
 
-				if (score > best_score) {
+	/* Use what an earlier search left in the table. The first worker
+	   works out ties found by the others again, so that the remoteness of
+	   a tie never comes from another worker's search. */
+	if ((found = ab_table_probe(position, min_remoteness, &entry))) {
+		best_move = entry.best_move;
+		if (entry.depth >= depth
+		    && !(ab_worker == 0 && entry.flag == AB_EXACT && entry.score == 0 && entry.depth == AB_COMPLETE)
+		    && (entry.flag == AB_EXACT
+		        || (entry.flag == AB_LOWER && entry.score >= beta)
+		        || (entry.flag == AB_UPPER && entry.score <= alpha))) {
+			ab_table_hits++;
+			*complete = (entry.depth == AB_COMPLETE);
+			if (entry.flag == AB_EXACT && *complete) // solved by another worker
+				ab_store_exact(position, entry.score, min_remoteness, max_remoteness, entry.remoteness);
+			return entry.score;
+		}
+	}
 
-					best_score = score;
-					best_child = child;
-					set = TRUE;
+	/* Generate possible moves from this position */
+	if (ab_child_positions == NULL) {
+		ab_child_positions = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+		ab_child_moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+	}
+	num_children = GenerateChildren(position, ab_child_positions, ab_child_moves);
 
-					/* If inverse of min score exceeds alpha */
-					if (best_score > alpha) {
+	if (num_children == 0) {
+		fprintf(stderr,"ERROR: empty move list\n");
+		return 0;
+	}
 
-						/* Replace alpha with inverse of min score */
-						alpha = best_score;
+	children = (AB_CHILD *) SafeMalloc(num_children * sizeof(AB_CHILD));
+	for (i = 0; i < num_children; i++) {
+		children[i].move = ab_child_moves[i];
+		children[i].position = ab_child_positions[i];
+		if (gSymmetries)
+			children[i].position = gCanonicalPosition(children[i].position);
+		children[i].order = (found && children[i].move == entry.best_move)
+		                    ? -1 : ab_child_order(children[i].position, beta, i);
+	}
+	qsort(children, num_children, sizeof(AB_CHILD), ab_compare_children);
 
-					}
+	best_score = -INFINITY;
 
-				}
+	/* For every possible move until alpha >= beta */
+	for (i = 0; i < num_children && alpha < beta; i++) {
 
-				/* Undo move for efficiency if GPS is enabled */
-				if (gUseGPS)
-					gUndoMove(move_node->move);
+		/* Obtain position resulting from application of move */
+		if (gUseGPS)
+			DoMove(position, children[i].move);
 
-			}
+		/* If position hash value is illegal, report error */
+		if (children[i].position >= gNumberOfPositions) {
 
-			/* Deallocate list of moves */
-			FreeMoveList(moves_list);
+			/* Report bad position */
+			FoundBadPosition(children[i].position, position, children[i].move);
 
-			/* Set value of position to depending on value of best child */
-			switch (GetValueOfPosition(best_child)) {
+		}
 
-			case win:
-				/* If child's can force win, this board's value is lose */
-				value = lose;
-				break;
-			case lose:
-				/* If child can't do better than lose, this board's value is win */
-				value = win;
-				break;
-			case tie:
-				/* If child's value is tie, this board's value is tie */
-				value = tie;
-				break;
-			case undecided:
-				break;
+		/* Run the alpha_beta algorithm on the child board with inverted alpha and beta */
+		score = invert_score(alpha_beta(children[i].position,
+		                                invert_score(beta, max_remoteness),
+		                                invert_score(alpha, max_remoteness),
+		                                min_remoteness - 1,
+		                                max_remoteness,
+		                                (depth == AB_COMPLETE) ? depth : depth - 1,
+		                                &child_complete),
+		                     max_remoteness);
+		if (!child_complete)
+			*complete = FALSE;
+
+		/* Tiers want to mate now: every child's score is exact while 0 is
+		   inside the window, so this is the least remoteness of all the
+		   tying children, whatever order they were searched in */
+		else if (score == 0 && Remoteness(children[i].position) < tie_remoteness)
+			tie_remoteness = Remoteness(children[i].position);
+
+		if (score > best_score) {
+
+			best_score = score;
+			best_move = children[i].move;
+
+			/* If inverse of min score exceeds alpha */
+			if (best_score > alpha) {
+
+				/* Replace alpha with inverse of min score, but keep 0
+				   inside the window while the best is a tie, so the
+				   other tying children are told apart too */
+				alpha = (best_score == 0 && alpha_in < 0 && beta > 0) ? -1 : best_score;
 
 			}
 
-			/* Set remoteness of position value to one more than that of chosen child */
-			remoteness = Remoteness(best_child) + 1;
-
 		}
 
-		/* Store remoteness of value in database */
-		SetRemoteness(position, remoteness);
-
-		/* Store value of position in database */
-		StoreValueOfPosition(position, value);
+		/* Undo move for efficiency if GPS is enabled */
+		if (gUseGPS)
+			gUndoMove(children[i].move);
 
 	}
 
-	/* Generate score for this board */
-	return generate_score(value, remoteness, min_remoteness, max_remoteness);
+	SafeFree(children);
+
+	if (best_score <= alpha_in)
+		flag = AB_UPPER;
+	else if (best_score >= beta)
+		flag = AB_LOWER;
+	else flag = AB_EXACT;
+
+	/* An exact score from the whole subtree is the position's real value */
+	if (flag == AB_EXACT && *complete)
+		ab_store_exact(position, best_score, min_remoteness, max_remoteness,
+		               (best_score == 0) ? tie_remoteness + 1 : 0);
+	else ab_table_store(position, min_remoteness, best_score, flag, (*complete ? AB_COMPLETE : depth), best_move, 0);
+
+	return best_score;
 
 }
 
-SCORE MTD(POSITION position, SCORE score) {
+SCORE MTD(POSITION position, SCORE score, int depth, BOOLEAN *complete) {
 
 	SCORE upperbound, lowerbound, beta;
+	BOOLEAN run_complete;
 
 	upperbound = +INFINITY;
 	lowerbound = -INFINITY;
 	int counter = 1;
 
+	*complete = TRUE;
+
 	/* Repeat until zeroed in on score */
 	do {
 		/* beta is a *valid* version of the approximate score
@@ -238,12 +443,17 @@ SCORE MTD(POSITION position, SCORE score) {
 		 */
 		beta = (lowerbound == score) ? score + 1 : score;
 
-		printf("Alpha-beta run #%d alpha=%d, beta=%d\n", counter, beta - 1, beta);
+		if (ab_worker == 0)
+			printf("Alpha-beta run #%d alpha=%d, beta=%d\n", counter, beta - 1, beta);
 
 		/* Run the alpha-beta pruning minimax search with alpha = beta - 1 */
-		score = alpha_beta(position, beta - 1, beta, gMinRemoteness, gMaxRemoteness);
+		score = alpha_beta(position, beta - 1, beta, gMinRemoteness, ab_max_remoteness, depth, &run_complete);
+		if (!run_complete)
+			*complete = FALSE;
 
-		printf("Score obtained in alpha-beta run #%d is %d\n", counter++, score);
+		if (ab_worker == 0)
+			printf("Score obtained in alpha-beta run #%d is %d\n", counter, score);
+		counter++;
 
 		/* If score is less than beta, change upperbound to equal score */
 		if (score < beta) {
@@ -260,16 +470,105 @@ SCORE MTD(POSITION position, SCORE score) {
 }
 
 
+/* Iterative deepening: MTD is run with the horizon one ply further out
+   each time, starting from the last score, until a run never reaches the
+   horizon. The shallow runs are cheap and leave the best moves in the
+   table, so the deeper ones mostly search good moves first. */
+SCORE ab_deepen(POSITION position, int depth) {
+
+	SCORE score = -INFINITY;
+	BOOLEAN complete = FALSE;
+
+	for (; !complete; depth++) {
+		if (depth > ab_max_remoteness)
+			depth = AB_COMPLETE;
+		if (ab_worker == 0)
+			printf("Searching to remoteness %d\n", depth);
+		score = MTD(position, score, depth, &complete);
+		if (depth == AB_COMPLETE)
+			break;
+	}
+
+	/* The null windows may have left the root itself as a bound only */
+	if (GetValueOfPosition(position) == undecided)
+		alpha_beta(position, score - 1, score + 1, gMinRemoteness, ab_max_remoteness, AB_COMPLETE, &complete);
+	return score;
+
+}
+
+
+/* With gSolverWorkers > 1 the search is run Lazy SMP style: every worker
+   runs the same iterative deepening, some a ply ahead and each in its own
+   move order, and they only talk through the shared table. Workers are
+   processes since the modules keep their state in globals. This process
+   is the first worker and its answer is the one used; the others are
+   killed once it has it. */
 VALUE DetermineValueAlphaBeta(POSITION position) {
 
+	int workers = gSolverWorkers, started, i, status;
+	pid_t *pids = NULL;
+	struct timeval begin, end;
+	double seconds;
+	long long total;
+
+	/* Games that don't give a bound get the largest remoteness there is */
+	ab_max_remoteness = (gMaxRemoteness > 0) ? gMaxRemoteness : REMOTENESS_MAX;
+
 	printf("starting alpha_beta with alpha = %d, beta = %d, min_remoteness = %d, max_remoteness = %d\n",
 	       -INFINITY,
 	       +INFINITY,
 	       gMinRemoteness,
-	       gMaxRemoteness);
+	       ab_max_remoteness);
+
+	gettimeofday(&begin, NULL);
+	ab_table_init(workers > 1);
+	if (workers > 1) {
+		ab_nodes = (long long *) mmap(NULL, workers * sizeof(long long), PROT_READ | PROT_WRITE,
+		                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (ab_nodes == MAP_FAILED) {
+			fprintf(stderr, "Error: couldn't map the alpha-beta node counters\n");
+			ExitStageRight();
+		}
+		memset(ab_nodes, 0, workers * sizeof(long long));
+		pids = (pid_t *) SafeMalloc(workers * sizeof(pid_t));
+		printf("Searching with %d workers\n", workers);
+		fflush(stdout); fflush(stderr);
+		for (started = 1; started < workers; started++) {
+			pids[started] = fork();
+			if (pids[started] == 0) { // helper: search until killed
+				ab_worker = started;
+				ab_deepen(position, 1 + started % 2);
+				ab_nodes[ab_worker] = ctra;
+				fflush(stdout);
+				_exit(0);
+			} else if (pids[started] < 0) {
+				printf("WARNING: Could only start %d of %d workers\n", started, workers);
+				break;
+			}
+		}
+	}
+
+	ab_deepen(position, 1);
+
+	total = ctra;
+	if (workers > 1) {
+		for (i = 1; i < started; i++) {
+			kill(pids[i], SIGKILL);
+			waitpid(pids[i], &status, 0);
+		}
+		for (i = 1; i < started; i++)
+			total += ab_nodes[i];
+		munmap(ab_nodes, workers * sizeof(long long));
+		ab_nodes = NULL;
+		SafeFree(pids);
+	}
+	gettimeofday(&end, NULL);
+	seconds = (end.tv_sec - begin.tv_sec) + (end.tv_usec - begin.tv_usec) / 1e6;
 
-	MTD(position, -INFINITY);
-	//alpha_beta(position, -INFINITY, +INFINITY, gMinRemoteness, gMaxRemoteness);
+	printf("evaluated %lld positions, %d table cutoffs\n", ctra, ab_table_hits);
+	printf("%lld positions in all workers in %.2f seconds (%.0f positions/sec)\n",
+	       total, seconds, (seconds > 0) ? total / seconds : 0.0);
+	ab_table_free();
 	return GetValueOfPosition(position);
 
 }
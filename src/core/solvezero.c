@@ -83,7 +83,9 @@ VALUE DetermineZeroValue(POSITION position)
 {
 	POSITION i,lowSeen,highSeen;
 	POSITION numUndecided, oldNumUndecided, numNew;
-	MOVELIST *moveptr, *headMove;
+	POSITION *children = (POSITION *) SafeMalloc(MAXFANOUT * sizeof(POSITION));
+	MOVE *moves = (MOVE *) SafeMalloc(MAXFANOUT * sizeof(MOVE));
+	int c, numChildren;
 	POSITION child;
 	VALUE childValue;
 	POSITION numTot, numWin, numTie;
@@ -109,11 +111,11 @@ VALUE DetermineZeroValue(POSITION position)
 		for(i = lowSeen; i <= highSeen; i++) {
 			if(Visited(i)) {
 				if(GetValueOfPosition(i) == undecided) {
-					moveptr = headMove = GenerateMoves(i);
+					numChildren = GenerateChildren(i, children, moves);
 					numTot = numWin = numTie = 0;
 					tieRemoteness = winRemoteness = REMOTENESS_MAX;
-					while(moveptr != NULL) {
-						child = DoMove(i,moveptr->move);
+					for(c = 0; c < numChildren; c++) {
+						child = children[c];
 						numTot++;
 						if(Visited(child))
 							childValue = GetValueOfPosition(child);
@@ -147,10 +149,7 @@ VALUE DetermineZeroValue(POSITION position)
 								tieRemoteness = Remoteness(child);
 							}
 						}
-
-						moveptr = moveptr->next;
 					}
-					FreeMoveList(headMove);
 					if((numTot != 0) && (numTot == numWin + numTie)) {
 						if(numTie == 0) {
 							SetRemoteness(i, winRemoteness+1);
@@ -180,6 +179,8 @@ VALUE DetermineZeroValue(POSITION position)
 		}
 		UnMarkAsVisited(i);
 	}
+	SafeFree(children);
+	SafeFree(moves);
 
 	return GetValueOfPosition(position);
 }
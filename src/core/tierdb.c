@@ -39,6 +39,7 @@
 
 #include <zlib.h>
 #include <netinet/in.h>
+#include <sys/mman.h>
 #include "gamesman.h"
 #include "tierdb.h"
 
@@ -46,8 +47,28 @@
 
 #define tierdb_FILEVER 1
 
+/* Version 2 files are uncompressed: a header, then the cells in the byte
+   order of the machine that wrote them, starting at dataOffset. That lets
+   a finished tier be mmap'd instead of read in. Version 1 files (gzip'd,
+   one network-order cell after another) are still read. */
+#define tierdb_RAWVER 2
+#define tierdb_MAGIC "GMTIERDB"
+#define tierdb_BYTEORDER 0x0102
+#define tierdb_IOCELLS (1 << 16) // cells per read/write on the gzip'd files
+#define tierdb_DATAOFFSET 64     // where the cells start in a version 2 file
+
 typedef short tierdb_cellValue;
 
+typedef struct tierdb_header {
+	char magic[8];
+	unsigned short version;
+	unsigned short byteOrder;   // tierdb_BYTEORDER as the writer saw it
+	unsigned short cellSize;
+	unsigned short reserved;
+	unsigned long long numPos;
+	unsigned long long dataOffset;
+} TIERDB_HEADER;
+
 BOOLEAN tierdb_dirty;
 POSITION tierdb_CurrentPosition;
 tierdb_cellValue tierdb_CurrentValue;
@@ -76,6 +97,11 @@ MEX             tierdb_get_mex                  (POSITION pos);
 MEX             tierdb_get_mex_file             (POSITION pos);
 void            tierdb_set_mex                  (POSITION pos, MEX mex);
 
+/* Bulk */
+void            tierdb_get_bulk_data            (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void            tierdb_put_bulk_data            (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void            tierdb_get_range_data           (POSITION start, int length, VALUE* values, REMOTENESS* remotenesses);
+
 /* saving to/reading from a file */
 BOOLEAN         tierdb_save_database            ();
 BOOLEAN         tierdb_load_database            ();
@@ -83,8 +109,51 @@ BOOLEAN         tierdb_load_database            ();
 tierdb_cellValue*       (*tierdb_get_raw)(POSITION pos);
 
 tierdb_cellValue*       tierdb_get_raw_ptr              (POSITION pos);
+tierdb_cellValue*       tierdb_get_raw_mapped           (POSITION pos);
+int                     tierdb_segment_of               (POSITION pos);
 
 tierdb_cellValue*       tierdb_array;
+POSITION tierdb_arraySize = 0;
+BOOLEAN tierdb_shared = FALSE; /* TRUE iff tierdb_array is a shared mapping */
+
+/* Tiers of the hash window whose cells live in the tier cache rather
+   than in tierdb_array; tierdb_segment[i] is NULL for the others. */
+int tierdb_numSegments = 0;
+tierdb_cellValue**      tierdb_segment = NULL;
+
+/* When playing or querying, finished tiers are kept in an LRU cache across
+   hash windows, so moving back to a recently used tier doesn't load it
+   again. Each entry is a mapping of the tier's version 2 file, or the
+   cells read from its file if it couldn't be mapped. Entries in the current
+   window are pinned; the others are dropped, least recently used first,
+   once the cache holds more than gTierCacheMB megabytes. A pinned entry
+   whose tier is solved again is marked stale, never found again, and
+   dropped as soon as the window lets go of it. */
+typedef struct tierdb_cache_entry {
+	TIER tier;
+	int variant;
+	tierdb_cellValue* cells;
+	void* mapBase;              // NULL if cells was malloc'd
+	size_t bytes;
+	BOOLEAN pinned;
+	BOOLEAN stale;              // the tier's file was written since
+	struct tierdb_cache_entry *prev, *next;
+} TIERDB_CACHE_ENTRY;
+
+TIERDB_CACHE_ENTRY *tierdb_cacheFront = NULL, *tierdb_cacheBack = NULL; // most to least recently used
+size_t tierdb_cacheBytes = 0;
+
+BOOLEAN         tierdb_save_raw                 ();
+BOOLEAN         tierdb_save_gz                  (POSITION start, POSITION finish);
+int             tierdb_open_raw                 (TIER tier, int variant, TIERDB_HEADER* header, BOOLEAN* swapped, int* fd);
+int             tierdb_load_raw                 (TIER tier, tierdb_cellValue* cells, TIERDB_CACHE_ENTRY* entry);
+int             tierdb_load_gz                  (TIER tier, tierdb_cellValue* cells, POSITION numPos);
+void            tierdb_free_segments            ();
+int             tierdb_cache_get                (TIER tier, tierdb_cellValue** cells);
+void            tierdb_cache_trim               ();
+void            tierdb_cache_unlink             (TIERDB_CACHE_ENTRY* entry);
+void            tierdb_cache_drop               (TIER tier);
+void            tierdb_cache_free_entry         (TIERDB_CACHE_ENTRY* entry);
 
 char tierdb_outfilename[80];
 gzFile         tierdb_filep;
@@ -102,10 +171,22 @@ void tierdb_init(DB_Table *new_db)
 	tierdb_get_raw = tierdb_get_raw_ptr;
 
 	//setup internal memory table
-	tierdb_array = (tierdb_cellValue *) SafeMalloc (gNumberOfPositions * sizeof(tierdb_cellValue));
+	//it is an anonymous mapping, so pages of tiers that end up mmap'd from
+	//their files are never touched. With parallel workers it is shared so
+	//that forked workers can write their part of the tier straight into it
+	tierdb_shared = (gSolverWorkers > 1);
+	tierdb_arraySize = (gNumberOfPositions > 0) ? gNumberOfPositions : 1;
+	tierdb_array = (tierdb_cellValue *) mmap(NULL, tierdb_arraySize * sizeof(tierdb_cellValue),
+	                                         PROT_READ | PROT_WRITE,
+	                                         (tierdb_shared ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS, -1, 0);
+	if (tierdb_array == MAP_FAILED) {
+		fprintf(stderr, "Error: tierdb could not map %llu positions\n", gNumberOfPositions);
+		ExitStageRight();
+	}
 
-	for(i = 0; i< gNumberOfPositions; i++)
-		tierdb_array[i] = undecided;
+	if (undecided != 0) // fresh anonymous pages are already zero
+		for(i = 0; i< gNumberOfPositions; i++)
+			tierdb_array[i] = undecided;
 
 	new_db->put_value = tierdb_set_value;
 	new_db->put_remoteness = tierdb_set_remoteness;
@@ -118,14 +199,75 @@ void tierdb_init(DB_Table *new_db)
 	new_db->get_remoteness = tierdb_get_remoteness;
 	new_db->check_visited = tierdb_check_visited;
 	new_db->get_mex = tierdb_get_mex;
+	new_db->get_bulk_data = tierdb_get_bulk_data;
+	new_db->put_bulk_data = tierdb_put_bulk_data;
+	new_db->get_range_data = tierdb_get_range_data;
 	new_db->save_database = tierdb_save_database;
 	new_db->load_database = tierdb_load_database;
 }
 
 void tierdb_free()
 {
+	tierdb_free_segments();
 	if(tierdb_array)
-		SafeFree(tierdb_array);
+		munmap(tierdb_array, tierdb_arraySize * sizeof(tierdb_cellValue));
+	tierdb_array = NULL;
+	tierdb_arraySize = 0;
+	tierdb_shared = FALSE;
+}
+
+/* Forgets the window's segments; the tiers stay in the cache, unpinned,
+   except stale ones */
+void tierdb_free_segments()
+{
+	TIERDB_CACHE_ENTRY *entry, *next;
+	for (entry = tierdb_cacheFront; entry != NULL; entry = next) {
+		next = entry->next;
+		entry->pinned = FALSE;
+		if (entry->stale)
+			tierdb_cache_free_entry(entry);
+	}
+	if (tierdb_segment != NULL) SafeFree(tierdb_segment);
+	tierdb_segment = NULL;
+	tierdb_numSegments = 0;
+	tierdb_get_raw = tierdb_get_raw_ptr;
+}
+
+/* TRUE iff the current table is visible to processes forked from now on */
+BOOLEAN tierdb_is_shared()
+{
+	return (tierdb_array != NULL && tierdb_shared);
+}
+
+/* Writes the cells of positions [start, finish) of the current tier to fp
+   as they are in memory, for the tier solver's checkpoints */
+BOOLEAN tierdb_write_cells(FILE* fp, POSITION start, POSITION finish)
+{
+	tierdb_cellValue* cells = tierdb_get_raw(0); // the current tier is contiguous
+	POSITION n;
+
+	for (; start < finish; start += n) {
+		n = finish - start;
+		if (n > tierdb_IOCELLS * 64) n = tierdb_IOCELLS * 64;
+		if (fwrite(cells + start, sizeof(tierdb_cellValue), n, fp) != n)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* Reads back cells written by tierdb_write_cells */
+BOOLEAN tierdb_read_cells(FILE* fp, POSITION start, POSITION finish)
+{
+	tierdb_cellValue* cells = tierdb_get_raw(0);
+	POSITION n;
+
+	for (; start < finish; start += n) {
+		n = finish - start;
+		if (n > tierdb_IOCELLS * 64) n = tierdb_IOCELLS * 64;
+		if (fread(cells + start, sizeof(tierdb_cellValue), n, fp) != n)
+			return FALSE;
+	}
+	return TRUE;
 }
 
 void tierdb_close_file()
@@ -138,6 +280,30 @@ tierdb_cellValue* tierdb_get_raw_ptr(POSITION pos)
 	return (&tierdb_array[pos]);
 }
 
+/* The segment pos is in: the first i with pos < gMaxPosOffset[i], found
+   by a binary search since windows can hold hundreds of tiers. */
+int tierdb_segment_of(POSITION pos)
+{
+	int lo = 1, hi = tierdb_numSegments - 1, mid;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (pos < gMaxPosOffset[mid])
+			hi = mid;
+		else lo = mid + 1;
+	}
+	return lo;
+}
+
+/* Used once some tier of the window is mmap'd. The mapping is private,
+   so cells can still be changed in memory without touching the file. */
+tierdb_cellValue* tierdb_get_raw_mapped(POSITION pos)
+{
+	int i = tierdb_segment_of(pos);
+	if (tierdb_segment[i] != NULL)
+		return (&tierdb_segment[i][pos - gMaxPosOffset[i-1]]);
+	return (&tierdb_array[pos]);
+}
+
 VALUE tierdb_set_value(POSITION pos, VALUE val)
 {
 	tierdb_cellValue *ptr;
@@ -234,6 +400,65 @@ MEX tierdb_get_mex(POSITION pos)
 	return (MEX)(((int)*ptr & MEX_MASK) >> MEX_SHIFT);
 }
 
+/* Each cell is read once for all of the fields asked for. Unless some of
+   the window is mapped, children's cells are prefetched before the first
+   one is read. tierdb keeps no WinBy, so those are 0. */
+void tierdb_get_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i;
+
+	if (tierdb_get_raw == tierdb_get_raw_ptr)
+		for (i = 0; i < length; i++)
+			__builtin_prefetch(&tierdb_array[positions[i]]);
+	for (i = 0; i < length; i++) {
+		db_unpack_cell(*tierdb_get_raw(positions[i]), i, values, remotenesses, mexes);
+		if (winbys != NULL)
+			winbys[i] = 0;
+	}
+}
+
+/* Straight runs over the cells, a segment at a time. Nothing is written,
+   so threads can each read their own range of the tiers in the window. */
+void tierdb_get_range_data(POSITION start, int length, VALUE* values, REMOTENESS* remotenesses)
+{
+	tierdb_cellValue *cells;
+	POSITION end = start + length, runEnd;
+	int i, seg;
+
+	while (start < end) {
+		runEnd = end;
+		if (tierdb_get_raw == tierdb_get_raw_mapped) {
+			seg = tierdb_segment_of(start);
+			if (seg < tierdb_numSegments - 1 && gMaxPosOffset[seg] < runEnd)
+				runEnd = gMaxPosOffset[seg];
+		}
+		cells = tierdb_get_raw(start);
+		for (i = 0; i < (int) (runEnd - start); i++) {
+			values[i] = (VALUE)(cells[i] & VALUE_MASK);
+			remotenesses[i] = (REMOTENESS)((cells[i] & REMOTENESS_MASK) >> REMOTENESS_SHIFT);
+		}
+		values += i;
+		remotenesses += i;
+		start = runEnd;
+	}
+}
+
+void tierdb_put_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i;
+	tierdb_cellValue *ptr;
+
+	for (i = 0; i < length; i++) {
+		if (remotenesses != NULL && remotenesses[i] > REMOTENESS_MAX) {
+			printf("Remoteness request (%d) for " POSITION_FORMAT  " larger than Max Remoteness (%d)\n",remotenesses[i],positions[i],REMOTENESS_MAX);
+			ExitStageRight();
+			exit(0);
+		}
+		ptr = tierdb_get_raw(positions[i]);
+		*ptr = (tierdb_cellValue) db_pack_cell(*ptr, i, values, remotenesses, mexes);
+	}
+}
+
 
 /***********
  ************
@@ -241,7 +466,10 @@ MEX tierdb_get_mex(POSITION pos)
  **
  **	Name: saveDatabase()
  **
- **	Description: writes tierdb to a compressed file in gzip format.
+ **	Description: writes the current tier of tierdb to its file. A whole
+ **	             tier goes to an uncompressed version 2 file with a few
+ **	             large writes; a partial tier (from gDBTierStart to
+ **	             gDBTierEnd) goes to a gzip'd version 1 minitierdb.
  **
  **	Inputs: none
  **
@@ -252,8 +480,9 @@ MEX tierdb_get_mex(POSITION pos)
  **		gzclose
  **		gzwrite
  **		(In std libraries)
- **		htonl
- **		ntohl
+ **		htons
+ **		fwrite
+ **		rename
  **
  **	Requirements:	tierdb_array contains a valid database of positions
  **			gNumberOfPositions stores the correct number of positions in tierdb_array
@@ -269,12 +498,8 @@ BOOLEAN tierdb_save_database ()
 	if(!gHashWindowInitialized)
 		return FALSE;
 
-	unsigned long i;
-	tierdb_goodCompression = 1;
-	tierdb_goodClose = 0;
-	POSITION tot = 0,sTot = gCurrentTierSize;
-
 	POSITION start = 0, finish = gCurrentTierSize;
+	BOOLEAN partial = FALSE;
 
 	if(!tierdb_array)
 		return FALSE;
@@ -288,14 +513,85 @@ BOOLEAN tierdb_save_database ()
 		        tierdb_outfilename, kDBName, getOption(), gCurrentTier, gDBTierStart, gDBTierEnd);
 		start = gDBTierStart;
 		finish = gDBTierEnd;
+		partial = TRUE;
 		// reset the vars
 		gDBTierStart = gDBTierEnd = -1;
 	} else {
-		sprintf(tierdb_outfilename, "%s/m%s_%d_%llu_tierdb.dat.gz",
+		sprintf(tierdb_outfilename, "%s/m%s_%d_%llu_tierdb.dat",
 		        tierdb_outfilename, kDBName, getOption(), gCurrentTier);
 	}
 
-	if((tierdb_filep = gzopen(tierdb_outfilename, "wb")) == NULL) {
+	if (partial)
+		return tierdb_save_gz(start, finish);
+	tierdb_cache_drop(gCurrentTier); // in case it was cached from an earlier solve
+	return tierdb_save_raw();
+}
+
+/* Writes all of the current tier as a version 2 file. It is written under
+   a temporary name and renamed, so a crash never leaves half a tier. */
+BOOLEAN tierdb_save_raw()
+{
+	char tmpfilename[100];
+	TIERDB_HEADER header;
+	char padding[tierdb_DATAOFFSET - sizeof(TIERDB_HEADER)];
+	tierdb_cellValue* cells = tierdb_get_raw(0); // the current tier is contiguous
+	POSITION written = 0, n;
+	FILE* filep;
+	BOOLEAN good;
+
+	sprintf(tmpfilename, "%s.tmp", tierdb_outfilename);
+	if((filep = fopen(tmpfilename, "wb")) == NULL) {
+		if(kDebugDetermineValue) {
+			printf("Unable to create data file\n");
+		}
+		return FALSE;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, tierdb_MAGIC, sizeof(header.magic));
+	header.version = tierdb_RAWVER;
+	header.byteOrder = tierdb_BYTEORDER;
+	header.cellSize = sizeof(tierdb_cellValue);
+	header.numPos = gCurrentTierSize;
+	header.dataOffset = tierdb_DATAOFFSET;
+	memset(padding, 0, sizeof(padding));
+	good = (fwrite(&header, sizeof(header), 1, filep) == 1 &&
+	        fwrite(padding, sizeof(padding), 1, filep) == 1);
+	while (good && written < gCurrentTierSize) {
+		n = gCurrentTierSize - written;
+		if (n > tierdb_IOCELLS * 64) n = tierdb_IOCELLS * 64;
+		good = (fwrite(cells + written, sizeof(tierdb_cellValue), n, filep) == n);
+		written += n;
+	}
+	good = (fclose(filep) == 0) && good;
+
+	if(good && rename(tmpfilename, tierdb_outfilename) == 0) {
+		if(kDebugDetermineValue && !gJustSolving) {
+			printf("File Successfully written\n");
+		}
+		return TRUE;
+	} else {
+		if(kDebugDetermineValue) {
+			fprintf(stderr, "\nError writing %s: " POSITION_FORMAT " of " POSITION_FORMAT " positions written\n",
+			        tierdb_outfilename, written, gCurrentTierSize);
+		}
+		remove(tmpfilename);
+		return FALSE;
+	}
+}
+
+/* Writes positions [start, finish) of the current tier as a version 1 file,
+   also under a temporary name, so a minitierdb on disk is always complete */
+BOOLEAN tierdb_save_gz(POSITION start, POSITION finish)
+{
+	char tmpfilename[100];
+	tierdb_cellValue* cells = tierdb_get_raw(0);
+	tierdb_cellValue* buffer;
+	POSITION i, j, n, tot = 0;
+
+	tierdb_goodCompression = 1;
+	tierdb_goodClose = 0;
+	sprintf(tmpfilename, "%s.tmp", tierdb_outfilename);
+	if((tierdb_filep = gzopen(tmpfilename, "wb")) == NULL) {
 		if(kDebugDetermineValue) {
 			printf("Unable to create compressed data file\n");
 		}
@@ -306,34 +602,40 @@ BOOLEAN tierdb_save_database ()
 	tierdb_numPos[0] = htonl(gMaxPosOffset[1]);
 	tierdb_goodCompression = gzwrite(tierdb_filep, tierdb_dbVer, sizeof(short));
 	tierdb_goodCompression = gzwrite(tierdb_filep, tierdb_numPos, sizeof(POSITION));
-	for(i=start; i<finish && tierdb_goodCompression; i++) { //convert to network byteorder for platform independence.
-		tierdb_array[i] = htons(tierdb_array[i]);
-		tierdb_goodCompression = gzwrite(tierdb_filep, tierdb_array+i, sizeof(tierdb_cellValue));
+	buffer = (tierdb_cellValue*) SafeMalloc(tierdb_IOCELLS * sizeof(tierdb_cellValue));
+	for(i=start; i<finish && tierdb_goodCompression; i+=n) { //convert to network byteorder for platform independence.
+		n = (finish - i < tierdb_IOCELLS) ? finish - i : tierdb_IOCELLS;
+		for (j = 0; j < n; j++)
+			buffer[j] = htons(cells[i+j]);
+		tierdb_goodCompression = gzwrite(tierdb_filep, buffer, n * sizeof(tierdb_cellValue));
 		tot += tierdb_goodCompression;
-		tierdb_array[i] = ntohs(tierdb_array[i]);
-		//gzflush(tierdb_filep,Z_FULL_FLUSH);
 	}
+	SafeFree(buffer);
 	tierdb_goodClose = gzclose(tierdb_filep);
 
-	if(tierdb_goodCompression && (tierdb_goodClose == 0)) {
+	if(tierdb_goodCompression && (tierdb_goodClose == 0)
+	   && rename(tmpfilename, tierdb_outfilename) == 0) {
 		if(kDebugDetermineValue && !gJustSolving) {
 			printf("File Successfully compressed\n");
 		}
 		return TRUE;
 	} else {
 		if(kDebugDetermineValue) {
-			fprintf(stderr, "\nError in file compression.\n Error codes:\ngzwrite error: %d\ngzclose error:%d\nBytes To Be Written: " POSITION_FORMAT "\nBytes Written: " POSITION_FORMAT "\n",tierdb_goodCompression, tierdb_goodClose,sTot*4,tot);
+			fprintf(stderr, "\nError in file compression.\n Error codes:\ngzwrite error: %d\ngzclose error:%d\nBytes To Be Written: " POSITION_FORMAT "\nBytes Written: " POSITION_FORMAT "\n",tierdb_goodCompression, tierdb_goodClose,(finish-start)*sizeof(tierdb_cellValue),tot);
 		}
-		remove (tierdb_outfilename);
+		remove (tmpfilename);
 		return FALSE;
 	}
-
 }
 
 /*
 **	Name: loadDatabase()
 **
-**	Description: loads the compressed file in gzip format into tierdb_array.
+**	Description: loads the tiers of the hash window. When every tier
+**	             comes from its file (playing or querying rather than
+**	             solving) they are taken from the tier cache, loading the
+**	             ones that aren't there yet. Otherwise they are read into
+**	             tierdb_array, from a version 2 file if there is one.
 **
 **	Inputs: none
 **
@@ -344,7 +646,9 @@ BOOLEAN tierdb_save_database ()
 **			gzclose
 **			gzread
 **			(In std libraries)
-**			ntohl
+**			ntohs
+**			mmap
+**			pread
 **
 **	Requirements:	tierdb_array has enough space malloced to store uncompressed database
 **			gNumberOfPositions stores the correct number of uncompressed positions in tierdb_array
@@ -361,14 +665,22 @@ BOOLEAN tierdb_load_database()
 	if(!gHashWindowInitialized)
 		return FALSE;
 
-	POSITION i, maxpos; int j;
-	tierdb_goodDecompression = 1;
-	tierdb_goodClose = 1;
-	BOOLEAN correctDBVer;
+	POSITION maxpos; int j;
+	BOOLEAN useCache, cached = FALSE;
+	int result;
 
 	if(!tierdb_array && !gZeroMemPlayer)
 		return FALSE;
 
+	tierdb_free_segments();
+	useCache = gDBLoadMainTier && !tierdb_shared;
+	if (useCache) {
+		tierdb_numSegments = gNumTiersInHashWindow;
+		tierdb_segment = (tierdb_cellValue**) SafeMalloc(tierdb_numSegments * sizeof(tierdb_cellValue*));
+		for (j = 0; j < tierdb_numSegments; j++)
+			tierdb_segment[j] = NULL;
+	}
+
 	int index;
 	// always load current tier at BOTTOM, thus it being first
 	for (index = 1; index < gNumTiersInHashWindow; index++) {
@@ -378,49 +690,267 @@ BOOLEAN tierdb_load_database()
 				tierdb_array[j] = undecided;
 			continue;
 		}
-		sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
-		        kDBName, getOption(), kDBName, getOption(), gTierInHashWindow[index]);
-		if((tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL) {
+		if (useCache) {
+			result = tierdb_cache_get(gTierInHashWindow[index], &tierdb_segment[index]);
+		} else {
+			result = tierdb_load_raw(gTierInHashWindow[index], tierdb_array + gMaxPosOffset[index-1], NULL);
+			if (result == 0) // no version 2 file, so try the older kind
+				result = tierdb_load_gz(gTierInHashWindow[index], tierdb_array + gMaxPosOffset[index-1],
+				                        gMaxPosOffset[index] - gMaxPosOffset[index-1]);
+		}
+		if (result == 0) {
 			if (gOpponent == AgainstEvaluator) { // go ahead and ignore the loading of the DB
 				maxpos = gMaxPosOffset[index];
-				for(j = 0; j < maxpos; j++)
+				for(j = gMaxPosOffset[index-1]; j < maxpos; j++)
 					tierdb_array[j] = undecided;
 				continue;
 			} else return FALSE;
 		}
-		tierdb_goodDecompression = gzread(tierdb_filep,tierdb_dbVer,sizeof(short));
-		tierdb_goodDecompression = gzread(tierdb_filep,tierdb_numPos,sizeof(POSITION));
-		*tierdb_dbVer = ntohs(*tierdb_dbVer);
-		*tierdb_numPos = ntohl(*tierdb_numPos);
-		if(*tierdb_numPos != (gMaxPosOffset[index]-gMaxPosOffset[index-1])) {
-			if (kDebugDetermineValue)
-				printf("\n\nError in file decompression: Stored gNumberOfPositions differs from internal gNumberOfPositions\n\n");
-			return FALSE;
-		}
-		correctDBVer = (*tierdb_dbVer == tierdb_FILEVER);
-		if (correctDBVer) {
-			maxpos = gMaxPosOffset[index];
-			for(i = gMaxPosOffset[index-1]; i < maxpos && tierdb_goodDecompression; i++) {
-				tierdb_goodDecompression = gzread(tierdb_filep, tierdb_array+i, sizeof(tierdb_cellValue));
-				tierdb_array[i] = ntohs(tierdb_array[i]);
-			}
-		}
-		tierdb_goodClose = gzclose(tierdb_filep);
-		if(!(tierdb_goodDecompression && (tierdb_goodClose == 0) && correctDBVer)) {
-			if(kDebugDetermineValue)
-				printf("\n\nError in file decompression:\ngzread error: %d\ngzclose error: %d\ndb version: %d\n",tierdb_goodDecompression,tierdb_goodClose,*tierdb_dbVer);
+		if (result < 0)
 			return FALSE;
-		}
+		if (useCache)
+			cached = TRUE;
 		gTierDBExists[index] = TRUE; // lets static evaluator know that this tierdb actually exists!
 	}
+	if (cached)
+		tierdb_get_raw = tierdb_get_raw_mapped;
+	if (useCache)
+		tierdb_cache_trim();
 	if(kDebugDetermineValue)
 		printf("Files Successfully Decompressed\n");
 	return TRUE;
 }
 
+/*
+** The tier cache
+*/
+
+/* Finds tier in the cache, or loads it there, and pins it. Returns the
+   same codes as tierdb_load_raw. */
+int tierdb_cache_get(TIER tier, tierdb_cellValue** cells)
+{
+	TIERDB_CACHE_ENTRY* entry;
+	POSITION numPos;
+	int result;
+
+	for (entry = tierdb_cacheFront; entry != NULL; entry = entry->next)
+		if (entry->tier == tier && entry->variant == getOption() && !entry->stale)
+			break;
+	if (entry != NULL) {
+		tierdb_cache_unlink(entry);
+	} else {
+		numPos = gNumberOfTierPositionsFunPtr(tier);
+		entry = (TIERDB_CACHE_ENTRY*) SafeMalloc(sizeof(TIERDB_CACHE_ENTRY));
+		entry->tier = tier;
+		entry->variant = getOption();
+		entry->mapBase = NULL;
+		entry->bytes = (numPos > 0 ? numPos : 1) * sizeof(tierdb_cellValue);
+		entry->cells = NULL;
+		entry->stale = FALSE;
+		result = tierdb_load_raw(tier, NULL, entry);
+		if (result == 0) { // no version 2 file, so decompress the older kind
+			entry->cells = (tierdb_cellValue*) SafeMalloc(entry->bytes);
+			result = tierdb_load_gz(tier, entry->cells, numPos);
+		}
+		if (result != 1) {
+			if (entry->cells != NULL && entry->mapBase == NULL)
+				SafeFree(entry->cells);
+			SafeFree(entry);
+			return result;
+		}
+		tierdb_cacheBytes += entry->bytes;
+	}
+	// now it's the most recently used
+	entry->prev = NULL;
+	entry->next = tierdb_cacheFront;
+	if (tierdb_cacheFront != NULL)
+		tierdb_cacheFront->prev = entry;
+	else tierdb_cacheBack = entry;
+	tierdb_cacheFront = entry;
+	entry->pinned = TRUE;
+	*cells = entry->cells;
+	return 1;
+}
+
+void tierdb_cache_unlink(TIERDB_CACHE_ENTRY* entry)
+{
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else tierdb_cacheFront = entry->next;
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else tierdb_cacheBack = entry->prev;
+}
+
+void tierdb_cache_free_entry(TIERDB_CACHE_ENTRY* entry)
+{
+	tierdb_cache_unlink(entry);
+	if (entry->mapBase != NULL)
+		munmap(entry->mapBase, entry->bytes);
+	else SafeFree(entry->cells);
+	tierdb_cacheBytes -= entry->bytes;
+	SafeFree(entry);
+}
+
+/* Drops unpinned tiers, least recently used first, until the cache fits */
+void tierdb_cache_trim()
+{
+	TIERDB_CACHE_ENTRY *entry, *prev;
+	size_t budget = (size_t) gTierCacheMB << 20;
+
+	for (entry = tierdb_cacheBack; entry != NULL && tierdb_cacheBytes > budget; entry = prev) {
+		prev = entry->prev;
+		if (!entry->pinned)
+			tierdb_cache_free_entry(entry);
+	}
+}
+
+/* Drops tier from the cache. If the current window is using it, it is
+   only marked stale, and dropped once the window is done with it. */
+void tierdb_cache_drop(TIER tier)
+{
+	TIERDB_CACHE_ENTRY *entry, *next;
+	for (entry = tierdb_cacheFront; entry != NULL; entry = next) {
+		next = entry->next;
+		if (entry->tier != tier || entry->variant != getOption())
+			continue;
+		if (entry->pinned)
+			entry->stale = TRUE;
+		else tierdb_cache_free_entry(entry);
+	}
+}
+
+/* Opens the version 2 file of a tier and checks its header, which is
+   left in host byte order. Returns 1 if it's fine (with *fd open),
+   0 if there's no such file and -1 if it's bad. */
+int tierdb_open_raw(TIER tier, int variant, TIERDB_HEADER* header, BOOLEAN* swapped, int* fd)
+{
+	struct stat st;
+	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat",
+	        kDBName, variant, kDBName, variant, tier);
+	if ((*fd = open(tierdb_outfilename, O_RDONLY)) < 0)
+		return 0;
+	if (read(*fd, header, sizeof(TIERDB_HEADER)) != sizeof(TIERDB_HEADER) ||
+	    memcmp(header->magic, tierdb_MAGIC, sizeof(header->magic)) != 0)
+		goto bad;
+	*swapped = (header->byteOrder != tierdb_BYTEORDER);
+	if (*swapped) { // written by a machine of the other endianness
+		header->byteOrder = __builtin_bswap16(header->byteOrder);
+		header->version = __builtin_bswap16(header->version);
+		header->cellSize = __builtin_bswap16(header->cellSize);
+		header->numPos = __builtin_bswap64(header->numPos);
+		header->dataOffset = __builtin_bswap64(header->dataOffset);
+	}
+	if (header->byteOrder != tierdb_BYTEORDER || header->version != tierdb_RAWVER ||
+	    header->cellSize != sizeof(tierdb_cellValue) || header->numPos != gNumberOfTierPositionsFunPtr(tier) ||
+	    fstat(*fd, &st) != 0 || (unsigned long long) st.st_size < header->dataOffset + header->numPos * sizeof(tierdb_cellValue))
+		goto bad;
+	return 1;
+bad:
+	close(*fd);
+	return -1;
+}
+
+/* Loads a tier from its version 2 file. Given a cache entry, the file is
+   mapped into it (or read into memory it allocates); otherwise the cells
+   are read into cells. Same codes as above. */
+int tierdb_load_raw(TIER tier, tierdb_cellValue* cells, TIERDB_CACHE_ENTRY* entry)
+{
+	TIERDB_HEADER header;
+	BOOLEAN swapped;
+	int fd, result;
+	POSITION i, n;
+	char* dest;
+	size_t length;
+	ssize_t got;
+	off_t offset;
+
+	if ((result = tierdb_open_raw(tier, getOption(), &header, &swapped, &fd)) != 1)
+		return result;
+	n = header.numPos;
+	if (entry != NULL) {
+		if (!swapped) {
+			length = header.dataOffset + n * sizeof(tierdb_cellValue);
+			void* base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (base != MAP_FAILED) {
+				close(fd);
+				entry->mapBase = base;
+				entry->bytes = length;
+				entry->cells = (tierdb_cellValue*) ((char*) base + header.dataOffset);
+				return 1;
+			}
+		} // else just read it in
+		cells = entry->cells = (tierdb_cellValue*) SafeMalloc(entry->bytes);
+	}
+	dest = (char*) cells;
+	length = n * sizeof(tierdb_cellValue);
+	offset = header.dataOffset;
+	while (length > 0) {
+		got = pread(fd, dest, length, offset);
+		if (got <= 0) {
+			close(fd);
+			return -1;
+		}
+		dest += got; offset += got; length -= got;
+	}
+	close(fd);
+	if (swapped)
+		for (i = 0; i < n; i++)
+			cells[i] = __builtin_bswap16(cells[i]);
+	return 1;
+}
+
+/* Loads a tier of numPos positions from its version 1 file. Same codes. */
+int tierdb_load_gz(TIER tier, tierdb_cellValue* cells, POSITION numPos)
+{
+	POSITION i, n, j;
+	BOOLEAN correctDBVer;
+
+	tierdb_goodDecompression = 1;
+	tierdb_goodClose = 1;
+	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
+	        kDBName, getOption(), kDBName, getOption(), tier);
+	if((tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL)
+		return 0;
+	tierdb_goodDecompression = gzread(tierdb_filep,tierdb_dbVer,sizeof(short));
+	tierdb_goodDecompression = gzread(tierdb_filep,tierdb_numPos,sizeof(POSITION));
+	*tierdb_dbVer = ntohs(*tierdb_dbVer);
+	*tierdb_numPos = ntohl(*tierdb_numPos);
+	if(*tierdb_numPos != numPos) {
+		if (kDebugDetermineValue)
+			printf("\n\nError in file decompression: Stored gNumberOfPositions differs from internal gNumberOfPositions\n\n");
+		gzclose(tierdb_filep);
+		return -1;
+	}
+	correctDBVer = (*tierdb_dbVer == tierdb_FILEVER);
+	if (correctDBVer) {
+		for(i = 0; i < numPos && tierdb_goodDecompression > 0; i += n) {
+			n = (numPos - i < tierdb_IOCELLS) ? numPos - i : tierdb_IOCELLS;
+			tierdb_goodDecompression = (gzread(tierdb_filep, cells+i, n * sizeof(tierdb_cellValue))
+			                            == n * sizeof(tierdb_cellValue));
+			for (j = i; j < i + n; j++)
+				cells[j] = ntohs(cells[j]);
+		}
+	}
+	tierdb_goodClose = gzclose(tierdb_filep);
+	if(!(tierdb_goodDecompression && (tierdb_goodClose == 0) && correctDBVer)) {
+		if(kDebugDetermineValue)
+			printf("\n\nError in file decompression:\ngzread error: %d\ngzclose error: %d\ndb version: %d\n",tierdb_goodDecompression,tierdb_goodClose,*tierdb_dbVer);
+		return -1;
+	}
+	return 1;
+}
+
 /* A helper to solveretrograde which simply checks for the existance of a DB.
  * Error Codes: 0 = Doesn't exist, -1 = Incorrect/corrupted, 1 = Exists. */
 int CheckTierDB(TIER tier, int variant) {
+	TIERDB_HEADER header;
+	BOOLEAN swapped;
+	int fd, result;
+	if ((result = tierdb_open_raw(tier, variant, &header, &swapped, &fd)) != 0) {
+		if (result == 1) close(fd);
+		return result;
+	}
 	sprintf(tierdb_outfilename, "./data/m%s_%d_tierdb/m%s_%d_%llu_tierdb.dat.gz",
 	        kDBName, variant, kDBName, variant, tier);
 	if((tierdb_filep = gzopen(tierdb_outfilename, "rb")) == NULL) {
@@ -445,7 +975,7 @@ BOOLEAN tierdb_load_minifile(char* filename)
 	if(!gHashWindowInitialized && !tierdb_array)
 		return FALSE;
 
-	POSITION i;
+	POSITION i, j, n;
 	tierdb_goodDecompression = 1;
 	tierdb_goodClose = 1;
 	BOOLEAN correctDBVer;
@@ -458,13 +988,18 @@ BOOLEAN tierdb_load_minifile(char* filename)
 	tierdb_goodDecompression = gzread(tierdb_filep,tierdb_numPos,sizeof(POSITION));
 	*tierdb_dbVer = ntohs(*tierdb_dbVer);
 	*tierdb_numPos = ntohl(*tierdb_numPos);
-	if(*tierdb_numPos != gCurrentTierSize)
+	if(*tierdb_numPos != gCurrentTierSize) {
+		gzclose(tierdb_filep);
 		return FALSE;
+	}
 	correctDBVer = (*tierdb_dbVer == tierdb_FILEVER);
 	if (correctDBVer) {
-		for(i = gDBTierStart; i < gDBTierEnd && tierdb_goodDecompression; i++) {
-			tierdb_goodDecompression = gzread(tierdb_filep, tierdb_array+i, sizeof(tierdb_cellValue));
-			tierdb_array[i] = ntohs(tierdb_array[i]);
+		for(i = gDBTierStart; i < gDBTierEnd && tierdb_goodDecompression > 0; i += n) {
+			n = (gDBTierEnd - i < tierdb_IOCELLS) ? gDBTierEnd - i : tierdb_IOCELLS;
+			tierdb_goodDecompression = (gzread(tierdb_filep, tierdb_array+i, n * sizeof(tierdb_cellValue))
+			                            == n * sizeof(tierdb_cellValue));
+			for (j = i; j < i + n; j++)
+				tierdb_array[j] = ntohs(tierdb_array[j]);
 		}
 	}
 	tierdb_goodClose = gzclose(tierdb_filep);
@@ -5,5 +5,8 @@
 void    tierdb_init     (DB_Table*);
 int CheckTierDB     (TIER, int);
 BOOLEAN tierdb_load_minifile (char*);
+BOOLEAN tierdb_is_shared (void);
+BOOLEAN tierdb_write_cells (FILE*, POSITION, POSITION);
+BOOLEAN tierdb_read_cells (FILE*, POSITION, POSITION);
 
 #endif /* GMCORE_TIERDB_H */
@@ -29,9 +29,28 @@
 **
 **************************************************************************/
 
+#include <sys/mman.h>
 #include "gamesman.h"
 #include "twobitdb.h"
 
+/* Saved databases are uncompressed: a header, then the packed values from
+   dataOffset on. The values are bytes, so only the header depends on the
+   byte order of the machine that wrote it, and the file can be mmap'd as
+   the database itself. */
+#define TWOBITDB_MAGIC "GM2BITDB"
+#define TWOBITDB_VERSION 1
+#define TWOBITDB_BYTEORDER 0x0102
+#define TWOBITDB_DATAOFFSET 64
+
+typedef struct twobitdb_header {
+	char magic[8];
+	unsigned short version;
+	unsigned short byteOrder;   // TWOBITDB_BYTEORDER as the writer saw it
+	unsigned int reserved;
+	unsigned long long numPos;
+	unsigned long long dataOffset;
+} TWOBITDB_HEADER;
+
 void            twobitdb_free ();
 
 /* Value */
@@ -43,9 +62,21 @@ BOOLEAN         twobitdb_check_visited          (POSITION position);
 void            twobitdb_mark_visited           (POSITION position);
 void            twobitdb_unmark_visited         (POSITION position);
 
+/* Bulk */
+void            twobitdb_get_bulk_data          (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+void            twobitdb_put_bulk_data          (POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys);
+
+/* saving to/reading from a file */
+BOOLEAN         twobitdb_save_database          ();
+BOOLEAN         twobitdb_load_database          ();
+
 
-int* twobitdb_database; //a cell has 8 bits
-int* twobitdb_visited;  //a cell has 8 bits
+unsigned char* twobitdb_database; //a cell has 4 positions
+unsigned int* twobitdb_visited;  //allocated the first time a position is marked
+size_t twobitdb_size;
+void* twobitdb_mapBase = NULL;  //the mapping twobitdb_database points into, if loaded that way
+size_t twobitdb_mapBytes;
+char twobitdb_filename[100];
 
 /*
 ** Code
@@ -54,14 +85,11 @@ int* twobitdb_visited;  //a cell has 8 bits
 void twobitdb_init(DB_Table *new_db) {
 
 	//we need two bits per position, so 4 values per byte
-	size_t dbSize = (gNumberOfPositions >> 2) + 1;
-	//we need one bit per position, so 8 visited values per byte
-	size_t visitedSize = (gNumberOfPositions >> 3) + 1;
+	twobitdb_size = (gNumberOfPositions >> 2) + 1;
 
-	twobitdb_database = (int*) SafeMalloc(dbSize);
-	memset(twobitdb_database, 0xffff, dbSize);
-	twobitdb_visited = (int*) SafeMalloc(visitedSize);
-	memset(twobitdb_visited, 0, visitedSize);
+	twobitdb_database = (unsigned char*) SafeMalloc(twobitdb_size);
+	memset(twobitdb_database, 0, twobitdb_size); //all undecided
+	twobitdb_visited = NULL;
 
 	//set function pointers
 	new_db->get_value = twobitdb_get_value;
@@ -69,6 +97,10 @@ void twobitdb_init(DB_Table *new_db) {
 	new_db->check_visited = twobitdb_check_visited;
 	new_db->mark_visited = twobitdb_mark_visited;
 	new_db->unmark_visited = twobitdb_unmark_visited;
+	new_db->get_bulk_data = twobitdb_get_bulk_data;
+	new_db->put_bulk_data = twobitdb_put_bulk_data;
+	new_db->save_database = twobitdb_save_database;
+	new_db->load_database = twobitdb_load_database;
 
 	new_db->free_db = twobitdb_free;
 
@@ -79,27 +111,21 @@ void twobitdb_init(DB_Table *new_db) {
 void twobitdb_free(){
 	if(twobitdb_visited)
 		SafeFree(twobitdb_visited);
-	if(twobitdb_database)
+	if(twobitdb_mapBase)
+		munmap(twobitdb_mapBase, twobitdb_mapBytes);
+	else if(twobitdb_database)
 		SafeFree(twobitdb_database);
-}
-
-int* twobitdb_get_raw_ptr(POSITION position){
-	return (&twobitdb_database[position>>4]);
+	twobitdb_visited = NULL;
+	twobitdb_database = NULL;
+	twobitdb_mapBase = NULL;
 }
 
 VALUE twobitdb_set_value(POSITION position, VALUE value)
 {
-	int shamt;
-	int* ptr;
-
-	ptr = twobitdb_get_raw_ptr(position);
-	shamt = (position & 15) << 1;
+	unsigned char* ptr = &twobitdb_database[position >> 2];
+	int shamt = (position & 3) << 1;
 
-	//printf("set --- pos: %llu, before: %d, value: %d, shamt: %d", position, *ptr, value, shamt);
-
-	*ptr = ((*ptr & ~(3 << shamt)) | ((3 & value) << shamt));
-
-	//printf(" after: %d\n", *ptr);
+	*ptr = (unsigned char) ((*ptr & ~(3 << shamt)) | ((3 & value) << shamt));
 
 	return value;
 }
@@ -107,30 +133,165 @@ VALUE twobitdb_set_value(POSITION position, VALUE value)
 // This is it
 VALUE twobitdb_get_value(POSITION position)
 {
-	int* ptr;
-	int shamt, value;
+	return (VALUE)(3 & (twobitdb_database[position >> 2] >> ((position & 3) << 1)));
+}
+/* Only values are kept; the other fields read as the defaults in db.c
+   would give, and storing them does nothing. */
+void twobitdb_get_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i;
 
-	ptr = twobitdb_get_raw_ptr(position);
-	shamt = (position & 15) << 1;
-	value = (VALUE)(3 & (*ptr >> shamt));
-	//printf("get --- pos: %llu, shamt: %d, value: %d\n", position, shamt, value);
-	return value;
+	for (i = 0; i < length; i++) {
+		if (values != NULL) {
+			values[i] = twobitdb_get_value(positions[i]);
+		}
+		if (remotenesses != NULL) remotenesses[i] = kBadRemoteness;
+		if (mexes != NULL) mexes[i] = kBadMexValue;
+		if (winbys != NULL) winbys[i] = 0;
+	}
+}
 
+void twobitdb_put_bulk_data(POSITION* positions, int length, VALUE* values, REMOTENESS* remotenesses, MEX* mexes, WINBY* winbys)
+{
+	int i;
+
+	if (values != NULL)
+		for (i = 0; i < length; i++)
+			twobitdb_set_value(positions[i], values[i]);
 }
 
+/* The visited bits are only allocated for solvers that use them, the
+   value-only solver doesn't. */
 BOOLEAN twobitdb_check_visited(POSITION position)
 {
+	if (twobitdb_visited == NULL)
+		return FALSE;
 	return ((twobitdb_visited[position >> 5] >> (position & 31)) & 1);
 }
 
 void twobitdb_mark_visited (POSITION position)
 {
-	twobitdb_visited[position >> 5] |= 1 << (position & 31);
+	if (twobitdb_visited == NULL) {
+		size_t visitedSize = ((gNumberOfPositions >> 5) + 1) * sizeof(unsigned int);
+		twobitdb_visited = (unsigned int*) SafeMalloc(visitedSize);
+		memset(twobitdb_visited, 0, visitedSize);
+	}
+	twobitdb_visited[position >> 5] |= 1U << (position & 31);
 	return;
 }
 
 void twobitdb_unmark_visited (POSITION position)
 {
-	twobitdb_visited[position >> 5] &= ~(1 << (position & 31));
+	if (twobitdb_visited != NULL)
+		twobitdb_visited[position >> 5] &= ~(1U << (position & 31));
 	return;
 }
+
+/* Written under a temporary name and renamed, so a crash never leaves half
+   a database, and a database mmap'd from the old file is left alone. */
+BOOLEAN twobitdb_save_database()
+{
+	char tmpfilename[110];
+	TWOBITDB_HEADER header;
+	char padding[TWOBITDB_DATAOFFSET - sizeof(TWOBITDB_HEADER)];
+	FILE* filep;
+	BOOLEAN good;
+
+	if (twobitdb_database == NULL)
+		return FALSE;
+
+	mkdir("data", 0755);
+	sprintf(twobitdb_filename, "./data/m%s_%d_2bitdb.dat", kDBName, getOption());
+	sprintf(tmpfilename, "%s.tmp", twobitdb_filename);
+	if ((filep = fopen(tmpfilename, "wb")) == NULL) {
+		if (kDebugDetermineValue) {
+			printf("Unable to create data file\n");
+		}
+		return FALSE;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TWOBITDB_MAGIC, sizeof(header.magic));
+	header.version = TWOBITDB_VERSION;
+	header.byteOrder = TWOBITDB_BYTEORDER;
+	header.numPos = gNumberOfPositions;
+	header.dataOffset = TWOBITDB_DATAOFFSET;
+	memset(padding, 0, sizeof(padding));
+	good = (fwrite(&header, sizeof(header), 1, filep) == 1 &&
+	        fwrite(padding, sizeof(padding), 1, filep) == 1 &&
+	        fwrite(twobitdb_database, 1, twobitdb_size, filep) == twobitdb_size);
+	good = (fclose(filep) == 0) && good;
+
+	if (good && rename(tmpfilename, twobitdb_filename) == 0) {
+		if (kDebugDetermineValue && !gJustSolving) {
+			printf("File Successfully written\n");
+		}
+		return TRUE;
+	}
+	if (kDebugDetermineValue) {
+		fprintf(stderr, "\nError writing %s\n", twobitdb_filename);
+	}
+	remove(tmpfilename);
+	return FALSE;
+}
+
+/* Maps the saved database in place of the one in memory. The mapping is
+   private, so values can still be changed without touching the file. If
+   the file can't be mapped it is read in. */
+BOOLEAN twobitdb_load_database()
+{
+	TWOBITDB_HEADER header;
+	struct stat st;
+	void* base;
+	size_t length;
+	char* dest;
+	ssize_t got;
+	off_t offset;
+	int fd;
+
+	sprintf(twobitdb_filename, "./data/m%s_%d_2bitdb.dat", kDBName, getOption());
+	if ((fd = open(twobitdb_filename, O_RDONLY)) < 0)
+		return FALSE;
+	if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+	    memcmp(header.magic, TWOBITDB_MAGIC, sizeof(header.magic)) != 0)
+		goto bad;
+	if (header.byteOrder != TWOBITDB_BYTEORDER) { // written by a machine of the other endianness
+		header.byteOrder = __builtin_bswap16(header.byteOrder);
+		header.version = __builtin_bswap16(header.version);
+		header.numPos = __builtin_bswap64(header.numPos);
+		header.dataOffset = __builtin_bswap64(header.dataOffset);
+	}
+	if (header.byteOrder != TWOBITDB_BYTEORDER || header.version != TWOBITDB_VERSION ||
+	    header.numPos != gNumberOfPositions || fstat(fd, &st) != 0 ||
+	    (unsigned long long) st.st_size < header.dataOffset + twobitdb_size)
+		goto bad;
+
+	length = header.dataOffset + twobitdb_size;
+	base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (base != MAP_FAILED) {
+		close(fd);
+		if (twobitdb_mapBase)
+			munmap(twobitdb_mapBase, twobitdb_mapBytes);
+		else
+			SafeFree(twobitdb_database);
+		twobitdb_mapBase = base;
+		twobitdb_mapBytes = length;
+		twobitdb_database = (unsigned char*) base + header.dataOffset;
+		return TRUE;
+	}
+
+	dest = (char*) twobitdb_database;
+	length = twobitdb_size;
+	offset = header.dataOffset;
+	while (length > 0) {
+		got = pread(fd, dest, length, offset);
+		if (got <= 0)
+			goto bad;
+		dest += got; offset += got; length -= got;
+	}
+	close(fd);
+	return TRUE;
+bad:
+	close(fd);
+	fprintf(stderr, "\n%s is not a two-bit database of this game, ignoring it\n", twobitdb_filename);
+	return FALSE;
+}
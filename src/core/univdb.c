@@ -63,6 +63,9 @@ DB_Table *univdb_init() {
 	db->unmark_visited = univdb_unmark_visited;
 	db->get_mex = univdb_get_mex;
 	db->put_mex = univdb_put_mex;
+	db->get_bulk_data = univdb_get_bulk_data;
+	db->put_bulk_data = univdb_put_bulk_data;
+	db->get_range_data = NULL;
 	db->free_db = univdb_free;
 	db->save_database = univdb_save_database;
 	db->load_database = univdb_load_database;
@@ -262,6 +265,39 @@ MEX univdb_get_mex (POSITION position) {
 
 }
 
+void univdb_get_bulk_data (POSITION *positions, int length, VALUE *values, REMOTENESS *remotenesses, MEX *mexes, WINBY *winbys) {
+
+	univdb_entry *entry;
+	int i;
+
+	/* One lookup per position for all of the fields; missing entries read as 0 */
+	for (i = 0; i < length; i++) {
+
+		entry = univdb_lookup_entry(positions[i]);
+		db_unpack_cell((entry == NULL) ? 0 : entry->flags, i, values, remotenesses, mexes);
+		if (winbys != NULL)
+			winbys[i] = 0;
+
+	}
+
+}
+
+void univdb_put_bulk_data (POSITION *positions, int length, VALUE *values, REMOTENESS *remotenesses, MEX *mexes, WINBY *winbys) {
+
+	univdb_entry *entry;
+	int i;
+
+	for (i = 0; i < length; i++) {
+
+		entry = univdb_lookup_entry(positions[i]);
+		if (entry == NULL)
+			entry = univdb_create_entry(positions[i]);
+		entry->flags = (VALUE) db_pack_cell(entry->flags, i, values, remotenesses, mexes);
+
+	}
+
+}
+
 BOOLEAN univdb_check_visited (POSITION position) {
 
 	univdb_entry *entry;
@@ -28,6 +28,9 @@ void univdb_unmark_visited (POSITION position);
 
 MEX univdb_get_mex (POSITION position);
 void univdb_put_mex (POSITION position, MEX mex);
+
+void univdb_get_bulk_data (POSITION *positions, int length, VALUE *values, REMOTENESS *remotenesses, MEX *mexes, WINBY *winbys);
+void univdb_put_bulk_data (POSITION *positions, int length, VALUE *values, REMOTENESS *remotenesses, MEX *mexes, WINBY *winbys);
 BOOLEAN univdb_save_database();
 BOOLEAN univdb_load_database();
 
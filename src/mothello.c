@@ -160,6 +160,8 @@ int oppositedirection(int);
 BOOLEAN IsPlayableBoard(char[]);
 
 BOOLEAN quickgeneratemoves(char[], int);
+void FlipPieces(char[], int, char, char);
+int GenerateChildrenEfficient(POSITION, POSITION*, MOVE*);
 
 char* getBoard(POSITION);
 char* getBlankBoard();
@@ -250,6 +252,7 @@ void InitializeGame ()
 	gMoveToStringFunPtr = &MoveToString;
 	gPutWinBy = &computeWinBy;
 	gActualNumberOfPositionsOptFunPtr = &ActualNumberOfPositions;
+	gGenerateChildrenFunPtr = &GenerateChildrenEfficient;
 
 	//Setup Tier Stuff
 	//SetupTierStuff();
@@ -354,7 +357,7 @@ int options[];
 
 POSITION DoMove (POSITION thePosition, MOVE theMove)
 {
-	int candidatemove[2], CandidateArrayNum, j, whoseturn, nextplayer;
+	int whoseturn, nextplayer;
 	char ownpiece, opponentpiece;
 	char* board;
 	int MoveArrayNum = (int) theMove;
@@ -384,6 +387,15 @@ POSITION DoMove (POSITION thePosition, MOVE theMove)
 		return getPosition(board, nextplayer);
 
 	board[MoveArrayNum] = ownpiece;
+	FlipPieces(board, MoveArrayNum, ownpiece, opponentpiece);
+	return getPosition(board, nextplayer);
+}
+
+/* Flips every run of opponent pieces that the piece just placed at
+   MoveArrayNum closes off. */
+void FlipPieces(char board[], int MoveArrayNum, char ownpiece, char opponentpiece)
+{
+	int candidatemove[2], CandidateArrayNum, j;
 
 	for(j = 1; j < 9; j++)
 	{
@@ -401,7 +413,6 @@ POSITION DoMove (POSITION thePosition, MOVE theMove)
 			}
 		}
 	}
-	return getPosition(board, nextplayer);
 }
 
 
@@ -937,6 +948,76 @@ MOVELIST *GenerateMoves(POSITION position)
 	return(head);
 }
 
+/************************************************************************
+**
+** NAME:        GenerateChildrenEfficient
+**
+** DESCRIPTION: Fills children[] and moves[] with every child of position
+**              and its move, in the same order GenerateMoves lists them.
+**              The board is unhashed once and each child is flipped on
+**              a copy of it, rather than unhashing once per move.
+**
+** INPUTS:      POSITION position : The position to expand
+**              POSITION *children, MOVE *moves : room for MAXFANOUT
+**
+** OUTPUTS:     (int) : The number of children written
+**
+************************************************************************/
+
+int GenerateChildrenEfficient(POSITION position, POSITION *children, MOVE *moves)
+{
+	int i, j, whoseturn = getTurn(position), nextplayer, numChildren = 0;
+	int boardsize = OthRows * OthCols;
+	char *board, *child;
+	char ownpiece, opponentpiece;
+
+	board = getBoard(position);
+	if(whoseturn == 1)
+	{
+		ownpiece = 'B';
+		opponentpiece = 'W';
+		nextplayer = 2;
+	}
+	else
+	{
+		ownpiece = 'W';
+		opponentpiece = 'B';
+		nextplayer = 1;
+	}
+
+	/* GenerateMoves prepends, so its list runs from the last square down */
+	for(i = boardsize - 1; i >= 0; i--)
+	{
+		if(board[i] != BLANKPIECE)
+			continue;
+		if(!variant_NoGenMovesRestriction)
+		{
+			for(j = 1; j < 9; j++)
+				if(Check1Spot1Direc(i, board, ownpiece, opponentpiece, j))
+					break;
+			if(j == 9)
+				continue;
+		}
+		/* getPosition frees the board it is handed */
+		child = SafeMalloc(boardsize * sizeof(char) + 1);
+		memcpy(child, board, boardsize + 1);
+		child[i] = ownpiece;
+		FlipPieces(child, i, ownpiece, opponentpiece);
+		moves[numChildren] = i;
+		children[numChildren++] = getPosition(child, nextplayer);
+	}
+
+	if(numChildren == 0)
+	{
+		moves[0] = PASSMOVE;
+		children[0] = getPosition(board, nextplayer);
+		return 1;
+	}
+
+	SafeFree(board);
+	return numChildren;
+}
+
 
 /************************************************************************
 **
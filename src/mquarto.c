@@ -329,6 +329,11 @@ int **trivialTable=NULL;
 int **lookupTable=NULL;
 int twoPowers[] = {1,2,4,8,16,32,64,128,256};
 
+/* for Mario's cannonicals: symmetrySlots[group][slot] is the slot the
+   group'th rotation/reflection of a board takes slot's piece from */
+#define NUMSYMMETRIES 8
+short **symmetrySlots=NULL;
+
 /*************************************************************************
 **
 ** Global Variables
@@ -337,6 +342,9 @@ int twoPowers[] = {1,2,4,8,16,32,64,128,256};
 
 BOOLEAN factorialTableSet;
 POSITION *factorialTable;
+/* n P r and n C r for n, r < FACTORIALMAX, filled with factorialTable */
+POSITION *permutationTable = NULL;
+POSITION *combinationTable = NULL;
 BOOLEAN offsetTableSet;
 POSITION *offsetTable;
 
@@ -357,6 +365,7 @@ void*                   gGameSpecificTclInit = NULL;  /* newly added to tempalte
 QTBPtr                  MallocBoard();
 void                    FreeBoard(QTBPtr b);
 void                    setOffsetTable();
+void                    setSymmetrySlots();
 POSITION                combination(int n, int r);
 POSITION                permutation(int n, int r);
 
@@ -498,6 +507,7 @@ void yanpeiInitializeGame() {
 	offsetTable = (POSITION *) SafeMalloc((NUMPIECES+2)*(sizeof(POSITION)));
 
 	if(!offsetTableSet) setOffsetTable();
+	setSymmetrySlots();
 	board = MallocBoard();
 
 	/* Initialize all fields to 0 */
@@ -1591,10 +1601,14 @@ void print_board( QTBPtr board ) {
 POSITION hashUnsymQuarto(QTBPtr b) {
 
 	POSITION toReturn;
-	QTBPtr helperBoard = MallocBoard();
+	QTBOARD helper;
+	short helperSlots[BOARDSIZE+1];
+	QTBPtr helperBoard = &helper;
 	POSITION squaresOccupiedOffset, firstSlotOffset;
 	short i;
 
+	helper.slots = helperSlots;
+
 	if (!offsetTableSet) setOffsetTable();
 
 	if (b->squaresOccupied==0 && b->piecesInPlay==0) {
@@ -1644,67 +1658,54 @@ POSITION hashUnsymQuarto(QTBPtr b) {
 	   }
 	 */
 
-	// giving space back to the malloc Godfather
-	FreeBoard(helperBoard);
 	return toReturn;
 
 }
 
 POSITION hashUnsymQuartoHelper(QTBPtr b, int baseSlot) {
 
-	short slotsSubset = BOARDSIZE - baseSlot + 1; // # of slots starting from baseSlot
-	short slotsOccupiedSubset = 0; // # of occupied slots starting from baseSlot
-	short firstSlot = 0; // first occupied slot
-	short firstPiece = EMPTYSLOT; // piece in firstSlot
+	short slotsSubset; // # of slots starting from baseSlot
+	short slotsOccupiedSubset; // # of occupied slots starting from baseSlot
 	short piecesBeforeBase = 0; // # of pieces before baseSlot
-	POSITION firstPieceOffset = 0;
-	POSITION firstSlotOffset = 0;
+	short slot, piece;
+	unsigned int placed = 0; // pieces already hashed, which later pieces skip over
+	POSITION firstPieceOffset, firstSlotOffset, pieceOrders;
 	short i;
-	POSITION toReturn;
+	POSITION toReturn = 0;
 
-	// traverse b->slots to set up local vars
-	for (i=0; i<BOARDSIZE+1; i++) {
-		if (i<baseSlot && b->slots[i]!=EMPTYSLOT) {
+	for (i=0; i<baseSlot; i++) {
+		if (b->slots[i]!=EMPTYSLOT) {
 			piecesBeforeBase++;
 		}
-		if (i>=baseSlot && b->slots[i]!=EMPTYSLOT) {
-			if (firstSlot == 0) firstSlot = i;
-			if (firstPiece == EMPTYSLOT) firstPiece = b->slots[i];
-		}
 	}
-	slotsOccupiedSubset = b->piecesInPlay - piecesBeforeBase;
 
-	if (slotsOccupiedSubset == 0) {
-		// error: recursive call should never have no pieces starting from baseSlot
-		toReturn = 0;
-		printf("\nError: hashUnsymQuartoHelper() check recursive call\n");
-	} else if (slotsOccupiedSubset == 1) {
-		// base case
-		toReturn = firstPiece*slotsSubset + (firstSlot - baseSlot);
-	} else {
-		// more complicated
-		// calculating a couple of offsets
-		for (i=slotsSubset-1; i>=slotsOccupiedSubset-1; i--) {
-			if (slotsSubset-i-1 == firstSlot-baseSlot) {
-				firstSlotOffset = firstPieceOffset;
-			}
-			firstPieceOffset +=
-			        permutation(NUMPIECES-piecesBeforeBase-1,slotsOccupiedSubset-1)
-			        *combination(i,slotsOccupiedSubset-1);
-		}
-		// preparing b for recursive call
-		for (i=firstSlot+1; i<BOARDSIZE+1; i++) {
-			if (b->slots[i] > b->slots[firstSlot] &&
-			    b->slots[i] != EMPTYSLOT) {
-				b->slots[i]--;
-			}
+	// each occupied slot in turn is the first slot of what used to be a
+	// recursive call on the slots after the previous one
+	for (slot=baseSlot; slot<BOARDSIZE+1; slot++) {
+		if (b->slots[slot] == EMPTYSLOT) continue;
+		slotsSubset = BOARDSIZE - baseSlot + 1;
+		slotsOccupiedSubset = b->piecesInPlay - piecesBeforeBase;
+		piece = b->slots[slot] - __builtin_popcount(placed & ((1u << b->slots[slot]) - 1));
+
+		if (slotsOccupiedSubset == 1) {
+			// base case
+			return toReturn + piece*slotsSubset + (slot - baseSlot);
 		}
-		// throw the rest of the problem onto a recursive call
-		toReturn =  firstPiece*firstPieceOffset
-		           +firstSlotOffset
-		           +hashUnsymQuartoHelper(b,firstSlot+1);
+		// calculating a couple of offsets: summing nPr * iCr over the
+		// slots i telescopes (hockey-stick identity) to a single nCr
+		pieceOrders = permutation(NUMPIECES-piecesBeforeBase-1,slotsOccupiedSubset-1);
+		firstPieceOffset = pieceOrders*combination(slotsSubset,slotsOccupiedSubset);
+		firstSlotOffset = firstPieceOffset
+		                  - pieceOrders*combination(slotsSubset-(slot-baseSlot),slotsOccupiedSubset);
+		toReturn += piece*firstPieceOffset + firstSlotOffset;
+
+		placed |= 1u << b->slots[slot];
+		piecesBeforeBase++;
+		baseSlot = slot + 1;
 	}
 
+	// error: should always end on the last piece
+	printf("\nError: hashUnsymQuartoHelper() check recursive call\n");
 	return toReturn;
 }
 
@@ -1766,7 +1767,7 @@ void unhashUnsymQuartoHelper(POSITION p, int baseSlot, QTBPtr toReturn) {
 	short slotsOccupiedSubset = 0;
 	short slotsSubset = BOARDSIZE - baseSlot + 1;
 	short firstSlot=-1,firstPiece=0;
-	short *piecesSubset = SafeMalloc(NUMPIECES*sizeof(short));
+	short piecesSubset[NUMPIECES];
 	POSITION firstSlotOffset=0, firstPieceOffset=0;
 
 	// traversing toReturn to setup local vars
@@ -1799,12 +1800,9 @@ void unhashUnsymQuartoHelper(POSITION p, int baseSlot, QTBPtr toReturn) {
 		toReturn->slots[firstSlot+baseSlot] = piecesSubset[firstPiece];
 	} else {
 		// more complicated
-		// calculating an offsets
-		for (i=0; i<=slotsSubset-slotsOccupiedSubset; i++) {
-			firstPieceOffset +=
-			        permutation(NUMPIECES-piecesBeforeBase-1,slotsOccupiedSubset-1)
-			        *combination(slotsSubset-i-1,slotsOccupiedSubset-1);
-		}
+		// calculating an offsets, telescoped as in hashUnsymQuartoHelper()
+		firstPieceOffset =  permutation(NUMPIECES-piecesBeforeBase-1,slotsOccupiedSubset-1)
+		                   *combination(slotsSubset,slotsOccupiedSubset);
 		// finding and setting firstPiece and firstSlot
 		firstPiece = p / firstPieceOffset;
 		i=0;
@@ -1839,9 +1837,6 @@ void unhashUnsymQuartoHelper(POSITION p, int baseSlot, QTBPtr toReturn) {
 		// throw the rest of the problem onto a recursive call
 		unhashUnsymQuartoHelper(p, firstSlot+baseSlot+1, toReturn);
 	}
-
-	// giving space back to the malloc Godfather
-	SafeFree(piecesSubset);
 }
 
 
@@ -1850,11 +1845,31 @@ void setFactorialTable() {
 
 	int i;
 
+	int n, r;
+
 	if (!factorialTableSet) {
 		factorialTable[0] = 1;
 		for (i=1; i<FACTORIALMAX; i++) {
 			factorialTable[i] = factorialTable[i-1] * i;
 		}
+		// the hash calls permutation() and combination() in its inner
+		// loops, so look them up rather than dividing factorials
+		if (permutationTable) SafeFree(permutationTable);
+		if (combinationTable) SafeFree(combinationTable);
+		permutationTable = (POSITION *) SafeMalloc(FACTORIALMAX*FACTORIALMAX*sizeof(POSITION));
+		combinationTable = (POSITION *) SafeMalloc(FACTORIALMAX*FACTORIALMAX*sizeof(POSITION));
+		for (n=0; n<FACTORIALMAX; n++) {
+			for (r=0; r<FACTORIALMAX; r++) {
+				if (r == 0) {
+					permutationTable[n*FACTORIALMAX+r] = combinationTable[n*FACTORIALMAX+r] = 1;
+				} else if (n == 0) {
+					permutationTable[n*FACTORIALMAX+r] = combinationTable[n*FACTORIALMAX+r] = 0;
+				} else {
+					permutationTable[n*FACTORIALMAX+r] = factorialTable[n] / factorialTable[(n>r) ? n-r : 0];
+					combinationTable[n*FACTORIALMAX+r] = permutationTable[n*FACTORIALMAX+r] / factorialTable[r];
+				}
+			}
+		}
 		factorialTableSet = TRUE;
 	}
 }
@@ -1894,6 +1909,9 @@ POSITION permutation(int n, int r) {
 		return 1;
 	} else if (n <= 0) {
 		return 0;
+	} else if (n < FACTORIALMAX && r < FACTORIALMAX) {
+		if (!factorialTableSet) setFactorialTable();
+		return permutationTable[n*FACTORIALMAX+r];
 	} else {
 		return factorial(n) / factorial(n-r);
 	}
@@ -1908,6 +1926,9 @@ POSITION combination(int n, int r) {
 		return 1;
 	} else if (n <= 0) {
 		return 0;
+	} else if (n < FACTORIALMAX && r < FACTORIALMAX) {
+		if (!factorialTableSet) setFactorialTable();
+		return combinationTable[n*FACTORIALMAX+r];
 	} else {
 		return factorial(n) / factorial(n-r) / factorial(r);
 	}
@@ -2342,12 +2363,25 @@ static QTBPtr normalizeBoard(QTBPtr board) {
 
 // Mario's Cannonical stuff
 
-POSITION marioGetCanonical(POSITION position) {
+/* Fills symmetrySlots by running a board of slot numbers through the
+   same rotations and reflections marioGetCanonical used to allocate */
+void setSymmetrySlots() {
 
-	QTBPtr orbit[8];
-	short group;
+	QTBPtr orbit[NUMSYMMETRIES];
+	short group, slot;
 
-	orbit[0] = unhash(position);
+	if (symmetrySlots) {
+		for (group = 0; group < NUMSYMMETRIES; group++)
+			SafeFree(symmetrySlots[group]);
+		SafeFree(symmetrySlots);
+	}
+	symmetrySlots = (short **) SafeMalloc(NUMSYMMETRIES * sizeof(short *));
+
+	orbit[0] = MallocBoard();
+	orbit[0]->squaresOccupied = orbit[0]->piecesInPlay = 0;
+	orbit[0]->usersTurn = FALSE;
+	for (slot = 0; slot <= BOARDSIZE; slot++)
+		orbit[0]->slots[slot] = slot;
 	orbit[1] = rotateBoard90(orbit[0]);
 	orbit[2] = rotateBoard90(orbit[1]);
 	orbit[3] = rotateBoard90(orbit[2]);
@@ -2356,14 +2390,44 @@ POSITION marioGetCanonical(POSITION position) {
 	orbit[6] = reflectBoard(orbit[2]);
 	orbit[7] = reflectBoard(orbit[3]);
 
-	position = offsetTable[NUMPIECES+1];
-	for (group = 0; group < 8; group++) {
-		POSITION temp = hash(normalizeBoard(orbit[group]));
-		position = (temp < position) ? temp : position;
-		/* Free allocated board */
+	for (group = 0; group < NUMSYMMETRIES; group++) {
+		symmetrySlots[group] = (short *) SafeMalloc((BOARDSIZE+1) * sizeof(short));
+		for (slot = 0; slot <= BOARDSIZE; slot++)
+			symmetrySlots[group][slot] = orbit[group]->slots[slot];
 		FreeBoard(orbit[group]);
 	}
 
+}
+
+/* Builds the orbit of position in place on the stack rather than
+   allocating a board per image, and hashes each normalized image only
+   if no earlier image normalized to the same board */
+POSITION marioGetCanonical(POSITION position) {
+
+	QTBPtr board = unhash(position);
+	QTBOARD orbit[NUMSYMMETRIES];
+	short slots[NUMSYMMETRIES][BOARDSIZE+1];
+	short group, other, slot;
+
+	position = offsetTable[NUMPIECES+1];
+	for (group = 0; group < NUMSYMMETRIES; group++) {
+		orbit[group] = *board;
+		orbit[group].slots = slots[group];
+		for (slot = 0; slot <= BOARDSIZE; slot++)
+			slots[group][slot] = board->slots[symmetrySlots[group][slot]];
+		normalizeBoard(&orbit[group]);
+
+		for (other = 0; other < group; other++)
+			if (!memcmp(slots[other], slots[group], (BOARDSIZE+1) * sizeof(short)))
+				break;
+		if (other == group) {
+			POSITION temp = hash(&orbit[group]);
+			position = (temp < position) ? temp : position;
+		}
+	}
+	/* Free allocated board */
+	FreeBoard(board);
+
 	return position;
 
 }
@@ -2952,9 +3016,11 @@ POSITION TierHash(QTBPtr board) {
 	if (gHashWindowInitialized) { //What the hell does this mean???
 		TIER tier = BoardToTier(board); // find this board's tier
 		generic_hash_context_switch(tier); // switch to that context
-		char* hashBoard = consCharArrayFromBoard(board);
+		char hashBoard[BOARDSIZE];
+		int x;
+		for(x=0; x<BOARDSIZE; x++)
+			hashBoard[x] = board->slots[x+1];
 		TIERPOSITION tierpos = generic_hash_hash(hashBoard, ((board->usersTurn) ? 2 : 1));
-		SafeFree(hashBoard);
 		/*Confusing addition up ahead: the plan is to NOT use generichash for the
 		   hand piece. So whatever GenHash returns, we add the maximum positions for
 		   that hash times the piece in hand (plus one so we never add zero if the hand
@@ -3006,12 +3072,11 @@ QTBPtr TierUnhash(POSITION position) {
 				} else encodedHand--;
 			}
 		}
-		char * hashBoard = (char*)SafeMalloc(NUMPIECES*sizeof(char));
+		char hashBoard[BOARDSIZE];
 		generic_hash_unhash(tierpos, hashBoard); // unhash in that tier
 		int x;
 		for(x=0; x<BOARDSIZE; x++)
 			board->slots[x+1] = hashBoard[x];
-		SafeFree(hashBoard);
 		setPiecesAndSquares(board);
 		return board;
 	} else return unhashUnsymQuarto(position);
@@ -193,6 +193,7 @@ struct {
 BOOLEAN AllFilledIn(BlankOX theBlankOX[]);
 POSITION BlankOXToPosition(BlankOX *theBlankOX);
 POSITION GetCanonicalPosition(POSITION position);
+void GetCanonicalPositions(POSITION *positions, POSITION *canonical, int length);
 void PositionToBlankOX(POSITION thePos,BlankOX *theBlankOX);
 BOOLEAN ThreeInARow(BlankOX[], int, int, int);
 void UndoMove(MOVE move);
@@ -200,6 +201,7 @@ BlankOX WhoseTurn(BlankOX *theBlankOX);
 
 STRING MoveToString( MOVE );
 POSITION ActualNumberOfPositions(int variant);
+int GenerateChildrenEfficient(POSITION position, POSITION *children, MOVE *moves);
 
 /**************************************************/
 /**************** SYMMETRY FUN BEGIN **************/
@@ -211,6 +213,12 @@ BOOLEAN kSupportsSymmetries = TRUE; /* Whether we support symmetries */
 
 int gSymmetryMatrix[NUMSYMMETRIES][BOARDSIZE];
 
+/* gSymmetryChunk[s][c][v] is what the three squares 3c..3c+2, holding
+   the base-3 digits of v, add to the position after symmetry s. A
+   position's image is then three lookups instead of an unhash and hash. */
+#define SYMMETRYCHUNK 27
+POSITION gSymmetryChunk[NUMSYMMETRIES][BOARDSIZE/3][SYMMETRYCHUNK];
+
 /* Proofs of correctness for the below arrays:
 **
 ** FLIP						ROTATE
@@ -246,7 +254,10 @@ void InitializeGame()
 
 	gCanonicalPosition = GetCanonicalPosition;
 
+	gCanonicalPositionBulkFunPtr = GetCanonicalPositions;
+
 	int i, j, temp; /* temp is used for debugging */
+	int c, v, k;
 
 	if(kSupportsSymmetries) { /* Initialize gSymmetryMatrix[][] */
 		for(i = 0; i < BOARDSIZE; i++) {
@@ -260,6 +271,17 @@ void InitializeGame()
 					temp = gSymmetryMatrix[j][i] = gRotate90CWNewPosition[temp];
 			}
 		}
+
+		/* Square gSymmetryMatrix[j][i] lands on square i */
+		for(j = 0; j < NUMSYMMETRIES; j++)
+			for(c = 0; c < BOARDSIZE/3; c++)
+				for(v = 0; v < SYMMETRYCHUNK; v++) {
+					gSymmetryChunk[j][c][v] = 0;
+					for(i = 0; i < BOARDSIZE; i++)
+						for(k = 0; k < 3; k++)
+							if(gSymmetryMatrix[j][i] == 3*c + k)
+								gSymmetryChunk[j][c][v] += (v / g3Array[k] % 3) * g3Array[i];
+				}
 	}
 
 	/**************************************************/
@@ -270,6 +292,7 @@ void InitializeGame()
 	gPosition.nextPiece = x;
 	gPosition.piecesPlaced = 0;
 	gUndoMove = UndoMove;
+	gGenerateChildrenFunPtr = &GenerateChildrenEfficient;
 
 	gMoveToStringFunPtr = &MoveToString;
 	gActualNumberOfPositionsOptFunPtr = &ActualNumberOfPositions;
@@ -590,6 +613,39 @@ MOVELIST *GenerateMoves(POSITION position)
 	return moves;
 }
 
+/************************************************************************
+**
+** NAME:        GenerateChildrenEfficient
+**
+** DESCRIPTION: GenerateMoves and DoMove in one go for the solvers: the
+**              board is unhashed once, and each child is the position
+**              plus the mover's piece in one blank.
+**
+** INPUTS:      POSITION position  : The position to branch off of.
+**              POSITION *children : Filled with the children.
+**              MOVE *moves        : Filled with the moves to them.
+**
+** OUTPUTS:     (int) The number of children, in GenerateMoves order.
+**
+************************************************************************/
+
+int GenerateChildrenEfficient(POSITION position, POSITION *children, MOVE *moves)
+{
+	BlankOX board[BOARDSIZE];
+	int index, turn, numChildren = 0;
+
+	PositionToBlankOX(position, board);
+	turn = (int) WhoseTurn(board);
+
+	for (index = BOARDSIZE - 1; index >= 0; --index)
+		if (board[index] == Blank) {
+			moves[numChildren] = index;
+			children[numChildren++] = position + g3Array[index] * turn;
+		}
+
+	return numChildren;
+}
+
 /**************************************************/
 /**************** SYMMETRY FUN BEGIN **************/
 /**************************************************/
@@ -611,14 +667,18 @@ MOVELIST *GenerateMoves(POSITION position)
 POSITION GetCanonicalPosition(position)
 POSITION position;
 {
-	POSITION newPosition, theCanonicalPosition, DoSymmetry();
-	int i;
+	POSITION newPosition, theCanonicalPosition;
+	int i, low, mid, high;
 
 	theCanonicalPosition = position;
+	low = position % SYMMETRYCHUNK;
+	mid = position / SYMMETRYCHUNK % SYMMETRYCHUNK;
+	high = position / (SYMMETRYCHUNK * SYMMETRYCHUNK);
 
 	for(i = 0; i < NUMSYMMETRIES; i++) {
 
-		newPosition = DoSymmetry(position, i); /* get new */
+		newPosition = gSymmetryChunk[i][0][low] + gSymmetryChunk[i][1][mid] +
+		              gSymmetryChunk[i][2][high]; /* get new */
 		if(newPosition < theCanonicalPosition) /* THIS is the one */
 			theCanonicalPosition = newPosition; /* set it to the ans */
 	}
@@ -626,6 +686,35 @@ POSITION position;
 	return(theCanonicalPosition);
 }
 
+/************************************************************************
+**
+** NAME:        GetCanonicalPositions
+**
+** DESCRIPTION: GetCanonicalPosition over a batch of positions, for
+**              CanonicalPositionBulk. canonical may be positions.
+**
+************************************************************************/
+
+void GetCanonicalPositions(POSITION *positions, POSITION *canonical, int length)
+{
+	POSITION newPosition, theCanonicalPosition;
+	int i, n, low, mid, high;
+
+	for(n = 0; n < length; n++) {
+		theCanonicalPosition = positions[n];
+		low = theCanonicalPosition % SYMMETRYCHUNK;
+		mid = theCanonicalPosition / SYMMETRYCHUNK % SYMMETRYCHUNK;
+		high = theCanonicalPosition / (SYMMETRYCHUNK * SYMMETRYCHUNK);
+		for(i = 0; i < NUMSYMMETRIES; i++) {
+			newPosition = gSymmetryChunk[i][0][low] + gSymmetryChunk[i][1][mid] +
+			              gSymmetryChunk[i][2][high];
+			if(newPosition < theCanonicalPosition)
+				theCanonicalPosition = newPosition;
+		}
+		canonical[n] = theCanonicalPosition;
+	}
+}
+
 /************************************************************************
 **
 ** NAME:        DoSymmetry
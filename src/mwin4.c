@@ -205,6 +205,7 @@ void            SetupTierStuff();
 void            positionToBinary(POSITION p);
 STRING          MoveToString( MOVE );
 POSITION        GetCanonicalPosition(POSITION position);
+void            GetCanonicalPositions(POSITION* positions, POSITION* canonical, int length);
 
 TIER            PositionToTier(POSITION pos);
 TIERPOSITION    PositionToTierPos(POSITION pos, TIER tier);
@@ -217,6 +218,9 @@ TIERPOSITION    NumberOfTierPositions(TIER tier);
 int             MostSigBit(uint num);
 POSITION        ModPosToPosition(POSITION p);
 POSITION        PositionToModPos(POSITION p, TIER t);
+POSITION        WindowToRawPosition(POSITION position);
+POSITION        RawToWindowPosition(POSITION position);
+int             GenerateChildrenEfficient(POSITION position, POSITION *children, MOVE *moves);
 /************************************************************************
 **
 ** NAME:        GetInitialPosition
@@ -264,8 +268,10 @@ void InitializeGame()
 	gPosition.nextPiece = x;
 	gPosition.piecesPlaced = 0;
 	gUndoMove = UndoMove;
+	gGenerateChildrenFunPtr = &GenerateChildrenEfficient;
 	gMoveToStringFunPtr =  &MoveToString;
 	gCanonicalPosition = GetCanonicalPosition;
+	gCanonicalPositionBulkFunPtr = GetCanonicalPositions;
 }
 
 
@@ -392,21 +398,11 @@ POSITION DoMove(POSITION position, MOVE move)
 	XOBlank turn,WhoseTurn();
 	POSITION turn2;
 	int i,free=0;
-	POSITION permutation_index, sizebits, remainderbits, temp=1;
-	TIER tier; TIERPOSITION tierpos;
-	POSITION modpos, bitmask, tierbits, temp1, temp2, temp3=2;
-
-	if (gHashWindowInitialized) {
-		gUnhashToTierPosition(position, &tierpos, &tier);
-		tierbits = temp << tier;
-		permutation_index = position / tierbits;
-		tierpos = (NumToPieceDist[tier].convert[permutation_index]);
-		tierpos <<= tier;
-		modpos = tierpos + (position % tierbits);
-		modpos <<= (64 - tier - TIER_COL_BITS);
-		position = ModPosToPosition(modpos);
+	POSITION temp=1;
+	POSITION temp1, temp2, temp3=2;
 
-	}
+	if (gHashWindowInitialized)
+		position = WindowToRawPosition(position);
 
 	for (i=move*(WIN4_HEIGHT+1)+WIN4_HEIGHT; (position & (temp1 = (temp << i))) == 0; --i)
 		free++;
@@ -427,21 +423,47 @@ POSITION DoMove(POSITION position, MOVE move)
 
 	position = (position | (temp2 = (temp3+turn2)<<i));
 
-	if (gHashWindowInitialized) {
-		tier = PositionToTier(position);
-		tierbits = temp << tier;
-		tierpos = PositionToModPos(position, tier);
-		bitmask = tierbits - 1;
-		sizebits = tierpos >> (64 - TIER_COL_BITS);
-		remainderbits = (tierpos >> (64 - tier - TIER_COL_BITS)) & bitmask;
-		permutation_index = PieceDistToNum[tier].convert[sizebits];
-		tierpos = permutation_index * tierbits + remainderbits;
-		position = gHashToWindowPosition(tierpos, tier);
-	}
+	if (gHashWindowInitialized)
+		position = RawToWindowPosition(position);
 
 	return position;
 }
 
+/* The column-bit position DoMove works on, from a hash window position */
+POSITION WindowToRawPosition(POSITION position)
+{
+	POSITION permutation_index, temp=1;
+	TIER tier; TIERPOSITION tierpos;
+	POSITION modpos, tierbits;
+
+	gUnhashToTierPosition(position, &tierpos, &tier);
+	tierbits = temp << tier;
+	permutation_index = position / tierbits;
+	tierpos = (NumToPieceDist[tier].convert[permutation_index]);
+	tierpos <<= tier;
+	modpos = tierpos + (position % tierbits);
+	modpos <<= (64 - tier - TIER_COL_BITS);
+	return ModPosToPosition(modpos);
+}
+
+/* And back */
+POSITION RawToWindowPosition(POSITION position)
+{
+	POSITION permutation_index, sizebits, remainderbits, temp=1;
+	TIER tier; TIERPOSITION tierpos;
+	POSITION bitmask, tierbits;
+
+	tier = PositionToTier(position);
+	tierbits = temp << tier;
+	tierpos = PositionToModPos(position, tier);
+	bitmask = tierbits - 1;
+	sizebits = tierpos >> (64 - TIER_COL_BITS);
+	remainderbits = (tierpos >> (64 - tier - TIER_COL_BITS)) & bitmask;
+	permutation_index = PieceDistToNum[tier].convert[sizebits];
+	tierpos = permutation_index * tierbits + remainderbits;
+	return gHashToWindowPosition(tierpos, tier);
+}
+
 void UndoMove(MOVE move)
 {
 	gPosition.board[move][--gPosition.heights[move]] = Blank;
@@ -763,6 +785,48 @@ MOVELIST *GenerateMoves(POSITION position)
 
 }
 
+/************************************************************************
+**
+** NAME:        GenerateChildrenEfficient
+**
+** DESCRIPTION: GenerateMoves and DoMove in one go for the solvers. The
+**              position is taken out of the hash window and its turn
+**              worked out once, rather than once per move.
+**
+** INPUTS:      POSITION position  : The position to branch off of.
+**              POSITION *children : Filled with the children.
+**              MOVE *moves        : Filled with the moves to them.
+**
+** OUTPUTS:     (int) The number of children, in GenerateMoves order.
+**
+************************************************************************/
+
+int GenerateChildrenEfficient(POSITION position, POSITION *children, MOVE *moves)
+{
+	XOBlank WhoseTurn();
+	POSITION raw = position, child, turn, one = 1, two = 2;
+	int col, top, i, numChildren = 0;
+
+	if (gHashWindowInitialized)
+		raw = WindowToRawPosition(position);
+	turn = (POSITION) WhoseTurn(raw);
+
+	for (col = WIN4_WIDTH - 1; col >= 0; col--) {
+		// from the top down, the first set bit marks the top of the column
+		top = col*(WIN4_HEIGHT+1)+WIN4_HEIGHT;
+		for (i = top; (raw & (one << i)) == 0; --i)
+			;
+		if (i == top) continue; // full
+		child = (raw & ~(one << i)) | ((two + turn) << i);
+		if (gHashWindowInitialized)
+			child = RawToWindowPosition(child);
+		moves[numChildren] = col;
+		children[numChildren++] = child;
+	}
+
+	return numChildren;
+}
+
 /************************************************************************
 **
 ** NAME:        GetAndPrintPlayersMove
@@ -1210,67 +1274,48 @@ POSITIONLIST *EnumerateWithinStage(int stage) {
 
 /************************************************************************
 **
-** NAME:        array_symm
+** NAME:        GetCanonicalPosition
 **
-** DESCRIPTION: Takes a 1D position array, imagines it as a
-**                2D [column][row] positon array, and swaps
-**                columns around the middle.
+** DESCRIPTION: Looks at a position and returns its canonical form
 **
-** INPUTS:      short* bits - 1D positon array
-**              short  columns - # of columns on the board
+** INPUTS:      POSITION p: a passed position
 **
-** OUTPUTS:     "bits" is modified to represent a mirror
-**                reflection of the original position.
+** OUTPUTS:     POSITION  : position's canonical form
 **
 ************************************************************************/
-void array_symm(short* bits, short columns){
-	short a, t, i = -1, j = columns;
-	short col_sz = WIN4_HEIGHT + 1;
-	while (++i < --j) {
-		for (a = 0; a < (WIN4_HEIGHT + 1); a++) {
-			t = bits[i * col_sz + a];
-			bits[i * col_sz + a] = bits[j * col_sz + a];
-			bits[j * col_sz + a] = t;
-		}
-	}
+POSITION GetCanonicalPosition(POSITION p){
+	int column = WIN4_HEIGHT + 1;
+	POSITION mask = ((POSITION) 1 << column) - 1, temp = 0;
+	short i;
+
+	//                               Mirror the columns around the middle
+	for (i = 0; i < WIN4_WIDTH; i++)
+		temp |= ((p >> (i * column)) & mask) << ((WIN4_WIDTH - 1 - i) * column);
+	return ((temp < p) ? temp : p); // Choose the smallest position
 }
 
 /************************************************************************
 **
-** NAME:        GetCanonicalPosition
+** NAME:        GetCanonicalPositions
 **
-** DESCRIPTION: Looks at a position and returns its canonical form
-**
-** INPUTS:      POSITION p: a passed position
-**
-** OUTPUTS:     POSITION  : position's canonical form
+** DESCRIPTION: GetCanonicalPosition over a batch of positions, for
+**              CanonicalPositionBulk. canonical may be positions.
 **
 ************************************************************************/
-POSITION GetCanonicalPosition(POSITION p){
-	POSITION temp, hold; // new, hold;
-	int column = WIN4_HEIGHT + 1;
-	short i, size = column * WIN4_WIDTH;
-	short bits[size];
-
-	//Copy position into an array
-	temp = p;
-	//                               Copy the orig position into an array
-	hold = temp;
-	for (i = 0; i < size; i++) {
-		bits[i] = temp & 1;
-		temp = temp >> 1;
-	}
-	temp = hold;
-	//                               Process an array
-	array_symm(bits, WIN4_WIDTH );
-	//                               Copy an array into the new position
-	temp = 0;
-	for (i = size-1; i >= 0; i--) {
-		temp = temp | bits[i];
-		if (i != 0)
-			temp = temp << 1;
+void GetCanonicalPositions(POSITION* positions, POSITION* canonical, int length){
+	int column = WIN4_HEIGHT + 1, n;
+	POSITION mask = ((POSITION) 1 << column) - 1, p, temp;
+	short i, shift[WIN4_WIDTH];
+
+	for (i = 0; i < WIN4_WIDTH; i++)
+		shift[i] = (WIN4_WIDTH - 1 - i) * column;
+	for (n = 0; n < length; n++) {
+		p = positions[n];
+		temp = 0;
+		for (i = 0; i < WIN4_WIDTH; i++)
+			temp |= ((p >> (i * column)) & mask) << shift[i];
+		canonical[n] = (temp < p) ? temp : p;
 	}
-	return ((temp < p) ? temp : p); // Choose the smallest position
 }
 
 